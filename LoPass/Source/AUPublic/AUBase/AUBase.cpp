@@ -206,7 +206,7 @@ OSStatus			AUBase::DoInitialize()
 		result = Initialize();
 		if (result == noErr) {
 			if (CanScheduleParameters())
-				mParamList.reserve(24);
+				mParamList.reserve(kMaxScheduledParameterEvents);
 			mHasBegunInitializing = true;
 			ReallocateBuffers();	// calls CreateElements()
 			mInitialized = true;	// signal that it's okay to render
@@ -1221,6 +1221,7 @@ OSStatus 	AUBase::ScheduleParameter (	const AudioUnitParameterEvent 		*inParamet
 													UInt32							inNumEvents)
 {
 	bool canScheduleParameters = CanScheduleParameters();
+	OSStatus result = noErr;
 		
 	for (UInt32 i = 0; i < inNumEvents; ++i) 
 	{
@@ -1233,11 +1234,16 @@ OSStatus 	AUBase::ScheduleParameter (	const AudioUnitParameterEvent 		*inParamet
 							inParameterEvent[i].eventValues.immediate.bufferOffset);
 		}
 		if (canScheduleParameters) {
-			mParamList.push_back (inParameterEvent[i]);
+			// growing the list would allocate on the render thread; an immediate event that
+			// doesn't fit has still been set above, but won't split the buffer
+			if (mParamList.size() < mParamList.capacity() || !IsInitialized())
+				mParamList.push_back (inParameterEvent[i]);
+			else
+				result = kAudioUnitErr_CannotDoInCurrentContext;
 		}
 	}
 	
-	return noErr;
+	return result;
 }
 
 // ____________________________________________________________________________
@@ -1346,10 +1352,12 @@ OSStatus 	AUBase::ProcessForScheduledParams(	ParameterEventList		&inParamList,
 
 		// Finally, actually do the processing for this slice.....
 		
+		AUTRACE(kLoPassTrace_ScheduledSliceStart, mComponentInstance, (intptr_t)this, currentStartFrame, framesThisTime, inFramesToProcess);
 		result = ProcessScheduledSlice(	inUserData,
 										currentStartFrame,
 										framesThisTime,
 										inFramesToProcess );
+		AUTRACE(kLoPassTrace_ScheduledSliceEnd, mComponentInstance, (intptr_t)this, result, 0, 0);
 								
 		if(result != noErr) break;
 		
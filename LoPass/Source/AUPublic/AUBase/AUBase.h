@@ -41,6 +41,11 @@ Part of Core Audio AUBase Classes
 	#endif
 #endif
 
+// LOPASS_TRACE records the trace points into per-thread rings, see LoPassTrace.hpp
+#if LOPASS_TRACE
+	#include "LoPassTrace.hpp"
+#endif
+
 #ifndef AUTRACE
 	#define AUTRACE(code, obj, a, b, c, d)
 #endif	
@@ -829,6 +834,11 @@ protected:
 
 	typedef std::vector<AudioUnitParameterEvent> ParameterEventList;
 
+	// Most events ScheduleParameter() keeps for one render cycle once initialized. The list
+	// is reserved to this in DoInitialize() and never grows after, since hosts schedule from
+	// the render thread; events past it are refused.
+	enum { kMaxScheduledParameterEvents = 1024 };
+
 	// Usually, you won't override this method.  You only need to call this if your DSP code
 	// is prepared to handle scheduled immediate and ramped parameter changes.
 	// Before calling this method, it is assumed you have already called PullInput() on the input busses
@@ -30,6 +30,7 @@ AUEffectBase::AUEffectBase(	AudioComponentInstance	audioUnit,
 #if TARGET_OS_IPHONE
 	, mOnlyOneKernel(false)
 #endif
+	, mChannelScheduler(NULL)
 {
 }
 
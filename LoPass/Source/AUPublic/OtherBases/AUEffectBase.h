@@ -12,9 +12,27 @@ Part of Core Audio AUBase Classes
 #include "AUBase.h"
 #include "AUSilentTimeout.h"
 #include "CAException.h"
+#include <atomic>
 
 class AUKernelBase;
 
+//	Optional hook for running the kernels of one buffer on more than one thread.
+//	Run() must call inFunction over every channel in [0, inNumberOfChannels), in groups of
+//	[inBegin, inEnd) on whatever threads it likes, and return once all of them are done.
+	/*! @class AUChannelScheduler */
+class AUChannelScheduler {
+public:
+	typedef void (*ChannelGroupFunction)(void *inContext, UInt32 inBegin, UInt32 inEnd);
+
+	/*! @dtor ~AUChannelScheduler */
+	virtual						~AUChannelScheduler() { }
+
+	/*! method Run */
+	virtual void				Run(	UInt32					inNumberOfChannels,
+										ChannelGroupFunction	inFunction,
+										void *					inContext) = 0;
+};
+
 //	Base class for an effect with one input stream, one output stream,
 //	any number of channels.
 	/*! @class AUEffectBase */
@@ -191,6 +209,13 @@ protected:
 
 	CAStreamBasicDescription::CommonPCMFormat GetCommonPCMFormat() const { return mCommonPCMFormat; }
 	
+	// With a scheduler set, ProcessBufferListsT hands the kernels to it instead of running
+	// them in turn. Kernels must then be independent of each other and must not throw.
+	// Not owned; NULL (the default) runs them in turn on the render thread.
+	/*! method SetChannelScheduler */
+	void						SetChannelScheduler(AUChannelScheduler *inScheduler) { mChannelScheduler = inScheduler; }
+	AUChannelScheduler *		GetChannelScheduler() const { return mChannelScheduler; }
+
 
 private:
 	/*! @var mBypassEffect */
@@ -218,6 +243,23 @@ private:
 	/*! @var mCommonPCMFormat */
 	CAStreamBasicDescription::CommonPCMFormat		mCommonPCMFormat;
 	UInt32							mBytesPerFrame;
+
+	/*! @var mChannelScheduler */
+	AUChannelScheduler *			mChannelScheduler;
+
+	// what a scheduled group of kernels needs from ProcessBufferListsT
+	struct ChannelGroupParams
+	{
+		AUEffectBase *				effect;
+		const AudioBufferList *		inBuffer;
+		AudioBufferList *			outBuffer;
+		UInt32						framesToProcess;
+		bool						silentInput;
+		std::atomic<bool>			outputIsSilence;
+	};
+
+	template <typename T>
+	static void	ProcessChannelGroupT(void *inParams, UInt32 inBegin, UInt32 inEnd);
 };
 
 
@@ -289,6 +331,29 @@ void	AUEffectBase::ProcessBufferListsT(
 
 	bool silentInput = IsInputSilent (ioActionFlags, inFramesToProcess);
 	ioActionFlags |= kAudioUnitRenderAction_OutputIsSilence;
+	AUTRACE(kLoPassTrace_ProcessBufferListsStart, GetComponentInstance(), (intptr_t)this, mKernelList.size(), inFramesToProcess, silentInput);
+
+	// hand groups of channels to the scheduler, which runs them alongside this thread
+	if (mChannelScheduler != NULL && mKernelList.size() > 1) {
+		if (inBuffer.mNumberBuffers == 1 && inBuffer.mBuffers[0].mNumberChannels == 0)
+			throw CAException(kAudio_ParamError);
+
+		ChannelGroupParams params;
+		params.effect = this;
+		params.inBuffer = &inBuffer;
+		params.outBuffer = &outBuffer;
+		params.framesToProcess = inFramesToProcess;
+		params.silentInput = silentInput;
+		params.outputIsSilence.store(true, std::memory_order_relaxed);
+
+		mChannelScheduler->Run((UInt32)mKernelList.size(), &ProcessChannelGroupT<T>, &params);
+
+		// Run() has waited for every group, so their stores are visible here
+		if (!params.outputIsSilence.load(std::memory_order_relaxed))
+			ioActionFlags &= ~kAudioUnitRenderAction_OutputIsSilence;
+		AUTRACE(kLoPassTrace_ProcessBufferListsEnd, GetComponentInstance(), (intptr_t)this, ioActionFlags, 0, 0);
+		return;
+	}
 
 	// call the kernels to handle either interleaved or deinterleaved
 	if (inBuffer.mNumberBuffers == 1) {
@@ -333,6 +398,48 @@ void	AUEffectBase::ProcessBufferListsT(
 				ioActionFlags &= ~kAudioUnitRenderAction_OutputIsSilence;
 		}
 	}
+	AUTRACE(kLoPassTrace_ProcessBufferListsEnd, GetComponentInstance(), (intptr_t)this, ioActionFlags, 0, 0);
+}
+
+template <typename T>
+void	AUEffectBase::ProcessChannelGroupT(void *inParams, UInt32 inBegin, UInt32 inEnd)
+{
+	ChannelGroupParams &params = *(ChannelGroupParams *)inParams;
+	const AudioBufferList &inBuffer = *params.inBuffer;
+	AudioBufferList &outBuffer = *params.outBuffer;
+	bool outputIsSilence = true;
+	AUTRACE(kLoPassTrace_ChannelGroupStart, params.effect->GetComponentInstance(), (intptr_t)params.effect, inBegin, inEnd, params.framesToProcess);
+
+	for (UInt32 channel = inBegin; channel < inEnd; ++channel) {
+		AUKernelBase *kernel = params.effect->mKernelList[channel];
+
+		if (kernel == NULL) continue;
+		bool ioSilence = params.silentInput;
+
+		if (inBuffer.mNumberBuffers == 1) {
+			// interleaved: neighbouring channels share cache lines, but never samples
+			kernel->Process(
+				(const T *)inBuffer.mBuffers[0].mData + channel,
+				(T *)outBuffer.mBuffers[0].mData + channel,
+				params.framesToProcess,
+				inBuffer.mBuffers[0].mNumberChannels,
+				ioSilence);
+		} else {
+			kernel->Process(
+				(const T *)inBuffer.mBuffers[channel].mData,
+				(T *)outBuffer.mBuffers[channel].mData,
+				params.framesToProcess,
+				1,
+				ioSilence);
+		}
+
+		if (!ioSilence)
+			outputIsSilence = false;
+	}
+
+	if (!outputIsSilence)
+		params.outputIsSilence.store(false, std::memory_order_relaxed);
+	AUTRACE(kLoPassTrace_ChannelGroupEnd, params.effect->GetComponentInstance(), (intptr_t)params.effect, 0, 0, 0);
 }
 
 
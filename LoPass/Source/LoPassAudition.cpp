@@ -0,0 +1,83 @@
+//
+//  LoPassAudition.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassAudition.hpp"
+#include "LoPassParameters.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAudition::LoPassAudition()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassAudition::LoPassAudition(double inSampleRate, unsigned inChannels) : mBanks(inChannels, LoPassFilterBank(inSampleRate)),
+                                                                           mNumberOfSettings(0) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAudition::AddSetting()
+//
+// Streams are never removed, so every bank hands out the same ids, which are the indices.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassAudition::AddSetting(double inCutoff, double inResonance) {
+
+    for (size_t c = 0; c < mBanks.size(); c++) { mBanks[c].AddStream(inCutoff, inResonance); }
+
+    return mNumberOfSettings++;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAudition::AddPresets()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassAudition::AddPresets() {
+
+    unsigned first = mNumberOfSettings;
+
+    for (int i = 0; i < kNumberOfPresets; i++) { AddSetting(kPresetValues[i].mFrequency, kPresetValues[i].mResonance); }
+
+    return first;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAudition::SetSetting()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassAudition::SetSetting(unsigned inSetting, double inCutoff, double inResonance) {
+
+    for (size_t c = 0; c < mBanks.size(); c++) { mBanks[c].SetParameters(inSetting, inCutoff, inResonance); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAudition::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassAudition::Reset() {
+
+    for (size_t c = 0; c < mBanks.size(); c++) {
+        for (unsigned s = 0; s < mNumberOfSettings; s++) { mBanks[c].Reset(s); }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAudition::Process()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassAudition::Process(const float *const *inSources, float *const *outDests, unsigned inFrames) {
+
+    if (inFrames == 0) { return; }
+
+    const unsigned channels = (unsigned)mBanks.size();
+
+    for (unsigned c = 0; c < channels; c++) {
+
+        LoPassFilterBank &bank = mBanks[c];
+
+        for (unsigned s = 0; s < mNumberOfSettings; s++) { bank.Submit(s, inSources[c], outDests[s * channels + c], inFrames); }
+
+        bank.Run();
+    }
+}
@@ -0,0 +1,62 @@
+//
+//  LoPassAudition.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassAudition_hpp
+#define LoPassAudition_hpp
+
+#include "LoPassFilterBank.hpp"
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Audition
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// One input through many settings in one pass, for comparing the factory presets and
+// variations on them over the same clip without rendering it again for each. Every setting
+// is a stream of a LoPassFilterBank, one bank per input channel, and all the streams of a
+// channel are submitted with that channel's buffer as their source. The bank then reads each
+// input sample once for kFilterBank_Lanes settings at a time and runs them all in one step of
+// the recursion, so sixteen settings cost a few plain renders rather than sixteen; most of
+// that is the vector arithmetic, the rest sorting the lanes out into their own outputs.
+// Tools/LoPassAuditionBench.cpp checks the outputs and measures the cost.
+//
+// Each output is bit identical to a LoPassBiquad running that setting over the input, which
+// is what the effect renders once its parameters have settled. Smoothing, multirate and
+// linear phase aren't auditioned: a change of setting takes effect in a step at the next
+// Process().
+
+class LoPassAudition {
+
+public:
+    LoPassAudition(double inSampleRate, unsigned inChannels);
+
+    /// Cutoff in Hz and resonance in dB, bounds checked as for the effect. Returns the new
+    /// setting's index; settings are numbered in the order they were added.
+    unsigned AddSetting(double inCutoff, double inResonance);
+
+    /// Adds each factory preset in turn, returning the index of the first.
+    unsigned AddPresets();
+
+    void SetSetting(unsigned inSetting, double inCutoff, double inResonance);
+
+    /// Clear the history of every setting, for a new clip.
+    void Reset();
+
+    /// Filter inFrames of every channel of inSources through every setting. outDests has a
+    /// buffer per channel per setting, setting by setting: outDests[setting * channels +
+    /// channel]. No output may be an input buffer, which the other settings still read.
+    /// Any block size; the banks regroup when it changes.
+    void Process(const float *const *inSources, float *const *outDests, unsigned inFrames);
+
+    unsigned GetNumberOfSettings() const { return mNumberOfSettings; }
+    unsigned GetNumberOfChannels() const { return (unsigned)mBanks.size(); }
+
+private:
+    std::vector<LoPassFilterBank>   mBanks;
+    unsigned                        mNumberOfSettings;
+};
+
+#endif /* LoPassAudition_hpp */
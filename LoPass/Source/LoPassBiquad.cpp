@@ -0,0 +1,158 @@
+//
+//  LoPassBiquad.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassBiquad.hpp"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Loops
+//
+// kRamp steps the coefficients before each sample; otherwise the increment is unused.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+template <bool kRamp>
+static void ProcessDirectForm(LoPassCoefficients        &ioCoefficients,
+                              const LoPassCoefficients  &inIncrement,
+                              const float               *inSourceP,
+                              float                     *inDestP,
+                              unsigned                  inFramesToProcess,
+                              double                    &ioX1,
+                              double                    &ioX2,
+                              double                    &ioY1,
+                              double                    &ioY2) {
+    
+    double a0 = ioCoefficients.mA0;
+    double a1 = ioCoefficients.mA1;
+    double a2 = ioCoefficients.mA2;
+    double b1 = ioCoefficients.mB1;
+    double b2 = ioCoefficients.mB2;
+    
+    double x1 = ioX1, x2 = ioX2, y1 = ioY1, y2 = ioY2;
+    
+    for (unsigned i = 0; i < inFramesToProcess; i++) {
+        
+        if (kRamp) {
+            a0 += inIncrement.mA0;
+            a1 += inIncrement.mA1;
+            a2 += inIncrement.mA2;
+            b1 += inIncrement.mB1;
+            b2 += inIncrement.mB2;
+        }
+        
+        double input = inSourceP[i];
+        double output = a0*input + a1*x1 + a2*x2 - b1*y1 - b2*y2;
+        
+        x2 = x1;
+        x1 = input;
+        y2 = y1;
+        y1 = output;
+        
+        inDestP[i] = float(output);
+    }
+    
+    ioX1 = x1; ioX2 = x2; ioY1 = y1; ioY2 = y2;
+    
+    if (kRamp) {
+        ioCoefficients.mA0 = a0;
+        ioCoefficients.mA1 = a1;
+        ioCoefficients.mA2 = a2;
+        ioCoefficients.mB1 = b1;
+        ioCoefficients.mB2 = b2;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::LoPassBiquad()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassBiquad::LoPassBiquad() {
+    
+    Reset();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBiquad::Reset() {
+    mX1 = 0.0;
+    mX2 = 0.0;
+    mY1 = 0.0;
+    mY2 = 0.0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::GetState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassBiquadState LoPassBiquad::GetState() const {
+    
+    LoPassBiquadState state = { mX1, mX2, mY1, mY2 };
+    return state;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::SetState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBiquad::SetState(const LoPassBiquadState &inState) {
+    
+    mX1 = inState.mX1;
+    mX2 = inState.mX2;
+    mY1 = inState.mY1;
+    mY2 = inState.mY2;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::SaveState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBiquad::SaveState(LoPassStateWriter &ioWriter) const {
+    
+    ioWriter.PutDouble(mX1);
+    ioWriter.PutDouble(mX2);
+    ioWriter.PutDouble(mY1);
+    ioWriter.PutDouble(mY2);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::LoadState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBiquad::LoadState(LoPassStateReader &ioReader) {
+    
+    mX1 = ioReader.GetDouble();
+    mX2 = ioReader.GetDouble();
+    mY1 = ioReader.GetDouble();
+    mY2 = ioReader.GetDouble();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::Process()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBiquad::Process(const LoPassCoefficients &inCoefficients,
+                           const float              *inSourceP,
+                           float                    *inDestP,
+                           unsigned                 inFramesToProcess) {
+    
+    LoPassCoefficients coefficients = inCoefficients; // only written back when ramping
+    
+    ProcessDirectForm<false>(coefficients, inCoefficients, inSourceP, inDestP, inFramesToProcess, mX1, mX2, mY1, mY2);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBiquad::ProcessRamp()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBiquad::ProcessRamp(LoPassCoefficients       &ioCoefficients,
+                               const LoPassCoefficients &inIncrement,
+                               const float              *inSourceP,
+                               float                    *inDestP,
+                               unsigned                 inFramesToProcess) {
+    
+    ProcessDirectForm<true>(ioCoefficients, inIncrement, inSourceP, inDestP, inFramesToProcess, mX1, mX2, mY1, mY2);
+}
@@ -0,0 +1,66 @@
+//
+//  LoPassBiquad.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassBiquad_hpp
+#define LoPassBiquad_hpp
+
+#include "LoPassFilter.hpp"
+#include "LoPassState.hpp"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Biquad
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// One channel of the IIR filter: Direct Form 1 with the whole feedback path in double, which
+// holds 120 dB SNR against a long double reference; the output is only rounded to float on
+// the way out. Tools/LoPassPrecision.cpp reports the accuracy and speed across the parameter
+// range, on steady designs and after a change of design, and checks that bound.
+
+/// Filter history: the last two inputs and outputs.
+struct LoPassBiquadState {
+    double mX1;
+    double mX2;
+    double mY1;
+    double mY2;
+};
+
+class LoPassBiquad {
+    
+public:
+    LoPassBiquad();
+    
+    /// Clear the filter state.
+    void Reset();
+    
+    LoPassBiquadState GetState() const;
+    void SetState(const LoPassBiquadState &inState);
+    
+    /// History, see LoPassState.hpp.
+    void SaveState(LoPassStateWriter &ioWriter) const;
+    void LoadState(LoPassStateReader &ioReader);
+    
+    /// Run with fixed coefficients.
+    void Process(const LoPassCoefficients   &inCoefficients,
+                 const float                *inSourceP,
+                 float                      *inDestP,
+                 unsigned                   inFramesToProcess);
+    
+    /// Run while stepping ioCoefficients by inIncrement before every sample.
+    void ProcessRamp(LoPassCoefficients         &ioCoefficients,
+                     const LoPassCoefficients   &inIncrement,
+                     const float                *inSourceP,
+                     float                      *inDestP,
+                     unsigned                   inFramesToProcess);
+    
+private:
+    // Filter state
+    double mX1;
+    double mX2;
+    double mY1;
+    double mY2;
+};
+
+#endif /* LoPassBiquad_hpp */
@@ -0,0 +1,257 @@
+//
+//  LoPassCoefficientCache.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassCoefficientCache.hpp"
+#include <atomic>
+#include <string.h>
+
+static constexpr unsigned kBuckets = kCoefficientCache_Entries / kCoefficientCache_Ways;
+
+static_assert(kCoefficientCache_Entries % kCoefficientCache_Ways == 0, "the table must be whole buckets");
+static_assert((kBuckets & (kBuckets - 1)) == 0, "the bucket count must be a power of two");
+
+/// One setting. mSequence is odd while the entry is being written; mMode is the mode plus
+/// one, so a zeroed entry is empty.
+struct Entry {
+    std::atomic<uint32_t>   mSequence;
+    std::atomic<uint32_t>   mMode;
+    std::atomic<uint64_t>   mKey[3];        // sample rate, freq, resonance
+    std::atomic<uint64_t>   mValue[5];
+};
+
+/// Written by every instance, so each on a line of its own.
+struct alignas(64) Counter {
+    std::atomic<uint64_t>   mValue;
+};
+
+/// All zeros is a valid empty table, so the static in GetTable() needs no constructor run
+/// and no guard.
+struct Table {
+    Entry                   mEntries[kCoefficientCache_Entries];
+    Counter                 mHits;
+    Counter                 mMisses;
+    Counter                 mEvictions;
+    Counter                 mVictim;        // round robin over the ways of a full bucket
+    std::atomic<bool>       mDisabled;
+};
+
+static Table &GetTable() {
+
+    static Table table;
+    return table;
+}
+
+static uint64_t GetBits(double inValue) {
+
+    uint64_t bits;
+    memcpy(&bits, &inValue, sizeof(bits));
+    return bits;
+}
+
+static void ToValues(const LoPassCoefficients &inCoefficients, uint64_t *outValues) {
+
+    outValues[0] = GetBits(inCoefficients.mA0);
+    outValues[1] = GetBits(inCoefficients.mA1);
+    outValues[2] = GetBits(inCoefficients.mA2);
+    outValues[3] = GetBits(inCoefficients.mB1);
+    outValues[4] = GetBits(inCoefficients.mB2);
+}
+
+static void FromValues(const uint64_t *inValues, LoPassCoefficients &outCoefficients) {
+
+    memcpy(&outCoefficients.mA0, &inValues[0], 8);
+    memcpy(&outCoefficients.mA1, &inValues[1], 8);
+    memcpy(&outCoefficients.mA2, &inValues[2], 8);
+    memcpy(&outCoefficients.mB1, &inValues[3], 8);
+    memcpy(&outCoefficients.mB2, &inValues[4], 8);
+}
+
+/// The bucket a key lives in. Neighbouring cutoffs differ only in their low mantissa bits,
+/// so everything is mixed down before the bucket is taken.
+static unsigned GetBucket(const uint64_t *inKey, uint32_t inMode) {
+
+    uint64_t h = inKey[0] ^ (inKey[1] * 0x9E3779B97F4A7C15ull) ^ (inKey[2] * 0xC2B2AE3D27D4EB4Full) ^ inMode;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+
+    return (unsigned)h & (kBuckets - 1);
+}
+
+/// True and the value when inEntry holds the key, and wasn't written while being read.
+static bool Read(const Entry &inEntry, const uint64_t *inKey, uint32_t inMode, uint64_t *outValues) {
+
+    uint32_t sequence = inEntry.mSequence.load(std::memory_order_acquire);
+    if (sequence & 1) { return false; }
+
+    if (inEntry.mMode.load(std::memory_order_relaxed) != inMode) { return false; }
+
+    for (int k = 0; k < 3; k++) {
+        if (inEntry.mKey[k].load(std::memory_order_relaxed) != inKey[k]) { return false; }
+    }
+
+    for (int k = 0; k < 5; k++) { outValues[k] = inEntry.mValue[k].load(std::memory_order_relaxed); }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return inEntry.mSequence.load(std::memory_order_relaxed) == sequence;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassCoefficientCache::Design()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassCoefficientCache::Design(double                  inSampleRate,
+                                    double                  inFreq,
+                                    double                  inResonance,
+                                    LoPassDesignMode        inMode,
+                                    LoPassCoefficients      &outCoefficients) {
+
+    if (!IsEnabled()) {
+        LoPassFilter::CalculateLopassParams(inFreq, inResonance, outCoefficients);
+        return;
+    }
+
+    if (Lookup(inSampleRate, inFreq, inResonance, inMode, outCoefficients)) { return; }
+
+    LoPassFilter::CalculateLopassParams(inFreq, inResonance, outCoefficients);
+    Insert(inSampleRate, inFreq, inResonance, inMode, outCoefficients);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassCoefficientCache::Lookup()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassCoefficientCache::Lookup(double                  inSampleRate,
+                                    double                  inFreq,
+                                    double                  inResonance,
+                                    LoPassDesignMode        inMode,
+                                    LoPassCoefficients      &outCoefficients) {
+
+    Table &table = GetTable();
+
+    const uint64_t key[3] = { GetBits(inSampleRate), GetBits(inFreq), GetBits(inResonance) };
+    const uint32_t mode = (uint32_t)inMode + 1;
+
+    Entry *bucket = &table.mEntries[GetBucket(key, mode) * kCoefficientCache_Ways];
+
+    for (unsigned way = 0; way < kCoefficientCache_Ways; way++) {
+        uint64_t values[5];
+        if (Read(bucket[way], key, mode, values)) {
+            FromValues(values, outCoefficients);
+            table.mHits.mValue.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    table.mMisses.mValue.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassCoefficientCache::Insert()
+//
+// Takes an empty way if the bucket has one, else the next in turn. The entry is claimed by
+// making its sequence odd; if another writer already has it the insert is simply dropped,
+// and the setting is designed again next time it's asked for.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassCoefficientCache::Insert(double                  inSampleRate,
+                                    double                  inFreq,
+                                    double                  inResonance,
+                                    LoPassDesignMode        inMode,
+                                    const LoPassCoefficients &inCoefficients) {
+
+    Table &table = GetTable();
+
+    const uint64_t key[3] = { GetBits(inSampleRate), GetBits(inFreq), GetBits(inResonance) };
+    const uint32_t mode = (uint32_t)inMode + 1;
+
+    Entry *bucket = &table.mEntries[GetBucket(key, mode) * kCoefficientCache_Ways];
+    Entry *entry = NULL;
+
+    for (unsigned way = 0; way < kCoefficientCache_Ways && entry == NULL; way++) {
+        if (bucket[way].mMode.load(std::memory_order_relaxed) == 0) { entry = &bucket[way]; }
+    }
+
+    bool evicting = entry == NULL;
+    if (evicting) {
+        uint64_t victim = table.mVictim.mValue.fetch_add(1, std::memory_order_relaxed);
+        entry = &bucket[victim % kCoefficientCache_Ways];
+    }
+
+    uint32_t sequence = entry->mSequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) || !entry->mSequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed)) { return; }
+
+    // no store below may be seen before the odd sequence
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t values[5];
+    ToValues(inCoefficients, values);
+
+    entry->mMode.store(mode, std::memory_order_relaxed);
+    for (int k = 0; k < 3; k++) { entry->mKey[k].store(key[k], std::memory_order_relaxed); }
+    for (int k = 0; k < 5; k++) { entry->mValue[k].store(values[k], std::memory_order_relaxed); }
+
+    entry->mSequence.store(sequence + 2, std::memory_order_release);
+
+    if (evicting) { table.mEvictions.mValue.fetch_add(1, std::memory_order_relaxed); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassCoefficientCache::SetEnabled()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassCoefficientCache::SetEnabled(bool inEnabled) {
+
+    GetTable().mDisabled.store(!inEnabled, std::memory_order_relaxed);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassCoefficientCache::IsEnabled()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassCoefficientCache::IsEnabled() {
+
+    return !GetTable().mDisabled.load(std::memory_order_relaxed);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassCoefficientCache::GetStatistics()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassCoefficientCacheStatistics LoPassCoefficientCache::GetStatistics() {
+
+    Table &table = GetTable();
+
+    LoPassCoefficientCacheStatistics statistics;
+    statistics.mHits        = table.mHits.mValue.load(std::memory_order_relaxed);
+    statistics.mMisses      = table.mMisses.mValue.load(std::memory_order_relaxed);
+    statistics.mEvictions   = table.mEvictions.mValue.load(std::memory_order_relaxed);
+
+    return statistics;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassCoefficientCache::Clear()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassCoefficientCache::Clear() {
+
+    Table &table = GetTable();
+
+    for (unsigned n = 0; n < kCoefficientCache_Entries; n++) {
+        Entry &entry = table.mEntries[n];
+        entry.mMode.store(0, std::memory_order_relaxed);
+        for (int k = 0; k < 3; k++) { entry.mKey[k].store(0, std::memory_order_relaxed); }
+        for (int k = 0; k < 5; k++) { entry.mValue[k].store(0, std::memory_order_relaxed); }
+    }
+
+    table.mHits.mValue.store(0, std::memory_order_relaxed);
+    table.mMisses.mValue.store(0, std::memory_order_relaxed);
+    table.mEvictions.mValue.store(0, std::memory_order_relaxed);
+}
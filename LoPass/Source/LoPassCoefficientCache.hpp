@@ -0,0 +1,82 @@
+//
+//  LoPassCoefficientCache.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassCoefficientCache_hpp
+#define LoPassCoefficientCache_hpp
+
+#include "LoPassFilter.hpp"
+#include <stdint.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Coefficient Cache
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// One table for the whole process, so instances sitting on the same setting (a factory
+// preset in a big session, or hundreds of feeds in a LoPassFilterBank) design it once
+// between them. Keyed on the sample rate, normalised cutoff, resonance and the mode asking,
+// compared bit for bit; a hit returns exactly what LoPassFilter::CalculateLopassParams()
+// would have, so nothing downstream can tell.
+//
+// The table is a fixed kCoefficientCache_Entries, in buckets of kCoefficientCache_Ways,
+// so it never allocates. Each entry is guarded by a sequence count: readers never wait,
+// they retry nothing and just count a miss if they catch an entry being written, and a
+// writer that finds an entry busy skips the insert. It's safe from the render thread.
+//
+// Only settled designs are worth keeping; a smoothed sweep designs a new point every
+// control period, and LoPassControlRate keeps those out of the table.
+
+enum LoPassDesignMode {
+    kLoPassDesign_Filter        = 0,    // LoPassSmoothedBiquad and LoPassFilterBank
+    kLoPassDesign_Multirate     = 1,    // the biquad in a multirate lane
+    kLoPassDesign_LinearPhase   = 2,    // the prototype for the FIR design
+    kNumberOfLoPassDesignModes  = 3
+};
+
+/// Table size, and entries per bucket.
+static constexpr unsigned kCoefficientCache_Entries = 1024;
+static constexpr unsigned kCoefficientCache_Ways    = 4;
+
+struct LoPassCoefficientCacheStatistics {
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mEvictions;    // inserts that threw out another setting
+};
+
+class LoPassCoefficientCache {
+
+public:
+    /// inFreq is normalised frequency 0 -> 1 as designed at inSampleRate, inResonance is in
+    /// decibels. Looks the design up, and designs and inserts it on a miss.
+    static void Design(double                  inSampleRate,
+                       double                  inFreq,
+                       double                  inResonance,
+                       LoPassDesignMode        inMode,
+                       LoPassCoefficients      &outCoefficients);
+
+    /// False on a miss, leaving outCoefficients alone.
+    static bool Lookup(double                  inSampleRate,
+                       double                  inFreq,
+                       double                  inResonance,
+                       LoPassDesignMode        inMode,
+                       LoPassCoefficients      &outCoefficients);
+
+    static void Insert(double                  inSampleRate,
+                       double                  inFreq,
+                       double                  inResonance,
+                       LoPassDesignMode        inMode,
+                       const LoPassCoefficients &inCoefficients);
+
+    /// With the cache off Design() always designs and nothing is counted; for comparisons.
+    static void SetEnabled(bool inEnabled);
+    static bool IsEnabled();
+
+    static LoPassCoefficientCacheStatistics GetStatistics();
+
+    /// Empty the table and zero the counters. Not while anything else is designing.
+    static void Clear();
+};
+
+#endif /* LoPassCoefficientCache_hpp */
@@ -0,0 +1,355 @@
+//
+//  LoPassControlRate.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassControlRate.hpp"
+#include "LoPassFastMath.h"
+#include <math.h>
+
+// Smoothing stops once both parameters are this close to their targets.
+static constexpr double kSettledLogFreq     = 1e-5;     // ~0.002% of the cutoff
+static constexpr double kSettledResonance   = 1e-4;     // dB
+
+// The longer period is only used when a time constant spans at least this many periods,
+// which keeps the straight line interpolation close to the exponential it stands in for.
+static constexpr double kPeriodsPerTimeConstant = 8.0;
+
+static void SaveCoefficients(LoPassStateWriter &ioWriter, const LoPassCoefficients &inCoefficients) {
+    
+    const double values[5] = { inCoefficients.mA0, inCoefficients.mA1, inCoefficients.mA2,
+                               inCoefficients.mB1, inCoefficients.mB2 };
+    ioWriter.PutDoubles(values, 5);
+}
+
+static void LoadCoefficients(LoPassStateReader &ioReader, LoPassCoefficients &outCoefficients) {
+    
+    double values[5];
+    ioReader.GetDoubles(values, 5);
+    
+    outCoefficients.mA0 = values[0];
+    outCoefficients.mA1 = values[1];
+    outCoefficients.mA2 = values[2];
+    outCoefficients.mB1 = values[3];
+    outCoefficients.mB2 = values[4];
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::LoPassControlRate()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassControlRate::LoPassControlRate(double inSampleRate) :
+    mSampleRate(inSampleRate),
+    mDesignMode(kLoPassDesign_Filter),
+    mSmoothingTime(0.0),
+    mFixedInterval(0),
+    mInterval(kControlRate_MinInterval),
+    mTargetFreq(-1.0),
+    mTargetResonance(0.0),
+    mTarget(LoPassDouble2::Set(0.0)),
+    mCurrent(LoPassDouble2::Set(0.0)),
+    mStep(LoPassDouble2::Set(1.0)),
+    mPrimed(false),
+    mSmoothing(false),
+    mDesigns(0) {
+    
+    LoPassFilter::CalculateLopassParams(0.5, 0.0, mCoefficients);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::SetSampleRate()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::SetSampleRate(double inSampleRate) {
+    
+    mSampleRate = inSampleRate;
+    UpdateRate();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::SetSmoothingTime()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::SetSmoothingTime(double inSeconds) {
+    
+    if (inSeconds < 0.0) { inSeconds = 0.0; }
+    if (inSeconds == mSmoothingTime) { return; }
+    
+    mSmoothingTime = inSeconds;
+    UpdateRate();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::SetInterval()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::SetInterval(unsigned inInterval) {
+    
+    if (inInterval != 0 && inInterval < kControlRate_MinInterval) { inInterval = kControlRate_MinInterval; }
+    if (inInterval > kControlRate_MaxInterval) { inInterval = kControlRate_MaxInterval; }
+    
+    mFixedInterval = inInterval;
+    UpdateRate();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::UpdateRate()
+//
+// picks the control period and the matching one-pole step
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::UpdateRate() {
+    
+    double timeConstant = mSmoothingTime * mSampleRate; // in samples
+    
+    if (mFixedInterval != 0) {
+        mInterval = mFixedInterval;
+    } else {
+        mInterval = kControlRate_MaxInterval;
+        while (mInterval > kControlRate_MinInterval && timeConstant < kPeriodsPerTimeConstant * mInterval) {
+            mInterval /= 2;
+        }
+    }
+    
+    double step = timeConstant > 0.0 ? 1.0 - exp(-(double)mInterval / timeConstant) : 1.0;
+    mStep = LoPassDouble2::Set(step);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::SetTarget()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::SetTarget(double inFreq, double inResonance) {
+    
+    if (mPrimed && inFreq == mTargetFreq && inResonance == mTargetResonance) { return; }
+    
+    const double target[2] = { log10(inFreq), inResonance };
+    mTarget = LoPassDouble2::Load(target);
+    
+    mTargetFreq         = inFreq;
+    mTargetResonance    = inResonance;
+    
+    if (!mPrimed || mSmoothingTime == 0.0) {
+        // no history to smooth from, or smoothing is off
+        mCurrent    = mTarget;
+        mSmoothing  = false;
+        mPrimed     = true;
+        Design();
+    } else {
+        mSmoothing  = true;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::Advance()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::Advance(LoPassCoefficients &outIncrement) {
+    
+    const LoPassCoefficients previous = mCoefficients;
+    
+    if (mSmoothing) {
+        mCurrent = mCurrent + (mTarget - mCurrent) * mStep;
+        
+        double current[2], target[2];
+        mCurrent.Store(current);
+        mTarget.Store(target);
+        
+        if (fabs(target[0] - current[0]) < kSettledLogFreq && fabs(target[1] - current[1]) < kSettledResonance) {
+            mCurrent    = mTarget;
+            mSmoothing  = false;
+        }
+        
+        Design();
+    }
+    
+    const double scale = 1.0 / mInterval;
+    
+    outIncrement.mA0 = (mCoefficients.mA0 - previous.mA0) * scale;
+    outIncrement.mA1 = (mCoefficients.mA1 - previous.mA1) * scale;
+    outIncrement.mA2 = (mCoefficients.mA2 - previous.mA2) * scale;
+    outIncrement.mB1 = (mCoefficients.mB1 - previous.mB1) * scale;
+    outIncrement.mB2 = (mCoefficients.mB2 - previous.mB2) * scale;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::Design()
+//
+// only a design the parameters have settled on is worth sharing
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::Design() {
+    
+    double current[2];
+    mCurrent.Store(current);
+    mDesigns++;
+    
+    if (mSmoothing) {
+        LoPassFilter::CalculateLopassParams(LoPassExp10(current[0]), current[1], mCoefficients);
+    } else {
+        LoPassCoefficientCache::Design(mSampleRate, LoPassExp10(current[0]), current[1], mDesignMode, mCoefficients);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::SaveState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::SaveState(LoPassStateWriter &ioWriter) const {
+    
+    double target[2], current[2], step[2];
+    mTarget.Store(target);
+    mCurrent.Store(current);
+    mStep.Store(step);
+    
+    ioWriter.PutDouble(mSmoothingTime);
+    ioWriter.PutUInt32(mFixedInterval);
+    ioWriter.PutUInt32(mInterval);
+    ioWriter.PutDouble(mTargetFreq);
+    ioWriter.PutDouble(mTargetResonance);
+    ioWriter.PutDoubles(target, 2);
+    ioWriter.PutDoubles(current, 2);
+    ioWriter.PutDoubles(step, 2);
+    ioWriter.PutBool(mPrimed);
+    ioWriter.PutBool(mSmoothing);
+    SaveCoefficients(ioWriter, mCoefficients);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassControlRate::LoadState()
+//
+// The step is loaded as saved rather than worked out again, so it is the same to the bit
+// whatever the maths library.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassControlRate::LoadState(LoPassStateReader &ioReader) {
+    
+    double target[2], current[2], step[2];
+    
+    mSmoothingTime      = ioReader.GetDouble();
+    mFixedInterval      = ioReader.GetUInt32();
+    mInterval           = ioReader.GetUInt32();
+    mTargetFreq         = ioReader.GetDouble();
+    mTargetResonance    = ioReader.GetDouble();
+    ioReader.GetDoubles(target, 2);
+    ioReader.GetDoubles(current, 2);
+    ioReader.GetDoubles(step, 2);
+    mPrimed             = ioReader.GetBool();
+    mSmoothing          = ioReader.GetBool();
+    LoadCoefficients(ioReader, mCoefficients);
+    
+    if (mInterval < kControlRate_MinInterval || mInterval > kControlRate_MaxInterval) { ioReader.Fail(); }
+    if (mFixedInterval != 0 && mFixedInterval != mInterval) { ioReader.Fail(); }
+    
+    if (!ioReader.IsOK()) {
+        // leave something that runs, the caller resets anyway
+        mFixedInterval  = 0;
+        mSmoothingTime  = 0.0;
+        mPrimed         = false;
+        UpdateRate();
+        return;
+    }
+    
+    mTarget     = LoPassDouble2::Load(target);
+    mCurrent    = LoPassDouble2::Load(current);
+    mStep       = LoPassDouble2::Load(step);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSmoothedBiquad::LoPassSmoothedBiquad()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassSmoothedBiquad::LoPassSmoothedBiquad(double inSampleRate) :
+    mControlRate(inSampleRate),
+    mCoefficients(mControlRate.GetCoefficients()),
+    mIncrement(),
+    mRampFrames(0),
+    mParallel(NULL) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSmoothedBiquad::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassSmoothedBiquad::Reset() {
+    
+    mBiquad.Reset();
+    mControlRate.Reset();
+    mRampFrames = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSmoothedBiquad::Process()
+//
+// ramps the coefficients one control period at a time until the parameters settle
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassSmoothedBiquad::Process(const float  *inSourceP,
+                                   float        *inDestP,
+                                   unsigned     inFramesToProcess) {
+    
+    const float *sourceP    = inSourceP;
+    float *destP            = inDestP;
+    unsigned n              = inFramesToProcess;
+    
+    while (n > 0) {
+        
+        if (mRampFrames == 0) {
+            
+            if (!mControlRate.IsSmoothing()) {
+                mCoefficients = mControlRate.GetCoefficients();
+                if (mParallel != NULL) {
+                    mParallel->Process(mBiquad, mCoefficients, sourceP, destP, n);
+                } else {
+                    mBiquad.Process(mCoefficients, sourceP, destP, n);
+                }
+                return;
+            }
+            
+            mControlRate.Advance(mIncrement);
+            mRampFrames = mControlRate.GetInterval();
+        }
+        
+        unsigned frames = n < mRampFrames ? n : mRampFrames;
+        mBiquad.ProcessRamp(mCoefficients, mIncrement, sourceP, destP, frames);
+        
+        mRampFrames -= frames;
+        sourceP     += frames;
+        destP       += frames;
+        n           -= frames;
+        
+        // land exactly on the new design
+        if (mRampFrames == 0) { mCoefficients = mControlRate.GetCoefficients(); }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSmoothedBiquad::SaveState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassSmoothedBiquad::SaveState(LoPassStateWriter &ioWriter) const {
+    
+    mControlRate.SaveState(ioWriter);
+    mBiquad.SaveState(ioWriter);
+    SaveCoefficients(ioWriter, mCoefficients);
+    SaveCoefficients(ioWriter, mIncrement);
+    ioWriter.PutUInt32(mRampFrames);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSmoothedBiquad::LoadState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassSmoothedBiquad::LoadState(LoPassStateReader &ioReader) {
+    
+    mControlRate.LoadState(ioReader);
+    mBiquad.LoadState(ioReader);
+    LoadCoefficients(ioReader, mCoefficients);
+    LoadCoefficients(ioReader, mIncrement);
+    mRampFrames = ioReader.GetUInt32();
+    
+    if (mRampFrames > mControlRate.GetInterval()) { ioReader.Fail(); }
+    if (!ioReader.IsOK()) { Reset(); }
+}
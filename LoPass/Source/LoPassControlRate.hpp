@@ -0,0 +1,145 @@
+//
+//  LoPassControlRate.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassControlRate_hpp
+#define LoPassControlRate_hpp
+
+#include "LoPassFilter.hpp"
+#include "LoPassBiquad.hpp"
+#include "LoPassCoefficientCache.hpp"
+#include "LoPassParallel.hpp"
+#include "LoPassSIMD.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Control Rate Engine
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Parameter targets are smoothed by a one-pole per parameter, stepped once per control
+// period of N samples rather than per sample. Cutoff is smoothed as log10 of the normalised
+// frequency so sweeps move evenly in octaves; both smoothers run side by side in one
+// LoPassDouble2.
+//
+// At the end of each period the biquad is redesigned and the caller interpolates the
+// coefficients linearly across the period. The stable region of (b1, b2) is a triangle, so
+// every point on the line between two stable designs is stable too.
+//
+// Settled designs go through the shared LoPassCoefficientCache; the points along a sweep
+// are designed directly, as they are rarely asked for twice.
+
+/// Control period bounds in samples.
+static constexpr unsigned kControlRate_MinInterval  = 16;
+static constexpr unsigned kControlRate_MaxInterval  = 32;
+
+class LoPassControlRate {
+    
+public:
+    LoPassControlRate(double inSampleRate);
+    
+    void SetSampleRate(double inSampleRate);
+    
+    /// One-pole time constant in seconds; 0 makes parameter changes take effect immediately.
+    /// The control period is chosen from this unless fixed with SetInterval().
+    void SetSmoothingTime(double inSeconds);
+    
+    /// Fix the control period (clamped to the bounds above); 0 selects it automatically.
+    void SetInterval(unsigned inInterval);
+    
+    unsigned GetInterval() const { return mInterval; }
+    
+    /// Who is designing, for the coefficient cache. kLoPassDesign_Filter unless set.
+    void SetDesignMode(LoPassDesignMode inMode) { mDesignMode = inMode; }
+    
+    /// inFreq is normalised frequency 0 -> 1, inResonance is in decibels.
+    void SetTarget(double inFreq, double inResonance);
+    
+    /// Jump straight to the current target on the next SetTarget().
+    void Reset() { mPrimed = false; }
+    
+    bool IsSmoothing() const { return mSmoothing; }
+    
+    /// Biquad designs since construction, settled or along a sweep; for telemetry.
+    uint64_t GetDesignCount() const { return mDesigns; }
+    
+    /// The design at the end of the most recent control period.
+    const LoPassCoefficients &GetCoefficients() const { return mCoefficients; }
+    
+    /// Step the smoothers over one control period and redesign. outIncrement receives the
+    /// per sample step from the previous design to the new one.
+    void Advance(LoPassCoefficients &outIncrement);
+    
+    /// Smoothing settings, targets and the smoothers' positions, see LoPassState.hpp.
+    /// The sample rate is left alone; it belongs to whoever owns this.
+    void SaveState(LoPassStateWriter &ioWriter) const;
+    void LoadState(LoPassStateReader &ioReader);
+    
+private:
+    void UpdateRate();
+    void Design();
+    
+    double              mSampleRate;
+    LoPassDesignMode    mDesignMode;
+    double              mSmoothingTime;
+    unsigned            mFixedInterval;
+    unsigned            mInterval;
+    
+    double              mTargetFreq;
+    double              mTargetResonance;
+    
+    // { log10(normalised cutoff), resonance in dB }
+    LoPassDouble2       mTarget;
+    LoPassDouble2       mCurrent;
+    LoPassDouble2       mStep;          // one-pole coefficient per control period
+    
+    bool                mPrimed;
+    bool                mSmoothing;
+    LoPassCoefficients  mCoefficients;
+    uint64_t            mDesigns;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Smoothed Biquad
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// One channel of the IIR filter driven by a LoPassControlRate: coefficients ramp across
+/// each control period while the parameters move, and stay fixed once they settle.
+class LoPassSmoothedBiquad {
+    
+public:
+    LoPassSmoothedBiquad(double inSampleRate);
+    
+    LoPassControlRate &GetControlRate() { return mControlRate; }
+    const LoPassControlRate &GetControlRate() const { return mControlRate; }
+    
+    /// The coefficients in use at the current sample.
+    const LoPassCoefficients &GetCoefficients() const { return mCoefficients; }
+    
+    /// Run settled stretches across threads (offline only); NULL to run serially.
+    void SetParallel(LoPassParallelBiquad *inParallel) { mParallel = inParallel; }
+    
+    /// inFreq is normalised frequency 0 -> 1, inResonance is in decibels.
+    void SetTarget(double inFreq, double inResonance) { mControlRate.SetTarget(inFreq, inResonance); }
+    
+    /// Clear the filter state; the next target is jumped to rather than smoothed.
+    void Reset();
+    
+    void Process(const float *inSourceP, float *inDestP, unsigned inFramesToProcess);
+    
+    /// Everything but the parallel runner, see LoPassState.hpp. Loading mid ramp carries
+    /// on down the same ramp.
+    void SaveState(LoPassStateWriter &ioWriter) const;
+    void LoadState(LoPassStateReader &ioReader);
+    
+private:
+    LoPassControlRate   mControlRate;
+    LoPassBiquad        mBiquad;
+    LoPassCoefficients  mCoefficients;
+    LoPassCoefficients  mIncrement;
+    unsigned            mRampFrames;    // samples left in the current control period
+    
+    LoPassParallelBiquad *mParallel;
+};
+
+#endif /* LoPassControlRate_hpp */
@@ -0,0 +1,169 @@
+//
+//  LoPassFFT.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassFFT.hpp"
+#include <math.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFFT::LoPassFFT()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassFFT::LoPassFFT(unsigned inSize) :
+    mSize(inSize),
+    mHalfSize(inSize / 2),
+    mBitReverse(inSize / 2),
+    mCos(inSize / 4),
+    mSin(inSize / 4),
+    mSplitCos(inSize / 2 + 1),
+    mSplitSin(inSize / 2 + 1),
+    mWorkReal(inSize / 2),
+    mWorkImag(inSize / 2) {
+    
+    unsigned bits = 0;
+    while ((1u << bits) < mHalfSize) { bits++; }
+    
+    for (unsigned i = 0; i < mHalfSize; i++) {
+        unsigned r = 0;
+        for (unsigned b = 0; b < bits; b++) {
+            if (i & (1u << b)) { r |= 1u << (bits - 1 - b); }
+        }
+        mBitReverse[i] = r;
+    }
+    
+    for (unsigned i = 0; i < mHalfSize / 2; i++) {
+        double phase = -2.0 * M_PI * i / mHalfSize;
+        mCos[i] = cos(phase);
+        mSin[i] = sin(phase);
+    }
+    
+    for (unsigned i = 0; i <= mHalfSize; i++) {
+        double phase = -2.0 * M_PI * i / mSize;
+        mSplitCos[i] = cos(phase);
+        mSplitSin[i] = sin(phase);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFFT::Transform()
+//
+// In place complex transform of mHalfSize points (decimation in time).
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFFT::Transform(float *ioReal, float *ioImag, bool inInverse) {
+    
+    const unsigned n = mHalfSize;
+    
+    for (unsigned i = 0; i < n; i++) {
+        unsigned j = mBitReverse[i];
+        if (j > i) {
+            float t = ioReal[i]; ioReal[i] = ioReal[j]; ioReal[j] = t;
+            t = ioImag[i]; ioImag[i] = ioImag[j]; ioImag[j] = t;
+        }
+    }
+    
+    const float sign = inInverse ? -1.0f : 1.0f;
+    
+    for (unsigned len = 2; len <= n; len <<= 1) {
+        unsigned half = len >> 1;
+        unsigned step = n / len;
+        
+        for (unsigned i = 0; i < n; i += len) {
+            for (unsigned j = 0; j < half; j++) {
+                float wr = mCos[j * step];
+                float wi = sign * mSin[j * step];
+                
+                unsigned a = i + j;
+                unsigned b = a + half;
+                
+                float tr = ioReal[b] * wr - ioImag[b] * wi;
+                float ti = ioReal[b] * wi + ioImag[b] * wr;
+                
+                ioReal[b] = ioReal[a] - tr;
+                ioImag[b] = ioImag[a] - ti;
+                ioReal[a] += tr;
+                ioImag[a] += ti;
+            }
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFFT::Forward()
+//
+// The real input is packed into a half size complex sequence (even samples real,
+// odd samples imaginary), transformed, then split into the real spectrum.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFFT::Forward(const float *inTime, float *outReal, float *outImag) {
+    
+    const unsigned n = mHalfSize;
+    float *zr = &mWorkReal[0];
+    float *zi = &mWorkImag[0];
+    
+    for (unsigned k = 0; k < n; k++) {
+        zr[k] = inTime[2 * k];
+        zi[k] = inTime[2 * k + 1];
+    }
+    
+    Transform(zr, zi, false);
+    
+    for (unsigned k = 0; k <= n; k++) {
+        unsigned a = (k == n) ? 0 : k;
+        unsigned b = (k == 0) ? 0 : n - k;
+        
+        // even and odd sample spectra
+        float er = 0.5f * (zr[a] + zr[b]);
+        float ei = 0.5f * (zi[a] - zi[b]);
+        float or_ = 0.5f * (zi[a] + zi[b]);
+        float oi = -0.5f * (zr[a] - zr[b]);
+        
+        float wr = mSplitCos[k];
+        float wi = mSplitSin[k];
+        
+        outReal[k] = er + or_ * wr - oi * wi;
+        outImag[k] = ei + or_ * wi + oi * wr;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFFT::Inverse()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFFT::Inverse(const float *inReal, const float *inImag, float *outTime) {
+    
+    const unsigned n = mHalfSize;
+    float *zr = &mWorkReal[0];
+    float *zi = &mWorkImag[0];
+    
+    for (unsigned k = 0; k < n; k++) {
+        unsigned b = n - k;
+        
+        // recombine the even and odd sample spectra
+        float er = 0.5f * (inReal[k] + inReal[b]);
+        float ei = 0.5f * (inImag[k] - inImag[b]);
+        float dr = 0.5f * (inReal[k] - inReal[b]);
+        float di = 0.5f * (inImag[k] + inImag[b]);
+        
+        // odd spectrum = d * conj(w)
+        float wr = mSplitCos[k];
+        float wi = mSplitSin[k];
+        float or_ = dr * wr + di * wi;
+        float oi = di * wr - dr * wi;
+        
+        zr[k] = er - oi;
+        zi[k] = ei + or_;
+    }
+    
+    Transform(zr, zi, true);
+    
+    const float scale = 1.0f / n;
+    
+    for (unsigned k = 0; k < n; k++) {
+        outTime[2 * k]      = zr[k] * scale;
+        outTime[2 * k + 1]  = zi[k] * scale;
+    }
+}
@@ -0,0 +1,55 @@
+//
+//  LoPassFFT.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassFFT_hpp
+#define LoPassFFT_hpp
+
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFFT
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Radix-2 real FFT working on split complex spectra of inSize / 2 + 1 bins.
+/// All tables and scratch memory are allocated up front, so Forward and Inverse
+/// are safe to call on the render thread. An instance must only be used by one thread at a time.
+class LoPassFFT {
+    
+public:
+    /// inSize is the real transform length and must be a power of two (>= 4).
+    LoPassFFT(unsigned inSize);
+    
+    unsigned GetSize() const { return mSize; }
+    unsigned GetNumberOfBins() const { return mSize / 2 + 1; }
+    
+    /// Time domain (inSize samples) to spectrum (inSize / 2 + 1 bins).
+    void Forward(const float *inTime, float *outReal, float *outImag);
+    
+    /// Spectrum to time domain, scaled so that Inverse(Forward(x)) == x.
+    void Inverse(const float *inReal, const float *inImag, float *outTime);
+    
+private:
+    void Transform(float *ioReal, float *ioImag, bool inInverse);
+    
+    unsigned                mSize;
+    unsigned                mHalfSize;
+    
+    std::vector<unsigned>   mBitReverse;
+    
+    // twiddles for the half size complex transform
+    std::vector<float>      mCos;
+    std::vector<float>      mSin;
+    
+    // twiddles for splitting the packed real transform
+    std::vector<float>      mSplitCos;
+    std::vector<float>      mSplitSin;
+    
+    std::vector<float>      mWorkReal;
+    std::vector<float>      mWorkImag;
+};
+
+#endif /* LoPassFFT_hpp */
@@ -0,0 +1,220 @@
+//
+//  LoPassFastMath.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassFastMath_h
+#define LoPassFastMath_h
+
+#include "LoPassSIMD.h"
+#include <stdint.h>
+#include <string.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Fast Math
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Bounded-error replacements for the libm calls used by the coefficient design, in the
+// spirit of the small inline helpers in CAMath.h. Each function is a fixed polynomial after
+// a branch free range reduction, written once as a template so the same code runs on
+// double and on LoPassDouble2 (SSE2 / NEON).
+//
+// Maximum errors below were measured against long double libm by Tools/LoPassAccuracy.cpp
+// and are guaranteed only inside the stated domains.
+//
+//  LoPassSinCosPi(x)       |x| <= 2^20         absolute error <= 1.6e-16 (sin and cos)
+//  LoPassTanHalfPi(x)      |x| <= 0.999        relative error <= 4.5e-16
+//  LoPassExp10(x)          |x| <= 1            relative error <= 4.0e-16
+//  LoPassExp10(x)          |x| <= 30           relative error <= 8.5e-15 (rounding of x * log2(10))
+//
+// The scalar and vector forms return bit identical results. Through the full design the
+// magnitude response stays within 2.0e-7 dB of a long double reference; the worst case is
+// the lowest cutoff at full resonance.
+//
+// The bounds are also the constants below, which LoPassAccuracy checks against, so a change
+// here that the measurement doesn't support fails the tool.
+
+static constexpr double kLoPassFastMath_MaxSinCosError      = 1.6e-16;
+static constexpr double kLoPassFastMath_MaxTanHalfPiError   = 4.5e-16;
+static constexpr double kLoPassFastMath_MaxExp10Error       = 4.0e-16;
+static constexpr double kLoPassFastMath_MaxExp10WideError   = 8.5e-15;
+static constexpr double kLoPassFastMath_MaxResponseErrorDB  = 2.0e-7;
+
+static constexpr double kLoPassFastMath_Magic   = 6755399441055744.0; // 1.5 * 2^52
+static constexpr double kLoPassFastMath_Log2Of10 = 3.32192809488736218e+00;
+
+//~~~~ double helpers
+
+/// Round to nearest integer, valid for |x| < 2^51.
+inline double LoPassRoundToInteger(double x) { return (x + kLoPassFastMath_Magic) - kLoPassFastMath_Magic; }
+
+/// Returns inIfOdd when the integer valued n is odd, inIfEven otherwise.
+inline double LoPassSelectIfOdd(double n, double inIfOdd, double inIfEven) {
+    return (static_cast<int64_t>(n) & 1) ? inIfOdd : inIfEven;
+}
+
+/// Negates x when bit 1 of the integer valued n is set.
+inline double LoPassNegateIfBit1(double n, double x) {
+    return (static_cast<int64_t>(n) & 2) ? -x : x;
+}
+
+/// x * 2^n for an integer valued n, assuming the result stays normal.
+inline double LoPassScaleByPow2(double x, double n) {
+    int64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits += static_cast<int64_t>(static_cast<uint64_t>(static_cast<int64_t>(n)) << 52);
+    memcpy(&x, &bits, sizeof(bits));
+    return x;
+}
+
+//~~~~ LoPassDouble2 helpers
+
+inline LoPassDouble2 LoPassRoundToInteger(const LoPassDouble2 &x) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    const __m128d magic = _mm_set1_pd(kLoPassFastMath_Magic);
+    r.v = _mm_sub_pd(_mm_add_pd(x.v, magic), magic);
+#elif LOPASS_SIMD_NEON
+    r.v = vrndnq_f64(x.v);
+#else
+    r.v[0] = LoPassRoundToInteger(x.v[0]);
+    r.v[1] = LoPassRoundToInteger(x.v[1]);
+#endif
+    return r;
+}
+
+#if LOPASS_SIMD_SSE
+// Integer valued doubles to int64 lanes. SSE2 has no direct conversion, so the value is
+// placed in the low mantissa bits by adding the magic number and the magic is then removed.
+inline __m128i LoPassToInt64(__m128d n) {
+    const __m128d magic = _mm_set1_pd(kLoPassFastMath_Magic);
+    return _mm_sub_epi64(_mm_castpd_si128(_mm_add_pd(n, magic)), _mm_castpd_si128(magic));
+}
+#endif
+
+inline LoPassDouble2 LoPassSelectIfOdd(const LoPassDouble2 &n, const LoPassDouble2 &inIfOdd, const LoPassDouble2 &inIfEven) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    const __m128i one = _mm_set1_epi64x(1);
+    __m128i odd = _mm_cmpeq_epi32(_mm_and_si128(LoPassToInt64(n.v), one), one);
+    __m128d mask = _mm_castsi128_pd(_mm_shuffle_epi32(odd, _MM_SHUFFLE(2, 2, 0, 0)));
+    r.v = _mm_or_pd(_mm_and_pd(mask, inIfOdd.v), _mm_andnot_pd(mask, inIfEven.v));
+#elif LOPASS_SIMD_NEON
+    uint64x2_t mask = vtstq_s64(vcvtq_s64_f64(n.v), vdupq_n_s64(1));
+    r.v = vbslq_f64(mask, inIfOdd.v, inIfEven.v);
+#else
+    r.v[0] = LoPassSelectIfOdd(n.v[0], inIfOdd.v[0], inIfEven.v[0]);
+    r.v[1] = LoPassSelectIfOdd(n.v[1], inIfOdd.v[1], inIfEven.v[1]);
+#endif
+    return r;
+}
+
+inline LoPassDouble2 LoPassNegateIfBit1(const LoPassDouble2 &n, const LoPassDouble2 &x) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    // bit 1 shifted up into the sign bit (bit 0 lands in bit 62 and is masked off)
+    __m128i sign = _mm_and_si128(_mm_slli_epi64(LoPassToInt64(n.v), 62), _mm_set1_epi64x(INT64_MIN));
+    r.v = _mm_xor_pd(x.v, _mm_castsi128_pd(sign));
+#elif LOPASS_SIMD_NEON
+    int64x2_t sign = vandq_s64(vshlq_n_s64(vcvtq_s64_f64(n.v), 62), vdupq_n_s64(INT64_MIN));
+    r.v = vreinterpretq_f64_s64(veorq_s64(vreinterpretq_s64_f64(x.v), sign));
+#else
+    r.v[0] = LoPassNegateIfBit1(n.v[0], x.v[0]);
+    r.v[1] = LoPassNegateIfBit1(n.v[1], x.v[1]);
+#endif
+    return r;
+}
+
+inline LoPassDouble2 LoPassScaleByPow2(const LoPassDouble2 &x, const LoPassDouble2 &n) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_castsi128_pd(_mm_add_epi64(_mm_castpd_si128(x.v), _mm_slli_epi64(LoPassToInt64(n.v), 52)));
+#elif LOPASS_SIMD_NEON
+    r.v = vreinterpretq_f64_s64(vaddq_s64(vreinterpretq_s64_f64(x.v), vshlq_n_s64(vcvtq_s64_f64(n.v), 52)));
+#else
+    r.v[0] = LoPassScaleByPow2(x.v[0], n.v[0]);
+    r.v[1] = LoPassScaleByPow2(x.v[1], n.v[1]);
+#endif
+    return r;
+}
+
+inline LoPassDouble2 operator*(const LoPassDouble2 &a, double b) { return a * LoPassDouble2::Set(b); }
+inline LoPassDouble2 operator+(const LoPassDouble2 &a, double b) { return a + LoPassDouble2::Set(b); }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Approximations
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// sin(pi x) and cos(pi x).
+/// x is reduced to x = n / 2 + r with |r| <= 1/4, where degree 17 / 18 polynomials
+/// are accurate to well below one ulp; the quadrant n then swaps and negates the results.
+/// Exact at the multiples of 1/2, so cos stays fully accurate next to z = 1.
+template <class T>
+inline void LoPassSinCosPi(const T &x, T &outSin, T &outCos) {
+
+    T n = LoPassRoundToInteger(x * 2.0);
+    T r = x - n * 0.5;
+    T z = r * r;
+
+    T s = ((((((((z *  7.95205400147551261e-07
+                    + -2.19153534478302173e-05) * z
+                    +  4.66302805767612554e-04) * z
+                    + -7.37043094571435044e-03) * z
+                    +  8.21458866111282326e-02) * z
+                    + -5.99264529320792105e-01) * z
+                    +  2.55016403987734552e+00) * z
+                    + -5.16771278004997026e+00) * z
+                    +  3.14159265358979312e+00) * r;
+
+    T c = ((((((((z * -1.38789524622137714e-07
+                     +  4.30306958703294729e-06) * z
+                     + -1.04638104924845705e-04) * z
+                     +  1.92957430940392314e-03) * z
+                     + -2.58068913900140612e-02) * z
+                     +  2.35330630358893206e-01) * z
+                     + -1.33526276885458950e+00) * z
+                     +  4.05871212641676848e+00) * z
+                     + -4.93480220054467900e+00) * z
+                     +  1.0;
+
+    outSin = LoPassNegateIfBit1(n, LoPassSelectIfOdd(n, c, s));
+    outCos = LoPassNegateIfBit1(n + 1.0, LoPassSelectIfOdd(n, s, c));
+}
+
+/// tan(pi x / 2), for |x| < 1.
+template <class T>
+inline T LoPassTanHalfPi(const T &x) {
+
+    T s, c;
+    LoPassSinCosPi(x * 0.5, s, c);
+    return s / c;
+}
+
+/// 10^x, as 2^n * 2^f with |f| <= 1/2 and a degree 13 polynomial for 2^f.
+template <class T>
+inline T LoPassExp10(const T &x) {
+
+    T t = x * kLoPassFastMath_Log2Of10;
+    T n = LoPassRoundToInteger(t);
+    T f = t - n;
+
+    T p = (((((((((((( f *  1.36914888539041281e-12
+                          +  2.56784359934882055e-11) * f
+                          +  4.44553827187081162e-10) * f
+                          +  7.05491162080112336e-09) * f
+                          +  1.01780860092396999e-07) * f
+                          +  1.32154867901443095e-06) * f
+                          +  1.52527338040598411e-05) * f
+                          +  1.54035303933816088e-04) * f
+                          +  1.33335581464284433e-03) * f
+                          +  9.61812910762847688e-03) * f
+                          +  5.55041086648215831e-02) * f
+                          +  2.40226506959100722e-01) * f
+                          +  6.93147180559945286e-01) * f
+                          +  1.0;
+
+    return LoPassScaleByPow2(p, n);
+}
+
+#endif /* LoPassFastMath_h */
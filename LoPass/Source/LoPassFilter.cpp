@@ -0,0 +1,133 @@
+//
+//  LoPassFilter.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassFilter.hpp"
+#include "LoPassFastMath.h"
+#include <math.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilter::CalculateLopassParams()
+//
+// inFreq is normalised frequency 0 -> 1
+// inResonance is in decibels
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilter::CalculateLopassParams(double                 inFreq,
+                                         double                 inResonance,
+                                         LoPassCoefficients     &outCoefficients) {
+    
+    // Convert from decibels to linear
+    double r = LoPassExp10(0.05 * -inResonance);
+    
+    /* The original formulation,
+         k  = 0.5 * r * sin(pi f)
+         c1 = 0.5 * (1 - k) / (1 + k)
+         c2 = (0.5 + c1) * cos(pi f)
+         c3 = (0.5 + c1 - c2) * 0.25
+     loses most of c3 to cancellation when f is small. With s = sin^2(pi f / 2) and
+     K = 1 + k the same quantities are c1 = 0.5 (1 - k) / K, c2 = (1 - 2s) / K and
+     c3 = 0.5 s / K, which need no subtraction of nearly equal values. */
+    double sinHalf, cosHalf;
+    LoPassSinCosPi(0.5 * inFreq, sinHalf, cosHalf);
+    
+    double s        = sinHalf * sinHalf;
+    double sinPiF   = 2.0 * sinHalf * cosHalf;
+    double cosPiF   = (cosHalf - sinHalf) * (cosHalf + sinHalf);
+    
+    double k        = 0.5 * r * sinPiF;
+    double scale    = 1.0 / (1.0 + k);
+    
+    double c1   = 0.5 * (1.0 - k) * scale;
+    double c2   = cosPiF * scale;
+    double c3   = 0.5 * s * scale;
+    
+    outCoefficients.mA0 = 2.0 *     c3;
+    outCoefficients.mA1 = 2.0 *     2.0 * c3;
+    outCoefficients.mA2 = 2.0 *     c3;
+    outCoefficients.mB1 = 2.0 *     -c2;
+    outCoefficients.mB2 = 2.0 *     c1;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFrequencyResponse()
+//
+// shared by the scalar and vector forms of GetFrequencyResponse()
+// the ratio of the squared magnitudes needs only the one square root
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static inline double Sqrt(double x) { return sqrt(x); }
+
+template <class T>
+static inline T LoPassFrequencyResponse(const LoPassCoefficients &c, const T &inScaledFrequency) {
+    
+    // frequency on unit circle in z-plane
+    T zr, zi;
+    LoPassSinCosPi(inScaledFrequency, zi, zr);
+    
+    // zeros respone
+    T num_r = (zr*zr - zi*zi) * c.mA0 + zr * c.mA1 + c.mA2;
+    T num_i = zr * zi * (2.0 * c.mA0) + zi * c.mA1;
+    
+    // poles response
+    T den_r = zr * zr - zi * zi + zr * c.mB1 + c.mB2;
+    T den_i = zr * zi * 2.0 + zi * c.mB1;
+    
+    // total response
+    return Sqrt((num_r * num_r + num_i * num_i) / (den_r * den_r + den_i * den_i));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilter::GetFrequencyResponse()
+//
+// returns a scalar magnitude response
+// inScaledFrequency is normalised frequency 0 -> 1
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+double LoPassFilter::GetFrequencyResponse(const LoPassCoefficients  &inCoefficients,
+                                          double                    inScaledFrequency) {
+    
+    return LoPassFrequencyResponse(inCoefficients, inScaledFrequency);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilter::GetFrequencyResponse()
+//
+// batch form, results are identical to the scalar form
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilter::GetFrequencyResponse(const LoPassCoefficients    &inCoefficients,
+                                        const double                *inScaledFrequencies,
+                                        double                      *outResponses,
+                                        unsigned                    inCount) {
+    unsigned i = 0;
+    
+    for (; i + 2 <= inCount; i += 2) {
+        LoPassDouble2 f = LoPassDouble2::Load(inScaledFrequencies + i);
+        LoPassFrequencyResponse(inCoefficients, f).Store(outResponses + i);
+    }
+    
+    for (; i < inCount; i++) {
+        outResponses[i] = LoPassFrequencyResponse(inCoefficients, inScaledFrequencies[i]);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilter::GetDecayFrames()
+//
+// The impulse response decays as r^n for the largest pole radius r: sqrt(b2) for a complex
+// pair, the larger root for real poles.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+double LoPassFilter::GetDecayFrames(const LoPassCoefficients &inCoefficients, double inLevel) {
+    
+    double discriminant = inCoefficients.mB1 * inCoefficients.mB1 - 4.0 * inCoefficients.mB2;
+    double radius = discriminant >= 0.0 ? 0.5 * (fabs(inCoefficients.mB1) + sqrt(discriminant)) : sqrt(inCoefficients.mB2);
+    
+    if (radius <= 0.0) { return 0.0; }
+    
+    return log(inLevel) / log(radius);
+}
@@ -0,0 +1,52 @@
+//
+//  LoPassFilter.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassFilter_hpp
+#define LoPassFilter_hpp
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Filter Design
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The coefficient design lives outside the kernel and has no AudioUnit dependencies,
+// so it can also be run off the render thread (e.g. by the linear-phase FIR designer).
+// The trigonometry goes through LoPassFastMath.h rather than libm; see
+// Tools/LoPassAccuracy.cpp for the error bound this gives on the response.
+
+/// Direct Form 1 biquad coefficients; mA* feed forward, mB* feed back.
+struct LoPassCoefficients {
+    double mA0;
+    double mA1;
+    double mA2;
+    double mB1;
+    double mB2;
+};
+
+class LoPassFilter {
+    
+public:
+    /// inFreq is normalised frequency 0 -> 1, inResonance is in decibels.
+    static void CalculateLopassParams(double                inFreq,
+                                      double                inResonance,
+                                      LoPassCoefficients    &outCoefficients);
+    
+    /// Returns the linear magnitude response.
+    /// inScaledFrequency is normalised frequency 0 -> 1, where 1 is Nyquist.
+    static double GetFrequencyResponse(const LoPassCoefficients &inCoefficients,
+                                       double                   inScaledFrequency);
+    
+    /// Frames for the impulse response to die away to inLevel (linear, below 1) of its size,
+    /// from the pole radius. The poles are always inside the unit circle.
+    static double GetDecayFrames(const LoPassCoefficients &inCoefficients, double inLevel);
+    
+    /// Batch form of GetFrequencyResponse(), two frequencies per vector.
+    static void GetFrequencyResponse(const LoPassCoefficients    &inCoefficients,
+                                     const double               *inScaledFrequencies,
+                                     double                     *outResponses,
+                                     unsigned                   inCount);
+};
+
+#endif /* LoPassFilter_hpp */
@@ -0,0 +1,619 @@
+//
+//  LoPassFilterBank.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassFilterBank.hpp"
+#include "LoPassCoefficientCache.hpp"
+#include "LoPassParameters.h"
+#include "LoPassSIMD.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define LOPASS_BANK_DISPATCH    1   // AVX and AVX-512 picked at run time
+#endif
+
+// AVX-512 and NEON have fused multiply-adds, which would round differently from LoPassBiquad
+#if defined(__clang__)
+    #pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+    #pragma GCC optimize ("fp-contract=off")
+#endif
+
+typedef void (*Kernel)(const double *inCoefficients, double *ioHistory, const float *inSourceP, float *inDestP, unsigned inFrames, bool inBroadcast);
+
+struct Kernels {
+    const char      *mName;
+    Kernel          mProcess;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Kernels
+//
+// inCoefficients is a0, a1, a2, b1, b2 and ioHistory x1, x2, y1, y2, each kFilterBank_Lanes
+// wide; the source and destination are interleaved. With inBroadcast the source is one mono
+// buffer that every lane reads, each sample loaded once and copied across the register. The
+// sum is the one in LoPassBiquad.cpp, term for term, so each lane rounds exactly as a
+// LoPassBiquad would.
+//
+// With GCC or clang the lanes are written as vector extension types of the width in hand, V
+// for the arithmetic and VFloat for the float samples with as many lanes. The template is
+// always inlined, so it is compiled for whatever unit the function around it targets.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#if defined(__GNUC__)
+
+template <class T, class V, class VFloat, bool kBroadcast>
+static inline __attribute__((always_inline)) void ProcessLanes(const T      *inCoefficients,
+                                                               T            *ioHistory,
+                                                               const float  *inSourceP,
+                                                               float        *inDestP,
+                                                               unsigned     inFrames) {
+
+    static constexpr unsigned kWidth    = sizeof(V) / sizeof(T);
+    static constexpr unsigned kVectors  = kFilterBank_Lanes / kWidth;
+    static constexpr unsigned kLanes    = kFilterBank_Lanes;
+
+    V a0[kVectors], a1[kVectors], a2[kVectors], b1[kVectors], b2[kVectors];
+    V x1[kVectors], x2[kVectors], y1[kVectors], y2[kVectors];
+
+    // memcpy() for unaligned loads and stores without the intrinsics of any one unit
+    for (unsigned k = 0; k < kVectors; k++) {
+        memcpy(&a0[k], inCoefficients + 0 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&a1[k], inCoefficients + 1 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&a2[k], inCoefficients + 2 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&b1[k], inCoefficients + 3 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&b2[k], inCoefficients + 4 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&x1[k], ioHistory + 0 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&x2[k], ioHistory + 1 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&y1[k], ioHistory + 2 * kLanes + k * kWidth, sizeof(V));
+        memcpy(&y2[k], ioHistory + 3 * kLanes + k * kWidth, sizeof(V));
+    }
+
+    for (unsigned i = 0; i < inFrames; i++, inSourceP += kBroadcast ? 1 : kLanes, inDestP += kLanes) {
+        for (unsigned k = 0; k < kVectors; k++) {
+
+            VFloat samples;
+            V input;
+
+            if (kBroadcast) {
+                input = V{} + T(*inSourceP);
+            } else {
+                memcpy(&samples, inSourceP + k * kWidth, sizeof(VFloat));
+                input = __builtin_convertvector(samples, V);
+            }
+
+            V output = a0[k]*input + a1[k]*x1[k] + a2[k]*x2[k] - b1[k]*y1[k] - b2[k]*y2[k];
+
+            x2[k] = x1[k];
+            x1[k] = input;
+            y2[k] = y1[k];
+            y1[k] = output;
+
+            samples = __builtin_convertvector(output, VFloat);
+            memcpy(inDestP + k * kWidth, &samples, sizeof(VFloat));
+        }
+    }
+
+    for (unsigned k = 0; k < kVectors; k++) {
+        memcpy(ioHistory + 0 * kLanes + k * kWidth, &x1[k], sizeof(V));
+        memcpy(ioHistory + 1 * kLanes + k * kWidth, &x2[k], sizeof(V));
+        memcpy(ioHistory + 2 * kLanes + k * kWidth, &y1[k], sizeof(V));
+        memcpy(ioHistory + 3 * kLanes + k * kWidth, &y2[k], sizeof(V));
+    }
+}
+
+typedef float   Float2  __attribute__((vector_size(8)));
+typedef float   Float4  __attribute__((vector_size(16)));
+typedef float   Float8  __attribute__((vector_size(32)));
+typedef double  Double2 __attribute__((vector_size(16)));
+typedef double  Double4 __attribute__((vector_size(32)));
+typedef double  Double8 __attribute__((vector_size(64)));
+
+// the baseline: SSE2 or NEON, or split up by the compiler on anything else
+static void ProcessDouble128(const double *inCoefficients, double *ioHistory, const float *inSourceP, float *inDestP, unsigned inFrames, bool inBroadcast) {
+    if (inBroadcast) {
+        ProcessLanes<double, Double2, Float2, true>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    } else {
+        ProcessLanes<double, Double2, Float2, false>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    }
+}
+
+#if LOPASS_BANK_DISPATCH
+
+__attribute__((target("avx")))
+static void ProcessDouble256(const double *inCoefficients, double *ioHistory, const float *inSourceP, float *inDestP, unsigned inFrames, bool inBroadcast) {
+    if (inBroadcast) {
+        ProcessLanes<double, Double4, Float4, true>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    } else {
+        ProcessLanes<double, Double4, Float4, false>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void ProcessDouble512(const double *inCoefficients, double *ioHistory, const float *inSourceP, float *inDestP, unsigned inFrames, bool inBroadcast) {
+    if (inBroadcast) {
+        ProcessLanes<double, Double8, Float8, true>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    } else {
+        ProcessLanes<double, Double8, Float8, false>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    }
+}
+
+#endif
+
+#else
+
+// one lane at a time, for compilers without vector extensions
+template <class T, bool kBroadcast>
+static void ProcessLanes(const T *inCoefficients, T *ioHistory, const float *inSourceP, float *inDestP, unsigned inFrames) {
+
+    static constexpr unsigned kLanes = kFilterBank_Lanes;
+
+    for (unsigned lane = 0; lane < kLanes; lane++) {
+
+        T a0 = inCoefficients[0 * kLanes + lane];
+        T a1 = inCoefficients[1 * kLanes + lane];
+        T a2 = inCoefficients[2 * kLanes + lane];
+        T b1 = inCoefficients[3 * kLanes + lane];
+        T b2 = inCoefficients[4 * kLanes + lane];
+
+        T x1 = ioHistory[0 * kLanes + lane];
+        T x2 = ioHistory[1 * kLanes + lane];
+        T y1 = ioHistory[2 * kLanes + lane];
+        T y2 = ioHistory[3 * kLanes + lane];
+
+        for (unsigned i = 0; i < inFrames; i++) {
+            T input = kBroadcast ? inSourceP[i] : inSourceP[i * kLanes + lane];
+            T output = a0*input + a1*x1 + a2*x2 - b1*y1 - b2*y2;
+
+            x2 = x1;
+            x1 = input;
+            y2 = y1;
+            y1 = output;
+
+            inDestP[i * kLanes + lane] = float(output);
+        }
+
+        ioHistory[0 * kLanes + lane] = x1;
+        ioHistory[1 * kLanes + lane] = x2;
+        ioHistory[2 * kLanes + lane] = y1;
+        ioHistory[3 * kLanes + lane] = y2;
+    }
+}
+
+static void ProcessDouble128(const double *inCoefficients, double *ioHistory, const float *inSourceP, float *inDestP, unsigned inFrames, bool inBroadcast) {
+    if (inBroadcast) {
+        ProcessLanes<double, true>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    } else {
+        ProcessLanes<double, false>(inCoefficients, ioHistory, inSourceP, inDestP, inFrames);
+    }
+}
+
+#endif
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GetKernels()
+//
+// The CPU is asked once; __builtin_cpu_supports() also checks the OS saves the registers.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static Kernels ChooseKernels() {
+
+#if LOPASS_BANK_DISPATCH
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+        Kernels kernels = { "AVX-512", ProcessDouble512 };
+        return kernels;
+    }
+
+    if (__builtin_cpu_supports("avx")) {
+        Kernels kernels = { "AVX", ProcessDouble256 };
+        return kernels;
+    }
+#endif
+
+#if LOPASS_SIMD_SSE
+    Kernels kernels = { "SSE2", ProcessDouble128 };
+#elif LOPASS_SIMD_NEON
+    Kernels kernels = { "NEON", ProcessDouble128 };
+#else
+    Kernels kernels = { "scalar", ProcessDouble128 };
+#endif
+    return kernels;
+}
+
+static const Kernels &GetKernels() {
+
+    static const Kernels kernels = ChooseKernels();
+    return kernels;
+}
+
+static inline void ProcessKernel(const double *inCoefficients, double *ioHistory, const float *inSourceP, float *inDestP, unsigned inFrames, bool inBroadcast) {
+    GetKernels().mProcess(inCoefficients, ioHistory, inSourceP, inDestP, inFrames, inBroadcast);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Interleaving
+//
+// Between one buffer per lane and one interleaved buffer, four lanes by four frames at a
+// time, with a transpose in between. Deinterleaving skips four lanes at a time where none of
+// them are in use.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void InterleaveLanes(const float *const *inSources, float *outInterleaved, unsigned inFrames) {
+
+    static constexpr unsigned kLanes = kFilterBank_Lanes;
+    unsigned i = 0;
+
+    for (; i + 4 <= inFrames; i += 4) {
+        for (unsigned lane = 0; lane < kLanes; lane += 4) {
+            LoPassFloat4 r0 = LoPassFloat4::Load(inSources[lane + 0] + i);
+            LoPassFloat4 r1 = LoPassFloat4::Load(inSources[lane + 1] + i);
+            LoPassFloat4 r2 = LoPassFloat4::Load(inSources[lane + 2] + i);
+            LoPassFloat4 r3 = LoPassFloat4::Load(inSources[lane + 3] + i);
+
+            LoPassTranspose(r0, r1, r2, r3);
+
+            r0.Store(outInterleaved + (i + 0) * kLanes + lane);
+            r1.Store(outInterleaved + (i + 1) * kLanes + lane);
+            r2.Store(outInterleaved + (i + 2) * kLanes + lane);
+            r3.Store(outInterleaved + (i + 3) * kLanes + lane);
+        }
+    }
+
+    for (; i < inFrames; i++) {
+        for (unsigned lane = 0; lane < kLanes; lane++) { outInterleaved[i * kLanes + lane] = inSources[lane][i]; }
+    }
+}
+
+static void DeinterleaveLanes(const float *inInterleaved, float *const *outDests, const bool *inActive, unsigned inFrames) {
+
+    static constexpr unsigned kLanes = kFilterBank_Lanes;
+    unsigned i = 0;
+
+    bool used[kLanes / 4];
+    for (unsigned lane = 0; lane < kLanes; lane += 4) {
+        used[lane / 4] = inActive[lane] || inActive[lane + 1] || inActive[lane + 2] || inActive[lane + 3];
+    }
+
+    for (; i + 4 <= inFrames; i += 4) {
+        for (unsigned lane = 0; lane < kLanes; lane += 4) {
+            if (!used[lane / 4]) { continue; }
+
+            LoPassFloat4 r0 = LoPassFloat4::Load(inInterleaved + (i + 0) * kLanes + lane);
+            LoPassFloat4 r1 = LoPassFloat4::Load(inInterleaved + (i + 1) * kLanes + lane);
+            LoPassFloat4 r2 = LoPassFloat4::Load(inInterleaved + (i + 2) * kLanes + lane);
+            LoPassFloat4 r3 = LoPassFloat4::Load(inInterleaved + (i + 3) * kLanes + lane);
+
+            LoPassTranspose(r0, r1, r2, r3);
+
+            r0.Store(outDests[lane + 0] + i);
+            r1.Store(outDests[lane + 1] + i);
+            r2.Store(outDests[lane + 2] + i);
+            r3.Store(outDests[lane + 3] + i);
+        }
+    }
+
+    for (; i < inFrames; i++) {
+        for (unsigned lane = 0; lane < kLanes; lane++) {
+            if (inActive[lane]) { outDests[lane][i] = inInterleaved[i * kLanes + lane]; }
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::LoPassFilterBank()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassFilterBank::LoPassFilterBank(double inSampleRate) : mSampleRate(inSampleRate),
+                                                          mNumberOfStreams(0),
+                                                          mInput(kFilterBank_SliceFrames * kFilterBank_Lanes, 0.0f),
+                                                          mOutput(kFilterBank_SliceFrames * kFilterBank_Lanes, 0.0f),
+                                                          mZeros(kFilterBank_SliceFrames, 0.0f),
+                                                          mDiscard(kFilterBank_SliceFrames, 0.0f) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::AddStream()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassFilterBank::AddStream(double inCutoff, double inResonance) {
+
+    unsigned id = 0;
+    while (id < mStreams.size() && mStreams[id].mInUse) { id++; }
+
+    if (id == mStreams.size()) { mStreams.push_back(Stream()); }
+
+    Stream &stream = mStreams[id];
+    stream.mInUse       = true;
+    stream.mGroup       = kFilterBank_NoStream;
+    stream.mLane        = 0;
+    stream.mSourceP     = NULL;
+    stream.mDestP       = NULL;
+    stream.mFrames      = 0;
+    stream.mSubmitted   = false;
+
+    mNumberOfStreams++;
+
+    Reset(id);
+    SetParameters(id, inCutoff, inResonance);
+    return id;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::RemoveStream()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::RemoveStream(unsigned inStream) {
+
+    Stream &stream = mStreams[inStream];
+    if (!stream.mInUse) { return; }
+
+    if (stream.mGroup != kFilterBank_NoStream) { Leave(stream); }
+
+    stream.mInUse       = false;
+    stream.mSubmitted   = false;
+    mNumberOfStreams--;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::SetParameters()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::SetParameters(unsigned inStream, double inCutoff, double inResonance) {
+
+    Stream &stream = mStreams[inStream];
+
+    double freq, resonance;
+    LoPassNormaliseParameters(inCutoff, inResonance, mSampleRate, freq, resonance);
+    LoPassCoefficientCache::Design(mSampleRate, freq, resonance, kLoPassDesign_Filter, stream.mCoefficients);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::Reset(unsigned inStream) {
+
+    Stream &stream = mStreams[inStream];
+
+    LoPassBiquadState clear = { 0.0, 0.0, 0.0, 0.0 };
+    stream.mState = clear;
+
+    if (stream.mGroup != kFilterBank_NoStream) {
+        for (int k = 0; k < 4; k++) { mGroups[stream.mGroup].mHistory[k][stream.mLane] = 0.0; }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::Submit()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::Submit(unsigned inStream, const float *inSourceP, float *inDestP, unsigned inFrames) {
+
+    Stream &stream = mStreams[inStream];
+
+    stream.mSourceP     = inSourceP;
+    stream.mDestP       = inDestP;
+    stream.mFrames      = inFrames;
+    stream.mSubmitted   = inFrames > 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::GetNumberOfGroups()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassFilterBank::GetNumberOfGroups() const {
+
+    unsigned groups = 0;
+    for (size_t g = 0; g < mGroups.size(); g++) { groups += mGroups[g].mUsed > 0; }
+    return groups;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::GetInstructionSet()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+const char *LoPassFilterBank::GetInstructionSet() {
+
+    return GetKernels().mName;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::Leave()
+//
+// Takes the stream's history out of its group.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::Leave(Stream &ioStream) {
+
+    Group &group = mGroups[ioStream.mGroup];
+    unsigned lane = ioStream.mLane;
+
+    ioStream.mState.mX1 = group.mHistory[0][lane];
+    ioStream.mState.mX2 = group.mHistory[1][lane];
+    ioStream.mState.mY1 = group.mHistory[2][lane];
+    ioStream.mState.mY2 = group.mHistory[3][lane];
+
+    group.mStreams[lane] = kFilterBank_NoStream;
+    group.mUsed--;
+
+    ioStream.mGroup = kFilterBank_NoStream;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::Join()
+//
+// Puts the stream in a group with room of its block size, or failing that an empty
+// group, or failing that a new one.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::Join(unsigned inStream) {
+
+    Stream &stream = mStreams[inStream];
+
+    unsigned found = kFilterBank_NoStream;
+    unsigned empty = kFilterBank_NoStream;
+
+    for (unsigned g = 0; g < mGroups.size() && found == kFilterBank_NoStream; g++) {
+
+        const Group &group = mGroups[g];
+
+        if (group.mUsed == 0) {
+            if (empty == kFilterBank_NoStream) { empty = g; }
+        } else if (group.mUsed < kFilterBank_Lanes && group.mFrames == stream.mFrames) {
+            found = g;
+        }
+    }
+
+    if (found == kFilterBank_NoStream) {
+
+        if (empty == kFilterBank_NoStream) {
+            empty = (unsigned)mGroups.size();
+            mGroups.push_back(Group());
+        }
+
+        found = empty;
+
+        Group &group = mGroups[found];
+        group.mFrames   = stream.mFrames;
+        group.mUsed     = 0;
+        for (unsigned lane = 0; lane < kFilterBank_Lanes; lane++) { group.mStreams[lane] = kFilterBank_NoStream; }
+    }
+
+    Group &group = mGroups[found];
+
+    unsigned lane = 0;
+    while (group.mStreams[lane] != kFilterBank_NoStream) { lane++; }
+
+    group.mHistory[0][lane] = stream.mState.mX1;
+    group.mHistory[1][lane] = stream.mState.mX2;
+    group.mHistory[2][lane] = stream.mState.mY1;
+    group.mHistory[3][lane] = stream.mState.mY2;
+
+    group.mStreams[lane] = inStream;
+    group.mUsed++;
+
+    stream.mGroup   = found;
+    stream.mLane    = lane;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::Run()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::Run() {
+
+    // place the streams whose block size has changed
+    for (unsigned s = 0; s < mStreams.size(); s++) {
+
+        Stream &stream = mStreams[s];
+        if (!stream.mSubmitted) { continue; }
+
+        if (stream.mGroup != kFilterBank_NoStream) {
+            const Group &group = mGroups[stream.mGroup];
+            if (group.mFrames == stream.mFrames) { continue; }
+
+            Leave(stream);
+        }
+
+        Join(s);
+    }
+
+    for (size_t g = 0; g < mGroups.size(); g++) {
+        if (mGroups[g].mUsed > 0) { RunGroup(mGroups[g]); }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFilterBank::RunGroup()
+//
+// Lanes not submitted this time run with zero coefficients, history and input, and what
+// comes out of them is thrown away; their own history stays in the group untouched. The
+// slices are moved in and out of the interleaved buffers 4 x 4 at a time, except that when
+// every submitted lane reads the same source, as when auditioning settings on one input,
+// the kernel reads it directly and nothing is interleaved on the way in. The idle lanes
+// then see that input too, which their zero coefficients still turn into nothing.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFilterBank::RunGroup(Group &ioGroup) {
+
+    static constexpr unsigned kLanes = kFilterBank_Lanes;
+
+    bool active[kLanes];
+    bool any = false;
+
+    for (unsigned lane = 0; lane < kLanes; lane++) {
+        unsigned s = ioGroup.mStreams[lane];
+        active[lane] = s != kFilterBank_NoStream && mStreams[s].mSubmitted;
+        any = any || active[lane];
+    }
+
+    if (!any) { return; }
+
+    double coefficients[5][kLanes];
+    double history[4][kLanes];
+
+    for (unsigned lane = 0; lane < kLanes; lane++) {
+
+        if (!active[lane]) {
+            for (int k = 0; k < 5; k++) { coefficients[k][lane] = 0.0; }
+            for (int k = 0; k < 4; k++) { history[k][lane] = 0.0; }
+            continue;
+        }
+
+        const LoPassCoefficients &c = mStreams[ioGroup.mStreams[lane]].mCoefficients;
+
+        coefficients[0][lane] = c.mA0;
+        coefficients[1][lane] = c.mA1;
+        coefficients[2][lane] = c.mA2;
+        coefficients[3][lane] = c.mB1;
+        coefficients[4][lane] = c.mB2;
+
+        for (int k = 0; k < 4; k++) { history[k][lane] = ioGroup.mHistory[k][lane]; }
+    }
+    const float *sources[kLanes];
+    float *dests[kLanes];
+
+    const float *shared = NULL;
+    bool broadcast = true;
+
+    for (unsigned lane = 0; lane < kLanes && broadcast; lane++) {
+        if (!active[lane]) { continue; }
+
+        const float *source = mStreams[ioGroup.mStreams[lane]].mSourceP;
+        broadcast = shared == NULL || shared == source;
+        shared = source;
+    }
+
+    for (unsigned start = 0; start < ioGroup.mFrames; start += kFilterBank_SliceFrames) {
+
+        unsigned frames = ioGroup.mFrames - start;
+        if (frames > kFilterBank_SliceFrames) { frames = kFilterBank_SliceFrames; }
+
+        for (unsigned lane = 0; lane < kLanes; lane++) {
+            const Stream *stream = active[lane] ? &mStreams[ioGroup.mStreams[lane]] : NULL;
+            sources[lane]   = stream != NULL ? stream->mSourceP + start : &mZeros[0];
+            dests[lane]     = stream != NULL ? stream->mDestP + start : &mDiscard[0];
+        }
+
+        if (broadcast) {
+            ProcessKernel(&coefficients[0][0], &history[0][0], shared + start, &mOutput[0], frames, true);
+        } else {
+            InterleaveLanes(sources, &mInput[0], frames);
+            ProcessKernel(&coefficients[0][0], &history[0][0], &mInput[0], &mOutput[0], frames, false);
+        }
+        DeinterleaveLanes(&mOutput[0], dests, active, frames);
+    }
+
+    for (unsigned lane = 0; lane < kLanes; lane++) {
+
+        if (!active[lane]) { continue; }
+
+        for (int k = 0; k < 4; k++) { ioGroup.mHistory[k][lane] = history[k][lane]; }
+        mStreams[ioGroup.mStreams[lane]].mSubmitted = false;
+    }
+}
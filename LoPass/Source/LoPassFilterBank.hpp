@@ -0,0 +1,114 @@
+//
+//  LoPassFilterBank.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassFilterBank_hpp
+#define LoPassFilterBank_hpp
+
+#include "LoPassBiquad.hpp"
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Filter Bank
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The lowpass on many independent mono streams at once, each with its own cutoff, resonance
+// and history, without an AudioUnit or a LoPassProcessor per stream. Streams are packed
+// kFilterBank_Lanes to a group, each group holding its coefficients and history as a
+// structure of arrays, so one step of the recursion runs one sample of every stream in the
+// group in double: two AVX-512 registers, four AVX registers, or eight SSE2 / NEON ones.
+// The widest unit the machine has is picked at run time.
+//
+// A group holds streams of one block size. Run() first places the streams submitted since
+// the last Run(), moving a stream to another group, history and all, when its block size
+// has changed, then runs each group through an interleaved scratch buffer. Each stream's
+// output is bit identical to a LoPassBiquad on its own, whatever group it lands in.
+// Tools/LoPassBankBench.cpp checks that and measures the gain.
+// A group whose streams all read the same source, as LoPassAudition's do, reads each of its
+// samples once for the whole group rather than once per stream.
+//
+// Parameters change in a step at the next Run(); a stream that needs smoothing wants a
+// LoPassProcessor. Run() only allocates when a stream has to go into a new group.
+
+/// Streams per group.
+static constexpr unsigned kFilterBank_Lanes         = 16;
+
+/// Frames per pass over a group, so the interleaved scratch buffers stay in L1.
+static constexpr unsigned kFilterBank_SliceFrames   = 128;
+
+/// Stream id for no stream.
+static constexpr unsigned kFilterBank_NoStream      = ~0u;
+
+class LoPassFilterBank {
+
+public:
+    explicit LoPassFilterBank(double inSampleRate);
+
+    /// Returns the new stream's id. The ids of removed streams are reused.
+    unsigned AddStream(double inCutoff, double inResonance);
+    void RemoveStream(unsigned inStream);
+
+    /// Cutoff in Hz and resonance in dB, bounds checked as for the effect.
+    void SetParameters(unsigned inStream, double inCutoff, double inResonance);
+
+    /// Clear a stream's history.
+    void Reset(unsigned inStream);
+
+    /// Queue a block for the next Run(). The source and destination may be the same buffer
+    /// and must stay valid until then. A stream not submitted keeps its history untouched.
+    void Submit(unsigned inStream, const float *inSourceP, float *inDestP, unsigned inFrames);
+
+    /// Filter everything submitted since the last Run().
+    void Run();
+
+    unsigned GetNumberOfStreams() const { return mNumberOfStreams; }
+
+    /// Groups with at least one stream in them.
+    unsigned GetNumberOfGroups() const;
+
+    /// The vector unit the groups run on.
+    static const char *GetInstructionSet();
+
+private:
+    struct Stream {
+        bool                mInUse;
+        LoPassCoefficients  mCoefficients;
+        unsigned            mGroup;         // kFilterBank_NoStream until first run
+        unsigned            mLane;
+        LoPassBiquadState   mState;         // the history while not in a group
+
+        // the block queued by Submit()
+        const float         *mSourceP;
+        float               *mDestP;
+        unsigned            mFrames;
+        bool                mSubmitted;
+    };
+
+    struct Group {
+        unsigned            mFrames;
+        unsigned            mUsed;
+        unsigned            mStreams[kFilterBank_Lanes];
+        double              mHistory[4][kFilterBank_Lanes];    // x1, x2, y1, y2
+    };
+
+    void Leave(Stream &ioStream);
+    void Join(unsigned inStream);
+    void RunGroup(Group &ioGroup);
+
+    double              mSampleRate;
+    std::vector<Stream> mStreams;
+    std::vector<Group>  mGroups;
+    unsigned            mNumberOfStreams;
+
+    // interleaved, one frame of every lane after another
+    std::vector<float>  mInput;
+    std::vector<float>  mOutput;
+
+    // what lanes not submitted read from and write to
+    std::vector<float>  mZeros;
+    std::vector<float>  mDiscard;
+};
+
+#endif /* LoPassFilterBank_hpp */
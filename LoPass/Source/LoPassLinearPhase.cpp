@@ -0,0 +1,508 @@
+//
+//  LoPassLinearPhase.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassLinearPhase.hpp"
+#include "LoPassCoefficientCache.hpp"
+#include "LoPassFilter.hpp"
+#include "LoPassSIMD.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+// Set on the hand-over slot index when it holds a design the render thread hasn't picked up.
+static constexpr int        kSlotFresh              = 4;
+static constexpr int        kSlotIndexMask          = 3;
+
+// How often the designer thread looks for pending targets.
+static constexpr unsigned   kDesignerPollInterval   = 10; // milliseconds
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::GetFilterLength()
+//
+// 8191 taps up to 48kHz, doubled per octave of sample rate above that, so the
+// frequency resolution (and the latency in seconds) stays roughly the same.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassLinearPhase::GetFilterLength(double inSampleRate) {
+
+    unsigned length = 8192;
+
+    for (double srate = 48000.0; srate < inSampleRate && length < 65536; srate *= 2.0) {
+        length *= 2;
+    }
+
+    return length - 1;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::GetLatencyFrames()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassLinearPhase::GetLatencyFrames(double inSampleRate) {
+
+    return (GetFilterLength(inSampleRate) - 1) / 2 + kLinearPhase_BlockSize;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::LoPassLinearPhase()
+//
+// Everything the render thread touches is allocated here.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassLinearPhase::LoPassLinearPhase(double inSampleRate) :
+    mSampleRate(inSampleRate),
+    mFilterLength(GetFilterLength(inSampleRate)),
+    mNumberOfPartitions((mFilterLength + kLinearPhase_BlockSize - 1) / kLinearPhase_BlockSize),
+    mNumberOfBins(kLinearPhase_BlockSize + 1),
+    mBlockFFT(2 * kLinearPhase_BlockSize),
+    mInput(2 * kLinearPhase_BlockSize),
+    mOutput(kLinearPhase_BlockSize),
+    mTime(2 * kLinearPhase_BlockSize),
+    mFade(kLinearPhase_BlockSize),
+    mAccReal(mNumberOfBins),
+    mAccImag(mNumberOfBins),
+    mFDLReal(mNumberOfPartitions * mNumberOfBins),
+    mFDLImag(mNumberOfPartitions * mNumberOfBins),
+    mFDLPosition(0),
+    mBlockPosition(0),
+    mFront(0),
+    mFrontValid(false),
+    mLastFreq(-1.0),
+    mLastResonance(-1.0),
+    mMiddle(1),
+    mRequestFreq(0.0),
+    mRequestResonance(0.0),
+    mRequestSerial(0),
+    mDesignFFT(2 * (mFilterLength + 1)),
+    mPartitionFFT(2 * kLinearPhase_BlockSize),
+    mDesignReal(mFilterLength + 2),
+    mDesignImag(mFilterLength + 2),
+    mDesignGrid(mFilterLength + 2),
+    mDesignResponse(mFilterLength + 2),
+    mDesignTime(2 * (mFilterLength + 1)),
+    mTaps(mNumberOfPartitions * kLinearPhase_BlockSize),
+    mDesignedSerial(0),
+    mBack(2) {
+
+    for (int i = 0; i < 3; i++) {
+        mSlotReal[i].resize(mNumberOfPartitions * mNumberOfBins);
+        mSlotImag[i].resize(mNumberOfPartitions * mNumberOfBins);
+        mSlotFreq[i]        = -1.0;
+        mSlotResonance[i]   = -1.0;
+    }
+
+    // normalised frequency of each design bin
+    for (unsigned k = 0; k < mDesignGrid.size(); k++) {
+        mDesignGrid[k] = 2.0 * k / mDesignFFT.GetSize();
+    }
+
+    LoPassFIRDesigner::Shared().Register(this);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::~LoPassLinearPhase()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassLinearPhase::~LoPassLinearPhase() {
+
+    // blocks until any design in progress for this convolver has finished
+    LoPassFIRDesigner::Shared().Unregister(this);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::Reset() {
+
+    std::fill(mInput.begin(), mInput.end(), 0.0f);
+    std::fill(mOutput.begin(), mOutput.end(), 0.0f);
+    std::fill(mFDLReal.begin(), mFDLReal.end(), 0.0f);
+    std::fill(mFDLImag.begin(), mFDLImag.end(), 0.0f);
+
+    mFDLPosition    = 0;
+    mBlockPosition  = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::SetTarget()
+//
+// Render thread. Only bumps the request serial when the target actually moves.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::SetTarget(double inFreq, double inResonance) {
+
+    if (inFreq == mLastFreq && inResonance == mLastResonance) { return; }
+
+    mLastFreq       = inFreq;
+    mLastResonance  = inResonance;
+
+    mRequestFreq.store(inFreq, std::memory_order_relaxed);
+    mRequestResonance.store(inResonance, std::memory_order_relaxed);
+    mRequestSerial.fetch_add(1, std::memory_order_release);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::Design()
+//
+// Windowed frequency sampling: the biquad magnitude is sampled on a grid twice the
+// filter length, transformed back to a zero phase impulse, delayed by half the filter
+// length and Blackman windowed. The taps are then cut into partitions and transformed
+// into the spare slot, which is handed over to the render thread.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::Design() {
+
+    std::lock_guard<std::mutex> lock(mDesignMutex);
+
+    unsigned serial;
+    double freq;
+    double resonance;
+
+    // re-read if the render thread posted a new target half way through
+    do {
+        serial      = mRequestSerial.load(std::memory_order_acquire);
+        freq        = mRequestFreq.load(std::memory_order_relaxed);
+        resonance   = mRequestResonance.load(std::memory_order_relaxed);
+    } while (serial != mRequestSerial.load(std::memory_order_acquire));
+
+    if (serial == mDesignedSerial.load(std::memory_order_relaxed)) { return; }
+
+    LoPassCoefficients coefficients;
+    LoPassCoefficientCache::Design(mSampleRate, freq, resonance, kLoPassDesign_LinearPhase, coefficients);
+
+    // zero phase magnitude response
+    const unsigned designSize = mDesignFFT.GetSize();
+    const unsigned designBins = mDesignFFT.GetNumberOfBins();
+
+    LoPassFilter::GetFrequencyResponse(coefficients, &mDesignGrid[0], &mDesignResponse[0], designBins);
+
+    for (unsigned k = 0; k < designBins; k++) {
+        mDesignReal[k] = mDesignResponse[k];
+        mDesignImag[k] = 0.0f;
+    }
+
+    mDesignFFT.Inverse(&mDesignReal[0], &mDesignImag[0], &mDesignTime[0]);
+
+    // centre and window the impulse
+    const unsigned delay = (mFilterLength - 1) / 2;
+    std::fill(mTaps.begin(), mTaps.end(), 0.0f);
+
+    for (unsigned n = 0; n < mFilterLength; n++) {
+        double w = 2.0 * M_PI * n / (mFilterLength - 1);
+        double window = 0.42 - 0.5 * cos(w) + 0.08 * cos(2.0 * w);
+
+        unsigned index = (n + designSize - delay) % designSize;
+        mTaps[n] = mDesignTime[index] * window;
+    }
+
+    // partition spectra into the back slot
+    float *slotReal = &mSlotReal[mBack][0];
+    float *slotImag = &mSlotImag[mBack][0];
+
+    for (unsigned p = 0; p < mNumberOfPartitions; p++) {
+        float *block = &mDesignTime[0];
+
+        memcpy(block, &mTaps[p * kLinearPhase_BlockSize], kLinearPhase_BlockSize * sizeof(float));
+        memset(block + kLinearPhase_BlockSize, 0, kLinearPhase_BlockSize * sizeof(float));
+
+        mPartitionFFT.Forward(block, slotReal + p * mNumberOfBins, slotImag + p * mNumberOfBins);
+    }
+
+    mSlotFreq[mBack]        = freq;
+    mSlotResonance[mBack]   = resonance;
+
+    // hand over
+    mBack = mMiddle.exchange(mBack | kSlotFresh, std::memory_order_acq_rel) & kSlotIndexMask;
+    mDesignedSerial.store(serial, std::memory_order_relaxed);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::Convolve()
+//
+// Sums every partition against the delay line and returns the valid (second) half
+// of the circular convolution.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::Convolve(unsigned inSlot, float *outBlock) {
+
+    std::fill(mAccReal.begin(), mAccReal.end(), 0.0f);
+    std::fill(mAccImag.begin(), mAccImag.end(), 0.0f);
+
+    const float *slotReal = &mSlotReal[inSlot][0];
+    const float *slotImag = &mSlotImag[inSlot][0];
+
+    for (unsigned p = 0; p < mNumberOfPartitions; p++) {
+        unsigned fdl = (mFDLPosition + mNumberOfPartitions - p) % mNumberOfPartitions;
+
+        LoPassComplexMultiplyAccumulate(&mFDLReal[fdl * mNumberOfBins],
+                                        &mFDLImag[fdl * mNumberOfBins],
+                                        slotReal + p * mNumberOfBins,
+                                        slotImag + p * mNumberOfBins,
+                                        &mAccReal[0],
+                                        &mAccImag[0],
+                                        mNumberOfBins);
+    }
+
+    mBlockFFT.Inverse(&mAccReal[0], &mAccImag[0], &mTime[0]);
+    memcpy(outBlock, &mTime[kLinearPhase_BlockSize], kLinearPhase_BlockSize * sizeof(float));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::ProcessBlock()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::ProcessBlock() {
+
+    const unsigned B = kLinearPhase_BlockSize;
+
+    mBlockFFT.Forward(&mInput[0], &mFDLReal[mFDLPosition * mNumberOfBins], &mFDLImag[mFDLPosition * mNumberOfBins]);
+
+    // slide the input window
+    memcpy(&mInput[0], &mInput[B], B * sizeof(float));
+
+    bool fresh = (mMiddle.load(std::memory_order_relaxed) & kSlotFresh) != 0;
+
+    if (mFrontValid) {
+        Convolve(mFront, &mOutput[0]);
+    } else {
+        std::fill(mOutput.begin(), mOutput.end(), 0.0f);
+    }
+
+    if (fresh) {
+        // the old front is released by the exchange, so it must not be touched after this
+        mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & kSlotIndexMask;
+
+        Convolve(mFront, &mFade[0]);
+
+        if (mFrontValid) {
+            for (unsigned i = 0; i < B; i++) {
+                float ramp = (i + 0.5f) / B;
+                mOutput[i] += (mFade[i] - mOutput[i]) * ramp;
+            }
+        } else {
+            memcpy(&mOutput[0], &mFade[0], B * sizeof(float));
+        }
+
+        mFrontValid = true;
+    }
+
+    mFDLPosition = (mFDLPosition + 1) % mNumberOfPartitions;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::Process()
+//
+// Input is gathered into blocks; each output sample comes from the previous block,
+// which is where the extra kLinearPhase_BlockSize frames of latency come from.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::Process(const float *inSourceP, float *inDestP, unsigned inFramesToProcess) {
+
+    const unsigned B = kLinearPhase_BlockSize;
+
+    while (inFramesToProcess > 0) {
+        unsigned n = std::min(inFramesToProcess, B - mBlockPosition);
+
+        memcpy(&mInput[B + mBlockPosition], inSourceP, n * sizeof(float));
+        memmove(inDestP, &mOutput[mBlockPosition], n * sizeof(float));
+
+        inSourceP           += n;
+        inDestP             += n;
+        inFramesToProcess   -= n;
+        mBlockPosition      += n;
+
+        if (mBlockPosition == B) {
+            ProcessBlock();
+            mBlockPosition = 0;
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::SaveState()
+//
+// The designer is held off so the hand-over slot can't change under us.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::SaveState(LoPassStateWriter &ioWriter) const {
+
+    std::lock_guard<std::mutex> lock(mDesignMutex);
+
+    int middle = mMiddle.load(std::memory_order_acquire);
+    bool fresh = (middle & kSlotFresh) != 0;
+
+    ioWriter.PutUInt32(mFilterLength);
+    ioWriter.PutFloats(&mInput[0], mInput.size());
+    ioWriter.PutFloats(&mOutput[0], mOutput.size());
+    ioWriter.PutFloats(&mFDLReal[0], mFDLReal.size());
+    ioWriter.PutFloats(&mFDLImag[0], mFDLImag.size());
+    ioWriter.PutUInt32(mFDLPosition);
+    ioWriter.PutUInt32(mBlockPosition);
+
+    ioWriter.PutBool(mFrontValid);
+    ioWriter.PutDouble(mFrontValid ? mSlotFreq[mFront] : 0.0);
+    ioWriter.PutDouble(mFrontValid ? mSlotResonance[mFront] : 0.0);
+
+    ioWriter.PutBool(fresh);
+    ioWriter.PutDouble(fresh ? mSlotFreq[middle & kSlotIndexMask] : 0.0);
+    ioWriter.PutDouble(fresh ? mSlotResonance[middle & kSlotIndexMask] : 0.0);
+
+    ioWriter.PutDouble(mLastFreq);
+    ioWriter.PutDouble(mLastResonance);
+    ioWriter.PutBool(NeedsDesign());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::Install()
+//
+// designs for the given target right here and leaves it in the hand-over slot
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::Install(double inFreq, double inResonance) {
+
+    mLastFreq = -1.0;
+    SetTarget(inFreq, inResonance);
+    Design();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassLinearPhase::LoadState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassLinearPhase::LoadState(LoPassStateReader &ioReader) {
+
+    Reset();
+
+    if (ioReader.GetUInt32() != mFilterLength) { ioReader.Fail(); }
+
+    ioReader.GetFloats(&mInput[0], mInput.size());
+    ioReader.GetFloats(&mOutput[0], mOutput.size());
+    ioReader.GetFloats(&mFDLReal[0], mFDLReal.size());
+    ioReader.GetFloats(&mFDLImag[0], mFDLImag.size());
+    mFDLPosition    = ioReader.GetUInt32();
+    mBlockPosition  = ioReader.GetUInt32();
+
+    bool frontValid         = ioReader.GetBool();
+    double frontFreq        = ioReader.GetDouble();
+    double frontResonance   = ioReader.GetDouble();
+    bool fresh              = ioReader.GetBool();
+    double freshFreq        = ioReader.GetDouble();
+    double freshResonance   = ioReader.GetDouble();
+    double lastFreq         = ioReader.GetDouble();
+    double lastResonance    = ioReader.GetDouble();
+    bool pending            = ioReader.GetBool();
+
+    if (mFDLPosition >= mNumberOfPartitions || mBlockPosition >= kLinearPhase_BlockSize) { ioReader.Fail(); }
+
+    if (!ioReader.IsOK()) {
+        Reset();
+        return;
+    }
+
+    // the filter that was playing, taken straight to the front
+    if (frontValid) {
+        Install(frontFreq, frontResonance);
+        mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & kSlotIndexMask;
+    }
+
+    mFrontValid = frontValid;
+
+    // the one waiting to be crossfaded in
+    if (fresh) {
+        Install(freshFreq, freshResonance);
+    } else {
+        // nor anything left over from before, designed or still to come
+        std::lock_guard<std::mutex> lock(mDesignMutex);
+        mMiddle.fetch_and(kSlotIndexMask, std::memory_order_acq_rel);
+        mDesignedSerial.store(mRequestSerial.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    mLastFreq       = pending ? -1.0 : lastFreq;
+    mLastResonance  = lastResonance;
+
+    if (pending) { SetTarget(lastFreq, lastResonance); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFIRDesigner::Shared()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassFIRDesigner &LoPassFIRDesigner::Shared() {
+
+    // Never destroyed: a process may exit with convolvers alive, from a host that quits without
+    // disposing its units or from static objects, and joining or destroying the running thread
+    // during static destruction would terminate it. The thread ends with the process.
+    static LoPassFIRDesigner *sDesigner = new LoPassFIRDesigner();
+    return *sDesigner;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFIRDesigner::Register()
+//
+// The thread is started with the first convolver and stopped with the last one.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFIRDesigner::Register(LoPassLinearPhase *inConvolver) {
+
+    std::lock_guard<std::mutex> lifecycle(mLifecycleMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mConvolvers.push_back(inConvolver);
+    }
+
+    if (!mThread.joinable()) {
+        mQuit = false;
+        mThread = std::thread(&LoPassFIRDesigner::Run, this);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFIRDesigner::Unregister()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFIRDesigner::Unregister(LoPassLinearPhase *inConvolver) {
+
+    std::lock_guard<std::mutex> lifecycle(mLifecycleMutex);
+
+    bool stop;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mConvolvers.erase(std::remove(mConvolvers.begin(), mConvolvers.end(), inConvolver), mConvolvers.end());
+
+        stop = mConvolvers.empty();
+        if (stop) { mQuit = true; }
+    }
+
+    if (stop && mThread.joinable()) {
+        mWake.notify_one();
+        mThread.join();
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFIRDesigner::Run()
+//
+// Designs run with the registry locked, so a convolver can't be destroyed mid-design.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassFIRDesigner::Run() {
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (!mQuit) {
+        for (size_t i = 0; i < mConvolvers.size(); i++) {
+            if (mConvolvers[i]->NeedsDesign()) {
+                mConvolvers[i]->Design();
+            }
+        }
+
+        mWake.wait_for(lock, std::chrono::milliseconds(kDesignerPollInterval));
+    }
+}
@@ -0,0 +1,148 @@
+//
+//  LoPassLinearPhase.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassLinearPhase_hpp
+#define LoPassLinearPhase_hpp
+
+#include "LoPassFFT.hpp"
+#include "LoPassState.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Linear Phase Convolver
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A symmetric FIR is designed from the magnitude of the LoPass biquad response and applied
+// with uniformly partitioned overlap-save convolution.
+//
+// The render thread only ever posts a new target and picks up finished designs. The design
+// itself runs on the shared LoPassFIRDesigner thread, which fills the spare slot of a triple
+// buffer and swaps it in with a single atomic exchange, so no locks or allocations happen
+// during Process(). A newly picked up filter is crossfaded in over one block.
+
+/// Convolution block size in frames; also the buffering part of the reported latency.
+static constexpr unsigned kLinearPhase_BlockSize = 256;
+
+class LoPassLinearPhase {
+
+public:
+    LoPassLinearPhase(double inSampleRate);
+    ~LoPassLinearPhase();
+
+    /// Number of FIR taps used at the given sample rate (always odd).
+    static unsigned GetFilterLength(double inSampleRate);
+
+    /// Total latency in frames: the FIR group delay plus one convolution block.
+    static unsigned GetLatencyFrames(double inSampleRate);
+
+    /// Post a new target response. Safe to call on the render thread.
+    /// inFreq is normalised frequency 0 -> 1, inResonance is in decibels.
+    void SetTarget(double inFreq, double inResonance);
+
+    /// Design the FIR for the latest target and publish it to the render thread.
+    /// Never call this on the render thread.
+    void Design();
+
+    bool NeedsDesign() const { return mRequestSerial.load(std::memory_order_acquire) != mDesignedSerial.load(std::memory_order_relaxed); }
+
+    void Process(const float *inSourceP, float *inDestP, unsigned inFramesToProcess);
+
+    /// Clear the convolution history. The current filter is kept.
+    void Reset();
+
+    /// Convolution history and the targets of the filters in use, see LoPassState.hpp.
+    /// The filters themselves are designed again on loading, straight away rather than on
+    /// the designer thread, so output carries on exactly as it would have. A design still
+    /// pending when saved is posted again and lands whenever the designer gets to it, as it
+    /// would have anyway. Neither may run alongside Process().
+    void SaveState(LoPassStateWriter &ioWriter) const;
+    void LoadState(LoPassStateReader &ioReader);
+
+private:
+    void ProcessBlock();
+    void Convolve(unsigned inSlot, float *outBlock);
+    void Install(double inFreq, double inResonance);
+
+    double                  mSampleRate;
+    unsigned                mFilterLength;
+    unsigned                mNumberOfPartitions;
+    unsigned                mNumberOfBins;
+
+    //~~~~ render thread state
+    LoPassFFT               mBlockFFT;
+    std::vector<float>      mInput;         // 2 blocks: previous | current
+    std::vector<float>      mOutput;        // 1 block, read while the next one fills
+    std::vector<float>      mTime;
+    std::vector<float>      mFade;
+    std::vector<float>      mAccReal;
+    std::vector<float>      mAccImag;
+    std::vector<float>      mFDLReal;       // frequency domain delay line
+    std::vector<float>      mFDLImag;
+    unsigned                mFDLPosition;
+    unsigned                mBlockPosition;
+    int                     mFront;
+    bool                    mFrontValid;
+    double                  mLastFreq;
+    double                  mLastResonance;
+
+    //~~~~ shared
+    // Partition spectra, three slots: front (render), back (designer), middle (hand-over).
+    std::vector<float>      mSlotReal[3];
+    std::vector<float>      mSlotImag[3];
+    double                  mSlotFreq[3];   // the target each slot was designed for
+    double                  mSlotResonance[3];
+    std::atomic<int>        mMiddle;
+    std::atomic<double>     mRequestFreq;
+    std::atomic<double>     mRequestResonance;
+    std::atomic<unsigned>   mRequestSerial;
+
+    //~~~~ designer state
+    mutable std::mutex      mDesignMutex;
+    LoPassFFT               mDesignFFT;
+    LoPassFFT               mPartitionFFT;
+    std::vector<float>      mDesignReal;
+    std::vector<float>      mDesignImag;
+    std::vector<double>     mDesignGrid;
+    std::vector<double>     mDesignResponse;
+    std::vector<float>      mDesignTime;
+    std::vector<float>      mTaps;
+    std::atomic<unsigned>   mDesignedSerial;    // polled by the designer without the lock
+    int                     mBack;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass FIR Designer
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// One low priority background thread shared by every linear-phase convolver in the process.
+/// It polls the registered convolvers and redesigns the ones with a pending target. The
+/// shared instance is never destroyed, so exiting with convolvers alive is safe.
+class LoPassFIRDesigner {
+
+public:
+    static LoPassFIRDesigner &Shared();
+
+    void Register(LoPassLinearPhase *inConvolver);
+    void Unregister(LoPassLinearPhase *inConvolver);
+
+private:
+    LoPassFIRDesigner() : mQuit(false) { }
+
+    void Run();
+
+    std::mutex                          mLifecycleMutex;
+    std::mutex                          mMutex;
+    std::condition_variable             mWake;
+    std::thread                         mThread;
+    bool                                mQuit;
+    std::vector<LoPassLinearPhase *>    mConvolvers;
+};
+
+#endif /* LoPassLinearPhase_hpp */
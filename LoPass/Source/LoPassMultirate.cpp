@@ -0,0 +1,585 @@
+//
+//  LoPassMultirate.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassMultirate.hpp"
+#include "LoPassSIMD.h"
+#include <math.h>
+#include <string.h>
+
+// Halfband taps either side of the centre tap (which is 0.5), outwards from the centre.
+// Normalised so each side sums to exactly 0.25, for unity gain at DC.
+static const float kHalfbandTaps[3] = {
+     2.94401872536317832e-01f,
+    -5.10352263804786307e-02f,
+     6.63335384416079230e-03f
+};
+
+// Stages are added while the cutoff stays below this at the reduced rate, which keeps it
+// well inside the halfband passband and away from the folded stopband.
+static constexpr double     kMaxDecimatedFreq   = 0.05;
+static constexpr double     kStageHysteresis    = 1.25;
+
+static constexpr unsigned   kFadeFrames         = 512;
+
+// A new lane's biquad is left to ring down to this before the fade, about e^-6.
+static constexpr double     kSettleLevel        = 2.5e-3;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassHalfband::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassHalfband::Reset() {
+    
+    memset(mEven, 0, sizeof(mEven));
+    memset(mOdd, 0, sizeof(mOdd));
+    mOddPending = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassHalfband::Convolve()
+//
+// The non-zero side taps of a halfband all land on one polyphase branch, so output j is
+//     0.5 odd[p - 3] + sum over i of tap[i] * (even[p - 2 + i] + even[p - 3 - i])
+// where p = kHistory + j. Eight outputs are computed at once; their inputs are contiguous
+// for every tap.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassHalfband::Convolve(const float *inEven, const float *inOdd, float *outDestP, unsigned inCount) {
+    
+    const float *x          = inEven + kHistory - kPairs;
+    const float *centre     = inOdd + kHistory - kPairs;
+    unsigned j = 0;
+    
+    LoPassFloat4 taps[kPairs];
+    for (unsigned i = 0; i < kPairs; i++) { taps[i] = LoPassFloat4::Set(kHalfbandTaps[i]); }
+    
+    const LoPassFloat4 half = LoPassFloat4::Set(0.5f);
+    
+    // two independent accumulator chains
+    for (; j + 8 <= inCount; j += 8) {
+        
+        const float *p = x + j;
+        LoPassFloat4 acc0 = LoPassFloat4::Load(centre + j) * half;
+        LoPassFloat4 acc1 = LoPassFloat4::Load(centre + j + 4) * half;
+        
+        for (int i = 0; i < (int)kPairs; i++) {
+            acc0 = acc0 + (LoPassFloat4::Load(p + 1 + i) + LoPassFloat4::Load(p - i)) * taps[i];
+            acc1 = acc1 + (LoPassFloat4::Load(p + 5 + i) + LoPassFloat4::Load(p + 4 - i)) * taps[i];
+        }
+        
+        acc0.Store(outDestP + j);
+        acc1.Store(outDestP + j + 4);
+    }
+    
+    for (; j < inCount; j++) {
+        
+        const float *p = x + j;
+        float acc = 0.5f * centre[j];
+        
+        for (int i = 0; i < (int)kPairs; i++) {
+            acc += kHalfbandTaps[i] * (p[1 + i] + p[-i]);
+        }
+        
+        outDestP[j] = acc;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassHalfband::Decimate()
+//
+// Output m is produced when input 2m arrives. Even inputs go to mEven, odd inputs to mOdd,
+// both indexed by m.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassHalfband::Decimate(const float *inSourceP, float *outDestP, unsigned inFrames) {
+    
+    // Deeper stages see empty blocks when the host's are small. One must leave a pending
+    // odd sample pending, or the output runs ahead of the input.
+    if (inFrames == 0) { return 0; }
+    
+    unsigned i = 0;
+    
+    // an odd sample belongs with the even sample before it, which was in the last block
+    if (mOddPending) {
+        mOdd[kHistory - 1] = inSourceP[i++];
+    }
+    
+    unsigned count = (inFrames - i) / 2;
+    unsigned m = 0;
+    
+    for (; m + 4 <= count; m += 4, i += 8) {
+        LoPassFloat4 even, odd;
+        LoPassDeinterleave(inSourceP + i, even, odd);
+        even.Store(mEven + kHistory + m);
+        odd.Store(mOdd + kHistory + m);
+    }
+    
+    for (; m < count; m++, i += 2) {
+        mEven[kHistory + m] = inSourceP[i];
+        mOdd[kHistory + m]  = inSourceP[i + 1];
+    }
+    
+    mOddPending = 0;
+    
+    if (i < inFrames) {
+        mEven[kHistory + count++] = inSourceP[i];
+        mOddPending = 1;
+    }
+    
+    Convolve(mEven, mOdd, outDestP, count);
+    
+    memmove(mEven, mEven + count, kHistory * sizeof(float));
+    memmove(mOdd, mOdd + count, kHistory * sizeof(float));
+    
+    return count;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassHalfband::Interpolate()
+//
+// With the zero stuffed input filtered at twice the gain, input m produces y[2m] from the
+// side taps alone and y[2m + 1] = x[m - 2] from the centre tap.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassHalfband::Interpolate(const float *inSourceP, float *outDestP, unsigned inFrames) {
+    
+    memcpy(mEven + kHistory, inSourceP, inFrames * sizeof(float));
+    
+    // mOdd is all zeros here, so the centre tap drops out
+    Convolve(mEven, mOdd, mScratch, inFrames);
+    
+    const float *x = mEven + kHistory + 1 - kPairs;
+    const LoPassFloat4 two = LoPassFloat4::Set(2.0f);
+    unsigned j = 0;
+    
+    for (; j + 4 <= inFrames; j += 4) {
+        LoPassInterleave(LoPassFloat4::Load(mScratch + j) * two, LoPassFloat4::Load(x + j), outDestP + 2 * j);
+    }
+    
+    for (; j < inFrames; j++) {
+        outDestP[2 * j]     = 2.0f * mScratch[j];
+        outDestP[2 * j + 1] = x[j];
+    }
+    
+    memmove(mEven, mEven + inFrames, kHistory * sizeof(float));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassHalfband::SaveState()
+//
+// Only the low rate history is kept between blocks; the rest of the branches is scratch.
+// The interpolator's odd branch is always zero, so it goes along for nothing.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassHalfband::SaveState(LoPassStateWriter &ioWriter) const {
+    
+    ioWriter.PutFloats(mEven, kHistory);
+    ioWriter.PutFloats(mOdd, kHistory);
+    ioWriter.PutBool(mOddPending != 0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassHalfband::LoadState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassHalfband::LoadState(LoPassStateReader &ioReader) {
+    
+    Reset();
+    
+    ioReader.GetFloats(mEven, kHistory);
+    ioReader.GetFloats(mOdd, kHistory);
+    mOddPending = ioReader.GetBool() ? 1 : 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirateLane::LoPassMultirateLane()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassMultirateLane::LoPassMultirateLane(double inSampleRate) :
+    mSampleRate(inSampleRate),
+    mStages(0),
+    mFilter(inSampleRate),
+    mPendingCount(0),
+    mDelay(LoPassMultirate::GetLatencyFrames()),
+    mDelayLength(0),
+    mDelayPosition(0) {
+    
+    mFilter.GetControlRate().SetDesignMode(kLoPassDesign_Multirate);
+    Configure(0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirateLane::Configure()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirateLane::Configure(unsigned inStages) {
+    
+    mStages = inStages;
+    mFilter.GetControlRate().SetSampleRate(mSampleRate / (1 << mStages));
+    
+    // each stage delays by kDelay on the way down and again on the way up, at its input rate
+    unsigned latency = 2 * LoPassHalfband::kDelay * ((1 << mStages) - 1);
+    mDelayLength = LoPassMultirate::GetLatencyFrames() - latency;
+    
+    Reset();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirateLane::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirateLane::Reset() {
+    
+    for (unsigned s = 0; s < kMultirate_MaxStages; s++) {
+        mDecimators[s].Reset();
+        mInterpolators[s].Reset();
+    }
+    
+    mFilter.Reset();
+    mPendingCount = 0;
+    
+    std::fill(mDelay.begin(), mDelay.end(), 0.0f);
+    mDelayPosition = 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirateLane::Process()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirateLane::Process(const float *inSourceP, float *inDestP, unsigned inFramesToProcess) {
+    
+    const float *source = inSourceP;
+    unsigned count      = inFramesToProcess;
+    
+    // down
+    for (unsigned s = 0; s < mStages; s++) {
+        count = mDecimators[s].Decimate(source, mScratch[s & 1], count);
+        source = mScratch[s & 1];
+    }
+    
+    // filter at the reduced rate, in place once decimated
+    unsigned which  = mStages == 0 ? 0 : (mStages - 1) & 1;
+    float *filtered = mScratch[which];
+    mFilter.Process(source, filtered, count);
+    
+    // up, the last stage straight into the pending output
+    source = filtered;
+    
+    for (unsigned s = mStages; s-- > 0; ) {
+        which ^= 1;
+        float *dest = s == 0 ? mPending + mPendingCount : mScratch[which];
+        mInterpolators[s].Interpolate(source, dest, count);
+        source = dest;
+        count *= 2;
+    }
+    
+    if (mStages == 0) { memcpy(mPending + mPendingCount, filtered, count * sizeof(float)); }
+    mPendingCount += count;
+    
+    // hand out through the padding delay
+    const float *pending = mPending;
+    unsigned n = inFramesToProcess;
+    
+    while (n > 0 && mDelayLength != 0) {
+        
+        unsigned frames = mDelayLength - mDelayPosition;
+        if (frames > n) { frames = n; }
+        
+        float *delay = &mDelay[mDelayPosition];
+        memcpy(inDestP, delay, frames * sizeof(float));
+        memcpy(delay, pending, frames * sizeof(float));
+        
+        mDelayPosition += frames;
+        if (mDelayPosition == mDelayLength) { mDelayPosition = 0; }
+        
+        inDestP += frames;
+        pending += frames;
+        n       -= frames;
+    }
+    
+    memcpy(inDestP, pending, n * sizeof(float));
+    
+    mPendingCount -= inFramesToProcess;
+    memmove(mPending, mPending + inFramesToProcess, mPendingCount * sizeof(float));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirateLane::SaveState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirateLane::SaveState(LoPassStateWriter &ioWriter) const {
+    
+    ioWriter.PutUInt32(mStages);
+    
+    for (unsigned s = 0; s < mStages; s++) {
+        mDecimators[s].SaveState(ioWriter);
+        mInterpolators[s].SaveState(ioWriter);
+    }
+    
+    mFilter.SaveState(ioWriter);
+    
+    ioWriter.PutUInt32(mPendingCount);
+    ioWriter.PutFloats(mPending, mPendingCount);
+    ioWriter.PutUInt32(mDelayPosition);
+    ioWriter.PutFloats(&mDelay[0], mDelayLength);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirateLane::LoadState()
+//
+// Configure() first, for the filter's rate and the delay length that go with the stages.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirateLane::LoadState(LoPassStateReader &ioReader) {
+    
+    uint32_t stages = ioReader.GetUInt32();
+    if (stages > kMultirate_MaxStages) { ioReader.Fail(); }
+    
+    Configure(ioReader.IsOK() ? stages : 0);
+    
+    for (unsigned s = 0; s < mStages; s++) {
+        mDecimators[s].LoadState(ioReader);
+        mInterpolators[s].LoadState(ioReader);
+    }
+    
+    mFilter.LoadState(ioReader);
+    
+    uint32_t pending = ioReader.GetUInt32();
+    if (pending > sizeof(mPending) / sizeof(mPending[0])) { ioReader.Fail(); }
+    
+    mPendingCount = ioReader.IsOK() ? pending : 0;
+    ioReader.GetFloats(mPending, mPendingCount);
+    
+    mDelayPosition = ioReader.GetUInt32();
+    if (mDelayPosition >= mDelayLength && mDelayPosition != 0) { ioReader.Fail(); }
+    
+    ioReader.GetFloats(&mDelay[0], mDelayLength);
+    
+    if (!ioReader.IsOK()) { Reset(); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::LoPassMultirate()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassMultirate::LoPassMultirate(double inSampleRate) :
+    mSampleRate(inSampleRate),
+    mLanes { LoPassMultirateLane(inSampleRate), LoPassMultirateLane(inSampleRate) },
+    mActive(0),
+    mFreq(0.5),
+    mResonance(0.0),
+    mPrimed(false),
+    mWarmupFrames(0),
+    mFadeFrames(0) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::GetLatencyFrames()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassMultirate::GetLatencyFrames() {
+    
+    return 2 * LoPassHalfband::kDelay * ((1 << kMultirate_MaxStages) - 1);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::ChooseStages()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassMultirate::ChooseStages(double inFreq, unsigned inCurrent) {
+    
+    unsigned stages = inCurrent > kMultirate_MaxStages ? kMultirate_MaxStages : inCurrent;
+    
+    while (stages > 0 && inFreq * (1 << stages) > kMaxDecimatedFreq * kStageHysteresis) {
+        stages--;
+    }
+    
+    while (stages < kMultirate_MaxStages && inFreq * (2 << stages) < kMaxDecimatedFreq / kStageHysteresis) {
+        stages++;
+    }
+    
+    return stages;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::SetSmoothingTime()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirate::SetSmoothingTime(double inSeconds) {
+    
+    mLanes[0].GetFilter().GetControlRate().SetSmoothingTime(inSeconds);
+    mLanes[1].GetFilter().GetControlRate().SetSmoothingTime(inSeconds);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::SetTarget()
+//
+// starts a lane change when the cutoff asks for a different stage count
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirate::SetTarget(double inFreq, double inResonance) {
+    
+    mFreq       = inFreq;
+    mResonance  = inResonance;
+    
+    LoPassMultirateLane &active     = mLanes[mActive];
+    LoPassMultirateLane &incoming   = mLanes[mActive ^ 1];
+    
+    if (!mPrimed) {
+        active.Configure(ChooseStages(inFreq, kMultirate_MaxStages));
+        mPrimed = true;
+    }
+    
+    active.SetTarget(inFreq, inResonance);
+    
+    if (mWarmupFrames != 0 || mFadeFrames != 0) {
+        // finish the change in progress first
+        incoming.SetTarget(inFreq, inResonance);
+        return;
+    }
+    
+    unsigned stages = ChooseStages(inFreq, active.GetStages());
+    if (stages == active.GetStages()) { return; }
+    
+    incoming.Configure(stages);
+    incoming.SetTarget(inFreq, inResonance);
+    
+    // let the new lane's biquad settle, plus the time to fill the decimators and interpolators
+    double decay    = LoPassFilter::GetDecayFrames(incoming.GetFilter().GetControlRate().GetCoefficients(), kSettleLevel);
+    double settle   = decay * (1 << stages) + GetLatencyFrames();
+    
+    mWarmupFrames   = settle < mSampleRate ? (unsigned)settle : (unsigned)mSampleRate;
+    mFadeFrames     = kFadeFrames;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::GetDesignCount()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+uint64_t LoPassMultirate::GetDesignCount() const {
+    return mLanes[0].GetFilter().GetControlRate().GetDesignCount() + mLanes[1].GetFilter().GetControlRate().GetDesignCount();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirate::Reset() {
+    
+    mLanes[0].Reset();
+    mLanes[1].Reset();
+    
+    mWarmupFrames   = 0;
+    mFadeFrames     = 0;
+    mPrimed         = false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::Process()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirate::Process(const float *inSourceP, float *inDestP, unsigned inFramesToProcess) {
+    
+    if (!mPrimed) { SetTarget(mFreq, mResonance); }
+    
+    while (inFramesToProcess > 0) {
+        
+        unsigned frames = inFramesToProcess < kMultirate_ChunkSize ? inFramesToProcess : kMultirate_ChunkSize;
+        
+        // end a lane change on a chunk boundary, so the next one starts on the same frame
+        // however the host slices its buffers
+        unsigned changing = mWarmupFrames + mFadeFrames;
+        if (changing != 0 && frames > changing) { frames = changing; }
+        
+        ProcessChunk(inSourceP, inDestP, frames);
+        
+        inSourceP           += frames;
+        inDestP             += frames;
+        inFramesToProcess   -= frames;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::ProcessChunk()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirate::ProcessChunk(const float *inSourceP, float *inDestP, unsigned inFrames) {
+    
+    mLanes[mActive].Process(inSourceP, inDestP, inFrames);
+    
+    if (mWarmupFrames == 0 && mFadeFrames == 0) { return; }
+    
+    mLanes[mActive ^ 1].Process(inSourceP, mIncoming, inFrames);
+    
+    unsigned i = 0;
+    
+    // still settling, its output is discarded
+    if (mWarmupFrames != 0) {
+        i = inFrames < mWarmupFrames ? inFrames : mWarmupFrames;
+        mWarmupFrames -= i;
+    }
+    
+    // linear crossfade
+    for (; i < inFrames && mFadeFrames != 0; i++) {
+        float gain = 1.0f - (float)(--mFadeFrames) / kFadeFrames;
+        inDestP[i] += (mIncoming[i] - inDestP[i]) * gain;
+    }
+    
+    for (; i < inFrames; i++) { inDestP[i] = mIncoming[i]; }
+    
+    if (mWarmupFrames == 0 && mFadeFrames == 0) {
+        mActive ^= 1;
+        
+        // the target may have moved to another stage count while the change ran
+        SetTarget(mFreq, mResonance);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::SaveState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirate::SaveState(LoPassStateWriter &ioWriter) const {
+    
+    ioWriter.PutUInt32(mActive);
+    ioWriter.PutDouble(mFreq);
+    ioWriter.PutDouble(mResonance);
+    ioWriter.PutBool(mPrimed);
+    ioWriter.PutUInt32(mWarmupFrames);
+    ioWriter.PutUInt32(mFadeFrames);
+    
+    mLanes[mActive].SaveState(ioWriter);
+    
+    // the other lane only matters while it is being brought in
+    if (mWarmupFrames != 0 || mFadeFrames != 0) { mLanes[mActive ^ 1].SaveState(ioWriter); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassMultirate::LoadState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassMultirate::LoadState(LoPassStateReader &ioReader) {
+    
+    Reset();
+    
+    uint32_t active = ioReader.GetUInt32();
+    if (active > 1) { ioReader.Fail(); }
+    
+    mActive         = ioReader.IsOK() ? (int)active : 0;
+    mFreq           = ioReader.GetDouble();
+    mResonance      = ioReader.GetDouble();
+    mPrimed         = ioReader.GetBool();
+    mWarmupFrames   = ioReader.GetUInt32();
+    mFadeFrames     = ioReader.GetUInt32();
+    
+    if (mFadeFrames > kFadeFrames) { ioReader.Fail(); }
+    
+    mLanes[mActive].LoadState(ioReader);
+    if (mWarmupFrames != 0 || mFadeFrames != 0) { mLanes[mActive ^ 1].LoadState(ioReader); }
+    
+    if (!ioReader.IsOK()) { Reset(); }
+}
@@ -0,0 +1,171 @@
+//
+//  LoPassMultirate.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassMultirate_hpp
+#define LoPassMultirate_hpp
+
+#include "LoPassControlRate.hpp"
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Multirate
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// For very low cutoffs the signal is decimated by 2 per stage, filtered at the reduced rate
+// and interpolated back up. The biquad then runs at a fraction of the cost, and its poles
+// move away from z = 1 by the decimation factor, so it is better conditioned too.
+//
+// The number of stages follows the cutoff, so the same latency is reported for every stage
+// count: shorter chains are padded with a delay. A change of stage count brings up a second
+// lane at the new rate, lets it settle, and crossfades to it.
+
+/// Decimation by up to 2^kMultirate_MaxStages.
+static constexpr unsigned kMultirate_MaxStages  = 4;
+
+/// Internal block size in frames at the full rate.
+static constexpr unsigned kMultirate_ChunkSize  = 256;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Halfband
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// 11 tap equiripple halfband FIR in polyphase form, as a 2:1 decimator or a 1:2 interpolator.
+/// 100 dB stopband above 0.45 fs and flat to 0.0001 dB below 0.05 fs. That is all the band
+/// a stage has to keep: the cutoff is never above 0.016 of a stage's input rate.
+class LoPassHalfband {
+    
+public:
+    /// Group delay, in samples at the higher of the two rates.
+    static constexpr unsigned kDelay = 5;
+    
+    LoPassHalfband() { Reset(); }
+    
+    void Reset();
+    
+    /// Filter and keep every second sample; returns the number of samples written.
+    /// inFrames must not exceed kMultirate_ChunkSize.
+    unsigned Decimate(const float *inSourceP, float *outDestP, unsigned inFrames);
+    
+    /// Filter the zero stuffed input; writes 2 * inFrames samples.
+    /// inFrames must not exceed kMultirate_ChunkSize.
+    void Interpolate(const float *inSourceP, float *outDestP, unsigned inFrames);
+    
+    /// The history between blocks, see LoPassState.hpp.
+    void SaveState(LoPassStateWriter &ioWriter) const;
+    void LoadState(LoPassStateReader &ioReader);
+    
+private:
+    static constexpr unsigned kPairs        = 3;
+    static constexpr unsigned kHistory      = 2 * kPairs - 1;   // low rate samples kept
+    
+    void Convolve(const float *inEven, const float *inOdd, float *outDestP, unsigned inCount);
+    
+    // Polyphase branches, low rate history followed by the current block
+    float       mEven[kHistory + kMultirate_ChunkSize];
+    float       mOdd[kHistory + kMultirate_ChunkSize];
+    float       mScratch[kMultirate_ChunkSize];
+    unsigned    mOddPending;    // decimator: an odd sample is waiting for its even partner
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Multirate Lane
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Decimators, a smoothed biquad at the reduced rate, interpolators and the padding delay.
+class LoPassMultirateLane {
+    
+public:
+    LoPassMultirateLane(double inSampleRate);
+    
+    /// Change the number of stages; clears all state.
+    void Configure(unsigned inStages);
+    
+    unsigned GetStages() const { return mStages; }
+    
+    LoPassSmoothedBiquad &GetFilter() { return mFilter; }
+    const LoPassSmoothedBiquad &GetFilter() const { return mFilter; }
+    
+    /// inFreq is normalised to the full rate.
+    void SetTarget(double inFreq, double inResonance) { mFilter.SetTarget(inFreq * (1 << mStages), inResonance); }
+    
+    void Reset();
+    
+    /// inFramesToProcess must not exceed kMultirate_ChunkSize.
+    void Process(const float *inSourceP, float *inDestP, unsigned inFramesToProcess);
+    
+    /// Stage count and the state of every part, see LoPassState.hpp.
+    void SaveState(LoPassStateWriter &ioWriter) const;
+    void LoadState(LoPassStateReader &ioReader);
+    
+private:
+    double                  mSampleRate;
+    unsigned                mStages;
+    
+    LoPassHalfband          mDecimators[kMultirate_MaxStages];
+    LoPassHalfband          mInterpolators[kMultirate_MaxStages];
+    LoPassSmoothedBiquad    mFilter;
+    
+    float                   mScratch[2][kMultirate_ChunkSize + 4];
+    
+    // Interpolated output not yet handed out, the last stage produces whole groups of 2^stages.
+    float                   mPending[kMultirate_ChunkSize + 2 * (1 << kMultirate_MaxStages)];
+    unsigned                mPendingCount;
+    
+    std::vector<float>      mDelay;
+    unsigned                mDelayLength;
+    unsigned                mDelayPosition;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Multirate
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LoPassMultirate {
+    
+public:
+    LoPassMultirate(double inSampleRate);
+    
+    /// Latency in frames, the same for every stage count.
+    static unsigned GetLatencyFrames();
+    
+    /// Number of 2:1 stages for a normalised cutoff. inCurrent adds hysteresis.
+    static unsigned ChooseStages(double inFreq, unsigned inCurrent);
+    
+    unsigned GetStages() const { return mLanes[mActive].GetStages(); }
+    
+    /// IIR coefficient designs so far, both lanes together.
+    uint64_t GetDesignCount() const;
+    
+    void SetSmoothingTime(double inSeconds);
+    
+    /// inFreq is normalised frequency 0 -> 1, inResonance is in decibels.
+    void SetTarget(double inFreq, double inResonance);
+    
+    void Process(const float *inSourceP, float *inDestP, unsigned inFramesToProcess);
+    
+    void Reset();
+    
+    /// Both lanes and any lane change in progress, see LoPassState.hpp.
+    void SaveState(LoPassStateWriter &ioWriter) const;
+    void LoadState(LoPassStateReader &ioReader);
+    
+private:
+    void ProcessChunk(const float *inSourceP, float *inDestP, unsigned inFrames);
+    
+    double                  mSampleRate;
+    LoPassMultirateLane     mLanes[2];
+    int                     mActive;
+    
+    double                  mFreq;
+    double                  mResonance;
+    bool                    mPrimed;
+    
+    unsigned                mWarmupFrames;  // incoming lane runs silently for this long
+    unsigned                mFadeFrames;    // then fades in over this many frames
+    float                   mIncoming[kMultirate_ChunkSize];
+};
+
+#endif /* LoPassMultirate_hpp */
@@ -0,0 +1,242 @@
+//
+//  LoPassParallel.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassParallel.hpp"
+#include <math.h>
+#include <string.h>
+#include <thread>
+
+/// Shortest segment worth a thread of its own.
+static constexpr unsigned   kParallel_MinSegment        = 1 << 16;
+
+/// Segments are at least this many times the settling time, so reruns are short.
+static constexpr double     kParallel_SettlingRatio     = 4.0;
+
+/// Frames between checkpoints of the zero history run.
+static constexpr unsigned   kParallel_CheckpointFrames  = 1024;
+
+/// Decay that takes the carried-in state below the last bit of a double.
+static constexpr double     kParallel_SettlingDecay     = 1e-17;
+
+static bool IsSameState(const LoPassBiquadState &inA, const LoPassBiquadState &inB) {
+    return memcmp(&inA, &inB, sizeof(LoPassBiquadState)) == 0;
+}
+
+/// Output history within inTolerance of each other, relative to its size.
+static bool IsCloseState(const LoPassBiquadState &inA, const LoPassBiquadState &inB, double inTolerance) {
+    
+    double difference   = fabs(inA.mY1 - inB.mY1) + fabs(inA.mY2 - inB.mY2);
+    double size         = fabs(inA.mY1) + fabs(inA.mY2);
+    
+    return difference <= inTolerance * size;
+}
+
+/// Runs inFunction(i) for i in [0, inCount), index 0 on the calling thread.
+template <class F>
+static void RunInParallel(unsigned inCount, const F &inFunction) {
+    
+    std::vector<std::thread> threads;
+    
+    for (unsigned i = 1; i < inCount; i++) { threads.push_back(std::thread(inFunction, i)); }
+    
+    if (inCount > 0) { inFunction(0); }
+    
+    for (size_t i = 0; i < threads.size(); i++) { threads[i].join(); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassParallelBiquad::LoPassParallelBiquad()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassParallelBiquad::LoPassParallelBiquad(unsigned inThreads) :
+    mThreads(inThreads),
+    mTolerance(kParallel_DefaultTolerance),
+    mSettlingFrames(0.0),
+    mExact(true),
+    mCoefficients(NULL),
+    mSourceP(NULL),
+    mDestP(NULL) {
+    
+    if (mThreads == 0) { mThreads = std::thread::hardware_concurrency(); }
+    if (mThreads == 0) { mThreads = 1; }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassParallelBiquad::GetSettlingFrames()
+//
+// The carried-in (y1, y2) reaches the output through powers of the companion matrix
+// [-b1 -b2; 1 0], which shrink as rho^n for its spectral radius rho, the larger pole
+// magnitude. Twice the pure decay time covers the n rho^n term of coincident poles.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+double LoPassParallelBiquad::GetSettlingFrames(const LoPassCoefficients &inCoefficients) {
+    
+    const double b1 = inCoefficients.mB1;
+    const double b2 = inCoefficients.mB2;
+    double discriminant = b1 * b1 - 4.0 * b2;
+    double radius;
+    
+    if (discriminant < 0.0) {
+        radius = sqrt(b2);
+    } else {
+        double root = sqrt(discriminant);
+        radius = 0.5 * (fabs(b1) + root);
+    }
+    
+    if (radius >= 1.0) { return HUGE_VAL; }
+    if (radius <= 0.0) { return 2.0; }
+    
+    return 2.0 * log(kParallel_SettlingDecay) / log(radius) + 2.0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassParallelBiquad::RunZeroHistory()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassParallelBiquad::RunZeroHistory(Segment &ioSegment, const LoPassBiquad &inBiquad) {
+    
+    LoPassBiquad biquad = inBiquad;     // same precision
+    
+    if (ioSegment.mStart > 0) {
+        const float *history = mSourceP + ioSegment.mStart;
+        LoPassBiquadState state = { history[-1], history[-2], 0.0, 0.0 };
+        biquad.SetState(state);
+    }
+    
+    ioSegment.mCheckpoints.clear();
+    
+    for (unsigned done = 0; done < ioSegment.mFrames; ) {
+        
+        unsigned frames = ioSegment.mFrames - done;
+        if (frames > kParallel_CheckpointFrames) { frames = kParallel_CheckpointFrames; }
+        
+        unsigned offset = ioSegment.mStart + done;
+        biquad.Process(*mCoefficients, mSourceP + offset, mDestP + offset, frames);
+        
+        ioSegment.mCheckpoints.push_back(biquad.GetState());
+        done += frames;
+    }
+    
+    ioSegment.mEndState     = biquad.GetState();
+    ioSegment.mRerunFrames  = 0;
+    ioSegment.mConverged    = true;
+    ioSegment.mExact        = true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassParallelBiquad::Converge()
+//
+// Rerun from inState, overwriting the zero history output, until the two runs meet. A redo
+// has to get at least as far as any earlier rerun, whose output it is replacing.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassParallelBiquad::Converge(Segment                 &ioSegment,
+                                    const LoPassBiquad      &inBiquad,
+                                    const LoPassBiquadState &inState) {
+    
+    LoPassBiquad biquad = inBiquad;
+    biquad.SetState(inState);
+    
+    ioSegment.mStartState   = inState;
+    ioSegment.mConverged    = false;
+    ioSegment.mExact        = false;
+    
+    unsigned done = 0;
+    
+    for (size_t i = 0; i < ioSegment.mCheckpoints.size(); i++) {
+        
+        unsigned frames = ioSegment.mFrames - done;
+        if (frames > kParallel_CheckpointFrames) { frames = kParallel_CheckpointFrames; }
+        
+        unsigned offset = ioSegment.mStart + done;
+        biquad.Process(*mCoefficients, mSourceP + offset, mDestP + offset, frames);
+        done += frames;
+        
+        if (done < ioSegment.mRerunFrames) { continue; }
+        
+        LoPassBiquadState state = biquad.GetState();
+        
+        if (IsSameState(state, ioSegment.mCheckpoints[i])) {
+            ioSegment.mExact = true;
+        } else if (mTolerance <= 0.0 || done < mSettlingFrames || !IsCloseState(state, ioSegment.mCheckpoints[i], mTolerance)) {
+            continue;
+        }
+        
+        ioSegment.mRerunFrames  = done;
+        ioSegment.mConverged    = true;
+        return;
+    }
+    
+    // ran the whole segment, so it is as exact as the state it started from
+    ioSegment.mRerunFrames  = done;
+    ioSegment.mTrueEndState = biquad.GetState();
+    ioSegment.mExact        = true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassParallelBiquad::Process()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassParallelBiquad::Process(LoPassBiquad             &ioBiquad,
+                                   const LoPassCoefficients &inCoefficients,
+                                   const float              *inSourceP,
+                                   float                    *inDestP,
+                                   unsigned                 inFramesToProcess) {
+    
+    mSettlingFrames = GetSettlingFrames(inCoefficients);
+    mExact          = true;
+    
+    double minimum  = kParallel_SettlingRatio * mSettlingFrames;
+    if (minimum < kParallel_MinSegment) { minimum = kParallel_MinSegment; }
+    
+    double possible = inFramesToProcess / minimum;
+    unsigned count  = possible < mThreads ? (unsigned)possible : mThreads;
+    
+    bool overlap = inSourceP < inDestP + inFramesToProcess && inDestP < inSourceP + inFramesToProcess;
+    
+    if (count < 2 || overlap) {
+        ioBiquad.Process(inCoefficients, inSourceP, inDestP, inFramesToProcess);
+        return;
+    }
+    
+    mCoefficients   = &inCoefficients;
+    mSourceP        = inSourceP;
+    mDestP          = inDestP;
+    
+    mSegments.resize(count);
+    
+    for (unsigned i = 0; i < count; i++) {
+        unsigned start = (unsigned)((uint64_t)inFramesToProcess * i / count);
+        unsigned end   = (unsigned)((uint64_t)inFramesToProcess * (i + 1) / count);
+        mSegments[i].mStart     = start;
+        mSegments[i].mFrames    = end - start;
+    }
+    
+    const LoPassBiquad &biquad = ioBiquad;
+    
+    // 1. zero history runs; segment 0 starts from the real state
+    RunInParallel(count, [this, &biquad](unsigned i) { RunZeroHistory(mSegments[i], biquad); });
+    
+    // 2. reruns from the carried-in state, each taken from the previous segment
+    RunInParallel(count - 1, [this, &biquad](unsigned i) {
+        Converge(mSegments[i + 1], biquad, mSegments[i].mEndState);
+    });
+    
+    // 3. a segment that never converged handed on the wrong state
+    for (unsigned i = 1; i < count; i++) {
+        
+        const Segment &previous = mSegments[i - 1];
+        const LoPassBiquadState &state = previous.mConverged ? previous.mEndState : previous.mTrueEndState;
+        
+        if (!IsSameState(state, mSegments[i].mStartState)) { Converge(mSegments[i], biquad, state); }
+    }
+    
+    for (unsigned i = 1; i < count; i++) { mExact = mExact && mSegments[i].mExact; }
+    
+    const Segment &last = mSegments[count - 1];
+    ioBiquad.SetState(last.mConverged ? last.mEndState : last.mTrueEndState);
+}
@@ -0,0 +1,98 @@
+//
+//  LoPassParallel.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassParallel_hpp
+#define LoPassParallel_hpp
+
+#include "LoPassBiquad.hpp"
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Block-Parallel Biquad
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Runs one long block of a fixed-coefficient biquad across several threads, for offline
+// use, with the same result as LoPassBiquad::Process() on one thread.
+//
+// The block is cut into segments. With fixed coefficients, y = z + c, where z is the segment
+// filtered from zero output history (the input history is known, it is just the previous
+// input samples) and c is the response to the carried-in (y1, y2), which evolves through the
+// 2x2 companion matrix of the poles and dies away at the rate of the pole radius.
+//
+//  1.  In parallel, every segment is filtered from zero output history, keeping its state
+//      at checkpoints along the way. Segment 0 starts from the real state, so it is exact.
+//  2.  In parallel, every other segment is filtered again from the carried-in state, the
+//      end state of the previous segment's zero history run, until its state meets one of
+//      the checkpoints. From there on the zero history output is already correct.
+//  3.  If a segment never met its checkpoints, the next one started from the wrong state
+//      and is redone serially from the right one.
+//
+// Above a normalised cutoff of about 0.01 the two runs usually meet bit for bit within the
+// settling time, and the output is bit identical to a serial run. Below that the rounding
+// noise of the recursion is amplified enough that they settle to within ~1e-9 of each other
+// but never meet exactly. A segment is then accepted once past the settling time with its
+// state within the (relative) tolerance. At the default of 1e-7 the largest output
+// difference measured was 6.3e-8 of the peak level, about one float ulp, and well inside the
+// 120 dB the biquad forms are held to against a long double reference. A tolerance of 0
+// insists on bit identical output, which for low cutoffs ends up mostly serial.
+//
+// The input and output must not overlap; in place calls, short blocks and filters that
+// ring for too long are run serially.
+
+/// Default for LoPassParallelBiquad::SetTolerance().
+static constexpr double kParallel_DefaultTolerance = 1e-7;
+
+class LoPassParallelBiquad {
+    
+public:
+    /// inThreads of 0 uses one thread per core.
+    LoPassParallelBiquad(unsigned inThreads = 0);
+    
+    unsigned GetThreads() const { return mThreads; }
+    
+    /// Relative state difference accepted when the runs don't meet exactly; 0 for none.
+    void SetTolerance(double inTolerance) { mTolerance = inTolerance; }
+    
+    /// True if the last Process() was bit identical to a serial run.
+    bool WasExact() const { return mExact; }
+    
+    /// Same as ioBiquad.Process(), carrying ioBiquad's state through.
+    void Process(LoPassBiquad               &ioBiquad,
+                 const LoPassCoefficients   &inCoefficients,
+                 const float                *inSourceP,
+                 float                      *inDestP,
+                 unsigned                   inFramesToProcess);
+    
+    /// Samples for the carried-in state of this design to decay below double precision.
+    static double GetSettlingFrames(const LoPassCoefficients &inCoefficients);
+    
+private:
+    struct Segment {
+        unsigned                        mStart;
+        unsigned                        mFrames;
+        LoPassBiquadState               mStartState;    // the state the rerun started from
+        LoPassBiquadState               mEndState;      // of the zero history run
+        LoPassBiquadState               mTrueEndState;  // of the rerun, if it never converged
+        unsigned                        mRerunFrames;   // output overwritten by reruns so far
+        bool                            mConverged;
+        bool                            mExact;
+        std::vector<LoPassBiquadState>  mCheckpoints;
+    };
+    
+    void RunZeroHistory(Segment &ioSegment, const LoPassBiquad &inBiquad);
+    void Converge(Segment &ioSegment, const LoPassBiquad &inBiquad, const LoPassBiquadState &inState);
+    
+    unsigned                mThreads;
+    double                  mTolerance;
+    double                  mSettlingFrames;
+    bool                    mExact;
+    const LoPassCoefficients *mCoefficients;
+    const float             *mSourceP;
+    float                   *mDestP;
+    std::vector<Segment>    mSegments;
+};
+
+#endif /* LoPassParallel_hpp */
@@ -0,0 +1,112 @@
+//
+//  LoPassParameters.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassParameters_h
+#define LoPassParameters_h
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Parameters
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Parameter IDs, ranges and factory presets, free of CoreAudio types so the offline tools
+// render with exactly the values the AudioUnit uses. The parameter names and the AUPreset
+// table live in LoPassUnit.hpp.
+
+// Define constants to represent the User Interface parameter min/max and default values.
+static constexpr float  kMinimumValue_LoPass_Frequency  = 12.0;
+//static constexpr float  kMaximumValue_LoPass_Frequency  = 20000.0;
+static constexpr float  kDefaultValue_LoPass_Frequency  = 1000.0;
+
+static constexpr float  kMinimumValue_LoPass_Resonance  = -20.0;
+static constexpr float  kMaximumValue_LoPass_Resonance  = 20.0;
+static constexpr float  kDefaultValue_LoPass_Resonance  = 0.0;
+
+static constexpr float  kDefaultValue_LoPass_LinearPhase = 0.0;
+
+static constexpr float  kMinimumValue_LoPass_Smoothing  = 0.0;
+static constexpr float  kMaximumValue_LoPass_Smoothing  = 500.0;
+static constexpr float  kDefaultValue_LoPass_Smoothing  = 20.0;
+
+static constexpr float  kDefaultValue_LoPass_Multirate  = 0.0;
+
+// Define an enum to represent ParameterID values.
+enum Parameters {
+    kParameter_CutoffFrequency          = 0,
+    kParameter_Resonance                = 1,
+    kParameter_LinearPhase              = 2,
+    kParameter_Smoothing                = 3,
+    kParameter_Multirate                = 4,
+    kNumberOfParameters                 = 5
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Factory Presets
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+enum FactoryPresets {
+    kPreset_Default     = 0,
+    kPreset_Dark        = 1,
+    kPreset_Bright      = 2,
+    kNumberOfPresets    = 3,
+};
+
+static constexpr float kParameter_Preset_Frequency_Default  = 1000.0;
+static constexpr float kParameter_Preset_Resonance_Default  = 0.0;
+
+/// Define a constant for the Cutoff Freq for preset "dark".
+static constexpr float kParameter_Preset_Frequency_Dark     = 200.0;
+/// Define a constant for the Resonance for preset "dark".
+static constexpr float kParameter_Preset_Resonance_Dark     = -5.0;
+/// Define a constant for the Cutoff Freq for preset "bright".
+static constexpr float kParameter_Preset_Frequency_Bright   = 1000.0;
+/// Define a constant for the Resonance for preset "bright".
+static constexpr float kParameter_Preset_Resonance_Bright   = 10.0;
+
+/// The factory presets by number, with the same names as the AUPreset table.
+struct LoPassPresetValues {
+    const char  *mName;
+    float       mFrequency;
+    float       mResonance;
+};
+
+static const LoPassPresetValues kPresetValues[kNumberOfPresets] = {
+    { "Default", kDefaultValue_LoPass_Frequency, kDefaultValue_LoPass_Resonance },
+    { "Dark", kParameter_Preset_Frequency_Dark, kParameter_Preset_Resonance_Dark },
+    { "Bright", kParameter_Preset_Frequency_Bright, kParameter_Preset_Resonance_Bright }
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Normalisation
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Bounds check cutoff (Hz) and resonance (dB), and convert the cutoff to the normalised
+/// 0 -> 1 frequency the filter is designed from.
+inline void LoPassNormaliseParameters(double    inCutoff,
+                                      double    inResonance,
+                                      double    inSampleRate,
+                                      double    &outFreq,
+                                      double    &outResonance) {
+    
+    double cutoff       = inCutoff;
+    double resonance    = inResonance;
+    
+    // do bounds checking on parameters
+    if (cutoff < kMinimumValue_LoPass_Frequency) { cutoff = kMinimumValue_LoPass_Frequency; }
+    
+    if (resonance < kMinimumValue_LoPass_Resonance) { resonance = kMinimumValue_LoPass_Resonance; }
+    if (resonance > kMaximumValue_LoPass_Resonance) { resonance = kMaximumValue_LoPass_Resonance; }
+    
+    // Convert to 0->1 normalized frequency
+    float srate = inSampleRate;
+    
+    cutoff = 2.0 * cutoff / srate;
+    if (cutoff > 0.99) { cutoff = 0.99; } // clip cutoff to highest allowed by sample rate.
+    
+    outFreq         = cutoff;
+    outResonance    = resonance;
+}
+
+#endif /* LoPassParameters_h */
@@ -0,0 +1,288 @@
+//
+//  LoPassProcessor.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassProcessor.hpp"
+#include "LoPassParameters.h"
+#include <math.h>
+#include <string.h>
+
+// State blob: magic, version, sample rate, mode, the active path, then a CRC-32 of it all.
+static const uint8_t kStateMagic[4] = { 'L', 'P', 's', 't' };
+
+// The tail runs until the IIR's ringing is down by this much on the input, matching the
+// 120 dB the filter is accurate to; what is left is dropped when the unit skips silence.
+static constexpr double kTail_Level = 1e-6;
+
+enum {
+    kStateMode_Filter       = 0,
+    kStateMode_Multirate    = 1,
+    kStateMode_LinearPhase  = 2
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSettings::LoPassSettings()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassSettings::LoPassSettings() :
+    mCutoff(kDefaultValue_LoPass_Frequency),
+    mResonance(kDefaultValue_LoPass_Resonance),
+    mSmoothing(kDefaultValue_LoPass_Smoothing),
+    mLinearPhase(kDefaultValue_LoPass_LinearPhase != 0.0),
+    mMultirate(kDefaultValue_LoPass_Multirate != 0.0) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::LoPassProcessor()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassProcessor::LoPassProcessor(double inSampleRate) :
+    mSampleRate(inSampleRate),
+    mFilter(inSampleRate),
+    mLinearPhase(NULL),
+    mLastLinearPhase(false),
+    mMultirate(inSampleRate),
+    mLastMultirate(false) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::~LoPassProcessor()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassProcessor::~LoPassProcessor() {
+    delete mLinearPhase.load(std::memory_order_acquire);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::GetLatencyFrames()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassProcessor::GetLatencyFrames(const LoPassSettings &inSettings, double inSampleRate) {
+    
+    // linear phase takes precedence
+    if (inSettings.mLinearPhase) { return LoPassLinearPhase::GetLatencyFrames(inSampleRate); }
+    if (inSettings.mMultirate) { return LoPassMultirate::GetLatencyFrames(); }
+    
+    return 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::GetTailFrames()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassProcessor::GetTailFrames(const LoPassSettings &inSettings, double inSampleRate) {
+    
+    if (inSettings.mLinearPhase) { return LoPassLinearPhase::GetFilterLength(inSampleRate) / 2; }
+    
+    double freq, resonance;
+    LoPassNormaliseParameters(inSettings.mCutoff, inSettings.mResonance, inSampleRate, freq, resonance);
+    
+    LoPassCoefficients coefficients;
+    LoPassFilter::CalculateLopassParams(freq, resonance, coefficients);
+    
+    // the resonant peak rings up to this much above the input
+    double peak = fmax(1.0, pow(10.0, 0.05 * resonance));
+    double frames = LoPassFilter::GetDecayFrames(coefficients, kTail_Level / peak);
+    
+    // a ramp still under way when the input stops lands on its target first
+    frames += 0.001 * inSettings.mSmoothing * inSampleRate;
+    
+    // The multirate IIR rings for as long in seconds at its own rate. The halfband chains
+    // run on for their own length after it, twice their delay; the latency covers one.
+    if (inSettings.mMultirate) { frames += LoPassMultirate::GetLatencyFrames(); }
+    
+    return (unsigned)ceil(frames);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::Prepare()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassProcessor::Prepare(const LoPassSettings &inSettings) {
+    
+    if (!inSettings.mLinearPhase || mLinearPhase.load(std::memory_order_acquire) != NULL) { return; }
+    
+    double freq, resonance;
+    LoPassNormaliseParameters(inSettings.mCutoff, inSettings.mResonance, mSampleRate, freq, resonance);
+    
+    GetLinearPhase(freq, resonance);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::GetLinearPhase()
+//
+// The convolver, created and designed for the given target if there isn't one yet. Prepare()
+// on another thread may get there first, in which case ours is thrown away.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassLinearPhase *LoPassProcessor::GetLinearPhase(double inFreq, double inResonance) {
+    
+    LoPassLinearPhase *linearPhase = mLinearPhase.load(std::memory_order_acquire);
+    if (linearPhase != NULL) { return linearPhase; }
+    
+    LoPassLinearPhase *created = new LoPassLinearPhase(mSampleRate);
+    created->SetTarget(inFreq, inResonance);
+    created->Design();
+    
+    if (mLinearPhase.compare_exchange_strong(linearPhase, created, std::memory_order_acq_rel)) { return created; }
+    
+    delete created;
+    return linearPhase;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::GetDesignCount()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+uint64_t LoPassProcessor::GetDesignCount() const {
+    return mFilter.GetControlRate().GetDesignCount() + mMultirate.GetDesignCount();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::Reset()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassProcessor::Reset() {
+    
+    // Forces filter coefficient calculation, jumping straight to the current parameters.
+    mFilter.Reset();
+    
+    LoPassLinearPhase *linearPhase = mLinearPhase.load(std::memory_order_acquire);
+    if (linearPhase != NULL) { linearPhase->Reset(); }
+    
+    mMultirate.Reset();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::Process()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassProcessor::Process(const LoPassSettings  &inSettings,
+                              const float           *inSourceP,
+                              float                 *inDestP,
+                              unsigned              inFramesToProcess) {
+    
+    double cutoff, resonance;
+    LoPassNormaliseParameters(inSettings.mCutoff, inSettings.mResonance, mSampleRate, cutoff, resonance);
+    
+    // Switching modes starts every path from a clean state.
+    bool linearPhase    = inSettings.mLinearPhase;
+    bool multirate      = inSettings.mMultirate && !linearPhase;
+    
+    if (linearPhase != mLastLinearPhase || multirate != mLastMultirate) {
+        Reset();
+        mLastLinearPhase    = linearPhase;
+        mLastMultirate      = multirate;
+    }
+    
+    if (linearPhase) {
+        LoPassLinearPhase *convolver = GetLinearPhase(cutoff, resonance);
+        convolver->SetTarget(cutoff, resonance);
+        convolver->Process(inSourceP, inDestP, inFramesToProcess);
+        return;
+    }
+    
+    double smoothingTime = inSettings.mSmoothing * 0.001;
+    
+    if (multirate) {
+        mMultirate.SetSmoothingTime(smoothingTime);
+        mMultirate.SetTarget(cutoff, resonance);
+        mMultirate.Process(inSourceP, inDestP, inFramesToProcess);
+        return;
+    }
+    
+    mFilter.GetControlRate().SetSmoothingTime(smoothingTime);
+    mFilter.SetTarget(cutoff, resonance);
+    mFilter.Process(inSourceP, inDestP, inFramesToProcess);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::ExportState()
+//
+// Only the path in use is written: a change of mode resets every path anyway.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassProcessor::ExportState(std::vector<uint8_t> &outState) const {
+    
+    size_t start = outState.size();
+    LoPassStateWriter writer(outState);
+    
+    uint32_t mode = mLastLinearPhase ? kStateMode_LinearPhase : mLastMultirate ? kStateMode_Multirate : kStateMode_Filter;
+    
+    writer.PutBytes(kStateMagic, sizeof(kStateMagic));
+    writer.PutUInt32(kProcessor_StateVersion);
+    writer.PutDouble(mSampleRate);
+    writer.PutUInt32(mode);
+    
+    switch (mode) {
+        case kStateMode_LinearPhase:    mLinearPhase.load(std::memory_order_acquire)->SaveState(writer); break;
+        case kStateMode_Multirate:      mMultirate.SaveState(writer); break;
+        default:                        mFilter.SaveState(writer); break;
+    }
+    
+    writer.PutUInt32(LoPassStateChecksum(&outState[start], outState.size() - start));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassProcessor::ImportState()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassProcessor::ImportState(const uint8_t *inState, size_t inSize) {
+    
+    Reset();
+    mLastLinearPhase    = false;
+    mLastMultirate      = false;
+    
+    // everything but the checksum at the end
+    if (inState == NULL || inSize < sizeof(kStateMagic) + 4) { return false; }
+    
+    size_t size = inSize - 4;
+    LoPassStateReader checksum(inState + size, 4);
+    if (checksum.GetUInt32() != LoPassStateChecksum(inState, size)) { return false; }
+    
+    LoPassStateReader reader(inState, size);
+    
+    uint8_t magic[sizeof(kStateMagic)];
+    reader.GetBytes(magic, sizeof(magic));
+    
+    if (memcmp(magic, kStateMagic, sizeof(magic)) != 0) { return false; }
+    if (reader.GetUInt32() != kProcessor_StateVersion) { return false; }
+    if (reader.GetDouble() != mSampleRate) { return false; }
+    
+    switch (reader.GetUInt32()) {
+        case kStateMode_Filter:
+            mFilter.LoadState(reader);
+            break;
+            
+        case kStateMode_Multirate:
+            mMultirate.LoadState(reader);
+            mLastMultirate = true;
+            break;
+            
+        case kStateMode_LinearPhase: {
+            // designed from the state's targets as it loads
+            LoPassLinearPhase *linearPhase = mLinearPhase.load(std::memory_order_acquire);
+            if (linearPhase == NULL) {
+                linearPhase = new LoPassLinearPhase(mSampleRate);
+                mLinearPhase.store(linearPhase, std::memory_order_release);
+            }
+            linearPhase->LoadState(reader);
+            mLastLinearPhase = true;
+            break;
+        }
+            
+        default:
+            reader.Fail();
+            break;
+    }
+    
+    if (reader.IsOK() && reader.GetRemaining() == 0) { return true; }
+    
+    Reset();
+    mLastLinearPhase    = false;
+    mLastMultirate      = false;
+    return false;
+}
@@ -0,0 +1,115 @@
+//
+//  LoPassProcessor.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassProcessor_hpp
+#define LoPassProcessor_hpp
+
+#include "LoPassControlRate.hpp"
+#include "LoPassLinearPhase.hpp"
+#include "LoPassMultirate.hpp"
+#include "LoPassState.hpp"
+#include <atomic>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Processor
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// One channel of the complete effect: the IIR filter, the linear phase and the multirate
+// paths, and the switching between them. LoPassKernel is a thin wrapper around this, and
+// the offline tools use it directly, so both render exactly the same thing.
+//
+// Process() takes any number of frames, and splitting a stream into different chunks gives
+// the same output to the bit. The linear phase convolver (most of a processor's memory, and
+// a full FIR design) only exists once Prepare() or Process() has been given settings with
+// linear phase on. With ExportState() and ImportState() a stream can also be
+// stopped after any chunk and carried on by another processor, in another process or on
+// another machine, with no discontinuity: the output is the same as if it had never been
+// split. The blob is versioned and checksummed; one that doesn't match is refused.
+
+/// Parameter values, as the AudioUnit holds them.
+struct LoPassSettings {
+    double  mCutoff;        // Hz
+    double  mResonance;     // dB
+    double  mSmoothing;     // ms
+    bool    mLinearPhase;
+    bool    mMultirate;
+    
+    /// The AudioUnit defaults.
+    LoPassSettings();
+};
+
+/// Bumped whenever the layout of an exported state changes; older blobs are refused.
+static constexpr uint32_t kProcessor_StateVersion = 2;
+
+class LoPassProcessor {
+    
+public:
+    LoPassProcessor(double inSampleRate);
+    ~LoPassProcessor();
+    
+    LoPassProcessor(const LoPassProcessor &) = delete;
+    LoPassProcessor &operator=(const LoPassProcessor &) = delete;
+    
+    /// Latency in frames for the given mode.
+    static unsigned GetLatencyFrames(const LoPassSettings &inSettings, double inSampleRate);
+    
+    /// Tail in frames for the given mode: until the IIR's ringing is 120 dB down, from its
+    /// pole radius and resonance, plus the smoothing time and, in multirate mode, the halfband
+    /// chains; half the FIR in linear phase mode. Past it a host may skip silent buffers, so
+    /// Reset() before skipping: the output carries on within 120 dB of never having stopped.
+    static unsigned GetTailFrames(const LoPassSettings &inSettings, double inSampleRate);
+    
+    /// If these settings use linear phase, create the convolver and design its FIR for them
+    /// straight away; otherwise, or if it already exists, do nothing. Never call this on the
+    /// render thread, but it may run alongside Process(), which would otherwise create the
+    /// convolver itself the first time linear phase is on.
+    void Prepare(const LoPassSettings &inSettings);
+    
+    /// The IIR filter, used when neither linear phase nor multirate mode is on.
+    LoPassSmoothedBiquad &GetFilter() { return mFilter; }
+    
+    /// Spread the IIR filter across threads once the parameters settle (offline only).
+    /// The other modes always run serially.
+    void SetParallel(LoPassParallelBiquad *inParallel) { mFilter.SetParallel(inParallel); }
+    
+    void Process(const LoPassSettings   &inSettings,
+                 const float            *inSourceP,
+                 float                  *inDestP,
+                 unsigned               inFramesToProcess);
+    
+    /// IIR coefficient designs so far by the filter and multirate paths, for telemetry.
+    uint64_t GetDesignCount() const;
+    
+    /// Clear every path; the next parameters are jumped to rather than smoothed.
+    void Reset();
+    
+    /// Append the state of the path in use to outState. Call between Process() calls,
+    /// never alongside one; the settings themselves aren't included.
+    void ExportState(std::vector<uint8_t> &outState) const;
+    
+    /// Carry on from an exported state. The next Process() must be given the settings
+    /// the exporting processor would have been given. Returns false, leaving the processor
+    /// reset, if the blob is damaged, from another version or for another sample rate.
+    /// Never call this on the render thread: a linear phase state designs its filters here.
+    bool ImportState(const uint8_t *inState, size_t inSize);
+    
+private:
+    LoPassLinearPhase *GetLinearPhase(double inFreq, double inResonance);
+    
+    double                  mSampleRate;
+    
+    LoPassSmoothedBiquad    mFilter;
+    
+    // Linear phase mode, created on first use and published to Process() with release
+    std::atomic<LoPassLinearPhase *> mLinearPhase;
+    bool                    mLastLinearPhase;
+    
+    // Multirate mode, for very low cutoffs
+    LoPassMultirate         mMultirate;
+    bool                    mLastMultirate;
+};
+
+#endif /* LoPassProcessor_hpp */
@@ -0,0 +1,296 @@
+//
+//  LoPassSIMD.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassSIMD_h
+#define LoPassSIMD_h
+
+// Thin wrappers over the native vector units so the DSP code can be written once.
+// SSE2 is the baseline on Intel, NEON on Apple Silicon; anything else gets a scalar fallback.
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define LOPASS_SIMD_SSE     1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define LOPASS_SIMD_NEON    1
+#endif
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassFloat4
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Four packed single precision values.
+struct LoPassFloat4 {
+#if LOPASS_SIMD_SSE
+    __m128      v;
+#elif LOPASS_SIMD_NEON
+    float32x4_t v;
+#else
+    float       v[4];
+#endif
+
+    static inline LoPassFloat4 Load(const float *inP) {
+        LoPassFloat4 r;
+#if LOPASS_SIMD_SSE
+        r.v = _mm_loadu_ps(inP);
+#elif LOPASS_SIMD_NEON
+        r.v = vld1q_f32(inP);
+#else
+        for (int i = 0; i < 4; i++) { r.v[i] = inP[i]; }
+#endif
+        return r;
+    }
+
+    static inline LoPassFloat4 Set(float inValue) {
+        LoPassFloat4 r;
+#if LOPASS_SIMD_SSE
+        r.v = _mm_set1_ps(inValue);
+#elif LOPASS_SIMD_NEON
+        r.v = vdupq_n_f32(inValue);
+#else
+        for (int i = 0; i < 4; i++) { r.v[i] = inValue; }
+#endif
+        return r;
+    }
+
+    inline void Store(float *outP) const {
+#if LOPASS_SIMD_SSE
+        _mm_storeu_ps(outP, v);
+#elif LOPASS_SIMD_NEON
+        vst1q_f32(outP, v);
+#else
+        for (int i = 0; i < 4; i++) { outP[i] = v[i]; }
+#endif
+    }
+};
+
+inline LoPassFloat4 operator+(const LoPassFloat4 &a, const LoPassFloat4 &b) {
+    LoPassFloat4 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_add_ps(a.v, b.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vaddq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; i++) { r.v[i] = a.v[i] + b.v[i]; }
+#endif
+    return r;
+}
+
+inline LoPassFloat4 operator-(const LoPassFloat4 &a, const LoPassFloat4 &b) {
+    LoPassFloat4 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_sub_ps(a.v, b.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vsubq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; i++) { r.v[i] = a.v[i] - b.v[i]; }
+#endif
+    return r;
+}
+
+inline LoPassFloat4 operator*(const LoPassFloat4 &a, const LoPassFloat4 &b) {
+    LoPassFloat4 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_mul_ps(a.v, b.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vmulq_f32(a.v, b.v);
+#else
+    for (int i = 0; i < 4; i++) { r.v[i] = a.v[i] * b.v[i]; }
+#endif
+    return r;
+}
+
+/// Split eight interleaved values into the even and the odd ones.
+inline void LoPassDeinterleave(const float *inP, LoPassFloat4 &outEven, LoPassFloat4 &outOdd) {
+#if LOPASS_SIMD_SSE
+    __m128 a = _mm_loadu_ps(inP);
+    __m128 b = _mm_loadu_ps(inP + 4);
+    outEven.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    outOdd.v  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+#elif LOPASS_SIMD_NEON
+    float32x4x2_t r = vld2q_f32(inP);
+    outEven.v = r.val[0];
+    outOdd.v  = r.val[1];
+#else
+    for (int i = 0; i < 4; i++) { outEven.v[i] = inP[2 * i]; outOdd.v[i] = inP[2 * i + 1]; }
+#endif
+}
+
+/// The inverse of LoPassDeinterleave(): writes eight values.
+inline void LoPassInterleave(const LoPassFloat4 &inEven, const LoPassFloat4 &inOdd, float *outP) {
+#if LOPASS_SIMD_SSE
+    _mm_storeu_ps(outP,     _mm_unpacklo_ps(inEven.v, inOdd.v));
+    _mm_storeu_ps(outP + 4, _mm_unpackhi_ps(inEven.v, inOdd.v));
+#elif LOPASS_SIMD_NEON
+    float32x4x2_t r = { { inEven.v, inOdd.v } };
+    vst2q_f32(outP, r);
+#else
+    for (int i = 0; i < 4; i++) { outP[2 * i] = inEven.v[i]; outP[2 * i + 1] = inOdd.v[i]; }
+#endif
+}
+
+/// Transpose the 4 x 4 matrix whose rows are io0 to io3.
+inline void LoPassTranspose(LoPassFloat4 &io0, LoPassFloat4 &io1, LoPassFloat4 &io2, LoPassFloat4 &io3) {
+#if LOPASS_SIMD_SSE
+    _MM_TRANSPOSE4_PS(io0.v, io1.v, io2.v, io3.v);
+#elif LOPASS_SIMD_NEON
+    float32x4x2_t t01 = vtrnq_f32(io0.v, io1.v);
+    float32x4x2_t t23 = vtrnq_f32(io2.v, io3.v);
+    io0.v = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    io1.v = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    io2.v = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    io3.v = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+#else
+    LoPassFloat4 *rows[4] = { &io0, &io1, &io2, &io3 };
+    for (int i = 0; i < 4; i++) {
+        for (int j = i + 1; j < 4; j++) {
+            float t = rows[i]->v[j]; rows[i]->v[j] = rows[j]->v[i]; rows[j]->v[i] = t;
+        }
+    }
+#endif
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassDouble2
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Two packed double precision values.
+struct LoPassDouble2 {
+#if LOPASS_SIMD_SSE
+    __m128d     v;
+#elif LOPASS_SIMD_NEON
+    float64x2_t v;
+#else
+    double      v[2];
+#endif
+
+    static inline LoPassDouble2 Load(const double *inP) {
+        LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+        r.v = _mm_loadu_pd(inP);
+#elif LOPASS_SIMD_NEON
+        r.v = vld1q_f64(inP);
+#else
+        r.v[0] = inP[0]; r.v[1] = inP[1];
+#endif
+        return r;
+    }
+
+    static inline LoPassDouble2 Set(double inValue) {
+        LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+        r.v = _mm_set1_pd(inValue);
+#elif LOPASS_SIMD_NEON
+        r.v = vdupq_n_f64(inValue);
+#else
+        r.v[0] = r.v[1] = inValue;
+#endif
+        return r;
+    }
+
+    inline void Store(double *outP) const {
+#if LOPASS_SIMD_SSE
+        _mm_storeu_pd(outP, v);
+#elif LOPASS_SIMD_NEON
+        vst1q_f64(outP, v);
+#else
+        outP[0] = v[0]; outP[1] = v[1];
+#endif
+    }
+};
+
+inline LoPassDouble2 operator+(const LoPassDouble2 &a, const LoPassDouble2 &b) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_add_pd(a.v, b.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vaddq_f64(a.v, b.v);
+#else
+    r.v[0] = a.v[0] + b.v[0]; r.v[1] = a.v[1] + b.v[1];
+#endif
+    return r;
+}
+
+inline LoPassDouble2 operator-(const LoPassDouble2 &a, const LoPassDouble2 &b) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_sub_pd(a.v, b.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vsubq_f64(a.v, b.v);
+#else
+    r.v[0] = a.v[0] - b.v[0]; r.v[1] = a.v[1] - b.v[1];
+#endif
+    return r;
+}
+
+inline LoPassDouble2 operator*(const LoPassDouble2 &a, const LoPassDouble2 &b) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_mul_pd(a.v, b.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vmulq_f64(a.v, b.v);
+#else
+    r.v[0] = a.v[0] * b.v[0]; r.v[1] = a.v[1] * b.v[1];
+#endif
+    return r;
+}
+
+inline LoPassDouble2 operator/(const LoPassDouble2 &a, const LoPassDouble2 &b) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_div_pd(a.v, b.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vdivq_f64(a.v, b.v);
+#else
+    r.v[0] = a.v[0] / b.v[0]; r.v[1] = a.v[1] / b.v[1];
+#endif
+    return r;
+}
+
+inline LoPassDouble2 Sqrt(const LoPassDouble2 &a) {
+    LoPassDouble2 r;
+#if LOPASS_SIMD_SSE
+    r.v = _mm_sqrt_pd(a.v);
+#elif LOPASS_SIMD_NEON
+    r.v = vsqrtq_f64(a.v);
+#else
+    r.v[0] = __builtin_sqrt(a.v[0]); r.v[1] = __builtin_sqrt(a.v[1]);
+#endif
+    return r;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Spectral helpers
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Split complex multiply-accumulate, ioY += inX * inH, over inCount bins.
+/// This is the inner loop of the partitioned convolver.
+inline void LoPassComplexMultiplyAccumulate(const float   *inXReal,
+                                            const float   *inXImag,
+                                            const float   *inHReal,
+                                            const float   *inHImag,
+                                            float         *ioYReal,
+                                            float         *ioYImag,
+                                            unsigned      inCount) {
+    unsigned i = 0;
+
+    for (; i + 4 <= inCount; i += 4) {
+        LoPassFloat4 xr = LoPassFloat4::Load(inXReal + i);
+        LoPassFloat4 xi = LoPassFloat4::Load(inXImag + i);
+        LoPassFloat4 hr = LoPassFloat4::Load(inHReal + i);
+        LoPassFloat4 hi = LoPassFloat4::Load(inHImag + i);
+
+        (LoPassFloat4::Load(ioYReal + i) + xr * hr - xi * hi).Store(ioYReal + i);
+        (LoPassFloat4::Load(ioYImag + i) + xr * hi + xi * hr).Store(ioYImag + i);
+    }
+
+    for (; i < inCount; i++) {
+        ioYReal[i] += inXReal[i] * inHReal[i] - inXImag[i] * inHImag[i];
+        ioYImag[i] += inXReal[i] * inHImag[i] + inXImag[i] * inHReal[i];
+    }
+}
+
+#endif /* LoPassSIMD_h */
@@ -0,0 +1,196 @@
+//
+//  LoPassState.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassState.hpp"
+#include <string.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateWriter::PutUInt32()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateWriter::PutUInt32(uint32_t inValue) {
+
+    for (int i = 0; i < 4; i++) { mBuffer.push_back((uint8_t)(inValue >> (8 * i))); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateWriter::PutDouble()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateWriter::PutDouble(double inValue) {
+
+    uint64_t bits;
+    memcpy(&bits, &inValue, sizeof(bits));
+
+    for (int i = 0; i < 8; i++) { mBuffer.push_back((uint8_t)(bits >> (8 * i))); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateWriter::PutFloats()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateWriter::PutFloats(const float *inValues, size_t inCount) {
+
+    if (inCount == 0) { return; }
+
+    size_t start = mBuffer.size();
+    mBuffer.resize(start + 4 * inCount);
+
+    uint8_t *p = &mBuffer[0] + start;
+
+    for (size_t n = 0; n < inCount; n++, p += 4) {
+        uint32_t bits;
+        memcpy(&bits, &inValues[n], sizeof(bits));
+
+        p[0] = (uint8_t)bits;
+        p[1] = (uint8_t)(bits >> 8);
+        p[2] = (uint8_t)(bits >> 16);
+        p[3] = (uint8_t)(bits >> 24);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateWriter::PutDoubles()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateWriter::PutDoubles(const double *inValues, size_t inCount) {
+
+    for (size_t n = 0; n < inCount; n++) { PutDouble(inValues[n]); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateWriter::PutBytes()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateWriter::PutBytes(const void *inBytes, size_t inCount) {
+
+    const uint8_t *bytes = (const uint8_t *)inBytes;
+    mBuffer.insert(mBuffer.end(), bytes, bytes + inCount);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateReader::Take()
+//
+// returns the next inCount bytes, or NULL and fails if there aren't that many left
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+const uint8_t *LoPassStateReader::Take(size_t inCount) {
+
+    if (!mOK || inCount > mSize - mPosition) {
+        mOK = false;
+        return NULL;
+    }
+
+    const uint8_t *p = mBytes + mPosition;
+    mPosition += inCount;
+    return p;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateReader::GetUInt32()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+uint32_t LoPassStateReader::GetUInt32() {
+
+    const uint8_t *p = Take(4);
+    if (p == NULL) { return 0; }
+
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateReader::GetDouble()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+double LoPassStateReader::GetDouble() {
+
+    const uint8_t *p = Take(8);
+    if (p == NULL) { return 0.0; }
+
+    uint64_t bits = 0;
+    for (int i = 7; i >= 0; i--) { bits = bits << 8 | p[i]; }
+
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateReader::GetBool()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassStateReader::GetBool() {
+
+    const uint8_t *p = Take(1);
+    if (p == NULL) { return false; }
+
+    if (*p > 1) { mOK = false; }
+    return *p == 1;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateReader::GetFloats()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateReader::GetFloats(float *outValues, size_t inCount) {
+
+    // checked first, 4 * inCount could overflow
+    const uint8_t *p = inCount <= GetRemaining() / 4 ? Take(4 * inCount) : NULL;
+
+    if (p == NULL) {
+        mOK = false;
+        memset(outValues, 0, inCount * sizeof(float));
+        return;
+    }
+
+    for (size_t n = 0; n < inCount; n++, p += 4) {
+        uint32_t bits = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        memcpy(&outValues[n], &bits, sizeof(bits));
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateReader::GetDoubles()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateReader::GetDoubles(double *outValues, size_t inCount) {
+
+    for (size_t n = 0; n < inCount; n++) { outValues[n] = GetDouble(); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateReader::GetBytes()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassStateReader::GetBytes(void *outBytes, size_t inCount) {
+
+    const uint8_t *p = Take(inCount);
+
+    if (p == NULL) {
+        memset(outBytes, 0, inCount);
+    } else {
+        memcpy(outBytes, p, inCount);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassStateChecksum()
+//
+// Bytewise and table free; it only runs on export and import, never while rendering.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+uint32_t LoPassStateChecksum(const uint8_t *inBytes, size_t inSize) {
+
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t n = 0; n < inSize; n++) {
+        crc ^= inBytes[n];
+        for (int bit = 0; bit < 8; bit++) { crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u))); }
+    }
+
+    return ~crc;
+}
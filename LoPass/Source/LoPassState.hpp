@@ -0,0 +1,78 @@
+//
+//  LoPassState.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassState_hpp
+#define LoPassState_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass State Archive
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Filter state written out so a stream can be stopped and picked up again elsewhere, in
+// another process or on another machine, without a glitch. Values are stored little endian
+// whatever the host, and floating point values bit for bit, so a resumed stream carries on
+// exactly where it left off.
+//
+// Each class writes its own fields with SaveState() and reads them back, in the same order,
+// with LoadState(). The reader never reads past the end; a short or damaged blob just turns
+// IsOK() false and the caller throws the result away. LoPassProcessor wraps the lot with a
+// header and a checksum.
+
+class LoPassStateWriter {
+
+public:
+    explicit LoPassStateWriter(std::vector<uint8_t> &outBuffer) : mBuffer(outBuffer) { }
+
+    void PutUInt32(uint32_t inValue);
+    void PutDouble(double inValue);
+    void PutBool(bool inValue) { mBuffer.push_back(inValue ? 1 : 0); }
+    void PutFloats(const float *inValues, size_t inCount);
+    void PutDoubles(const double *inValues, size_t inCount);
+    void PutBytes(const void *inBytes, size_t inCount);
+
+private:
+    std::vector<uint8_t>    &mBuffer;
+};
+
+class LoPassStateReader {
+
+public:
+    LoPassStateReader(const uint8_t *inBytes, size_t inSize) : mBytes(inBytes), mSize(inSize), mPosition(0), mOK(true) { }
+
+    /// False once anything was read past the end or rejected with Fail().
+    bool IsOK() const { return mOK; }
+
+    /// Bytes not read yet.
+    size_t GetRemaining() const { return mSize - mPosition; }
+
+    /// Mark the blob as bad, for values that read fine but make no sense.
+    void Fail() { mOK = false; }
+
+    // Each returns 0 (or false) once IsOK() is false.
+    uint32_t GetUInt32();
+    double GetDouble();
+    bool GetBool();
+    void GetFloats(float *outValues, size_t inCount);
+    void GetDoubles(double *outValues, size_t inCount);
+    void GetBytes(void *outBytes, size_t inCount);
+
+private:
+    const uint8_t *Take(size_t inCount);
+
+    const uint8_t   *mBytes;
+    size_t          mSize;
+    size_t          mPosition;
+    bool            mOK;
+};
+
+/// CRC-32 (IEEE 802.3), as used by zip and PNG.
+uint32_t LoPassStateChecksum(const uint8_t *inBytes, size_t inSize);
+
+#endif /* LoPassState_hpp */
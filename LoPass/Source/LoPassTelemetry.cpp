@@ -0,0 +1,69 @@
+//
+//  LoPassTelemetry.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassTelemetry.hpp"
+
+LoPassTelemetry::LoPassTelemetry() {
+    Reset();
+}
+
+void LoPassTelemetry::Reset() {
+
+    mCurrentSlices = 0;
+
+    mMaxSlices.store(0, std::memory_order_relaxed);
+    mRenders.store(0, std::memory_order_relaxed);
+    mFrames.store(0, std::memory_order_relaxed);
+    mSlices.store(0, std::memory_order_relaxed);
+    mDesigns.store(0, std::memory_order_relaxed);
+    mSilentBuffers.store(0, std::memory_order_relaxed);
+    mOverDeadline.store(0, std::memory_order_relaxed);
+    mMinRenderNs.store(UINT64_MAX, std::memory_order_relaxed);
+    mMaxRenderNs.store(0, std::memory_order_relaxed);
+    mTotalRenderNs.store(0, std::memory_order_relaxed);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTelemetry::EndRender()
+//
+// A render that went through AUBase's slicing calls AddSlice() per slice; one that didn't
+// is a single slice.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassTelemetry::EndRender(uint32_t inFrames, uint64_t inRenderNs, uint64_t inDeadlineNs, bool inSkipped) {
+
+    uint32_t slices = mCurrentSlices > 0 ? mCurrentSlices : 1;
+
+    Add(mRenders, 1);
+    Add(mFrames, inFrames);
+    Add(mSlices, slices);
+    Add(mTotalRenderNs, inRenderNs);
+
+    if (inSkipped) { Add(mSilentBuffers, 1); }
+    if (inRenderNs > inDeadlineNs) { Add(mOverDeadline, 1); }
+
+    if (slices > mMaxSlices.load(std::memory_order_relaxed)) { mMaxSlices.store(slices, std::memory_order_relaxed); }
+    if (inRenderNs < mMinRenderNs.load(std::memory_order_relaxed)) { mMinRenderNs.store(inRenderNs, std::memory_order_relaxed); }
+    if (inRenderNs > mMaxRenderNs.load(std::memory_order_relaxed)) { mMaxRenderNs.store(inRenderNs, std::memory_order_relaxed); }
+}
+
+void LoPassTelemetry::GetSnapshot(LoPassTelemetrySnapshot &outSnapshot) const {
+
+    outSnapshot.mVersion        = kTelemetry_Version;
+    outSnapshot.mMaxSlices      = mMaxSlices.load(std::memory_order_relaxed);
+    outSnapshot.mRenders        = mRenders.load(std::memory_order_relaxed);
+    outSnapshot.mFrames         = mFrames.load(std::memory_order_relaxed);
+    outSnapshot.mSlices         = mSlices.load(std::memory_order_relaxed);
+    outSnapshot.mDesigns        = mDesigns.load(std::memory_order_relaxed);
+    outSnapshot.mSilentBuffers  = mSilentBuffers.load(std::memory_order_relaxed);
+    outSnapshot.mOverDeadline   = mOverDeadline.load(std::memory_order_relaxed);
+    outSnapshot.mMinRenderNs    = mMinRenderNs.load(std::memory_order_relaxed);
+    outSnapshot.mMaxRenderNs    = mMaxRenderNs.load(std::memory_order_relaxed);
+    outSnapshot.mTotalRenderNs  = mTotalRenderNs.load(std::memory_order_relaxed);
+
+    if (outSnapshot.mMinRenderNs == UINT64_MAX) { outSnapshot.mMinRenderNs = 0; }
+}
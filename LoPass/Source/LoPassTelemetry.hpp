@@ -0,0 +1,90 @@
+//
+//  LoPassTelemetry.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassTelemetry_hpp
+#define LoPassTelemetry_hpp
+
+#include <atomic>
+#include <stdint.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Telemetry
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Counters for one instance, kept up by its render thread so a host or a tool can see
+// which of hundreds of instances is taking the time, and why: a render that is sliced up
+// by parameter events, redesigning coefficients through an automation sweep, or just doing
+// more channels. LoPassUnit hands a snapshot out as kAudioUnitCustomProperty_RenderTelemetry.
+//
+// Every counter but the designs has a single writer, the thread calling EndRender(), so it
+// is updated with a relaxed load and store and the render thread never takes a lock or a
+// locked instruction for it. Designs are added by the kernels, which may be on the worker
+// pool, so that one is a relaxed fetch_add, once per kernel per render. A snapshot reads
+// each counter on its own: each is exact, but they may be a render apart from each other.
+
+/// Bumped whenever LoPassTelemetrySnapshot changes.
+static constexpr uint32_t kTelemetry_Version = 1;
+
+/// Counts since the instance was initialised; times in nanoseconds.
+struct LoPassTelemetrySnapshot {
+    uint32_t mVersion;          // kTelemetry_Version
+    uint32_t mMaxSlices;        // most slices in one render
+    uint64_t mRenders;
+    uint64_t mFrames;
+    uint64_t mSlices;           // over every render; a render without parameter events is one
+    uint64_t mDesigns;          // IIR coefficient designs, every channel
+    uint64_t mSilentBuffers;    // renders skipped because the input and the tail were silent
+    uint64_t mOverDeadline;     // renders that took longer than the audio they produced
+    uint64_t mMinRenderNs;      // 0 before the first render
+    uint64_t mMaxRenderNs;
+    uint64_t mTotalRenderNs;
+};
+
+class LoPassTelemetry {
+
+public:
+    LoPassTelemetry();
+
+    /// Zero everything. Not while a render is under way.
+    void Reset();
+
+    /// Around each render, on the render thread. EndRender() is given the render's time
+    /// and the length of the audio it produced, both in nanoseconds.
+    void BeginRender() { mCurrentSlices = 0; }
+    void AddSlice() { mCurrentSlices++; }
+    void EndRender(uint32_t inFrames, uint64_t inRenderNs, uint64_t inDeadlineNs, bool inSkipped);
+
+    /// From any kernel's thread.
+    void AddDesigns(uint64_t inDesigns) {
+        if (inDesigns != 0) { mDesigns.fetch_add(inDesigns, std::memory_order_relaxed); }
+    }
+
+    /// From any thread.
+    void GetSnapshot(LoPassTelemetrySnapshot &outSnapshot) const;
+
+private:
+    LoPassTelemetry(const LoPassTelemetry&);
+    LoPassTelemetry &operator=(const LoPassTelemetry&);
+
+    static void Add(std::atomic<uint64_t> &ioCounter, uint64_t inValue) {
+        ioCounter.store(ioCounter.load(std::memory_order_relaxed) + inValue, std::memory_order_relaxed);
+    }
+
+    uint32_t                mCurrentSlices;     // render thread only
+
+    std::atomic<uint32_t>   mMaxSlices;
+    std::atomic<uint64_t>   mRenders;
+    std::atomic<uint64_t>   mFrames;
+    std::atomic<uint64_t>   mSlices;
+    std::atomic<uint64_t>   mDesigns;
+    std::atomic<uint64_t>   mSilentBuffers;
+    std::atomic<uint64_t>   mOverDeadline;
+    std::atomic<uint64_t>   mMinRenderNs;
+    std::atomic<uint64_t>   mMaxRenderNs;
+    std::atomic<uint64_t>   mTotalRenderNs;
+};
+
+#endif /* LoPassTelemetry_hpp */
@@ -0,0 +1,372 @@
+//
+//  LoPassTrace.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassTrace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#elif defined(__APPLE__)
+    #include <unistd.h>
+#endif
+
+std::atomic<bool> LoPassTrace::sEnabled(false);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTraceRing
+//
+// One writer, the owning thread, moves the head; one reader, whoever drains, moves the
+// tail. Each on a cache line of its own.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LoPassTraceRing {
+
+public:
+    LoPassTraceRing() : mHead(0), mTail(0), mDropped(0), mRetired(false), mThread(0), mNext(NULL) {
+        memset(mName, 0, sizeof(mName));
+    }
+
+    std::atomic<uint64_t>   mHead;
+    char                    mHeadPad[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t>   mTail;
+    char                    mTailPad[64 - sizeof(std::atomic<uint64_t>)];
+
+    std::atomic<uint64_t>   mDropped;
+    std::atomic<bool>       mRetired;       // its thread has exited
+    std::atomic<uint32_t>   mThread;
+    char                    mName[32];
+    LoPassTraceRing         *mNext;
+
+    LoPassTraceRecord       mRecords[kTrace_RingRecords];
+};
+
+static std::atomic<LoPassTraceRing *> sRings(NULL);
+
+/// Hands the ring back when its thread exits.
+struct LoPassTraceOwner {
+    LoPassTraceRing *mRing;
+
+    LoPassTraceOwner() : mRing(NULL) { }
+    ~LoPassTraceOwner() { if (mRing != NULL) { mRing->mRetired.store(true, std::memory_order_release); } }
+};
+
+static thread_local LoPassTraceOwner sOwner;
+
+static uint32_t GetThreadID() {
+
+#if defined(__linux__)
+    return (uint32_t)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+    uint64_t thread = 0;
+    pthread_threadid_np(NULL, &thread);
+    return (uint32_t)thread;
+#else
+    static std::atomic<uint32_t> sNext(1);
+    return sNext.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTrace::GetRing()
+//
+// A retired ring is only taken once it has been drained, so nothing still in it is put
+// down to the wrong thread.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassTraceRing *LoPassTrace::GetRing() {
+
+    if (sOwner.mRing != NULL) { return sOwner.mRing; }
+
+    LoPassTraceRing *ring = NULL;
+
+    for (LoPassTraceRing *r = sRings.load(std::memory_order_acquire); r != NULL && ring == NULL; r = r->mNext) {
+        bool retired = true;
+        if (r->mHead.load(std::memory_order_relaxed) == r->mTail.load(std::memory_order_acquire)
+            && r->mRetired.compare_exchange_strong(retired, false, std::memory_order_acquire)) {
+            ring = r;
+        }
+    }
+
+    if (ring == NULL) {
+        ring = new LoPassTraceRing();
+        ring->mNext = sRings.load(std::memory_order_relaxed);
+        while (!sRings.compare_exchange_weak(ring->mNext, ring, std::memory_order_release, std::memory_order_relaxed)) { }
+    }
+
+    memset(ring->mName, 0, sizeof(ring->mName));
+#if defined(__linux__) || defined(__APPLE__)
+    pthread_getname_np(pthread_self(), ring->mName, sizeof(ring->mName));
+#endif
+    ring->mThread.store(GetThreadID(), std::memory_order_release);
+
+    sOwner.mRing = ring;
+    return ring;
+}
+
+void LoPassTrace::RegisterThread() {
+    GetRing();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTrace::Write()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassTrace::Write(uint32_t inCode, uint64_t inObject, uint64_t inA, uint64_t inB, uint64_t inC, uint64_t inD) {
+
+    LoPassTraceRing *ring = GetRing();
+    uint64_t head = ring->mHead.load(std::memory_order_relaxed);
+
+    if (head - ring->mTail.load(std::memory_order_acquire) >= kTrace_RingRecords) {
+        ring->mDropped.store(ring->mDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    LoPassTraceRecord &record = ring->mRecords[head & (kTrace_RingRecords - 1)];
+    record.mTime    = Now();
+    record.mObject  = inObject;
+    record.mArgs[0] = inA;
+    record.mArgs[1] = inB;
+    record.mArgs[2] = inC;
+    record.mArgs[3] = inD;
+    record.mCode    = inCode;
+
+    ring->mHead.store(head + 1, std::memory_order_release);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTrace::Drain()
+//
+// The dropped counts are only ever added to by their writers, so the drain keeps its own
+// running total and hands on the difference.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+uint64_t LoPassTrace::Drain(std::vector<LoPassTraceRecord> &ioRecords) {
+
+    static uint64_t sDroppedSoFar = 0;
+    uint64_t dropped = 0;
+
+    for (LoPassTraceRing *ring = sRings.load(std::memory_order_acquire); ring != NULL; ring = ring->mNext) {
+        uint64_t tail = ring->mTail.load(std::memory_order_relaxed);
+        uint64_t head = ring->mHead.load(std::memory_order_acquire);
+        uint32_t thread = ring->mThread.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++) {
+            ioRecords.push_back(ring->mRecords[tail & (kTrace_RingRecords - 1)]);
+            ioRecords.back().mThread = thread;
+        }
+
+        ring->mTail.store(tail, std::memory_order_release);
+        dropped += ring->mDropped.load(std::memory_order_relaxed);
+    }
+
+    uint64_t recent = dropped - sDroppedSoFar;
+    sDroppedSoFar = dropped;
+    return recent;
+}
+
+void LoPassTrace::GetThreads(std::vector<uint32_t> &outThreads, std::vector<std::string> &outNames) {
+
+    outThreads.clear();
+    outNames.clear();
+
+    for (LoPassTraceRing *ring = sRings.load(std::memory_order_acquire); ring != NULL; ring = ring->mNext) {
+        outThreads.push_back(ring->mThread.load(std::memory_order_acquire));
+        outNames.push_back(std::string(ring->mName, strnlen(ring->mName, sizeof(ring->mName))));
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Names
+//
+// The argument names are those of each AUTRACE() call; a start and its end share a name
+// so the viewer pairs them.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct LoPassTraceName {
+    uint32_t    mCode;
+    char        mPhase;
+    const char  *mName;
+    const char  *mArgs[4];
+};
+
+static const LoPassTraceName kTraceNames[] = {
+    { kCATrace_AUBaseRenderStart,           'B', "AUBase::DoRender",        { "unit", "bus", "frames", "data" } },
+    { kCATrace_AUBaseRenderEnd,             'E', "AUBase::DoRender",        { "unit", "error", "flags", "data" } },
+    { kCATrace_AUBaseRenderCallbackStart,   'B', "render notify",           { "unit", "proc", "phase", NULL } },
+    { kCATrace_AUBaseRenderCallbackEnd,     'E', "render notify",           { "unit", "proc", "phase", NULL } },
+    { kCATrace_AUBaseDoRenderBus,           'i', "AUBase::DoRenderBus",     { "frames", "buffer", "data", "first" } },
+    { kLoPassTrace_ScheduledSliceStart,     'B', "ProcessScheduledSlice",   { "unit", "start", "frames", "buffer frames" } },
+    { kLoPassTrace_ScheduledSliceEnd,       'E', "ProcessScheduledSlice",   { "unit", "error", NULL, NULL } },
+    { kLoPassTrace_ProcessBufferListsStart, 'B', "ProcessBufferLists",      { "unit", "kernels", "frames", "silent input" } },
+    { kLoPassTrace_ProcessBufferListsEnd,   'E', "ProcessBufferLists",      { "unit", "flags", NULL, NULL } },
+    { kLoPassTrace_ChannelGroupStart,       'B', "channel group",           { "unit", "begin", "end", "frames" } },
+    { kLoPassTrace_ChannelGroupEnd,         'E', "channel group",           { "unit", NULL, NULL, NULL } },
+    { kLoPassTrace_KernelStart,             'B', "LoPassKernel::Process",   { "kernel", "channel", "frames", "silence" } },
+    { kLoPassTrace_KernelEnd,               'E', "LoPassKernel::Process",   { "kernel", "designs", NULL, NULL } }
+};
+
+static const LoPassTraceName *FindName(uint32_t inCode) {
+
+    for (size_t i = 0; i < sizeof(kTraceNames) / sizeof(kTraceNames[0]); i++) {
+        if (kTraceNames[i].mCode == inCode) { return &kTraceNames[i]; }
+    }
+    return NULL;
+}
+
+const char *LoPassTrace::GetName(uint32_t inCode) {
+
+    const LoPassTraceName *name = FindName(inCode);
+    return name != NULL ? name->mName : NULL;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTraceRecorder
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassTraceRecorder::LoPassTraceRecorder() :
+    mFile(NULL),
+    mStop(false),
+    mRecordCount(0),
+    mDroppedCount(0),
+    mProcess(0) { }
+
+LoPassTraceRecorder::~LoPassTraceRecorder() {
+    Stop();
+}
+
+bool LoPassTraceRecorder::Start(const char *inPath) {
+
+    Stop();
+
+    mFile = fopen(inPath, "w");
+    if (mFile == NULL) { return false; }
+
+#if defined(__linux__) || defined(__APPLE__)
+    mProcess = (uint32_t)getpid();
+#endif
+
+    mRecordCount = 0;
+    mDroppedCount = 0;
+    mNamed.clear();
+
+    // anything left from before belongs to no one
+    mRecords.clear();
+    LoPassTrace::Drain(mRecords);
+    mRecords.clear();
+
+    fprintf(mFile, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(mFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"LoPass\"}}", mProcess);
+
+    mStop = false;
+    LoPassTrace::SetEnabled(true);
+    mThread = std::thread(&LoPassTraceRecorder::Run, this);
+    return true;
+}
+
+void LoPassTraceRecorder::Stop() {
+
+    if (mFile == NULL) { return; }
+
+    LoPassTrace::SetEnabled(false);
+    mStop = true;
+    mThread.join();
+
+    // the records made just before tracing was turned off
+    Flush();
+
+    fprintf(mFile, "\n],\"otherData\":{\"records\":%llu,\"dropped\":%llu}}\n",
+            (unsigned long long)mRecordCount, (unsigned long long)mDroppedCount);
+    fclose(mFile);
+    mFile = NULL;
+}
+
+void LoPassTraceRecorder::Run() {
+
+    while (!mStop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kTrace_DrainInterval));
+        Flush();
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTraceRecorder::Flush()
+//
+// Timestamps are microseconds, Chrome's unit, written out to the nanosecond.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassTraceRecorder::Flush() {
+
+    mRecords.clear();
+    mDroppedCount += LoPassTrace::Drain(mRecords);
+
+    // a name for each thread the first time it shows up
+    std::vector<uint32_t> threads;
+    std::vector<std::string> names;
+    LoPassTrace::GetThreads(threads, names);
+
+    for (size_t t = 0; t < threads.size(); t++) {
+        if (threads[t] == 0 || std::find(mNamed.begin(), mNamed.end(), threads[t]) != mNamed.end()) { continue; }
+        mNamed.push_back(threads[t]);
+
+        std::string name = names[t].empty() ? "thread " + std::to_string(threads[t]) : names[t];
+        for (size_t c = 0; c < name.size(); c++) {
+            if (name[c] == '"' || name[c] == '\\' || (unsigned char)name[c] < 0x20) { name[c] = '_'; }
+        }
+        fprintf(mFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                mProcess, threads[t], name.c_str());
+    }
+
+    for (size_t n = 0; n < mRecords.size(); n++) {
+        const LoPassTraceRecord &record = mRecords[n];
+        const LoPassTraceName *name = FindName(record.mCode);
+
+        fprintf(mFile, ",\n{\"name\":\"%s\",\"cat\":\"lopass\",\"ph\":\"%c\",\"ts\":%llu.%03llu,\"pid\":%u,\"tid\":%u",
+                name != NULL ? name->mName : "unknown", name != NULL ? name->mPhase : 'i',
+                (unsigned long long)(record.mTime / 1000), (unsigned long long)(record.mTime % 1000), mProcess, record.mThread);
+
+        if (name == NULL || name->mPhase == 'i') { fprintf(mFile, ",\"s\":\"t\""); }
+
+        fprintf(mFile, ",\"args\":{\"instance\":\"0x%llx\"", (unsigned long long)record.mObject);
+        for (int a = 0; a < 4; a++) {
+            if (name == NULL || name->mArgs[a] == NULL) { continue; }
+            fprintf(mFile, ",\"%s\":%llu", name->mArgs[a], (unsigned long long)record.mArgs[a]);
+        }
+        if (name == NULL) { fprintf(mFile, ",\"code\":%u", record.mCode); }
+        fprintf(mFile, "}}");
+    }
+
+    mRecordCount += mRecords.size();
+    fflush(mFile);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassTraceRecorder::StartFromEnvironment()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassTraceRecorder::StartFromEnvironment() {
+
+    static std::once_flag sOnce;
+
+    std::call_once(sOnce, [] {
+        const char *path = getenv("LOPASS_TRACE_FILE");
+        if (path == NULL || *path == '\0') { return; }
+
+        // stopped, and the file finished, by the static destructor at exit
+        static LoPassTraceRecorder sRecorder;
+        if (!sRecorder.Start(path)) { fprintf(stderr, "LoPass: can't write a trace to %s\n", path); }
+    });
+}
@@ -0,0 +1,158 @@
+//
+//  LoPassTrace.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassTrace_hpp
+#define LoPassTrace_hpp
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Trace
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// What AUTRACE() records when LOPASS_TRACE is set: AUBase's own trace points around
+// DoRender() and the render notifications, and ours around each scheduled slice, each
+// ProcessBufferListsT(), each channel group on the worker pool and each LoPassKernel. Every
+// point is a fixed size record written into a ring belonging to the thread that hit it,
+// so the render thread never shares a cache line with another writer, takes a lock or
+// makes a system call: a record is the clock, six stores and a release store of the
+// ring's head. A full ring drops the record and counts it rather than wait.
+//
+// A thread gets its ring the first time it records, which allocates; threads that can
+// should call RegisterThread() before they render. Rings are never freed: a thread that
+// exits leaves its ring to be drained, and a later thread takes it over once it's empty.
+//
+// Drain() empties every ring, from any one thread at a time. LoPassTraceRecorder does that
+// every few milliseconds on a thread of its own and writes Chrome's trace event JSON,
+// which chrome://tracing and ui.perfetto.dev both open, with a track per thread and
+// timestamps to the nanosecond. With nothing recording, AUTRACE() is a relaxed load and
+// a branch; without LOPASS_TRACE it compiles to nothing, as it always has outside Apple.
+
+enum LoPassTraceCode {
+    // AUBase's points, names as in Apple's kdebug codes
+    kCATrace_AUBaseRenderStart              = 1,
+    kCATrace_AUBaseRenderEnd                = 2,
+    kCATrace_AUBaseRenderCallbackStart      = 3,
+    kCATrace_AUBaseRenderCallbackEnd        = 4,
+    kCATrace_AUBaseDoRenderBus              = 5,
+
+    // Ours
+    kLoPassTrace_ScheduledSliceStart        = 16,
+    kLoPassTrace_ScheduledSliceEnd          = 17,
+    kLoPassTrace_ProcessBufferListsStart    = 18,
+    kLoPassTrace_ProcessBufferListsEnd      = 19,
+    kLoPassTrace_ChannelGroupStart          = 20,
+    kLoPassTrace_ChannelGroupEnd            = 21,
+    kLoPassTrace_KernelStart                = 22,
+    kLoPassTrace_KernelEnd                  = 23
+};
+
+/// Records per thread; a power of two.
+static constexpr unsigned kTrace_RingRecords    = 16384;
+
+/// How often LoPassTraceRecorder drains, in milliseconds.
+static constexpr unsigned kTrace_DrainInterval  = 10;
+
+/// One trace point as it was hit. Time in nanoseconds on the steady clock.
+struct LoPassTraceRecord {
+    uint64_t mTime;
+    uint64_t mObject;       // the AudioComponentInstance
+    uint64_t mArgs[4];
+    uint32_t mCode;
+    uint32_t mThread;       // filled in by Drain()
+};
+
+class LoPassTraceRing;
+
+class LoPassTrace {
+
+public:
+    /// Nothing is recorded until this is on.
+    static void SetEnabled(bool inEnabled) { sEnabled.store(inEnabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    static void Record(uint32_t inCode, uint64_t inObject, uint64_t inA, uint64_t inB, uint64_t inC, uint64_t inD) {
+        if (sEnabled.load(std::memory_order_relaxed)) { Write(inCode, inObject, inA, inB, inC, inD); }
+    }
+
+    /// Give the calling thread its ring now rather than at its first record.
+    static void RegisterThread();
+
+    /// Append every record written since the last drain, ring by ring, and return how
+    /// many were dropped meanwhile. One thread at a time.
+    static uint64_t Drain(std::vector<LoPassTraceRecord> &ioRecords);
+
+    /// The OS thread id and name of every thread that has had a ring; outNames[i] is for
+    /// outThreads[i].
+    static void GetThreads(std::vector<uint32_t> &outThreads, std::vector<std::string> &outNames);
+
+    /// The event name for a code, NULL for unknown codes.
+    static const char *GetName(uint32_t inCode);
+
+private:
+    static void Write(uint32_t inCode, uint64_t inObject, uint64_t inA, uint64_t inB, uint64_t inC, uint64_t inD);
+    static LoPassTraceRing *GetRing();
+
+    static std::atomic<bool> sEnabled;
+};
+
+/// AUTRACE() arguments are a mix of pointers and integers.
+template <class T> inline uint64_t LoPassTraceValue(T inValue) { return (uint64_t)inValue; }
+template <class T> inline uint64_t LoPassTraceValue(T *inValue) { return (uint64_t)(uintptr_t)inValue; }
+
+#if LOPASS_TRACE
+    #define AUTRACE(code, obj, a, b, c, d) \
+        LoPassTrace::Record((code), LoPassTraceValue(obj), LoPassTraceValue(a), LoPassTraceValue(b), LoPassTraceValue(c), LoPassTraceValue(d))
+    #define CATrace_ablData(abl) ((abl).mBuffers[0].mData)
+#endif
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Trace Recorder
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Turns tracing on and streams everything recorded to a JSON file until Stop(). Start and
+// end codes become "B" and "E" events, anything else an instant. Only one may run at once.
+// StartFromEnvironment() starts one for the whole process if LOPASS_TRACE_FILE names a
+// file, so a host can be traced without changing it; that one stops at exit.
+
+class LoPassTraceRecorder {
+
+public:
+    LoPassTraceRecorder();
+    ~LoPassTraceRecorder();
+
+    /// False if the file can't be opened.
+    bool Start(const char *inPath);
+    void Stop();
+
+    /// Records written and dropped so far.
+    uint64_t GetRecordCount() const { return mRecordCount; }
+    uint64_t GetDroppedCount() const { return mDroppedCount; }
+
+    static void StartFromEnvironment();
+
+private:
+    LoPassTraceRecorder(const LoPassTraceRecorder&);
+    LoPassTraceRecorder &operator=(const LoPassTraceRecorder&);
+
+    void Run();
+    void Flush();
+
+    FILE                            *mFile;
+    std::thread                     mThread;
+    std::atomic<bool>               mStop;
+    std::vector<LoPassTraceRecord>  mRecords;
+    std::vector<uint32_t>           mNamed;         // threads given a name so far
+    uint64_t                        mRecordCount;
+    uint64_t                        mDroppedCount;
+    uint32_t                        mProcess;
+};
+
+#endif /* LoPassTrace_hpp */
@@ -9,6 +9,7 @@
 #include "AUEffectBase.h"
 #include <AudioToolbox/AudioUnitUtilities.h>
 #include "LoPassVersion.h"
+#include "CAHostTimeBase.h"
 #include <math.h>
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -17,6 +18,25 @@ AUDIOCOMPONENT_ENTRY(AUBaseFactory, LoPassUnit)
 /* The AUDIOCOMPOENT_ENTRY macro is required for the macOS Component Manager to recognize
  and use the audio unit. */
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GetSettings
+//
+// The current parameter values of the unit or one of its kernels.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+template <class T>
+static LoPassSettings GetSettings(T &inSource) {
+    
+    LoPassSettings settings;
+    
+    settings.mCutoff        = inSource.GetParameter(kParameter_CutoffFrequency);
+    settings.mResonance     = inSource.GetParameter(kParameter_Resonance);
+    settings.mSmoothing     = inSource.GetParameter(kParameter_Smoothing);
+    settings.mLinearPhase   = inSource.GetParameter(kParameter_LinearPhase) != 0.0;
+    settings.mMultirate     = inSource.GetParameter(kParameter_Multirate) != 0.0;
+    
+    return settings;
+}
+
 #pragma mark ____ Construction Initialization
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // LoPassUnit::LoPassUnit
@@ -38,27 +58,108 @@ LoPassUnit::LoPassUnit (AudioUnit component) : AUEffectBase(component) {
     
     SetParameter(kParameter_CutoffFrequency, kDefaultValue_LoPass_Frequency);
     SetParameter(kParameter_Resonance, kDefaultValue_LoPass_Resonance);
+    SetParameter(kParameter_LinearPhase, kDefaultValue_LoPass_LinearPhase);
+    SetParameter(kParameter_Smoothing, kDefaultValue_LoPass_Smoothing);
+    SetParameter(kParameter_Multirate, kDefaultValue_LoPass_Multirate);
     
     // Filter Cutoff Frequency max value depends on sample-rate.
     SetParamHasSampleRateDependency(true);
+    
+    UpdateTailTime();
+    
+#if LOPASS_TRACE
+    // tracing a host that knows nothing about it
+    LoPassTraceRecorder::StartFromEnvironment();
+#endif
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // LoPass Initialise
-//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//OSStatus LoPassUnit::Initialize() {
 //
-//    OSStatus result = AUEffectBase::Initialize();
+// One group of channels for the render thread and one for each worker, with a core left
+// over for the rest of the host.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus LoPassUnit::Initialize() {
     
-//    if (result == noErr) {
-//        
+    OSStatus result = AUEffectBase::Initialize();
+    
+    if (result == noErr) {
+        
+        UpdateTailTime();
+        
+        SetChannelScheduler(NULL);
+        mScheduler.reset();
+        mTelemetry.Reset();
+        
+        unsigned channels   = GetNumberOfChannels();
+        unsigned workers    = channels / kLoPass_ChannelsPerGroup;
+        unsigned cores      = std::thread::hardware_concurrency();
+        
+        workers = workers > 0 ? workers - 1 : 0;
+        if (cores != 0 && workers + 2 > cores) { workers = cores > 2 ? cores - 2 : 0; }
+        
+        if (channels >= kLoPass_ParallelChannels && workers > 0) {
+            mScheduler.reset(new LoPassChannelScheduler(workers));
+            mScheduler->GetPool().SetRealtime(GetMaxFramesPerSlice() / GetSampleRate());
+            SetChannelScheduler(mScheduler.get());
+        }
+        
 //        /* in case the AU was un-initialised and parameters were changed, the view can now
 //         be made aware it needs to update the frequency response curve. */
 //        PropertyChanged(kAudioUnitCustomProperty_FilterFrequencyResponse, kAudioUnitScope_Global, 0);
-//    }
+    }
+    
+    return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Cleanup
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void LoPassUnit::Cleanup() {
+    
+    SetChannelScheduler(NULL);
+    mScheduler.reset();
+    
+    AUEffectBase::Cleanup();
+}
+
+#pragma mark ____Render
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassUnit::Render
 //
-//    return result;
-//}
+// The deadline is the length of the buffer: a render slower than that can't keep up even
+// with nothing else in the session.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus LoPassUnit::Render(AudioUnitRenderActionFlags  &ioActionFlags,
+                            const AudioTimeStamp        &inTimeStamp,
+                            UInt32                      inNumberFrames) {
+    
+    mTelemetry.BeginRender();
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    
+    OSStatus result = AUEffectBase::Render(ioActionFlags, inTimeStamp, inNumberFrames);
+    
+    UInt64 elapsed  = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+    UInt64 deadline = UInt64(1e9 * inNumberFrames / GetSampleRate());
+    
+    // every kernel left the silence flag alone, so none of them ran
+    bool skipped = result == noErr && !ShouldBypassEffect() && (ioActionFlags & kAudioUnitRenderAction_OutputIsSilence) != 0;
+    
+    mTelemetry.EndRender(inNumberFrames, elapsed, deadline, skipped);
+    return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassUnit::ProcessScheduledSlice
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+OSStatus LoPassUnit::ProcessScheduledSlice(void     *inUserData,
+                                           UInt32   inStartFrameInBuffer,
+                                           UInt32   inSliceFramesToProcess,
+                                           UInt32   inTotalBufferFrames) {
+    
+    mTelemetry.AddSlice();
+    return AUEffectBase::ProcessScheduledSlice(inUserData, inStartFrameInBuffer, inSliceFramesToProcess, inTotalBufferFrames);
+}
 
 #pragma mark ____Parameters
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -93,6 +194,31 @@ OSStatus LoPassUnit::GetParameterInfo(AudioUnitScope            inScope,
                 outParameterInfo.defaultValue   = kDefaultValue_LoPass_Resonance;
                 outParameterInfo.flags          += kAudioUnitParameterFlag_IsHighResolution;
                 break;
+            case kParameter_LinearPhase:
+                AUBase::FillInParameterName(outParameterInfo, kParamName_LoPass_LinearPhase, false);
+                outParameterInfo.unit           = kAudioUnitParameterUnit_Boolean;
+                outParameterInfo.minValue       = 0.0;
+                outParameterInfo.maxValue       = 1.0;
+                outParameterInfo.defaultValue   = kDefaultValue_LoPass_LinearPhase;
+                // changes the latency, so it shouldn't be automated
+                outParameterInfo.flags          += kAudioUnitParameterFlag_NonRealTime;
+                break;
+            case kParameter_Smoothing:
+                AUBase::FillInParameterName(outParameterInfo, kParamName_LoPass_Smoothing, false);
+                outParameterInfo.unit           = kAudioUnitParameterUnit_Milliseconds;
+                outParameterInfo.minValue       = kMinimumValue_LoPass_Smoothing;
+                outParameterInfo.maxValue       = kMaximumValue_LoPass_Smoothing;
+                outParameterInfo.defaultValue   = kDefaultValue_LoPass_Smoothing;
+                break;
+            case kParameter_Multirate:
+                AUBase::FillInParameterName(outParameterInfo, kParamName_LoPass_Multirate, false);
+                outParameterInfo.unit           = kAudioUnitParameterUnit_Boolean;
+                outParameterInfo.minValue       = 0.0;
+                outParameterInfo.maxValue       = 1.0;
+                outParameterInfo.defaultValue   = kDefaultValue_LoPass_Multirate;
+                // changes the latency, so it shouldn't be automated
+                outParameterInfo.flags          += kAudioUnitParameterFlag_NonRealTime;
+                break;
             default:
                 result = kAudioUnitErr_InvalidParameter;
                 break;
@@ -104,6 +230,107 @@ OSStatus LoPassUnit::GetParameterInfo(AudioUnitScope            inScope,
     return result;
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass::SetParameter
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+OSStatus LoPassUnit::SetParameter(AudioUnitParameterID      inID,
+                                  AudioUnitScope            inScope,
+                                  AudioUnitElement          inElement,
+                                  AudioUnitParameterValue   inValue,
+                                  UInt32                    inBufferOffsetInFrames) {
+    
+    bool changed        = inScope == kAudioUnitScope_Global && inValue != GetParameter(inID);
+    bool latencyChanged = changed
+                        && (inID == kParameter_LinearPhase || inID == kParameter_Multirate)
+                        && (inValue != 0.0) != (GetParameter(inID) != 0.0);
+    
+    /* Before the render thread can see linear phase on, so it never has to create the
+     convolvers itself. The parameter is flagged non realtime, so this isn't the render thread. */
+    if (inScope == kAudioUnitScope_Global && inID == kParameter_LinearPhase && inValue != 0.0) {
+        LoPassSettings settings = GetSettings(*this);
+        settings.mLinearPhase = true;
+        PrepareKernels(settings);
+    }
+    
+    OSStatus result = AUEffectBase::SetParameter(inID, inScope, inElement, inValue, inBufferOffsetInFrames);
+    
+    if (result == noErr && changed) { UpdateTailTime(); }
+    
+    if (result == noErr && latencyChanged) {
+        PropertyChanged(kAudioUnitProperty_Latency, kAudioUnitScope_Global, 0);
+        PropertyChanged(kAudioUnitProperty_TailTime, kAudioUnitScope_Global, 0);
+    }
+    
+    return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass::RestoreState
+//
+// AUBase sets the restored parameters directly, without SetParameter(). A host restoring
+// linear phase on while rendering may still have the next render create the convolvers.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+OSStatus LoPassUnit::RestoreState(CFPropertyListRef inData) {
+    
+    OSStatus result = AUEffectBase::RestoreState(inData);
+    
+    if (result == noErr) {
+        PrepareKernels(GetSettings(*this));
+        UpdateTailTime();
+    }
+    
+    return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass::ChangeStreamFormat
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+OSStatus LoPassUnit::ChangeStreamFormat(AudioUnitScope                  inScope,
+                                        AudioUnitElement                inElement,
+                                        const CAStreamBasicDescription  &inPrevFormat,
+                                        const CAStreamBasicDescription  &inNewFormat) {
+    
+    OSStatus result = AUEffectBase::ChangeStreamFormat(inScope, inElement, inPrevFormat, inNewFormat);
+    
+    if (result == noErr && inPrevFormat.mSampleRate != inNewFormat.mSampleRate) { UpdateTailTime(); }
+    
+    return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass::PrepareKernels
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassUnit::PrepareKernels(const LoPassSettings &inSettings) {
+    
+    for (AUKernelBase *kernel : mKernelList) {
+        if (kernel != NULL) { static_cast<LoPassKernel *>(kernel)->Prepare(inSettings); }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass::GetLatency
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+Float64 LoPassUnit::GetLatency() {
+    
+    Float64 srate = GetSampleRate();
+    return LoPassProcessor::GetLatencyFrames(GetSettings(*this), srate) / srate;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass::UpdateTailTime
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassUnit::UpdateTailTime() {
+    
+    Float64 srate = GetSampleRate();
+    mTailTime.store(LoPassProcessor::GetTailFrames(GetSettings(*this), srate) / srate, std::memory_order_relaxed);
+}
+
 #pragma mark ____Properties
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // LoPass::GetPropertyInfo
@@ -133,6 +360,13 @@ OSStatus LoPassUnit::GetPropertyInfo(AudioUnitPropertyID    inID,
 //        }
 //    }
     
+    if (inID == kAudioUnitCustomProperty_RenderTelemetry) {
+        if (inScope != kAudioUnitScope_Global) { return kAudioUnitErr_InvalidScope; }
+        outDataSize = sizeof(LoPassTelemetrySnapshot);
+        outWritable = false;
+        return noErr;
+    }
+    
     return AUEffectBase::GetPropertyInfo(inID, inScope, inElement, outDataSize, outWritable);
 }
 
@@ -145,6 +379,12 @@ OSStatus LoPassUnit::GetProperty(AudioUnitPropertyID    inID,
                                  AudioUnitElement       inElement,
                                  void                   *outData) {
     
+    if (inID == kAudioUnitCustomProperty_RenderTelemetry) {
+        if (inScope != kAudioUnitScope_Global) { return kAudioUnitErr_InvalidScope; }
+        mTelemetry.GetSnapshot(*(LoPassTelemetrySnapshot *)outData);
+        return noErr;
+    }
+    
     return AUEffectBase::GetProperty(inID, inScope, inElement, outData);
 }
 
@@ -197,6 +437,7 @@ OSStatus LoPassUnit::NewFactoryPresetSet(const AUPreset &inNewFactoryPreset) {
                     break;
             }
             
+            UpdateTailTime();
             SetAFactoryPresetAsCurrent(kPresets[i]);
             return noErr;
         }
@@ -210,9 +451,19 @@ OSStatus LoPassUnit::NewFactoryPresetSet(const AUPreset &inNewFactoryPreset) {
 // LoPassKernel::LoPassKernel()
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-LoPassKernel::LoPassKernel(AUEffectBase *inAudioUnit) : AUKernelBase(inAudioUnit) {
+LoPassKernel::LoPassKernel(AUEffectBase *inAudioUnit, LoPassTelemetry *inTelemetry) : AUKernelBase(inAudioUnit),
+    mProcessor(inAudioUnit->GetSampleRate()),
+    mTelemetry(inTelemetry),
+    mReportedDesigns(0),
+    mSkipping(false) {
     
     Reset();
+    
+    /* Kernels are created when the unit is initialised, off the render thread, so with
+     linear phase on the first FIR can be designed right away rather than on the designer
+     thread. With it off, nothing is allocated until LoPassUnit::SetParameter() turns it on. */
+    mProcessor.Prepare(GetSettings(*this));
+    mReportedDesigns = mProcessor.GetDesignCount();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -229,14 +480,9 @@ LoPassKernel::~LoPassKernel() { }
  also be cleared. */
 
 void LoPassKernel::Reset() {
-    mX1 = 0.0;
-    mX2 = 0.0;
-    mY1 = 0.0;
-    mY2 = 0.0;
-    
-    // Forces filter coefficient calculation.
-    mLastCutoff     = -1.0;
-    mLastResonance  = -1.0;
+    
+    // Forces filter coefficient calculation, jumping straight to the current parameters.
+    mProcessor.Reset();
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -249,19 +495,7 @@ void LoPassKernel::Reset() {
 void LoPassKernel::CalculateLopassParams(double inFreq,
                                          double inResonance) {
     
-    // Convert from decibels to linear
-    double r = pow(10.0, 0.05 * -inResonance);
-    
-    double k    = 0.5 * r * sin(M_PI * inFreq);
-    double c1   = 0.5 * (1.0 - k) / (1.0 + k);
-    double c2   = (0.5 + c1) * cos(M_PI * inFreq);
-    double c3   = (0.5 + c1 - c2) * 0.25;
-    
-    mA0 = 2.0 *     c3;
-    mA1 = 2.0 *     2.0 * c3;
-    mA2 = 2.0 *     c3;
-    mB1 = 2.0 *     -c2;
-    mB2 = 2.0 *     c1;
+    mProcessor.GetFilter().SetTarget(inFreq, inResonance);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -277,32 +511,18 @@ double LoPassKernel::GetFrequencyResponse(double inFreq) {
     
     double scaledFrequency = 2.0 * inFreq / srate;
     
-    // frequency on unit circle in z-plane
-    double zr = cos(M_PI * scaledFrequency);
-    double zi = sin(M_PI * scaledFrequency);
-    
-    // zeros respone
-    double num_r = mA0 * (zr*zr - zi*zi) + mA1 * zr + mA2;
-    double num_i = 2.0 * mA0 * zr * zi + mA1 * zi;
-    
-    double num_mag = sqrt(num_r * num_r + num_i * num_i);
-    
-    // poles response
-    double den_r = zr * zr - zi * zi + mB1 * zr + mB2;
-    double den_i = 2.0 * zr * zi + mB1 * zi;
-    
-    double den_mag = sqrt(den_r * den_r + den_i * den_i);
-    
-    // total response
-    double response = num_mag / den_mag;
-    
-    return response;
+    return LoPassFilter::GetFrequencyResponse(mProcessor.GetFilter().GetCoefficients(), scaledFrequency);
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // LoPassKernel::Process()
 //
 // We process one non-interleaved stream at a time.
+// ioSilence only arrives set once the input has been silent for longer than the latency
+// and the tail, so all that is left to ring out is 120 dB down and the buffer is skipped;
+// leaving it set tells AUEffectBase to hand on silence. The state is cleared on the first
+// skipped buffer, so what is left isn't replayed, and a frozen ramp isn't finished off,
+// when the input comes back.
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 void LoPassKernel::Process(const Float32    *inSourceP,
@@ -311,48 +531,23 @@ void LoPassKernel::Process(const Float32    *inSourceP,
                            UInt32           inNumChannels, // for version 2 AudioUnits inNumChannels is always 1
                            bool             &ioSilence) {
     
-    double cutoff       = GetParameter(kParameter_CutoffFrequency);
-    double resonance    = GetParameter(kParameter_Resonance);
-    
-    // do bounds checking on parameters
-    if (cutoff < kMinimumValue_LoPass_Frequency) { cutoff = kMinimumValue_LoPass_Frequency; }
-    
-    if (resonance < kMinimumValue_LoPass_Resonance) { resonance = kMinimumValue_LoPass_Resonance; }
-    if (resonance > kMaximumValue_LoPass_Resonance) { resonance = kMaximumValue_LoPass_Resonance; }
-    
-    // Convert to 0->1 normalized frequency
-    float srate = GetSampleRate();
-    
-    cutoff = 2.0 * cutoff / srate;
-    if (cutoff > 0.99) { cutoff = 0.99; } // clip cutoff to highest allowed by sample rate.
-    
+    AUTRACE(kLoPassTrace_KernelStart, mAudioUnit->GetComponentInstance(), (intptr_t)this, GetChannelNum(), inFramesToProcess, ioSilence);
     
-    // only calculate the filter coefficients if the parameters have changed from last time
-    if (cutoff != mLastCutoff || resonance != mLastResonance) {
-        
-        CalculateLopassParams(cutoff, resonance);
-        
-        mLastCutoff = cutoff;
-        mLastResonance = resonance;
+    if (ioSilence) {
+        if (!mSkipping) {
+            mProcessor.Reset();
+            mSkipping = true;
+        }
+        AUTRACE(kLoPassTrace_KernelEnd, mAudioUnit->GetComponentInstance(), (intptr_t)this, 0, 0, 0);
+        return;
     }
     
-    const Float32 *sourceP  = inSourceP;
-    Float32 *destP          = inDestP;
-    int n                   = inFramesToProcess;
+    mSkipping = false;
     
-    //Apply the filter on the input and write to the ouput
+    mProcessor.Process(GetSettings(*this), inSourceP, inDestP, inFramesToProcess);
     
-    while (n--) {
-        
-        float input = *sourceP++;
-        float output = mA0*input + mA1*mX1 + mA2*mX2 - mB1*mY1 - mB2* mY2;
-        
-        mX2 = mX1;
-        mX1 = input;
-        mY2 = mY1;
-        mY1 = output;
-        
-        *destP++ = output;
-    }
+    uint64_t designs = mProcessor.GetDesignCount();
+    mTelemetry->AddDesigns(designs - mReportedDesigns);
+    AUTRACE(kLoPassTrace_KernelEnd, mAudioUnit->GetComponentInstance(), (intptr_t)this, designs - mReportedDesigns, 0, 0);
+    mReportedDesigns = designs;
 }
-
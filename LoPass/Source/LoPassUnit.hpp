@@ -7,6 +7,13 @@
 
 #include "AUEffectBase.h"
 #include "LoPassVersion.h"
+#include "LoPassParameters.h"
+#include "LoPassFilter.hpp"
+#include "LoPassProcessor.hpp"
+#include "LoPassTelemetry.hpp"
+#include "LoPassWorkerPool.hpp"
+#include <atomic>
+#include <memory>
 
 #if AU_DEBUG_DISPATCHER
     #include "AUDebugDispatcher.h"
@@ -41,53 +48,30 @@
 //    Float64 mMagnitude;
 //} FrequencyResponse;
 
+// Read only: a LoPassTelemetrySnapshot of the instance's render counters, global scope.
+// Cheap enough to poll a few times a second from a host's meter or a profiling script.
+enum {
+    kAudioUnitCustomProperty_RenderTelemetry            = 65537
+};
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Parameters
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 #pragma mark ____Parameters
 
-// Define constants to represent the User Interface parameter name, min/max and default values.
+// Define constants to represent the User Interface parameter names.
+// Ranges, defaults and the preset values are in LoPassParameters.h.
 static CFStringRef      kParamName_LoPass_Frequency     = CFSTR("cutoff frequency");
-static constexpr float  kMinimumValue_LoPass_Frequency  = 12.0;
-//static constexpr float  kMaximumValue_LoPass_Frequency  = 20000.0;
-static constexpr float  kDefaultValue_LoPass_Frequency  = 1000.0;
-
 static CFStringRef      kParamName_LoPass_Resonance     = CFSTR("resonance");
-static constexpr float  kMinimumValue_LoPass_Resonance  = -20.0;
-static constexpr float  kMaximumValue_LoPass_Resonance  = 20.0;
-static constexpr float  kDefaultValue_LoPass_Resonance  = 0.0;
-
-// Define an enum to represent ParameterID values.
-enum Parameters {
-    kParameter_CutoffFrequency          = 0,
-    kParameter_Resonance                = 1,
-    kNumberOfParameters                 = 2
-};
+static CFStringRef      kParamName_LoPass_LinearPhase   = CFSTR("linear phase");
+static CFStringRef      kParamName_LoPass_Smoothing     = CFSTR("smoothing time");
+static CFStringRef      kParamName_LoPass_Multirate     = CFSTR("multirate");
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Factory Presets
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 #pragma mark ____Factory Presets
 
-enum FactoryPresets {
-    kPreset_Default     = 0,
-    kPreset_Dark        = 1,
-    kPreset_Bright      = 2,
-    kNumberOfPresets    = 3,
-};
-
-static constexpr float kParameter_Preset_Frequency_Default  = 1000.0;
-static constexpr float kParameter_Preset_Resonance_Default  = 0.0;
-
-/// Define a constant for the Cutoff Freq for preset "dark".
-static constexpr float kParameter_Preset_Frequency_Dark     = 200.0;
-/// Define a constant for the Resonance for preset "dark".
-static constexpr float kParameter_Preset_Resonance_Dark     = -5.0;
-/// Define a constant for the Cutoff Freq for preset "bright".
-static constexpr float kParameter_Preset_Frequency_Bright   = 1000.0;
-/// Define a constant for the Resonance for preset "bright".
-static constexpr float kParameter_Preset_Resonance_Bright   = 10.0;
-
 static AUPreset kPresets[kNumberOfPresets] = {
     { kPreset_Default, CFSTR("Default") },
     { kPreset_Dark, CFSTR("Dark") },
@@ -103,7 +87,7 @@ static AUPreset kPresets[kNumberOfPresets] = {
 class LoPassKernel: public AUKernelBase {
     
 public:
-    LoPassKernel(AUEffectBase *inAudioUnit);
+    LoPassKernel(AUEffectBase *inAudioUnit, LoPassTelemetry *inTelemetry);
     
     virtual ~LoPassKernel();
     
@@ -116,26 +100,51 @@ public:
     /// Reset the filter state.
     virtual void Reset();
     
+    /// Create the linear phase convolver if these settings use it, see LoPassProcessor.
+    /// Never on the render thread.
+    void Prepare(const LoPassSettings &inSettings) { mProcessor.Prepare(inSettings); }
+    
     void CalculateLopassParams(double inFreq, double inResonance);
     
     double GetFrequencyResponse(double inFreq);
     
 private:
-    // Filter coefficients
-    double mA0;
-    double mA1;
-    double mA2;
-    double mB1;
-    double mB2;
-    
-    // Filter state
-    double mX1;
-    double mX2;
-    double mY1;
-    double mY2;
-    
-    double mLastCutoff;
-    double mLastResonance;
+    // The filter, linear phase and multirate paths, shared with the offline tools
+    LoPassProcessor mProcessor;
+    
+    // The unit's, and the design count it has last been given
+    LoPassTelemetry *mTelemetry;
+    uint64_t        mReportedDesigns;
+    
+    // Silent buffers are being skipped, and the state has been cleared
+    bool            mSkipping;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Channel Scheduler
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Wide formats (ambisonics, or a 7.1.4 bus at high sample rates) can take longer than a
+// small buffer allows on one core, so from kLoPass_ParallelChannels up the kernels are
+// shared between the render thread and a LoPassWorkerPool, a group of at least
+// kLoPass_ChannelsPerGroup channels each. The kernels share nothing but the parameters.
+#pragma mark ____Channel Scheduler
+
+static constexpr unsigned kLoPass_ParallelChannels  = 8;
+static constexpr unsigned kLoPass_ChannelsPerGroup  = 4;
+
+class LoPassChannelScheduler: public AUChannelScheduler {
+    
+public:
+    explicit LoPassChannelScheduler(unsigned inWorkers) : mPool(inWorkers) { }
+    
+    LoPassWorkerPool &GetPool() { return mPool; }
+    
+    virtual void Run(UInt32 inNumberOfChannels, ChannelGroupFunction inFunction, void *inContext) {
+        mPool.Run(inNumberOfChannels, inFunction, inContext);
+    }
+    
+private:
+    LoPassWorkerPool mPool;
 };
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -154,9 +163,21 @@ public:
     /// Provide the audio unit version information.
     virtual OSStatus Version() { return kLoPassVersion; }
     
-//    virtual OSStatus Initialize();
+    /// Sets up the worker pool for wide formats once the channel count is known.
+    virtual OSStatus Initialize();
+    virtual void Cleanup();
     
-    virtual AUKernelBase* NewKernel() { return new LoPassKernel(this); }
+    virtual AUKernelBase* NewKernel() { return new LoPassKernel(this, &mTelemetry); }
+    
+    /// Timed and counted for kAudioUnitCustomProperty_RenderTelemetry.
+    virtual OSStatus    Render(             AudioUnitRenderActionFlags  &ioActionFlags,
+                                            const AudioTimeStamp        &inTimeStamp,
+                                            UInt32                      inNumberFrames);
+    
+    virtual OSStatus    ProcessScheduledSlice(  void        *inUserData,
+                                                UInt32      inStartFrameInBuffer,
+                                                UInt32      inSliceFramesToProcess,
+                                                UInt32      inTotalBufferFrames);
     
     // For custom property
     virtual OSStatus    GetPropertyInfo(    AudioUnitPropertyID    inID,
@@ -174,20 +195,50 @@ public:
                                             AudioUnitParameterID      inParameterID,
                                             AudioUnitParameterInfo    &outParameterInfo);
     
+    /// Switching linear phase or multirate mode changes the latency, so the host is told about it here.
+    /// Switching linear phase on creates the kernels' convolvers first, off the render thread.
+    using AUEffectBase::SetParameter;
+    virtual OSStatus    SetParameter(       AudioUnitParameterID      inID,
+                                            AudioUnitScope            inScope,
+                                            AudioUnitElement          inElement,
+                                            AudioUnitParameterValue   inValue,
+                                            UInt32                    inBufferOffsetInFrames);
+    
+    /// Restoring a state with linear phase on creates the kernels' convolvers, as SetParameter() does.
+    virtual OSStatus    RestoreState(       CFPropertyListRef         inData);
+    
+    /// A new sample rate changes the tail time.
+    virtual OSStatus    ChangeStreamFormat( AudioUnitScope                  inScope,
+                                            AudioUnitElement                inElement,
+                                            const CAStreamBasicDescription  &inPrevFormat,
+                                            const CAStreamBasicDescription  &inNewFormat);
+    
     // Handle Factory Presets
     virtual OSStatus    GetPresets(CFArrayRef *outData) const;
     virtual OSStatus    NewFactoryPresetSet( const AUPreset &inNewFactoryPreset);
     
-    /// Support a 1ms tail time. A reverb effect would support a more substantial tail in the order of a few seconds.
+    /// The IIR rings until it is 120 dB down, from its pole radius: a few ms at most settings,
+    /// seconds for a resonant cutoff near the bottom of the range. See LoPassProcessor.
+    /// In linear phase mode the tail is the second half of the FIR.
+    /// AUEffectBase asks for it on every render, so it is worked out whenever a parameter or
+    /// the sample rate changes, and GetTailTime() only reads it.
     virtual bool        SupportsTail() { return true; }
-    virtual Float64     GetTailTime() {return 0.001; }
+    virtual Float64     GetTailTime() { return mTailTime.load(std::memory_order_relaxed); }
     
-    /// No latency.
-    /// A lookahead compressor or FFT-based processor should report the true latency in seconds.
-    virtual Float64 GetLatency() { return 0.0; }
+    /// No latency for the IIR filter.
+    /// In linear phase mode, the FIR group delay plus one convolution block, in seconds.
+    /// In multirate mode, the delay of the decimators and interpolators.
+    virtual Float64 GetLatency();
     
 protected:
     
+private:
+    void PrepareKernels(const LoPassSettings &inSettings);
+    void UpdateTailTime();
+    
+    std::unique_ptr<LoPassChannelScheduler> mScheduler;
+    LoPassTelemetry                         mTelemetry;
+    std::atomic<Float64>                    mTailTime;      // seconds, for the current parameters
 };
 
 
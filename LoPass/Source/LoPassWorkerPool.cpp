@@ -0,0 +1,367 @@
+//
+//  LoPassWorkerPool.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassWorkerPool.hpp"
+#include <chrono>
+
+#if LOPASS_TRACE
+    #include "LoPassTrace.hpp"
+#endif
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#elif defined(__APPLE__)
+    #include <mach/mach.h>
+    #include <mach/mach_time.h>
+    #include <mach/thread_policy.h>
+    #include <pthread.h>
+#else
+    #include <semaphore.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+/// Times a worker looks for more work before it goes to sleep, a few microseconds. Not on
+/// a single core, where it would only hold up the thread with the work.
+static constexpr unsigned kWorkerPool_SpinIterations = 2000;
+
+/// Weight of each new buffer in the running averages.
+static constexpr double kWorkerPool_Average = 0.125;
+
+typedef std::chrono::steady_clock Clock;
+
+static inline void Pause() {
+
+#if defined(__SSE2__) || defined(_M_X64)
+    _mm_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSemaphore
+//
+// A counting semaphore that posts without a system call when nobody is asleep on it.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LoPassSemaphore {
+
+public:
+    explicit LoPassSemaphore(unsigned inSpinIterations) : mSpinIterations(inSpinIterations), mCount(0), mSleepers(0) {
+#if defined(__APPLE__)
+        semaphore_create(mach_task_self(), &mSemaphore, SYNC_POLICY_FIFO, 0);
+#elif !defined(__linux__)
+        sem_init(&mSemaphore, 0, 0);
+#endif
+    }
+
+    ~LoPassSemaphore() {
+#if defined(__APPLE__)
+        semaphore_destroy(mach_task_self(), mSemaphore);
+#elif !defined(__linux__)
+        sem_destroy(&mSemaphore);
+#endif
+    }
+
+    void Post(unsigned inCount) {
+
+        mCount.fetch_add((int)inCount);
+        int sleepers = mSleepers.load();
+        if (sleepers == 0) { return; }
+
+#if defined(__linux__)
+        syscall(SYS_futex, (int *)&mCount, FUTEX_WAKE_PRIVATE, (int)inCount, NULL, NULL, 0);
+#else
+        for (int n = 0; n < sleepers && n < (int)inCount; n++) { Signal(); }
+#endif
+    }
+
+    /// Spins for a while before sleeping.
+    void Wait() {
+
+        for (unsigned n = 0; n < mSpinIterations; n++) {
+            if (TryTake()) { return; }
+            Pause();
+        }
+
+        for (;;) {
+            if (TryTake()) { return; }
+
+            mSleepers.fetch_add(1);
+#if defined(__linux__)
+            // sleeps only if the count is still 0, so a post in between isn't lost
+            syscall(SYS_futex, (int *)&mCount, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+#else
+            if (mCount.load() <= 0) { Sleep(); }
+#endif
+            mSleepers.fetch_sub(1);
+        }
+    }
+
+private:
+    bool TryTake() {
+
+        int count = mCount.load(std::memory_order_relaxed);
+        while (count > 0) {
+            if (mCount.compare_exchange_weak(count, count - 1, std::memory_order_acquire)) { return true; }
+        }
+        return false;
+    }
+
+#if defined(__APPLE__)
+    void Signal()   { semaphore_signal(mSemaphore); }
+    void Sleep()    { semaphore_wait(mSemaphore); }
+
+    semaphore_t     mSemaphore;
+#elif !defined(__linux__)
+    void Signal()   { sem_post(&mSemaphore); }
+    void Sleep()    { while (sem_wait(&mSemaphore) != 0) { } }
+
+    sem_t           mSemaphore;
+#endif
+
+    unsigned            mSpinIterations;
+    std::atomic<int>    mCount;
+    std::atomic<int>    mSleepers;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::LoPassWorkerPool()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassWorkerPool::LoPassWorkerPool(unsigned inWorkers) :
+    mSemaphore(new LoPassSemaphore(std::thread::hardware_concurrency() > 1 ? kWorkerPool_SpinIterations : 0)),
+    mQuit(false),
+    mTask(NULL),
+    mContext(NULL),
+    mCount(0),
+    mGroups(0),
+    mClaim(0),
+    mDone(0),
+    mGeneration(0),
+    mSinceProbe(0),
+    mInlineLeft(kWorkerPool_ProbeRuns),
+    mInlineSeconds(0.0),
+    mSharedSeconds(0.0),
+    mRuns(0),
+    mInlineRuns(0),
+    mFallbacks(0),
+    mGroupCount(0),
+    mWorkerGroups(0) {
+
+    unsigned workers = inWorkers < kWorkerPool_MaxWorkers ? inWorkers : kWorkerPool_MaxWorkers;
+    for (unsigned n = 0; n < workers; n++) { mThreads.push_back(std::thread(&LoPassWorkerPool::Work, this)); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::~LoPassWorkerPool()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassWorkerPool::~LoPassWorkerPool() {
+
+    mQuit.store(true, std::memory_order_release);
+    mSemaphore->Post((unsigned)mThreads.size());
+
+    for (size_t n = 0; n < mThreads.size(); n++) { mThreads[n].join(); }
+
+    delete mSemaphore;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::SetRealtime()
+//
+// On Linux a SCHED_FIFO priority just under a typical audio thread's, which needs
+// CAP_SYS_NICE or an rtprio limit. On macOS the same time constraint policy CoreAudio gives
+// its IO threads, sized to the buffer period.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWorkerPool::SetRealtime(double inPeriodSeconds) {
+
+    bool ok = true;
+
+#if defined(__linux__)
+    sched_param param;
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 60;
+    if (param.sched_priority > sched_get_priority_max(SCHED_FIFO)) { param.sched_priority = sched_get_priority_max(SCHED_FIFO); }
+
+    for (size_t n = 0; n < mThreads.size(); n++) {
+        if (pthread_setschedparam(mThreads[n].native_handle(), SCHED_FIFO, &param) != 0) { ok = false; }
+    }
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+
+    double ticksPerSecond = 1e9 * timebase.denom / timebase.numer;
+    uint32_t period = (uint32_t)(inPeriodSeconds * ticksPerSecond);
+
+    thread_time_constraint_policy_data_t policy;
+    policy.period       = period;
+    policy.computation  = period / 2;
+    policy.constraint   = period;
+    policy.preemptible  = true;
+
+    for (size_t n = 0; n < mThreads.size(); n++) {
+        mach_port_t thread = pthread_mach_thread_np(mThreads[n].native_handle());
+        if (thread_policy_set(thread, THREAD_TIME_CONSTRAINT_POLICY, (thread_policy_t)&policy, THREAD_TIME_CONSTRAINT_POLICY_COUNT) != KERN_SUCCESS) { ok = false; }
+    }
+#else
+    (void)inPeriodSeconds;
+    ok = mThreads.empty();
+#endif
+
+    return ok;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::Run()
+//
+// Shares the buffer out unless it is timing the inline runs or has found sharing slower.
+// The shared average only counts once a few buffers have gone into it since the last
+// switch, so one buffer with cold caches doesn't send it back inline.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassWorkerPool::Run(unsigned inCount, LoPassWorkerTask inTask, void *inContext) {
+
+    mRuns++;
+
+    unsigned groups = (unsigned)mThreads.size() + 1;
+    if (groups > inCount) { groups = inCount; }
+
+    if (groups < 2) {
+        mInlineRuns++;
+        inTask(inContext, 0, inCount);
+        return;
+    }
+
+    bool shared = mInlineLeft == 0;
+    Clock::time_point start = Clock::now();
+
+    if (shared) {
+        RunShared(inCount, groups, inTask, inContext);
+    } else {
+        inTask(inContext, 0, inCount);
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!shared) {
+        mInlineRuns++;
+        mInlineSeconds = mInlineSeconds == 0.0 ? seconds : mInlineSeconds + (seconds - mInlineSeconds) * kWorkerPool_Average;
+        if (--mInlineLeft == 0) { mSinceProbe = 0; mSharedSeconds = 0.0; }
+        return;
+    }
+
+    mSharedSeconds = mSharedSeconds == 0.0 ? seconds : mSharedSeconds + (seconds - mSharedSeconds) * kWorkerPool_Average;
+    mSinceProbe++;
+
+    if (mSinceProbe >= kWorkerPool_ProbeRuns && mSharedSeconds > mInlineSeconds) {
+        mInlineLeft = kWorkerPool_InlineRuns;
+        mFallbacks++;
+    } else if (mSinceProbe >= kWorkerPool_ProbeInterval) {
+        mInlineLeft = kWorkerPool_ProbeRuns;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::RunShared()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassWorkerPool::RunShared(unsigned inCount, unsigned inGroups, LoPassWorkerTask inTask, void *inContext) {
+
+    // publish the job; no group of the last one is left to claim, so no worker is reading it
+    mTask.store(inTask, std::memory_order_relaxed);
+    mContext.store(inContext, std::memory_order_relaxed);
+    mCount.store(inCount, std::memory_order_relaxed);
+    mGroups.store(inGroups, std::memory_order_relaxed);
+    mDone.store(0, std::memory_order_relaxed);
+    mGeneration++;
+    mClaim.store((uint64_t)mGeneration << 32, std::memory_order_release);
+
+    mSemaphore->Post(inGroups - 1);
+
+    while (RunGroup()) { }
+
+    // only groups a worker is already running are left
+    while (mDone.load(std::memory_order_acquire) < inGroups) { Pause(); }
+
+    mGroupCount += inGroups;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::RunGroup()
+//
+// Claims and runs the next group of the current job; false once there are none left. The
+// job is read before the claim, and the claim only succeeds if it is still the same job.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWorkerPool::RunGroup() {
+
+    uint64_t claim = mClaim.load(std::memory_order_acquire);
+
+    for (;;) {
+        unsigned group  = (unsigned)claim;
+        unsigned groups = mGroups.load(std::memory_order_relaxed);
+
+        if (group >= groups) { return false; }
+
+        LoPassWorkerTask task   = mTask.load(std::memory_order_relaxed);
+        void *context           = mContext.load(std::memory_order_relaxed);
+        unsigned count          = mCount.load(std::memory_order_relaxed);
+
+        if (mClaim.compare_exchange_weak(claim, claim + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            unsigned begin  = (unsigned)((uint64_t)count * group / groups);
+            unsigned end    = (unsigned)((uint64_t)count * (group + 1) / groups);
+
+            task(context, begin, end);
+
+            mDone.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::Work()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassWorkerPool::Work() {
+
+#if LOPASS_TRACE
+    // the ring is allocated here rather than in the first group
+    LoPassTrace::RegisterThread();
+#endif
+
+    for (;;) {
+        mSemaphore->Wait();
+        if (mQuit.load(std::memory_order_acquire)) { return; }
+
+        while (RunGroup()) { mWorkerGroups.fetch_add(1, std::memory_order_relaxed); }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWorkerPool::GetStatistics()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassWorkerPoolStatistics LoPassWorkerPool::GetStatistics() const {
+
+    LoPassWorkerPoolStatistics statistics;
+    statistics.mRuns            = mRuns;
+    statistics.mInlineRuns      = mInlineRuns;
+    statistics.mFallbacks       = mFallbacks;
+    statistics.mGroups          = mGroupCount;
+    statistics.mWorkerGroups    = mWorkerGroups.load(std::memory_order_relaxed);
+
+    return statistics;
+}
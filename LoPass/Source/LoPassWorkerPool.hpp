@@ -0,0 +1,108 @@
+//
+//  LoPassWorkerPool.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassWorkerPool_hpp
+#define LoPassWorkerPool_hpp
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Worker Pool
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A few threads that help the render thread through one buffer of a wide format: Run()
+// cuts the channels into one group per thread, wakes the workers and works on the groups
+// itself alongside them. Groups are handed out through a single atomic claim counter, so
+// nothing is locked or allocated on the way, and the only system call is the wake-up, a
+// futex on Linux and a Mach semaphore on macOS. Workers spin for a moment before going
+// back to sleep, so at small buffer sizes the next buffer usually finds them awake.
+//
+// The render thread never waits for a worker that hasn't started: it takes whatever groups
+// are left itself, and only waits for groups already being run. A worker that wakes late
+// costs nothing but the wake-up. Run() also times itself: every so often it runs a few
+// buffers inline, and whenever the buffers it shares out take longer on average than those,
+// because the wake-ups cost more than the work saved or the workers can't get a core, it
+// runs everything inline for a while before trying again. Short of channels to share, or
+// with no workers, it always runs inline.
+//
+// Only one thread may call Run() at a time. The task must not throw.
+
+/// Most workers per pool, on top of the calling thread.
+static constexpr unsigned kWorkerPool_MaxWorkers        = 3;
+
+/// Runs between inline timings, how many are timed, and how long Run() stays inline once
+/// sharing has been found to be slower.
+static constexpr unsigned kWorkerPool_ProbeInterval     = 256;
+static constexpr unsigned kWorkerPool_ProbeRuns         = 8;
+static constexpr unsigned kWorkerPool_InlineRuns        = 1024;
+
+/// Runs inTask over channels [inBegin, inEnd).
+typedef void (*LoPassWorkerTask)(void *inContext, unsigned inBegin, unsigned inEnd);
+
+struct LoPassWorkerPoolStatistics {
+    uint64_t mRuns;
+    uint64_t mInlineRuns;       // run without waking anyone
+    uint64_t mFallbacks;        // times sharing was found slower than inline
+    uint64_t mGroups;           // groups handed out by parallel runs
+    uint64_t mWorkerGroups;     // of which run by a worker
+};
+
+class LoPassSemaphore;
+
+class LoPassWorkerPool {
+
+public:
+    /// inWorkers of 0 makes Run() always inline. Clamped to kWorkerPool_MaxWorkers.
+    explicit LoPassWorkerPool(unsigned inWorkers);
+    ~LoPassWorkerPool();
+
+    unsigned GetWorkers() const { return (unsigned)mThreads.size(); }
+
+    /// Ask for realtime scheduling for the workers, for a render thread with the given
+    /// buffer period. Returns false where the system refuses, leaving them as they were;
+    /// the pool works either way, with later wake-ups.
+    bool SetRealtime(double inPeriodSeconds);
+
+    /// Runs inTask over [0, inCount) in groups, returning when every group is done.
+    void Run(unsigned inCount, LoPassWorkerTask inTask, void *inContext);
+
+    LoPassWorkerPoolStatistics GetStatistics() const;
+
+private:
+    void Work();
+    bool RunGroup();
+    void RunShared(unsigned inCount, unsigned inGroups, LoPassWorkerTask inTask, void *inContext);
+
+    std::vector<std::thread>    mThreads;
+    LoPassSemaphore             *mSemaphore;
+    std::atomic<bool>           mQuit;
+
+    // the job being run; mClaim is the job's generation and the next group to hand out,
+    // so a worker can't claim a group of a job that has already finished
+    std::atomic<LoPassWorkerTask> mTask;
+    std::atomic<void *>         mContext;
+    std::atomic<unsigned>       mCount;
+    std::atomic<unsigned>       mGroups;
+    std::atomic<uint64_t>       mClaim;
+    std::atomic<unsigned>       mDone;
+    uint32_t                    mGeneration;
+
+    // touched by the calling thread only, except mWorkerGroups
+    unsigned                    mSinceProbe;
+    unsigned                    mInlineLeft;
+    double                      mInlineSeconds;     // running averages per buffer
+    double                      mSharedSeconds;
+    uint64_t                    mRuns;
+    uint64_t                    mInlineRuns;
+    uint64_t                    mFallbacks;
+    uint64_t                    mGroupCount;
+    std::atomic<uint64_t>       mWorkerGroups;
+};
+
+#endif /* LoPassWorkerPool_hpp */
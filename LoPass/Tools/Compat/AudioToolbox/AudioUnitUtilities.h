@@ -0,0 +1,16 @@
+//
+//  AudioUnitUtilities.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. Nothing from
+//  it is used on the paths the compat layer builds.
+//
+
+#ifndef AudioUnitUtilities_h
+#define AudioUnitUtilities_h
+
+#include <AudioUnit/AudioUnit.h>
+
+#endif /* AudioUnitUtilities_h */
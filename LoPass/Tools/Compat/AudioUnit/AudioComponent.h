@@ -0,0 +1,67 @@
+//
+//  AudioComponent.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. Components
+//  exist only once registered in-process with AudioComponentRegister(); there is no bundle
+//  search.
+//
+
+#ifndef AudioComponent_h
+#define AudioComponent_h
+
+#include <CoreFoundation/CoreFoundation.h>
+
+CF_EXTERN_C_BEGIN
+
+typedef UInt32 AudioComponentFlags;
+
+enum {
+    kAudioComponentFlag_Unsearchable    = 1,
+    kAudioComponentFlag_SandboxSafe     = 2,
+    kAudioComponentFlag_IsV3AudioUnit   = 4,
+    kAudioComponentFlag_RequiresAsyncInstantiation = 8,
+    kAudioComponentFlag_CanLoadInProcess = 0x10
+};
+
+typedef struct AudioComponentDescription {
+    OSType  componentType;
+    OSType  componentSubType;
+    OSType  componentManufacturer;
+    UInt32  componentFlags;
+    UInt32  componentFlagsMask;
+} AudioComponentDescription;
+
+typedef struct OpaqueAudioComponent             *AudioComponent;
+typedef struct ComponentInstanceRecord          *AudioComponentInstance;
+
+typedef OSStatus (*AudioComponentMethod)(void *self, ...);
+
+typedef struct AudioComponentPlugInInterface {
+    OSStatus                (*Open)(void *self, AudioComponentInstance mInstance);
+    OSStatus                (*Close)(void *self);
+    AudioComponentMethod    (*Lookup)(SInt16 selector);
+    void                    *reserved;
+} AudioComponentPlugInInterface;
+
+typedef AudioComponentPlugInInterface *(*AudioComponentFactoryFunction)(const AudioComponentDescription *inDesc);
+
+extern AudioComponent   AudioComponentFindNext(AudioComponent inComponent, const AudioComponentDescription *inDesc);
+extern UInt32           AudioComponentCount(const AudioComponentDescription *inDesc);
+extern OSStatus         AudioComponentCopyName(AudioComponent inComponent, CFStringRef *outName);
+extern OSStatus         AudioComponentGetDescription(AudioComponent inComponent, AudioComponentDescription *outDesc);
+extern OSStatus         AudioComponentGetVersion(AudioComponent inComponent, UInt32 *outVersion);
+
+extern OSStatus         AudioComponentInstanceNew(AudioComponent inComponent, AudioComponentInstance *outInstance);
+extern OSStatus         AudioComponentInstanceDispose(AudioComponentInstance inInstance);
+extern AudioComponent   AudioComponentInstanceGetComponent(AudioComponentInstance inInstance);
+extern Boolean          AudioComponentInstanceCanDo(AudioComponentInstance inInstance, SInt16 inSelectorID);
+
+extern AudioComponent   AudioComponentRegister(const AudioComponentDescription *inDesc, CFStringRef inName, UInt32 inVersion,
+                                               AudioComponentFactoryFunction inFactory);
+
+CF_EXTERN_C_END
+
+#endif /* AudioComponent_h */
@@ -0,0 +1,18 @@
+//
+//  AudioUnit.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp.
+//
+
+#ifndef AudioUnit_h
+#define AudioUnit_h
+
+#include <AudioUnit/AudioComponent.h>
+#include <AudioUnit/AUComponent.h>
+#include <AudioUnit/AudioUnitProperties.h>
+#include <AudioUnit/MusicDevice.h>
+
+#endif /* AudioUnit_h */
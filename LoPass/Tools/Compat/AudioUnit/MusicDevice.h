@@ -0,0 +1,53 @@
+//
+//  MusicDevice.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. The types
+//  AUBase's instrument entry points are declared with.
+//
+
+#ifndef MusicDevice_h
+#define MusicDevice_h
+
+#include <AudioUnit/AUComponent.h>
+
+CF_EXTERN_C_BEGIN
+
+typedef UInt32 MusicDeviceInstrumentID;
+typedef UInt32 MusicDeviceGroupID;
+typedef UInt32 NoteInstanceID;
+typedef AudioComponentInstance MusicDeviceComponent;
+
+typedef struct NoteParamsControlValue {
+    AudioUnitParameterID    mID;
+    AudioUnitParameterValue mValue;
+} NoteParamsControlValue;
+
+typedef struct MusicDeviceNoteParams {
+    UInt32                  argCount;
+    Float32                 mPitch;
+    Float32                 mVelocity;
+    NoteParamsControlValue  mControls[1];   // arbitrary length
+} MusicDeviceNoteParams;
+
+enum {
+    kMusicDeviceRange                   = 0x0100,
+    kMusicDeviceMIDIEventSelect         = 0x0101,
+    kMusicDeviceSysExSelect             = 0x0102,
+    kMusicDevicePrepareInstrumentSelect = 0x0103,
+    kMusicDeviceReleaseInstrumentSelect = 0x0104,
+    kMusicDeviceStartNoteSelect         = 0x0105,
+    kMusicDeviceStopNoteSelect          = 0x0106
+};
+
+enum {
+    kAudioOutputUnitRange               = 0x0200,
+    kAudioOutputUnitStartSelect         = 0x0201,
+    kAudioOutputUnitStopSelect          = 0x0202
+};
+
+CF_EXTERN_C_END
+
+#endif /* MusicDevice_h */
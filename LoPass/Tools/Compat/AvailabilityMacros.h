@@ -0,0 +1,35 @@
+//
+//  AvailabilityMacros.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. Versions as
+//  the Xcode project builds for, macOS 11.3 on the 11.3 SDK.
+//
+
+#ifndef AvailabilityMacros_h
+#define AvailabilityMacros_h
+
+#define MAC_OS_X_VERSION_10_4           1040
+#define MAC_OS_X_VERSION_10_5           1050
+#define MAC_OS_X_VERSION_10_6           1060
+#define MAC_OS_X_VERSION_10_7           1070
+#define MAC_OS_X_VERSION_10_8           1080
+#define MAC_OS_X_VERSION_10_9           1090
+#define MAC_OS_X_VERSION_10_10          101000
+#define MAC_OS_X_VERSION_10_11          101100
+#define MAC_OS_X_VERSION_10_12          101200
+#define MAC_OS_VERSION_11_0             110000
+#define MAC_OS_VERSION_11_3             110300
+
+#define MAC_OS_X_VERSION_MIN_REQUIRED   MAC_OS_VERSION_11_3
+#define MAC_OS_X_VERSION_MAX_ALLOWED    MAC_OS_VERSION_11_3
+
+#define API_AVAILABLE(...)
+#define API_DEPRECATED(...)
+#define API_UNAVAILABLE(...)
+#define DEPRECATED_ATTRIBUTE
+#define AVAILABLE_MAC_OS_X_VERSION_10_5_AND_LATER
+
+#endif /* AvailabilityMacros_h */
@@ -0,0 +1,239 @@
+//
+//  CoreAudioTypes.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. Layouts and
+//  values are the SDK's, for the types the AU classes use.
+//
+
+#ifndef CoreAudioTypes_h
+#define CoreAudioTypes_h
+
+#include <CoreFoundation/CFBase.h>
+
+#define COREAUDIOTYPES_VERSION 1051
+
+CF_EXTERN_C_BEGIN
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Errors
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+enum {
+    kAudio_UnimplementedError       = -4,
+    kAudio_FileNotFoundError        = -43,
+    kAudio_FilePermissionError      = -54,
+    kAudio_TooManyFilesOpenError    = -42,
+    kAudio_BadFilePathError         = '!pth',
+    kAudio_ParamError               = -50,
+    kAudio_MemFullError             = -108
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Buffers
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct AudioValueRange {
+    Float64     mMinimum;
+    Float64     mMaximum;
+};
+typedef struct AudioValueRange AudioValueRange;
+
+struct AudioBuffer {
+    UInt32      mNumberChannels;
+    UInt32      mDataByteSize;
+    void        *mData;
+};
+typedef struct AudioBuffer AudioBuffer;
+
+struct AudioBufferList {
+    UInt32      mNumberBuffers;
+    AudioBuffer mBuffers[1];    // this is a variable length array of mNumberBuffers elements
+};
+typedef struct AudioBufferList AudioBufferList;
+
+typedef Float32 AudioSampleType;
+typedef Float32 AudioUnitSampleType;
+
+enum {
+    kAudioUnitSampleFractionBits    = 24
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Formats
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef UInt32 AudioFormatID;
+typedef UInt32 AudioFormatFlags;
+
+struct AudioStreamBasicDescription {
+    Float64             mSampleRate;
+    AudioFormatID       mFormatID;
+    AudioFormatFlags    mFormatFlags;
+    UInt32              mBytesPerPacket;
+    UInt32              mFramesPerPacket;
+    UInt32              mBytesPerFrame;
+    UInt32              mChannelsPerFrame;
+    UInt32              mBitsPerChannel;
+    UInt32              mReserved;
+};
+typedef struct AudioStreamBasicDescription AudioStreamBasicDescription;
+
+static const Float64 kAudioStreamAnyRate = 0.0;
+
+enum {
+    kAudioFormatLinearPCM           = 'lpcm',
+    kAudioFormatAC3                 = 'ac-3',
+    kAudioFormat60958AC3            = 'cac3',
+    kAudioFormatAppleIMA4           = 'ima4',
+    kAudioFormatMPEG4AAC            = 'aac ',
+    kAudioFormatAppleLossless       = 'alac',
+    kAudioFormatMPEGLayer3          = '.mp3'
+};
+
+enum {
+    kAudioFormatFlagIsFloat                     = (1U << 0),
+    kAudioFormatFlagIsBigEndian                 = (1U << 1),
+    kAudioFormatFlagIsSignedInteger             = (1U << 2),
+    kAudioFormatFlagIsPacked                    = (1U << 3),
+    kAudioFormatFlagIsAlignedHigh               = (1U << 4),
+    kAudioFormatFlagIsNonInterleaved            = (1U << 5),
+    kAudioFormatFlagIsNonMixable                = (1U << 6),
+    kAudioFormatFlagsAreAllClear                = 0x80000000,
+
+    kLinearPCMFormatFlagIsFloat                 = kAudioFormatFlagIsFloat,
+    kLinearPCMFormatFlagIsBigEndian             = kAudioFormatFlagIsBigEndian,
+    kLinearPCMFormatFlagIsSignedInteger         = kAudioFormatFlagIsSignedInteger,
+    kLinearPCMFormatFlagIsPacked                = kAudioFormatFlagIsPacked,
+    kLinearPCMFormatFlagIsAlignedHigh           = kAudioFormatFlagIsAlignedHigh,
+    kLinearPCMFormatFlagIsNonInterleaved        = kAudioFormatFlagIsNonInterleaved,
+    kLinearPCMFormatFlagIsNonMixable            = kAudioFormatFlagIsNonMixable,
+    kLinearPCMFormatFlagsSampleFractionShift    = 7,
+    kLinearPCMFormatFlagsSampleFractionMask     = (0x3F << kLinearPCMFormatFlagsSampleFractionShift),
+    kLinearPCMFormatFlagsAreAllClear            = kAudioFormatFlagsAreAllClear,
+
+    kAppleLosslessFormatFlag_16BitSourceData    = 1,
+    kAppleLosslessFormatFlag_20BitSourceData    = 2,
+    kAppleLosslessFormatFlag_24BitSourceData    = 3,
+    kAppleLosslessFormatFlag_32BitSourceData    = 4
+};
+
+enum {
+    kAudioFormatFlagsNativeEndian               = 0,
+    kAudioFormatFlagsCanonical                  = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked,
+    kAudioFormatFlagsAudioUnitCanonical         = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked | kAudioFormatFlagIsNonInterleaved,
+    kAudioFormatFlagsNativeFloatPacked          = kAudioFormatFlagIsFloat | kAudioFormatFlagsNativeEndian | kAudioFormatFlagIsPacked
+};
+
+struct AudioStreamPacketDescription {
+    SInt64      mStartOffset;
+    UInt32      mVariableFramesInPacket;
+    UInt32      mDataByteSize;
+};
+typedef struct AudioStreamPacketDescription AudioStreamPacketDescription;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Time stamps
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef UInt32 SMPTETimeType;
+typedef UInt32 SMPTETimeFlags;
+
+struct SMPTETime {
+    SInt16          mSubframes;
+    SInt16          mSubframeDivisor;
+    UInt32          mCounter;
+    SMPTETimeType   mType;
+    SMPTETimeFlags  mFlags;
+    SInt16          mHours;
+    SInt16          mMinutes;
+    SInt16          mSeconds;
+    SInt16          mFrames;
+};
+typedef struct SMPTETime SMPTETime;
+
+typedef UInt32 AudioTimeStampFlags;
+
+enum {
+    kAudioTimeStampNothingValid         = 0,
+    kAudioTimeStampSampleTimeValid      = (1U << 0),
+    kAudioTimeStampHostTimeValid        = (1U << 1),
+    kAudioTimeStampRateScalarValid      = (1U << 2),
+    kAudioTimeStampWordClockTimeValid   = (1U << 3),
+    kAudioTimeStampSMPTETimeValid       = (1U << 4),
+    kAudioTimeStampSampleHostTimeValid  = (kAudioTimeStampSampleTimeValid | kAudioTimeStampHostTimeValid)
+};
+
+struct AudioTimeStamp {
+    Float64             mSampleTime;
+    UInt64              mHostTime;
+    Float64             mRateScalar;
+    UInt64              mWordClockTime;
+    SMPTETime           mSMPTETime;
+    AudioTimeStampFlags mFlags;
+    UInt32              mReserved;
+};
+typedef struct AudioTimeStamp AudioTimeStamp;
+
+struct AudioClassDescription {
+    OSType  mType;
+    OSType  mSubType;
+    OSType  mManufacturer;
+};
+typedef struct AudioClassDescription AudioClassDescription;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Channel layouts
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef UInt32 AudioChannelLabel;
+typedef UInt32 AudioChannelLayoutTag;
+typedef UInt32 AudioChannelBitmap;
+typedef UInt32 AudioChannelFlags;
+
+enum {
+    kAudioChannelLabel_Unknown          = 0xFFFFFFFF,
+    kAudioChannelLabel_Unused           = 0,
+    kAudioChannelLabel_Left             = 1,
+    kAudioChannelLabel_Right            = 2,
+    kAudioChannelLabel_Center           = 3,
+    kAudioChannelLabel_LFEScreen        = 4,
+    kAudioChannelLabel_LeftSurround     = 5,
+    kAudioChannelLabel_RightSurround    = 6,
+    kAudioChannelLabel_Mono             = 42
+};
+
+struct AudioChannelDescription {
+    AudioChannelLabel   mChannelLabel;
+    AudioChannelFlags   mChannelFlags;
+    Float32             mCoordinates[3];
+};
+typedef struct AudioChannelDescription AudioChannelDescription;
+
+struct AudioChannelLayout {
+    AudioChannelLayoutTag   mChannelLayoutTag;
+    AudioChannelBitmap      mChannelBitmap;
+    UInt32                  mNumberChannelDescriptions;
+    AudioChannelDescription mChannelDescriptions[1];    // this is a variable length array of mNumberChannelDescriptions elements
+};
+typedef struct AudioChannelLayout AudioChannelLayout;
+
+/// The low 16 bits of a tag are its channel count.
+#define AudioChannelLayoutTag_GetNumberOfChannels(layoutTag) ((UInt32)((layoutTag) & 0x0000FFFF))
+
+enum {
+    kAudioChannelLayoutTag_UseChannelDescriptions   = (0U << 16) | 0,
+    kAudioChannelLayoutTag_UseChannelBitmap         = (1U << 16) | 0,
+    kAudioChannelLayoutTag_Mono                     = (100U << 16) | 1,
+    kAudioChannelLayoutTag_Stereo                   = (101U << 16) | 2,
+    kAudioChannelLayoutTag_Quadraphonic             = (108U << 16) | 4,
+    kAudioChannelLayoutTag_MPEG_5_1_A               = (121U << 16) | 6,
+    kAudioChannelLayoutTag_DiscreteInOrder          = (147U << 16) | 0,
+    kAudioChannelLayoutTag_Unknown                  = 0xFFFF0000
+};
+
+CF_EXTERN_C_END
+
+#endif /* CoreAudioTypes_h */
@@ -0,0 +1,73 @@
+//
+//  CFBase.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp.
+//
+
+#ifndef CFBase_h
+#define CFBase_h
+
+#include <AvailabilityMacros.h>
+#include <MacTypes.h>
+#include <TargetConditionals.h>
+
+#if defined(__cplusplus)
+    #define CF_EXTERN_C_BEGIN   extern "C" {
+    #define CF_EXTERN_C_END     }
+#else
+    #define CF_EXTERN_C_BEGIN
+    #define CF_EXTERN_C_END
+#endif
+
+#define CF_EXPORT               extern
+#define CF_INLINE               static inline
+#define CF_ENUM(type, name)     type name; enum
+
+#ifndef TRUE
+    #define TRUE                1
+#endif
+#ifndef FALSE
+    #define FALSE               0
+#endif
+
+CF_EXTERN_C_BEGIN
+
+typedef const void              *CFTypeRef;
+typedef unsigned long           CFTypeID;
+typedef unsigned long           CFOptionFlags;
+typedef unsigned long           CFHashCode;
+typedef long                    CFIndex;
+
+typedef const struct __CFAllocator  *CFAllocatorRef;
+typedef const struct __CFString     *CFStringRef;
+typedef struct __CFString           *CFMutableStringRef;
+typedef CFTypeRef                   CFPropertyListRef;
+
+#define kCFAllocatorDefault     ((CFAllocatorRef)NULL)
+
+typedef struct {
+    CFIndex     location;
+    CFIndex     length;
+} CFRange;
+
+CF_INLINE CFRange CFRangeMake(CFIndex inLocation, CFIndex inLength) { CFRange range = { inLocation, inLength }; return range; }
+
+typedef CF_ENUM(CFIndex, CFComparisonResult) {
+    kCFCompareLessThan      = -1,
+    kCFCompareEqualTo       = 0,
+    kCFCompareGreaterThan   = 1
+};
+
+CF_EXPORT CFTypeRef     CFRetain(CFTypeRef inObject);
+CF_EXPORT void          CFRelease(CFTypeRef inObject);
+CF_EXPORT CFIndex       CFGetRetainCount(CFTypeRef inObject);
+CF_EXPORT CFTypeID      CFGetTypeID(CFTypeRef inObject);
+CF_EXPORT Boolean       CFEqual(CFTypeRef inA, CFTypeRef inB);
+CF_EXPORT CFHashCode    CFHash(CFTypeRef inObject);
+
+CF_EXTERN_C_END
+
+#endif /* CFBase_h */
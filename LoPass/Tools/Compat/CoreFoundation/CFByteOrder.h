@@ -0,0 +1,45 @@
+//
+//  CFByteOrder.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. Every target
+//  the compat layer builds for is little-endian.
+//
+
+#ifndef CFByteOrder_h
+#define CFByteOrder_h
+
+#include <CoreFoundation/CFBase.h>
+
+CF_EXTERN_C_BEGIN
+
+typedef CF_ENUM(CFIndex, CFByteOrder) {
+    CFByteOrderUnknown,
+    CFByteOrderLittleEndian,
+    CFByteOrderBigEndian
+};
+
+CF_INLINE CFByteOrder CFByteOrderGetCurrent(void) { return CFByteOrderLittleEndian; }
+
+CF_INLINE UInt16 CFSwapInt16(UInt16 inValue) { return __builtin_bswap16(inValue); }
+CF_INLINE UInt32 CFSwapInt32(UInt32 inValue) { return __builtin_bswap32(inValue); }
+CF_INLINE UInt64 CFSwapInt64(UInt64 inValue) { return __builtin_bswap64(inValue); }
+
+CF_INLINE UInt16 CFSwapInt16BigToHost(UInt16 inValue) { return CFSwapInt16(inValue); }
+CF_INLINE UInt32 CFSwapInt32BigToHost(UInt32 inValue) { return CFSwapInt32(inValue); }
+CF_INLINE UInt64 CFSwapInt64BigToHost(UInt64 inValue) { return CFSwapInt64(inValue); }
+CF_INLINE UInt16 CFSwapInt16HostToBig(UInt16 inValue) { return CFSwapInt16(inValue); }
+CF_INLINE UInt32 CFSwapInt32HostToBig(UInt32 inValue) { return CFSwapInt32(inValue); }
+CF_INLINE UInt64 CFSwapInt64HostToBig(UInt64 inValue) { return CFSwapInt64(inValue); }
+CF_INLINE UInt16 CFSwapInt16LittleToHost(UInt16 inValue) { return inValue; }
+CF_INLINE UInt32 CFSwapInt32LittleToHost(UInt32 inValue) { return inValue; }
+CF_INLINE UInt64 CFSwapInt64LittleToHost(UInt64 inValue) { return inValue; }
+CF_INLINE UInt16 CFSwapInt16HostToLittle(UInt16 inValue) { return inValue; }
+CF_INLINE UInt32 CFSwapInt32HostToLittle(UInt32 inValue) { return inValue; }
+CF_INLINE UInt64 CFSwapInt64HostToLittle(UInt64 inValue) { return inValue; }
+
+CF_EXTERN_C_END
+
+#endif /* CFByteOrder_h */
@@ -0,0 +1,192 @@
+//
+//  CoreFoundation.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. Only what the
+//  AU classes use: strings, numbers, data, arrays and dictionaries, enough to build and
+//  read back a class info document and the preset and parameter name lists.
+//
+
+#ifndef CoreFoundation_h
+#define CoreFoundation_h
+
+#include <CoreFoundation/CFBase.h>
+#include <CoreFoundation/CFByteOrder.h>
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+CF_EXTERN_C_BEGIN
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BSD libc
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Darwin's libc has these; glibc gained strlcpy only in 2.38.
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t  strlcpy(char *outDest, const char *inSource, size_t inSize);
+#endif
+void    *reallocf(void *inPointer, size_t inSize);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Strings
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef UInt32 CFStringEncoding;
+
+enum {
+    kCFStringEncodingMacRoman       = 0,
+    kCFStringEncodingASCII          = 0x0600,
+    kCFStringEncodingUTF8           = 0x08000100
+};
+
+/// What CFSTR() expands to without the compiler's constant strings: interned, never freed.
+CF_EXPORT CFStringRef   __CFStringMakeConstantString(const char *inString);
+#define CFSTR(cStr)     __CFStringMakeConstantString("" cStr "")
+
+CF_EXPORT CFTypeID      CFStringGetTypeID(void);
+CF_EXPORT CFStringRef   CFStringCreateWithCString(CFAllocatorRef inAllocator, const char *inString, CFStringEncoding inEncoding);
+CF_EXPORT CFStringRef   CFStringCreateCopy(CFAllocatorRef inAllocator, CFStringRef inString);
+CF_EXPORT CFIndex       CFStringGetLength(CFStringRef inString);
+CF_EXPORT Boolean       CFStringGetCString(CFStringRef inString, char *outBuffer, CFIndex inBufferSize, CFStringEncoding inEncoding);
+CF_EXPORT const char    *CFStringGetCStringPtr(CFStringRef inString, CFStringEncoding inEncoding);
+CF_EXPORT CFComparisonResult CFStringCompare(CFStringRef inA, CFStringRef inB, CFOptionFlags inOptions);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Numbers
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef const struct __CFNumber *CFNumberRef;
+
+typedef CF_ENUM(CFIndex, CFNumberType) {
+    kCFNumberSInt8Type      = 1,
+    kCFNumberSInt16Type     = 2,
+    kCFNumberSInt32Type     = 3,
+    kCFNumberSInt64Type     = 4,
+    kCFNumberFloat32Type    = 5,
+    kCFNumberFloat64Type    = 6,
+    kCFNumberCharType       = 7,
+    kCFNumberShortType      = 8,
+    kCFNumberIntType        = 9,
+    kCFNumberLongType       = 10,
+    kCFNumberLongLongType   = 11,
+    kCFNumberFloatType      = 12,
+    kCFNumberDoubleType     = 13,
+    kCFNumberCFIndexType    = 14
+};
+
+CF_EXPORT CFTypeID      CFNumberGetTypeID(void);
+CF_EXPORT CFNumberRef   CFNumberCreate(CFAllocatorRef inAllocator, CFNumberType inType, const void *inValuePtr);
+CF_EXPORT Boolean       CFNumberGetValue(CFNumberRef inNumber, CFNumberType inType, void *outValuePtr);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Data
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef const struct __CFData   *CFDataRef;
+typedef struct __CFData         *CFMutableDataRef;
+
+CF_EXPORT CFTypeID          CFDataGetTypeID(void);
+CF_EXPORT CFDataRef         CFDataCreate(CFAllocatorRef inAllocator, const UInt8 *inBytes, CFIndex inLength);
+CF_EXPORT CFMutableDataRef  CFDataCreateMutable(CFAllocatorRef inAllocator, CFIndex inCapacity);
+CF_EXPORT void              CFDataAppendBytes(CFMutableDataRef ioData, const UInt8 *inBytes, CFIndex inLength);
+CF_EXPORT CFIndex           CFDataGetLength(CFDataRef inData);
+CF_EXPORT const UInt8       *CFDataGetBytePtr(CFDataRef inData);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Arrays
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef const void  *(*CFArrayRetainCallBack)(CFAllocatorRef inAllocator, const void *inValue);
+typedef void        (*CFArrayReleaseCallBack)(CFAllocatorRef inAllocator, const void *inValue);
+typedef CFStringRef (*CFArrayCopyDescriptionCallBack)(const void *inValue);
+typedef Boolean     (*CFArrayEqualCallBack)(const void *inA, const void *inB);
+
+typedef struct {
+    CFIndex                         version;
+    CFArrayRetainCallBack           retain;
+    CFArrayReleaseCallBack          release;
+    CFArrayCopyDescriptionCallBack  copyDescription;
+    CFArrayEqualCallBack            equal;
+} CFArrayCallBacks;
+
+CF_EXPORT const CFArrayCallBacks kCFTypeArrayCallBacks;
+
+typedef const struct __CFArray  *CFArrayRef;
+typedef struct __CFArray        *CFMutableArrayRef;
+
+CF_EXPORT CFTypeID          CFArrayGetTypeID(void);
+CF_EXPORT CFArrayRef        CFArrayCreate(CFAllocatorRef inAllocator, const void **inValues, CFIndex inCount, const CFArrayCallBacks *inCallBacks);
+CF_EXPORT CFMutableArrayRef CFArrayCreateMutable(CFAllocatorRef inAllocator, CFIndex inCapacity, const CFArrayCallBacks *inCallBacks);
+CF_EXPORT void              CFArrayAppendValue(CFMutableArrayRef ioArray, const void *inValue);
+CF_EXPORT CFIndex           CFArrayGetCount(CFArrayRef inArray);
+CF_EXPORT const void        *CFArrayGetValueAtIndex(CFArrayRef inArray, CFIndex inIndex);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Dictionaries
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef const void  *(*CFDictionaryRetainCallBack)(CFAllocatorRef inAllocator, const void *inValue);
+typedef void        (*CFDictionaryReleaseCallBack)(CFAllocatorRef inAllocator, const void *inValue);
+typedef CFStringRef (*CFDictionaryCopyDescriptionCallBack)(const void *inValue);
+typedef Boolean     (*CFDictionaryEqualCallBack)(const void *inA, const void *inB);
+typedef CFHashCode  (*CFDictionaryHashCallBack)(const void *inValue);
+
+typedef struct {
+    CFIndex                             version;
+    CFDictionaryRetainCallBack          retain;
+    CFDictionaryReleaseCallBack         release;
+    CFDictionaryCopyDescriptionCallBack copyDescription;
+    CFDictionaryEqualCallBack           equal;
+    CFDictionaryHashCallBack            hash;
+} CFDictionaryKeyCallBacks;
+
+typedef struct {
+    CFIndex                             version;
+    CFDictionaryRetainCallBack          retain;
+    CFDictionaryReleaseCallBack         release;
+    CFDictionaryCopyDescriptionCallBack copyDescription;
+    CFDictionaryEqualCallBack           equal;
+} CFDictionaryValueCallBacks;
+
+CF_EXPORT const CFDictionaryKeyCallBacks    kCFTypeDictionaryKeyCallBacks;
+CF_EXPORT const CFDictionaryKeyCallBacks    kCFCopyStringDictionaryKeyCallBacks;
+CF_EXPORT const CFDictionaryValueCallBacks  kCFTypeDictionaryValueCallBacks;
+
+typedef const struct __CFDictionary *CFDictionaryRef;
+typedef struct __CFDictionary       *CFMutableDictionaryRef;
+
+CF_EXPORT CFTypeID                  CFDictionaryGetTypeID(void);
+CF_EXPORT CFMutableDictionaryRef    CFDictionaryCreateMutable(CFAllocatorRef inAllocator, CFIndex inCapacity,
+                                                              const CFDictionaryKeyCallBacks *inKeyCallBacks,
+                                                              const CFDictionaryValueCallBacks *inValueCallBacks);
+CF_EXPORT void          CFDictionarySetValue(CFMutableDictionaryRef ioDictionary, const void *inKey, const void *inValue);
+CF_EXPORT void          CFDictionaryRemoveValue(CFMutableDictionaryRef ioDictionary, const void *inKey);
+CF_EXPORT const void    *CFDictionaryGetValue(CFDictionaryRef inDictionary, const void *inKey);
+CF_EXPORT Boolean       CFDictionaryGetValueIfPresent(CFDictionaryRef inDictionary, const void *inKey, const void **outValue);
+CF_EXPORT Boolean       CFDictionaryContainsKey(CFDictionaryRef inDictionary, const void *inKey);
+CF_EXPORT CFIndex       CFDictionaryGetCount(CFDictionaryRef inDictionary);
+CF_EXPORT void          CFDictionaryGetKeysAndValues(CFDictionaryRef inDictionary, const void **outKeys, const void **outValues);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// URLs
+//
+// Only the type: the icon location and external file references are never asked for.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef const struct __CFURL    *CFURLRef;
+
+CF_EXTERN_C_END
+
+#endif /* CoreFoundation_h */
@@ -0,0 +1,719 @@
+//
+//  LoPassCompat.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Just enough of CoreFoundation, the AudioComponent registry and the Darwin calls under
+//  them to build AUBase, AUEffectBase and LoPassUnit on Linux, so the framework's part of
+//  a render can be profiled and sanitized where the kernels already are.
+//
+//  The headers beside this file stand in for the SDK's, with the SDK's names and values,
+//  and present the build as macOS with CA_USE_AUDIO_PLUGIN_ONLY: the AU classes compile
+//  unchanged and take the same paths they take in the bundle, AudioComponent plug-in
+//  dispatch, pthread locks and the lot. Nothing past what those classes and lopass-host
+//  call is here; CF objects are small reference counted C++ objects, strings are UTF-8
+//  throughout, and a component is registered with AudioComponentRegister() the way
+//  APFactory::Register() does it, since there are no bundles to find factories in.
+//
+
+#include <AudioUnit/AudioUnit.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include <libkern/OSAtomic.h>
+#include <sys/sysctl.h>
+#include <errno.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CF objects
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+enum {
+    kTypeID_String      = 7,
+    kTypeID_Number      = 22,
+    kTypeID_Data        = 20,
+    kTypeID_Array       = 19,
+    kTypeID_Dictionary  = 18
+};
+
+/// What every CFTypeRef points at. Constant strings are never released.
+struct CompatObject {
+    explicit CompatObject(CFTypeID inType) : mType(inType), mRetainCount(1), mConstant(false) {}
+    virtual ~CompatObject() {}
+
+    CFTypeID    mType;
+    long        mRetainCount;
+    bool        mConstant;
+};
+
+static CompatObject *Object(CFTypeRef inObject) { return (CompatObject *)inObject; }
+
+struct __CFString : CompatObject {
+    explicit __CFString(const std::string &inString) : CompatObject(kTypeID_String), mString(inString) {}
+    std::string mString;
+};
+
+struct __CFNumber : CompatObject {
+    __CFNumber(bool inIsFloat, int64_t inInteger, double inFloat) :
+        CompatObject(kTypeID_Number), mIsFloat(inIsFloat), mInteger(inInteger), mFloat(inFloat) {}
+    bool        mIsFloat;
+    int64_t     mInteger;
+    double      mFloat;
+};
+
+struct __CFData : CompatObject {
+    __CFData() : CompatObject(kTypeID_Data) {}
+    std::vector<UInt8>  mBytes;
+};
+
+struct __CFArray : CompatObject {
+    explicit __CFArray(const CFArrayCallBacks *inCallBacks) : CompatObject(kTypeID_Array), mCallBacks() {
+        if (inCallBacks != NULL) { mCallBacks = *inCallBacks; }
+    }
+    ~__CFArray() {
+        for (size_t i = 0; i < mValues.size(); i++) {
+            if (mCallBacks.release != NULL) { mCallBacks.release(kCFAllocatorDefault, mValues[i]); }
+        }
+    }
+    CFArrayCallBacks            mCallBacks;
+    std::vector<const void *>   mValues;
+};
+
+struct __CFDictionary : CompatObject {
+    __CFDictionary(const CFDictionaryKeyCallBacks *inKeyCallBacks, const CFDictionaryValueCallBacks *inValueCallBacks) :
+        CompatObject(kTypeID_Dictionary), mKeyCallBacks(), mValueCallBacks() {
+        if (inKeyCallBacks != NULL) { mKeyCallBacks = *inKeyCallBacks; }
+        if (inValueCallBacks != NULL) { mValueCallBacks = *inValueCallBacks; }
+    }
+    ~__CFDictionary() {
+        for (size_t i = 0; i < mKeys.size(); i++) { ReleaseEntry(i); }
+    }
+
+    /// The class info and preset documents hold a dozen keys; a linear search is plenty.
+    CFIndex Find(const void *inKey) const {
+        for (size_t i = 0; i < mKeys.size(); i++) {
+            if (mKeys[i] == inKey || (mKeyCallBacks.equal != NULL && mKeyCallBacks.equal(mKeys[i], inKey))) { return (CFIndex)i; }
+        }
+        return -1;
+    }
+
+    void ReleaseEntry(size_t inIndex) {
+        if (mKeyCallBacks.release != NULL) { mKeyCallBacks.release(kCFAllocatorDefault, mKeys[inIndex]); }
+        if (mValueCallBacks.release != NULL) { mValueCallBacks.release(kCFAllocatorDefault, mValues[inIndex]); }
+    }
+
+    CFDictionaryKeyCallBacks    mKeyCallBacks;
+    CFDictionaryValueCallBacks  mValueCallBacks;
+    std::vector<const void *>   mKeys;
+    std::vector<const void *>   mValues;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CFBase
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+CFTypeRef CFRetain(CFTypeRef inObject) {
+
+    if (!Object(inObject)->mConstant) { __atomic_add_fetch(&Object(inObject)->mRetainCount, 1, __ATOMIC_RELAXED); }
+    return inObject;
+}
+
+void CFRelease(CFTypeRef inObject) {
+
+    if (Object(inObject)->mConstant) { return; }
+    if (__atomic_sub_fetch(&Object(inObject)->mRetainCount, 1, __ATOMIC_ACQ_REL) == 0) { delete Object(inObject); }
+}
+
+CFIndex CFGetRetainCount(CFTypeRef inObject) {
+
+    return Object(inObject)->mConstant ? LONG_MAX : __atomic_load_n(&Object(inObject)->mRetainCount, __ATOMIC_RELAXED);
+}
+
+CFTypeID CFGetTypeID(CFTypeRef inObject) { return Object(inObject)->mType; }
+
+Boolean CFEqual(CFTypeRef inA, CFTypeRef inB) {
+
+    if (inA == inB) { return true; }
+    if (Object(inA)->mType != Object(inB)->mType) { return false; }
+
+    switch (Object(inA)->mType) {
+        case kTypeID_String:
+            return ((CFStringRef)inA)->mString == ((CFStringRef)inB)->mString;
+        case kTypeID_Number: {
+            CFNumberRef a = (CFNumberRef)inA, b = (CFNumberRef)inB;
+            return a->mIsFloat || b->mIsFloat ? a->mFloat == b->mFloat : a->mInteger == b->mInteger;
+        }
+        case kTypeID_Data:
+            return ((CFDataRef)inA)->mBytes == ((CFDataRef)inB)->mBytes;
+        default:
+            return false;
+    }
+}
+
+CFHashCode CFHash(CFTypeRef inObject) {
+
+    if (Object(inObject)->mType == kTypeID_String) { return std::hash<std::string>()(((CFStringRef)inObject)->mString); }
+    return (CFHashCode)inObject;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CFString
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// CFSTR() is used in static initializers, so the table is made on first use.
+CFStringRef __CFStringMakeConstantString(const char *inString) {
+
+    static std::mutex *sMutex = new std::mutex;
+    static std::map<std::string, __CFString *> *sStrings = new std::map<std::string, __CFString *>;
+
+    std::lock_guard<std::mutex> lock(*sMutex);
+    __CFString *&string = (*sStrings)[inString];
+    if (string == NULL) {
+        string = new __CFString(inString);
+        string->mConstant = true;
+    }
+    return string;
+}
+
+CFTypeID CFStringGetTypeID(void) { return kTypeID_String; }
+
+CFStringRef CFStringCreateWithCString(CFAllocatorRef, const char *inString, CFStringEncoding) {
+
+    return inString != NULL ? new __CFString(inString) : NULL;
+}
+
+CFStringRef CFStringCreateCopy(CFAllocatorRef, CFStringRef inString) { return new __CFString(inString->mString); }
+
+/// In UTF-16 units, as CF counts: every code point below U+10000 is one, the rest two.
+CFIndex CFStringGetLength(CFStringRef inString) {
+
+    CFIndex length = 0;
+    for (unsigned char c : inString->mString) {
+        if ((c & 0xC0) != 0x80) { length += c >= 0xF0 ? 2 : 1; }
+    }
+    return length;
+}
+
+Boolean CFStringGetCString(CFStringRef inString, char *outBuffer, CFIndex inBufferSize, CFStringEncoding) {
+
+    if (inBufferSize <= (CFIndex)inString->mString.size()) { return false; }
+    memcpy(outBuffer, inString->mString.c_str(), inString->mString.size() + 1);
+    return true;
+}
+
+const char *CFStringGetCStringPtr(CFStringRef inString, CFStringEncoding) { return inString->mString.c_str(); }
+
+CFComparisonResult CFStringCompare(CFStringRef inA, CFStringRef inB, CFOptionFlags) {
+
+    int order = inA->mString.compare(inB->mString);
+    return order < 0 ? kCFCompareLessThan : order > 0 ? kCFCompareGreaterThan : kCFCompareEqualTo;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CFNumber
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+CFTypeID CFNumberGetTypeID(void) { return kTypeID_Number; }
+
+CFNumberRef CFNumberCreate(CFAllocatorRef, CFNumberType inType, const void *inValuePtr) {
+
+    switch (inType) {
+        case kCFNumberSInt8Type:
+        case kCFNumberCharType:     return new __CFNumber(false, *(const SInt8 *)inValuePtr, *(const SInt8 *)inValuePtr);
+        case kCFNumberSInt16Type:
+        case kCFNumberShortType:    return new __CFNumber(false, *(const SInt16 *)inValuePtr, *(const SInt16 *)inValuePtr);
+        case kCFNumberSInt32Type:
+        case kCFNumberIntType:      return new __CFNumber(false, *(const SInt32 *)inValuePtr, *(const SInt32 *)inValuePtr);
+        case kCFNumberSInt64Type:
+        case kCFNumberLongType:
+        case kCFNumberLongLongType:
+        case kCFNumberCFIndexType:  return new __CFNumber(false, *(const SInt64 *)inValuePtr, (double)*(const SInt64 *)inValuePtr);
+        case kCFNumberFloat32Type:
+        case kCFNumberFloatType:    return new __CFNumber(true, (int64_t)*(const Float32 *)inValuePtr, *(const Float32 *)inValuePtr);
+        case kCFNumberFloat64Type:
+        case kCFNumberDoubleType:   return new __CFNumber(true, (int64_t)*(const Float64 *)inValuePtr, *(const Float64 *)inValuePtr);
+        default:                    return NULL;
+    }
+}
+
+/// False when the value had to be truncated to fit the type asked for, as in CF.
+Boolean CFNumberGetValue(CFNumberRef inNumber, CFNumberType inType, void *outValuePtr) {
+
+    bool exact = !inNumber->mIsFloat || inNumber->mFloat == (double)inNumber->mInteger;
+
+    switch (inType) {
+        case kCFNumberSInt8Type:
+        case kCFNumberCharType:     *(SInt8 *)outValuePtr = (SInt8)inNumber->mInteger; return exact && inNumber->mInteger == (SInt8)inNumber->mInteger;
+        case kCFNumberSInt16Type:
+        case kCFNumberShortType:    *(SInt16 *)outValuePtr = (SInt16)inNumber->mInteger; return exact && inNumber->mInteger == (SInt16)inNumber->mInteger;
+        case kCFNumberSInt32Type:
+        case kCFNumberIntType:      *(SInt32 *)outValuePtr = (SInt32)inNumber->mInteger; return exact && inNumber->mInteger == (SInt32)inNumber->mInteger;
+        case kCFNumberSInt64Type:
+        case kCFNumberLongType:
+        case kCFNumberLongLongType:
+        case kCFNumberCFIndexType:  *(SInt64 *)outValuePtr = inNumber->mInteger; return exact;
+        case kCFNumberFloat32Type:
+        case kCFNumberFloatType:    *(Float32 *)outValuePtr = (Float32)inNumber->mFloat; return true;
+        case kCFNumberFloat64Type:
+        case kCFNumberDoubleType:   *(Float64 *)outValuePtr = inNumber->mFloat; return true;
+        default:                    return false;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CFData
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+CFTypeID CFDataGetTypeID(void) { return kTypeID_Data; }
+
+CFDataRef CFDataCreate(CFAllocatorRef, const UInt8 *inBytes, CFIndex inLength) {
+
+    __CFData *data = new __CFData;
+    data->mBytes.assign(inBytes, inBytes + inLength);
+    return data;
+}
+
+CFMutableDataRef CFDataCreateMutable(CFAllocatorRef, CFIndex inCapacity) {
+
+    __CFData *data = new __CFData;
+    data->mBytes.reserve(inCapacity);
+    return data;
+}
+
+void CFDataAppendBytes(CFMutableDataRef ioData, const UInt8 *inBytes, CFIndex inLength) {
+
+    ioData->mBytes.insert(ioData->mBytes.end(), inBytes, inBytes + inLength);
+}
+
+CFIndex CFDataGetLength(CFDataRef inData) { return (CFIndex)inData->mBytes.size(); }
+
+const UInt8 *CFDataGetBytePtr(CFDataRef inData) { return inData->mBytes.data(); }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CFArray, CFDictionary
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static const void *RetainCallBack(CFAllocatorRef, const void *inValue) { return CFRetain(inValue); }
+static void ReleaseCallBack(CFAllocatorRef, const void *inValue) { CFRelease(inValue); }
+static Boolean EqualCallBack(const void *inA, const void *inB) { return CFEqual(inA, inB); }
+static CFHashCode HashCallBack(const void *inValue) { return CFHash(inValue); }
+
+static const void *CopyStringCallBack(CFAllocatorRef, const void *inValue) {
+
+    return CFGetTypeID(inValue) == kTypeID_String ? CFStringCreateCopy(kCFAllocatorDefault, (CFStringRef)inValue) : CFRetain(inValue);
+}
+
+const CFArrayCallBacks kCFTypeArrayCallBacks = { 0, RetainCallBack, ReleaseCallBack, NULL, EqualCallBack };
+const CFDictionaryKeyCallBacks kCFTypeDictionaryKeyCallBacks = { 0, RetainCallBack, ReleaseCallBack, NULL, EqualCallBack, HashCallBack };
+const CFDictionaryKeyCallBacks kCFCopyStringDictionaryKeyCallBacks = { 0, CopyStringCallBack, ReleaseCallBack, NULL, EqualCallBack, HashCallBack };
+const CFDictionaryValueCallBacks kCFTypeDictionaryValueCallBacks = { 0, RetainCallBack, ReleaseCallBack, NULL, EqualCallBack };
+
+CFTypeID CFArrayGetTypeID(void) { return kTypeID_Array; }
+
+CFArrayRef CFArrayCreate(CFAllocatorRef, const void **inValues, CFIndex inCount, const CFArrayCallBacks *inCallBacks) {
+
+    __CFArray *array = new __CFArray(inCallBacks);
+    for (CFIndex i = 0; i < inCount; i++) { CFArrayAppendValue(array, inValues[i]); }
+    return array;
+}
+
+CFMutableArrayRef CFArrayCreateMutable(CFAllocatorRef, CFIndex inCapacity, const CFArrayCallBacks *inCallBacks) {
+
+    __CFArray *array = new __CFArray(inCallBacks);
+    array->mValues.reserve(inCapacity);
+    return array;
+}
+
+void CFArrayAppendValue(CFMutableArrayRef ioArray, const void *inValue) {
+
+    ioArray->mValues.push_back(ioArray->mCallBacks.retain != NULL ? ioArray->mCallBacks.retain(kCFAllocatorDefault, inValue) : inValue);
+}
+
+CFIndex CFArrayGetCount(CFArrayRef inArray) { return (CFIndex)inArray->mValues.size(); }
+
+const void *CFArrayGetValueAtIndex(CFArrayRef inArray, CFIndex inIndex) { return inArray->mValues[inIndex]; }
+
+CFTypeID CFDictionaryGetTypeID(void) { return kTypeID_Dictionary; }
+
+CFMutableDictionaryRef CFDictionaryCreateMutable(CFAllocatorRef, CFIndex inCapacity, const CFDictionaryKeyCallBacks *inKeyCallBacks,
+                                                 const CFDictionaryValueCallBacks *inValueCallBacks) {
+
+    __CFDictionary *dictionary = new __CFDictionary(inKeyCallBacks, inValueCallBacks);
+    dictionary->mKeys.reserve(inCapacity);
+    dictionary->mValues.reserve(inCapacity);
+    return dictionary;
+}
+
+void CFDictionarySetValue(CFMutableDictionaryRef ioDictionary, const void *inKey, const void *inValue) {
+
+    const CFDictionaryKeyCallBacks &keys = ioDictionary->mKeyCallBacks;
+    const CFDictionaryValueCallBacks &values = ioDictionary->mValueCallBacks;
+
+    const void *key = keys.retain != NULL ? keys.retain(kCFAllocatorDefault, inKey) : inKey;
+    const void *value = values.retain != NULL ? values.retain(kCFAllocatorDefault, inValue) : inValue;
+
+    CFIndex index = ioDictionary->Find(inKey);
+    if (index < 0) {
+        ioDictionary->mKeys.push_back(key);
+        ioDictionary->mValues.push_back(value);
+    } else {
+        ioDictionary->ReleaseEntry(index);
+        ioDictionary->mKeys[index] = key;
+        ioDictionary->mValues[index] = value;
+    }
+}
+
+void CFDictionaryRemoveValue(CFMutableDictionaryRef ioDictionary, const void *inKey) {
+
+    CFIndex index = ioDictionary->Find(inKey);
+    if (index < 0) { return; }
+
+    ioDictionary->ReleaseEntry(index);
+    ioDictionary->mKeys.erase(ioDictionary->mKeys.begin() + index);
+    ioDictionary->mValues.erase(ioDictionary->mValues.begin() + index);
+}
+
+const void *CFDictionaryGetValue(CFDictionaryRef inDictionary, const void *inKey) {
+
+    CFIndex index = inDictionary->Find(inKey);
+    return index < 0 ? NULL : inDictionary->mValues[index];
+}
+
+Boolean CFDictionaryGetValueIfPresent(CFDictionaryRef inDictionary, const void *inKey, const void **outValue) {
+
+    CFIndex index = inDictionary->Find(inKey);
+    if (index < 0) { return false; }
+    if (outValue != NULL) { *outValue = inDictionary->mValues[index]; }
+    return true;
+}
+
+Boolean CFDictionaryContainsKey(CFDictionaryRef inDictionary, const void *inKey) { return inDictionary->Find(inKey) >= 0; }
+
+CFIndex CFDictionaryGetCount(CFDictionaryRef inDictionary) { return (CFIndex)inDictionary->mKeys.size(); }
+
+void CFDictionaryGetKeysAndValues(CFDictionaryRef inDictionary, const void **outKeys, const void **outValues) {
+
+    for (size_t i = 0; i < inDictionary->mKeys.size(); i++) {
+        if (outKeys != NULL) { outKeys[i] = inDictionary->mKeys[i]; }
+        if (outValues != NULL) { outValues[i] = inDictionary->mValues[i]; }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AudioComponent
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Selectors up to kAudioUnitProcessMultipleSelect are looked up once, when the instance is
+/// made, so a call costs what it does through a host's cached fast dispatch.
+static constexpr SInt16 kCachedSelectors = kAudioUnitProcessMultipleSelect + 1;
+
+struct OpaqueAudioComponent {
+    AudioComponentDescription       mDescription;
+    CFStringRef                     mName;
+    UInt32                          mVersion;
+    AudioComponentFactoryFunction   mFactory;
+};
+
+struct ComponentInstanceRecord {
+    AudioComponent                  mComponent;
+    AudioComponentPlugInInterface   *mInterface;
+    AudioComponentMethod            mMethods[kCachedSelectors];
+};
+
+static std::vector<std::unique_ptr<OpaqueAudioComponent> > &Components() {
+
+    static std::vector<std::unique_ptr<OpaqueAudioComponent> > sComponents;
+    return sComponents;
+}
+
+/// Zero in the type, subtype or manufacturer matches anything, as in AudioComponentFindNext().
+static bool Matches(const AudioComponentDescription &inComponent, const AudioComponentDescription &inWanted) {
+
+    return (inWanted.componentType == 0 || inWanted.componentType == inComponent.componentType) &&
+           (inWanted.componentSubType == 0 || inWanted.componentSubType == inComponent.componentSubType) &&
+           (inWanted.componentManufacturer == 0 || inWanted.componentManufacturer == inComponent.componentManufacturer) &&
+           (inComponent.componentFlags & inWanted.componentFlagsMask) == (inWanted.componentFlags & inWanted.componentFlagsMask);
+}
+
+AudioComponent AudioComponentRegister(const AudioComponentDescription *inDesc, CFStringRef inName, UInt32 inVersion,
+                                      AudioComponentFactoryFunction inFactory) {
+
+    OpaqueAudioComponent *component = new OpaqueAudioComponent;
+    component->mDescription = *inDesc;
+    component->mName = inName != NULL ? (CFStringRef)CFRetain(inName) : NULL;
+    component->mVersion = inVersion;
+    component->mFactory = inFactory;
+
+    Components().emplace_back(component);
+    return component;
+}
+
+AudioComponent AudioComponentFindNext(AudioComponent inComponent, const AudioComponentDescription *inDesc) {
+
+    std::vector<std::unique_ptr<OpaqueAudioComponent> > &components = Components();
+    size_t i = 0;
+
+    if (inComponent != NULL) {
+        while (i < components.size() && components[i].get() != inComponent) { i++; }
+        i++;
+    }
+    for (; i < components.size(); i++) {
+        if (Matches(components[i]->mDescription, *inDesc)) { return components[i].get(); }
+    }
+    return NULL;
+}
+
+UInt32 AudioComponentCount(const AudioComponentDescription *inDesc) {
+
+    UInt32 count = 0;
+    for (const std::unique_ptr<OpaqueAudioComponent> &component : Components()) { count += Matches(component->mDescription, *inDesc); }
+    return count;
+}
+
+OSStatus AudioComponentCopyName(AudioComponent inComponent, CFStringRef *outName) {
+
+    if (inComponent == NULL || outName == NULL) { return kAudio_ParamError; }
+    *outName = inComponent->mName != NULL ? (CFStringRef)CFRetain(inComponent->mName) : NULL;
+    return noErr;
+}
+
+OSStatus AudioComponentGetDescription(AudioComponent inComponent, AudioComponentDescription *outDesc) {
+
+    if (inComponent == NULL || outDesc == NULL) { return kAudio_ParamError; }
+    *outDesc = inComponent->mDescription;
+    return noErr;
+}
+
+OSStatus AudioComponentGetVersion(AudioComponent inComponent, UInt32 *outVersion) {
+
+    if (inComponent == NULL || outVersion == NULL) { return kAudio_ParamError; }
+    *outVersion = inComponent->mVersion;
+    return noErr;
+}
+
+OSStatus AudioComponentInstanceNew(AudioComponent inComponent, AudioComponentInstance *outInstance) {
+
+    if (inComponent == NULL || outInstance == NULL) { return kAudio_ParamError; }
+
+    AudioComponentPlugInInterface *plugIn = inComponent->mFactory(&inComponent->mDescription);
+    if (plugIn == NULL) { return kAudio_MemFullError; }
+
+    ComponentInstanceRecord *instance = new ComponentInstanceRecord;
+    instance->mComponent = inComponent;
+    instance->mInterface = plugIn;
+    for (SInt16 selector = 0; selector < kCachedSelectors; selector++) { instance->mMethods[selector] = plugIn->Lookup(selector); }
+
+    // a failed Open() has already freed the plug-in instance
+    OSStatus result = plugIn->Open(plugIn, instance);
+    if (result != noErr) {
+        delete instance;
+        return result;
+    }
+
+    *outInstance = instance;
+    return noErr;
+}
+
+OSStatus AudioComponentInstanceDispose(AudioComponentInstance inInstance) {
+
+    if (inInstance == NULL) { return kAudio_ParamError; }
+
+    OSStatus result = inInstance->mInterface->Close(inInstance->mInterface);
+    delete inInstance;
+    return result;
+}
+
+AudioComponent AudioComponentInstanceGetComponent(AudioComponentInstance inInstance) {
+
+    return inInstance != NULL ? inInstance->mComponent : NULL;
+}
+
+Boolean AudioComponentInstanceCanDo(AudioComponentInstance inInstance, SInt16 inSelectorID) {
+
+    if (inInstance == NULL) { return false; }
+    if (inSelectorID >= 0 && inSelectorID < kCachedSelectors) { return inInstance->mMethods[inSelectorID] != NULL; }
+    return inInstance->mInterface->Lookup(inSelectorID) != NULL;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AudioUnit host calls
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// The method for inSelector as the proc type it was registered as, NULL if the unit has none.
+template <typename Proc>
+static Proc Method(AudioUnit inUnit, SInt16 inSelector) {
+
+    return inUnit != NULL ? (Proc)inUnit->mMethods[inSelector] : NULL;
+}
+
+#define CALL_METHOD(Proc, Selector, ...) \
+    Proc method = Method<Proc>(inUnit, Selector); \
+    return method != NULL ? method(inUnit->mInterface, __VA_ARGS__) : (OSStatus)kAudio_UnimplementedError
+
+OSStatus AudioUnitInitialize(AudioUnit inUnit) {
+
+    AudioUnitInitializeProc method = Method<AudioUnitInitializeProc>(inUnit, kAudioUnitInitializeSelect);
+    return method != NULL ? method(inUnit->mInterface) : (OSStatus)kAudio_UnimplementedError;
+}
+
+OSStatus AudioUnitUninitialize(AudioUnit inUnit) {
+
+    AudioUnitUninitializeProc method = Method<AudioUnitUninitializeProc>(inUnit, kAudioUnitUninitializeSelect);
+    return method != NULL ? method(inUnit->mInterface) : (OSStatus)kAudio_UnimplementedError;
+}
+
+OSStatus AudioUnitGetPropertyInfo(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+                                  UInt32 *outDataSize, Boolean *outWritable) {
+
+    CALL_METHOD(AudioUnitGetPropertyInfoProc, kAudioUnitGetPropertyInfoSelect, inID, inScope, inElement, outDataSize, outWritable);
+}
+
+OSStatus AudioUnitGetProperty(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+                              void *outData, UInt32 *ioDataSize) {
+
+    CALL_METHOD(AudioUnitGetPropertyProc, kAudioUnitGetPropertySelect, inID, inScope, inElement, outData, ioDataSize);
+}
+
+OSStatus AudioUnitSetProperty(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+                              const void *inData, UInt32 inDataSize) {
+
+    CALL_METHOD(AudioUnitSetPropertyProc, kAudioUnitSetPropertySelect, inID, inScope, inElement, inData, inDataSize);
+}
+
+OSStatus AudioUnitAddPropertyListener(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitPropertyListenerProc inProc,
+                                      void *inProcUserData) {
+
+    CALL_METHOD(AudioUnitAddPropertyListenerProc, kAudioUnitAddPropertyListenerSelect, inID, inProc, inProcUserData);
+}
+
+OSStatus AudioUnitRemovePropertyListenerWithUserData(AudioUnit inUnit, AudioUnitPropertyID inID, AudioUnitPropertyListenerProc inProc,
+                                                     void *inProcUserData) {
+
+    CALL_METHOD(AudioUnitRemovePropertyListenerWithUserDataProc, kAudioUnitRemovePropertyListenerWithUserDataSelect, inID, inProc,
+                inProcUserData);
+}
+
+OSStatus AudioUnitAddRenderNotify(AudioUnit inUnit, AURenderCallback inProc, void *inProcUserData) {
+
+    CALL_METHOD(AudioUnitAddRenderNotifyProc, kAudioUnitAddRenderNotifySelect, inProc, inProcUserData);
+}
+
+OSStatus AudioUnitRemoveRenderNotify(AudioUnit inUnit, AURenderCallback inProc, void *inProcUserData) {
+
+    CALL_METHOD(AudioUnitRemoveRenderNotifyProc, kAudioUnitRemoveRenderNotifySelect, inProc, inProcUserData);
+}
+
+OSStatus AudioUnitGetParameter(AudioUnit inUnit, AudioUnitParameterID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+                               AudioUnitParameterValue *outValue) {
+
+    CALL_METHOD(AudioUnitGetParameterProc, kAudioUnitGetParameterSelect, inID, inScope, inElement, outValue);
+}
+
+OSStatus AudioUnitSetParameter(AudioUnit inUnit, AudioUnitParameterID inID, AudioUnitScope inScope, AudioUnitElement inElement,
+                               AudioUnitParameterValue inValue, UInt32 inBufferOffsetInFrames) {
+
+    CALL_METHOD(AudioUnitSetParameterProc, kAudioUnitSetParameterSelect, inID, inScope, inElement, inValue, inBufferOffsetInFrames);
+}
+
+OSStatus AudioUnitScheduleParameters(AudioUnit inUnit, const AudioUnitParameterEvent *inParameterEvent, UInt32 inNumParamEvents) {
+
+    CALL_METHOD(AudioUnitScheduleParametersProc, kAudioUnitScheduleParametersSelect, inParameterEvent, inNumParamEvents);
+}
+
+OSStatus AudioUnitRender(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+                         UInt32 inOutputBusNumber, UInt32 inNumberFrames, AudioBufferList *ioData) {
+
+    CALL_METHOD(AudioUnitRenderProc, kAudioUnitRenderSelect, ioActionFlags, inTimeStamp, inOutputBusNumber, inNumberFrames, ioData);
+}
+
+OSStatus AudioUnitProcess(AudioUnit inUnit, AudioUnitRenderActionFlags *ioActionFlags, const AudioTimeStamp *inTimeStamp,
+                          UInt32 inNumberFrames, AudioBufferList *ioData) {
+
+    CALL_METHOD(AudioUnitProcessProc, kAudioUnitProcessSelect, ioActionFlags, inTimeStamp, inNumberFrames, ioData);
+}
+
+OSStatus AudioUnitReset(AudioUnit inUnit, AudioUnitScope inScope, AudioUnitElement inElement) {
+
+    CALL_METHOD(AudioUnitResetProc, kAudioUnitResetSelect, inScope, inElement);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Darwin
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// opaque2 is the lock; the critical section is two stores, and CAAtomicStack only uses the
+/// queue off the render thread.
+static void LockQueue(OSQueueHead *ioList) {
+
+    while (__atomic_exchange_n(&ioList->opaque2, 1L, __ATOMIC_ACQUIRE) != 0) { sched_yield(); }
+}
+
+static void UnlockQueue(OSQueueHead *ioList) { __atomic_store_n(&ioList->opaque2, 0L, __ATOMIC_RELEASE); }
+
+void OSAtomicEnqueue(OSQueueHead *ioList, void *inNew, size_t inOffset) {
+
+    LockQueue(ioList);
+    *(void **)((char *)inNew + inOffset) = ioList->opaque1;
+    ioList->opaque1 = inNew;
+    UnlockQueue(ioList);
+}
+
+void *OSAtomicDequeue(OSQueueHead *ioList, size_t inOffset) {
+
+    LockQueue(ioList);
+    void *element = ioList->opaque1;
+    if (element != NULL) { ioList->opaque1 = *(void **)((char *)element + inOffset); }
+    UnlockQueue(ioList);
+    return element;
+}
+
+int sysctl(int *, unsigned, void *, size_t *, void *, size_t) {
+
+    errno = ENOENT;
+    return -1;
+}
+
+/// The vector unit CAVectorUnit asks about is this CPU's.
+int sysctlbyname(const char *inName, void *outOld, size_t *ioOldLength, void *, size_t) {
+
+    int answer = -1;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (strcmp(inName, "hw.optional.avx1_0") == 0) { answer = __builtin_cpu_supports("avx") != 0; }
+    else if (strcmp(inName, "hw.optional.sse3") == 0) { answer = __builtin_cpu_supports("sse3") != 0; }
+    else if (strcmp(inName, "hw.optional.sse2") == 0) { answer = __builtin_cpu_supports("sse2") != 0; }
+#endif
+
+    if (answer < 0 || outOld == NULL || ioOldLength == NULL || *ioOldLength < sizeof(int)) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    *(int *)outOld = answer;
+    *ioOldLength = sizeof(int);
+    return 0;
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char *outDest, const char *inSource, size_t inSize) {
+
+    size_t length = strlen(inSource);
+    if (inSize > 0) {
+        size_t copied = length < inSize - 1 ? length : inSize - 1;
+        memcpy(outDest, inSource, copied);
+        outDest[copied] = '\0';
+    }
+    return length;
+}
+#endif
+
+void *reallocf(void *inPointer, size_t inSize) {
+
+    void *pointer = realloc(inPointer, inSize);
+    if (pointer == NULL && inSize != 0) { free(inPointer); }
+    return pointer;
+}
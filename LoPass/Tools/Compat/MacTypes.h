@@ -0,0 +1,50 @@
+//
+//  MacTypes.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp.
+//
+
+#ifndef MacTypes_h
+#define MacTypes_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t         UInt8;
+typedef int8_t          SInt8;
+typedef uint16_t        UInt16;
+typedef int16_t         SInt16;
+typedef uint32_t        UInt32;
+typedef int32_t         SInt32;
+typedef uint64_t        UInt64;
+typedef int64_t         SInt64;
+
+typedef float           Float32;
+typedef double          Float64;
+
+typedef unsigned char   Boolean;
+typedef UInt8           Byte;
+typedef SInt8           SignedByte;
+typedef char            *Ptr;
+typedef Ptr             *Handle;
+
+typedef SInt32          OSStatus;
+typedef SInt16          OSErr;
+typedef UInt32          OSType;
+typedef UInt32          FourCharCode;
+typedef unsigned long   ByteCount;
+typedef unsigned long   ItemCount;
+
+enum {
+    noErr               = 0,
+    paramErr            = -50,
+    memFullErr          = -108,
+    unimpErr            = -4,
+    fnfErr              = -43,
+    badComponentSelector = (OSStatus)0x80008002
+};
+
+#endif /* MacTypes_h */
@@ -0,0 +1,48 @@
+//
+//  TargetConditionals.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. The AU classes
+//  only know macOS, iOS and Windows, and what they want from macOS on these paths is
+//  pthreads, so the compat layer calls itself macOS and supplies the few Darwin calls
+//  that come with it.
+//
+
+#ifndef TargetConditionals_h
+#define TargetConditionals_h
+
+#define TARGET_OS_MAC               1
+#define TARGET_OS_OSX               1
+#define TARGET_OS_IPHONE            0
+#define TARGET_OS_IOS               0
+#define TARGET_OS_WIN32             0
+#define TARGET_OS_UNIX              0
+#define TARGET_OS_EMBEDDED          0
+#define TARGET_IPHONE_SIMULATOR     0
+#define TARGET_API_MAC_CARBON       0
+#define TARGET_API_MAC_OSX          1
+
+#if defined(__x86_64__)
+    #define TARGET_CPU_X86_64       1
+    #define TARGET_CPU_X86          0
+    #define TARGET_CPU_ARM64        0
+#elif defined(__aarch64__)
+    #define TARGET_CPU_X86_64       0
+    #define TARGET_CPU_X86          0
+    #define TARGET_CPU_ARM64        1
+#else
+    #error The compat layer knows x86_64 and arm64 only
+#endif
+
+#define TARGET_CPU_PPC              0
+#define TARGET_CPU_PPC64            0
+#define TARGET_CPU_ARM              0
+
+#define TARGET_RT_LITTLE_ENDIAN     1
+#define TARGET_RT_BIG_ENDIAN        0
+#define TARGET_RT_64_BIT            1
+#define TARGET_RT_MAC_MACHO         1
+
+#endif /* TargetConditionals_h */
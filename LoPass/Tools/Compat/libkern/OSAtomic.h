@@ -0,0 +1,97 @@
+//
+//  OSAtomic.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. The calls
+//  CAAtomic.h and CAAtomicStack.h make, on the compiler's atomic builtins; none of them
+//  enters the kernel, so they stay legal on the render thread.
+//
+
+#ifndef OSAtomic_h
+#define OSAtomic_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sched.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+static inline void OSMemoryBarrier(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+static inline int32_t OSAtomicAdd32(int32_t inAmount, volatile int32_t *ioValue) {
+    return __atomic_add_fetch(ioValue, inAmount, __ATOMIC_RELAXED);
+}
+static inline int32_t OSAtomicAdd32Barrier(int32_t inAmount, volatile int32_t *ioValue) {
+    return __atomic_add_fetch(ioValue, inAmount, __ATOMIC_SEQ_CST);
+}
+static inline int32_t OSAtomicIncrement32(volatile int32_t *ioValue) { return OSAtomicAdd32(1, ioValue); }
+static inline int32_t OSAtomicDecrement32(volatile int32_t *ioValue) { return OSAtomicAdd32(-1, ioValue); }
+static inline int32_t OSAtomicIncrement32Barrier(volatile int32_t *ioValue) { return OSAtomicAdd32Barrier(1, ioValue); }
+static inline int32_t OSAtomicDecrement32Barrier(volatile int32_t *ioValue) { return OSAtomicAdd32Barrier(-1, ioValue); }
+
+static inline int32_t OSAtomicOr32Barrier(uint32_t inMask, volatile uint32_t *ioValue) {
+    return (int32_t)__atomic_or_fetch(ioValue, inMask, __ATOMIC_SEQ_CST);
+}
+static inline int32_t OSAtomicAnd32Barrier(uint32_t inMask, volatile uint32_t *ioValue) {
+    return (int32_t)__atomic_and_fetch(ioValue, inMask, __ATOMIC_SEQ_CST);
+}
+
+static inline bool OSAtomicCompareAndSwap32Barrier(int32_t inOld, int32_t inNew, volatile int32_t *ioValue) {
+    return __atomic_compare_exchange_n(ioValue, &inOld, inNew, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static inline bool OSAtomicCompareAndSwap64Barrier(int64_t inOld, int64_t inNew, volatile int64_t *ioValue) {
+    return __atomic_compare_exchange_n(ioValue, &inOld, inNew, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static inline bool OSAtomicCompareAndSwapPtrBarrier(void *inOld, void *inNew, void *volatile *ioValue) {
+    return __atomic_compare_exchange_n(ioValue, &inOld, inNew, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/// Bit n counts from the most significant bit of the byte at address + n / 8, as on Darwin.
+static inline bool OSAtomicTestAndSetBarrier(uint32_t inBit, volatile void *ioAddress) {
+    volatile uint8_t *byte = (volatile uint8_t *)ioAddress + (inBit >> 3);
+    uint8_t mask = (uint8_t)(0x80 >> (inBit & 7));
+    return (__atomic_fetch_or(byte, mask, __ATOMIC_SEQ_CST) & mask) != 0;
+}
+static inline bool OSAtomicTestAndClearBarrier(uint32_t inBit, volatile void *ioAddress) {
+    volatile uint8_t *byte = (volatile uint8_t *)ioAddress + (inBit >> 3);
+    uint8_t mask = (uint8_t)(0x80 >> (inBit & 7));
+    return (__atomic_fetch_and(byte, (uint8_t)~mask, __ATOMIC_SEQ_CST) & mask) != 0;
+}
+static inline bool OSAtomicTestAndClear(uint32_t inBit, volatile void *ioAddress) {
+    return OSAtomicTestAndClearBarrier(inBit, ioAddress);
+}
+
+typedef int32_t OSSpinLock;
+#define OS_SPINLOCK_INIT 0
+
+static inline bool OSSpinLockTry(volatile OSSpinLock *ioLock) {
+    return __atomic_exchange_n(ioLock, 1, __ATOMIC_ACQUIRE) == 0;
+}
+static inline void OSSpinLockLock(volatile OSSpinLock *ioLock) {
+    while (!OSSpinLockTry(ioLock)) { sched_yield(); }
+}
+static inline void OSSpinLockUnlock(volatile OSSpinLock *ioLock) {
+    __atomic_store_n(ioLock, 0, __ATOMIC_RELEASE);
+}
+
+/// A LIFO of elements linked through the pointer at inOffset, see LoPassCompat.cpp.
+typedef struct {
+    void    *opaque1;
+    long    opaque2;
+} OSQueueHead;
+
+#define OS_ATOMIC_QUEUE_INIT { NULL, 0 }
+
+void OSAtomicEnqueue(OSQueueHead *ioList, void *inNew, size_t inOffset);
+void *OSAtomicDequeue(OSQueueHead *ioList, size_t inOffset);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* OSAtomic_h */
@@ -0,0 +1,45 @@
+//
+//  mach_time.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the SDK header of the same name, see LoPassCompat.cpp. Host time is
+//  CLOCK_MONOTONIC in nanoseconds, so the time base is 1/1.
+//
+
+#ifndef mach_time_h
+#define mach_time_h
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct mach_timebase_info {
+    uint32_t    numer;
+    uint32_t    denom;
+};
+typedef struct mach_timebase_info *mach_timebase_info_t;
+typedef struct mach_timebase_info mach_timebase_info_data_t;
+
+static inline int mach_timebase_info(mach_timebase_info_t outInfo) {
+    outInfo->numer = 1;
+    outInfo->denom = 1;
+    return 0;
+}
+
+/// clock_gettime() is answered from the vDSO, without a system call.
+static inline uint64_t mach_absolute_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* mach_time_h */
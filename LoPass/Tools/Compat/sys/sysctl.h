@@ -0,0 +1,30 @@
+//
+//  sysctl.h
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Linux stand-in for the Darwin header of the same name, see LoPassCompat.cpp. glibc no
+//  longer ships one. Only the "hw.optional." names CAVectorUnit asks for are answered.
+//
+
+#ifndef sysctl_h
+#define sysctl_h
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define CTL_HW          6
+#define HW_VECTORUNIT   13
+
+int sysctl(int *inName, unsigned inNameLength, void *outOld, size_t *ioOldLength, void *inNew, size_t inNewLength);
+int sysctlbyname(const char *inName, void *outOld, size_t *ioOldLength, void *inNew, size_t inNewLength);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* sysctl_h */
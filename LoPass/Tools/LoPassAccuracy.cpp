@@ -0,0 +1,234 @@
+//
+//  LoPassAccuracy.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Accuracy harness for LoPassFastMath.h and the filter design built on it.
+//
+//  c++ -O2 -std=c++11 -I../Source LoPassAccuracy.cpp ../Source/LoPassFilter.cpp -o lopass-accuracy
+//
+//  Every approximation is compared with long double libm over its documented domain, then
+//  the full design and magnitude response are swept over the whole cutoff / resonance
+//  range and compared with a long double reference. Exits non-zero if any error exceeds
+//  the bound LoPassFastMath.h documents for it, or a scalar and a vector result differ.
+//
+
+#include "LoPassFastMath.h"
+#include "LoPassFilter.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr double kMinFreq        = 1.25e-4;  // 3 Hz at 48 kHz
+static constexpr double kMaxFreq        = 0.99;
+static constexpr double kMinResonance   = -20.0;
+static constexpr double kMaxResonance   = 20.0;
+
+static constexpr unsigned kFreqSteps        = 400;
+static constexpr unsigned kResonanceSteps   = 161;
+static constexpr unsigned kResponsePoints   = 512;
+
+static const long double kPi = 3.141592653589793238462643383279502884L;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Reference design, the original libm formulation in long double
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct ReferenceCoefficients {
+    long double mA0, mA1, mA2, mB1, mB2;
+};
+
+static void ReferenceDesign(double inFreq, double inResonance, ReferenceCoefficients &out) {
+
+    long double r   = powl(10.0L, 0.05L * -inResonance);
+    long double k   = 0.5L * r * sinl(kPi * inFreq);
+    long double c1  = 0.5L * (1.0L - k) / (1.0L + k);
+    long double c2  = (0.5L + c1) * cosl(kPi * inFreq);
+    long double c3  = (0.5L + c1 - c2) * 0.25L;
+
+    out.mA0 = 2.0L * c3;
+    out.mA1 = 4.0L * c3;
+    out.mA2 = 2.0L * c3;
+    out.mB1 = -2.0L * c2;
+    out.mB2 = 2.0L * c1;
+}
+
+static long double ReferenceResponse(const ReferenceCoefficients &c, double inScaledFrequency) {
+
+    long double zr = cosl(kPi * inScaledFrequency);
+    long double zi = sinl(kPi * inScaledFrequency);
+
+    long double num_r = c.mA0 * (zr*zr - zi*zi) + c.mA1 * zr + c.mA2;
+    long double num_i = 2.0L * c.mA0 * zr * zi + c.mA1 * zi;
+    long double den_r = zr*zr - zi*zi + c.mB1 * zr + c.mB2;
+    long double den_i = 2.0L * zr * zi + c.mB1 * zi;
+
+    return sqrtl((num_r*num_r + num_i*num_i) / (den_r*den_r + den_i*den_i));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Function sweeps
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static double RandomIn(double inLow, double inHigh) {
+    return inLow + (inHigh - inLow) * (rand() / (double)RAND_MAX);
+}
+
+/// Prints a measured error against its documented bound and returns whether it holds.
+static bool Report(const char *inName, double inError, double inBound) {
+
+    bool holds = inError <= inBound;
+    printf("%-44s %.3g  (bound %.2g)%s\n", inName, inError, inBound, holds ? "" : "  EXCEEDED");
+    return holds;
+}
+
+/// Measures each approximation and checks the scalar and LoPassDouble2 paths agree bit for bit.
+static bool CheckFunctions() {
+
+    const unsigned count = 1000000;
+    double sinError = 0.0, cosError = 0.0, expError = 0.0, expWideError = 0.0, tanError = 0.0;
+    unsigned mismatches = 0;
+
+    for (unsigned i = 0; i < count; i++) {
+
+        // sincospi, absolute error, exact reduction of the reference by fmodl
+        double x[2] = { RandomIn(-1.0, 1.0), RandomIn(-1048576.0, 1048576.0) };
+        double s[2], c[2];
+        LoPassDouble2 vs, vc;
+        LoPassSinCosPi(LoPassDouble2::Load(x), vs, vc);
+        vs.Store(s);
+        vc.Store(c);
+
+        for (int j = 0; j < 2; j++) {
+            double ss, cc;
+            LoPassSinCosPi(x[j], ss, cc);
+            if (ss != s[j] || cc != c[j]) { mismatches++; }
+
+            long double reduced = fmodl(x[j], 2.0L);
+            sinError = fmax(sinError, (double)fabsl(ss - sinl(kPi * reduced)));
+            cosError = fmax(cosError, (double)fabsl(cc - cosl(kPi * reduced)));
+        }
+
+        // exp10, relative error, over the resonance range and a wider one
+        double e[2] = { RandomIn(-1.0, 1.0), RandomIn(-30.0, 30.0) };
+        double ve[2];
+        LoPassExp10(LoPassDouble2::Load(e)).Store(ve);
+
+        for (int j = 0; j < 2; j++) {
+            double r = LoPassExp10(e[j]);
+            if (r != ve[j]) { mismatches++; }
+
+            long double reference = powl(10.0L, e[j]);
+            double error = (double)fabsl((r - reference) / reference);
+            if (j == 0) { expError = fmax(expError, error); }
+            else        { expWideError = fmax(expWideError, error); }
+        }
+
+        // tan(pi x / 2), relative error
+        double t = RandomIn(-0.999, 0.999);
+        long double reference = tanl(kPi * t / 2.0L);
+        if (reference != 0.0L) {
+            tanError = fmax(tanError, (double)fabsl((LoPassTanHalfPi(t) - reference) / reference));
+        }
+    }
+
+    bool holds = true;
+    holds &= Report("LoPassSinCosPi   |x| <= 2^20    max abs  sin", sinError, kLoPassFastMath_MaxSinCosError);
+    holds &= Report("LoPassSinCosPi   |x| <= 2^20    max abs  cos", cosError, kLoPassFastMath_MaxSinCosError);
+    holds &= Report("LoPassExp10      |x| <= 1       max rel", expError, kLoPassFastMath_MaxExp10Error);
+    holds &= Report("LoPassExp10      |x| <= 30      max rel", expWideError, kLoPassFastMath_MaxExp10WideError);
+    holds &= Report("LoPassTanHalfPi  |x| <= 0.999   max rel", tanError, kLoPassFastMath_MaxTanHalfPiError);
+    printf("scalar / vector mismatches                   %u\n\n", mismatches);
+
+    return holds && mismatches == 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Response sweep
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The response is evaluated from 1e-5 to 0.999 of Nyquist, log spaced, plus each cutoff
+// itself where the resonant peak makes the response most sensitive.
+
+static double SweepResponse() {
+
+    double grid[kResponsePoints + 1];
+    double fast[kResponsePoints + 1];
+
+    double worstDB = 0.0, worstFreq = 0.0, worstResonance = 0.0, worstAt = 0.0;
+    double coefficientError = 0.0;
+
+    for (unsigned i = 0; i < kFreqSteps; i++) {
+
+        double freq = kMinFreq * pow(kMaxFreq / kMinFreq, i / (double)(kFreqSteps - 1));
+
+        for (unsigned j = 0; j < kResonanceSteps; j++) {
+
+            double resonance = kMinResonance + (kMaxResonance - kMinResonance) * j / (kResonanceSteps - 1);
+
+            LoPassCoefficients coefficients;
+            LoPassFilter::CalculateLopassParams(freq, resonance, coefficients);
+
+            ReferenceCoefficients reference;
+            ReferenceDesign(freq, resonance, reference);
+
+            const double designed[5]    = { coefficients.mA0, coefficients.mA1, coefficients.mA2, coefficients.mB1, coefficients.mB2 };
+            const long double exact[5]  = { reference.mA0, reference.mA1, reference.mA2, reference.mB1, reference.mB2 };
+            for (int n = 0; n < 5; n++) {
+                coefficientError = fmax(coefficientError, (double)fabsl((designed[n] - exact[n]) / exact[n]));
+            }
+
+            for (unsigned n = 0; n < kResponsePoints; n++) {
+                grid[n] = 1e-5 * pow(0.999 / 1e-5, n / (double)(kResponsePoints - 1));
+            }
+            grid[kResponsePoints] = freq;
+
+            LoPassFilter::GetFrequencyResponse(coefficients, grid, fast, kResponsePoints + 1);
+
+            for (unsigned n = 0; n <= kResponsePoints; n++) {
+                double scalar = LoPassFilter::GetFrequencyResponse(coefficients, grid[n]);
+                long double exactResponse = ReferenceResponse(reference, grid[n]);
+
+                double errorDB = fmax(fabs(20.0 * log10((double)(fast[n] / exactResponse))),
+                                      fabs(20.0 * log10((double)(scalar / exactResponse))));
+
+                if (!(errorDB <= worstDB)) {
+                    worstDB         = errorDB;
+                    worstFreq       = freq;
+                    worstResonance  = resonance;
+                    worstAt         = grid[n];
+                }
+            }
+        }
+    }
+
+    printf("design   %u cutoffs %g -> %g, %u resonances %g -> %g dB\n",
+           kFreqSteps, kMinFreq, kMaxFreq, kResonanceSteps, kMinResonance, kMaxResonance);
+    printf("         max coefficient rel error  %.3g\n", coefficientError);
+    printf("response max error  %.3g dB  (cutoff %g, resonance %g dB, at %g)\n",
+           worstDB, worstFreq, worstResonance, worstAt);
+
+    return worstDB;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main() {
+
+    bool functions = CheckFunctions();
+
+    double worstDB = SweepResponse();
+    bool response = worstDB <= kLoPassFastMath_MaxResponseErrorDB;
+
+    if (!functions || !response) {
+        printf("FAIL: %s the bounds documented in LoPassFastMath.h\n",
+               response ? "a function exceeds" : "the response exceeds");
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: within the bounds documented in LoPassFastMath.h, response within %g dB\n",
+           kLoPassFastMath_MaxResponseErrorDB);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,358 @@
+//
+//  LoPassAsyncIO.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassAsyncIO.hpp"
+#include <deque>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+static constexpr size_t kPoolAlignment = 4096;
+
+const char *LoPassIOBackendName(LoPassIOBackend inBackend) {
+    
+    switch (inBackend) {
+        case kLoPassIO_Map:     return "map";
+        case kLoPassIO_Sync:    return "sync";
+        case kLoPassIO_Uring:   return "uring";
+        default:                return "?";
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAsyncIO::LoPassAsyncIO()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassAsyncIO::LoPassAsyncIO(uint8_t *inPool, unsigned inBuffers, size_t inBufferBytes) :
+    mPool(inPool),
+    mBufferCount(inBuffers),
+    mBufferBytes(inBufferBytes),
+    mPending(0) {
+}
+
+LoPassAsyncIO::~LoPassAsyncIO() { free(mPool); }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSyncIO
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LoPassSyncIO : public LoPassAsyncIO {
+    
+public:
+    LoPassSyncIO(uint8_t *inPool, unsigned inBuffers, size_t inBufferBytes) :
+        LoPassAsyncIO(inPool, inBuffers, inBufferBytes) { }
+    
+    LoPassIOBackend GetBackend() const { return kLoPassIO_Sync; }
+    
+    bool SubmitRead(int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag) {
+        return Transfer(false, inFile, inBuffer, inOffset, inBytes, inTag);
+    }
+    
+    bool SubmitWrite(int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag) {
+        return Transfer(true, inFile, inBuffer, inOffset, inBytes, inTag);
+    }
+    
+    bool Wait(uint64_t &outTag, int &outResult) {
+        
+        if (mDone.empty()) { return false; }
+        
+        outTag      = mDone.front().mTag;
+        outResult   = mDone.front().mResult;
+        mDone.pop_front();
+        mPending--;
+        return true;
+    }
+    
+private:
+    struct Completion {
+        uint64_t    mTag;
+        int         mResult;
+    };
+    
+    bool Transfer(bool inWrite, int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag) {
+        
+        uint8_t *buffer = GetBuffer(inBuffer);
+        unsigned done   = 0;
+        int result      = 0;
+        
+        while (done < inBytes) {
+            
+            ssize_t n = inWrite ? pwrite(inFile, buffer + done, inBytes - done, (off_t)(inOffset + done))
+                                : pread(inFile, buffer + done, inBytes - done, (off_t)(inOffset + done));
+            
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n < 0) { result = -errno; break; }
+            if (n == 0) { break; }
+            
+            done += (unsigned)n;
+        }
+        
+        Completion completion = { inTag, result < 0 ? result : (int)done };
+        mDone.push_back(completion);
+        mPending++;
+        return true;
+    }
+    
+    std::deque<Completion> mDone;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassUringIO
+//
+// The submission and completion rings are shared with the kernel; their head and tail
+// indices are read with acquire and written with release ordering, as the io_uring ABI
+// requires, and everything else about them is private to this thread.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static int SetupRing(unsigned inEntries, struct io_uring_params *ioParams) {
+    return (int)syscall(__NR_io_uring_setup, inEntries, ioParams);
+}
+
+static int EnterRing(int inRing, unsigned inSubmit, unsigned inComplete, unsigned inFlags) {
+    return (int)syscall(__NR_io_uring_enter, inRing, inSubmit, inComplete, inFlags, NULL, 0);
+}
+
+static int RegisterRing(int inRing, unsigned inOpcode, const void *inArgument, unsigned inCount) {
+    return (int)syscall(__NR_io_uring_register, inRing, inOpcode, inArgument, inCount);
+}
+
+class LoPassUringIO : public LoPassAsyncIO {
+    
+public:
+    LoPassUringIO(uint8_t *inPool, unsigned inBuffers, size_t inBufferBytes) :
+        LoPassAsyncIO(inPool, inBuffers, inBufferBytes),
+        mRing(-1),
+        mSQMap(MAP_FAILED),
+        mSQMapSize(0),
+        mCQMap(MAP_FAILED),
+        mCQMapSize(0),
+        mSQEs((struct io_uring_sqe *)MAP_FAILED),
+        mSQEsSize(0),
+        mFixed(false),
+        mQueued(0) {
+    }
+    
+    ~LoPassUringIO() {
+        
+        if (mSQEs != MAP_FAILED) { munmap(mSQEs, mSQEsSize); }
+        if (mCQMap != MAP_FAILED && mCQMap != mSQMap) { munmap(mCQMap, mCQMapSize); }
+        if (mSQMap != MAP_FAILED) { munmap(mSQMap, mSQMapSize); }
+        if (mRing >= 0) { close(mRing); }
+    }
+    
+    bool Setup();
+    
+    LoPassIOBackend GetBackend() const { return kLoPassIO_Uring; }
+    
+    bool SubmitRead(int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag) {
+        return Queue(mFixed ? IORING_OP_READ_FIXED : IORING_OP_READ, inFile, inBuffer, inOffset, inBytes, inTag);
+    }
+    
+    bool SubmitWrite(int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag) {
+        return Queue(mFixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, inFile, inBuffer, inOffset, inBytes, inTag);
+    }
+    
+    void Flush() { Enter(0); }
+    
+    bool Wait(uint64_t &outTag, int &outResult);
+    
+private:
+    bool Queue(uint8_t inOpcode, int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag);
+    void Enter(unsigned inComplete);
+    
+    int                     mRing;
+    
+    void                    *mSQMap;
+    size_t                  mSQMapSize;
+    unsigned                *mSQHead;
+    unsigned                *mSQTail;
+    unsigned                mSQMask;
+    unsigned                mSQEntries;
+    unsigned                *mSQArray;
+    
+    void                    *mCQMap;
+    size_t                  mCQMapSize;
+    unsigned                *mCQHead;
+    unsigned                *mCQTail;
+    unsigned                mCQMask;
+    struct io_uring_cqe     *mCQEs;
+    
+    struct io_uring_sqe     *mSQEs;
+    size_t                  mSQEsSize;
+    
+    bool                    mFixed;         // the pool is registered
+    unsigned                mQueued;        // in the ring, not yet handed to the kernel
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassUringIO::Setup()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassUringIO::Setup() {
+    
+    // every buffer can be in flight at once
+    unsigned entries = 1;
+    while (entries < mBufferCount) { entries <<= 1; }
+    
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    
+    mRing = SetupRing(entries, &params);
+    if (mRing < 0) { return false; }
+    
+    mSQMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    mCQMapSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    
+    // newer kernels map both rings with one call
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) { mSQMapSize = mCQMapSize = mSQMapSize > mCQMapSize ? mSQMapSize : mCQMapSize; }
+    
+    mSQMap = mmap(NULL, mSQMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+    if (mSQMap == MAP_FAILED) { return false; }
+    
+    mCQMap = single ? mSQMap : mmap(NULL, mCQMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_CQ_RING);
+    if (mCQMap == MAP_FAILED) { return false; }
+    
+    mSQEsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    mSQEs = (struct io_uring_sqe *)mmap(NULL, mSQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+    if (mSQEs == MAP_FAILED) { return false; }
+    
+    uint8_t *sq = (uint8_t *)mSQMap;
+    mSQHead     = (unsigned *)(sq + params.sq_off.head);
+    mSQTail     = (unsigned *)(sq + params.sq_off.tail);
+    mSQMask     = *(unsigned *)(sq + params.sq_off.ring_mask);
+    mSQEntries  = params.sq_entries;
+    mSQArray    = (unsigned *)(sq + params.sq_off.array);
+    
+    uint8_t *cq = (uint8_t *)mCQMap;
+    mCQHead     = (unsigned *)(cq + params.cq_off.head);
+    mCQTail     = (unsigned *)(cq + params.cq_off.tail);
+    mCQMask     = *(unsigned *)(cq + params.cq_off.ring_mask);
+    mCQEs       = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    
+    // Registering pins the pool; if the memlock limit says no, plain reads and writes
+    // on the same buffers still work, they just cost a page walk each.
+    std::vector<struct iovec> buffers(mBufferCount);
+    
+    for (unsigned i = 0; i < mBufferCount; i++) {
+        buffers[i].iov_base = GetBuffer(i);
+        buffers[i].iov_len  = mBufferBytes;
+    }
+    
+    mFixed = RegisterRing(mRing, IORING_REGISTER_BUFFERS, &buffers[0], mBufferCount) == 0;
+    
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassUringIO::Queue()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassUringIO::Queue(uint8_t   inOpcode,
+                          int       inFile,
+                          unsigned  inBuffer,
+                          uint64_t  inOffset,
+                          unsigned  inBytes,
+                          uint64_t  inTag) {
+    
+    unsigned tail = *mSQTail;
+    
+    // full of requests the kernel hasn't picked up yet
+    if (tail - __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE) >= mSQEntries) {
+        Enter(0);
+        if (tail - __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE) >= mSQEntries) { return false; }
+    }
+    
+    unsigned index = tail & mSQMask;
+    struct io_uring_sqe *sqe = &mSQEs[index];
+    
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode     = inOpcode;
+    sqe->fd         = inFile;
+    sqe->off        = inOffset;
+    sqe->addr       = (uint64_t)(uintptr_t)GetBuffer(inBuffer);
+    sqe->len        = inBytes;
+    sqe->buf_index  = (uint16_t)inBuffer;
+    sqe->user_data  = inTag;
+    
+    mSQArray[index] = index;
+    __atomic_store_n(mSQTail, tail + 1, __ATOMIC_RELEASE);
+    
+    mQueued++;
+    mPending++;
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassUringIO::Enter()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassUringIO::Enter(unsigned inComplete) {
+    
+    if (mQueued == 0 && inComplete == 0) { return; }
+    
+    unsigned flags = inComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int submitted = EnterRing(mRing, mQueued, inComplete, flags);
+    
+    // EINTR and EAGAIN / EBUSY (completion queue backed up) are retried by the caller
+    if (submitted > 0) { mQueued -= (unsigned)submitted < mQueued ? (unsigned)submitted : mQueued; }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassUringIO::Wait()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassUringIO::Wait(uint64_t &outTag, int &outResult) {
+    
+    if (mPending == 0) { return false; }
+    
+    for (;;) {
+        
+        unsigned head = *mCQHead;
+        
+        if (head != __atomic_load_n(mCQTail, __ATOMIC_ACQUIRE)) {
+            
+            const struct io_uring_cqe &cqe = mCQEs[head & mCQMask];
+            outTag      = cqe.user_data;
+            outResult   = cqe.res;
+            
+            __atomic_store_n(mCQHead, head + 1, __ATOMIC_RELEASE);
+            mPending--;
+            return true;
+        }
+        
+        Enter(1);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassAsyncIO::Create()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassAsyncIO *LoPassAsyncIO::Create(LoPassIOBackend inBackend, unsigned inBuffers, size_t inBufferBytes) {
+    
+    void *pool = NULL;
+    if (posix_memalign(&pool, kPoolAlignment, inBuffers * inBufferBytes) != 0) { return NULL; }
+    
+    if (inBackend == kLoPassIO_Uring) {
+        
+        LoPassUringIO *uring = new LoPassUringIO((uint8_t *)pool, inBuffers, inBufferBytes);
+        if (uring->Setup()) { return uring; }
+        
+        // the pool belongs to the engine, so take it back before falling back
+        uring->mPool = NULL;
+        delete uring;
+    }
+    
+    return new LoPassSyncIO((uint8_t *)pool, inBuffers, inBufferBytes);
+}
@@ -0,0 +1,77 @@
+//
+//  LoPassAsyncIO.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Queued file I/O on a fixed pool of buffers for the offline renderer (Linux).
+//
+
+#ifndef LoPassAsyncIO_hpp
+#define LoPassAsyncIO_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Async IO
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Reads and writes are queued against buffers from a pool the engine owns, and each one
+// comes back through Wait() with the tag it was queued with, in any order.
+//
+//  kLoPassIO_Uring     io_uring, with the pool registered once so the kernel doesn't map
+//                      the pages on every request. Submit() only fills the ring; Flush()
+//                      hands everything queued to the kernel in one system call, so the
+//                      caller can get on with filtering while the I/O runs.
+//  kLoPassIO_Sync      pread / pwrite, done straight away inside Submit(). The fallback
+//                      where io_uring isn't available, and the baseline to compare with.
+//
+// The raw system calls are used, so there is no dependency on liburing.
+
+enum LoPassIOBackend {
+    kLoPassIO_Map       = 0,    // not an engine: the mapped reader and stdio writer
+    kLoPassIO_Sync      = 1,
+    kLoPassIO_Uring     = 2
+};
+
+const char *LoPassIOBackendName(LoPassIOBackend inBackend);
+
+class LoPassAsyncIO {
+    
+public:
+    /// A kLoPassIO_Uring request falls back to kLoPassIO_Sync if the kernel refuses it;
+    /// GetBackend() tells which one was made. Returns NULL only if the pool can't be allocated.
+    static LoPassAsyncIO *Create(LoPassIOBackend inBackend, unsigned inBuffers, size_t inBufferBytes);
+    
+    virtual ~LoPassAsyncIO();
+    
+    virtual LoPassIOBackend GetBackend() const = 0;
+    
+    unsigned GetBufferCount() const { return mBufferCount; }
+    size_t GetBufferBytes() const { return mBufferBytes; }
+    uint8_t *GetBuffer(unsigned inBuffer) const { return mPool + inBuffer * mBufferBytes; }
+    
+    /// Requests queued or in flight, not yet returned by Wait().
+    unsigned GetPending() const { return mPending; }
+    
+    /// Queue a transfer between the start of a pool buffer and the file.
+    virtual bool SubmitRead(int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag) = 0;
+    virtual bool SubmitWrite(int inFile, unsigned inBuffer, uint64_t inOffset, unsigned inBytes, uint64_t inTag) = 0;
+    
+    /// Start whatever has been queued.
+    virtual void Flush() { }
+    
+    /// Blocks for the next finished request. outResult is the byte count, or -errno.
+    /// Returns false if nothing is pending.
+    virtual bool Wait(uint64_t &outTag, int &outResult) = 0;
+    
+protected:
+    LoPassAsyncIO(uint8_t *inPool, unsigned inBuffers, size_t inBufferBytes);
+    
+    uint8_t     *mPool;
+    unsigned    mBufferCount;
+    size_t      mBufferBytes;
+    unsigned    mPending;
+};
+
+#endif /* LoPassAsyncIO_hpp */
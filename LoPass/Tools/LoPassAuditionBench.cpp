@@ -0,0 +1,280 @@
+//
+//  LoPassAuditionBench.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Check and benchmark for LoPassAudition, one input through many settings in one pass.
+//
+//  make lopass-audition
+//
+//  First a stereo clip goes through the factory presets and random variations on them, at
+//  a few block sizes and with settings changed along the way, and every output must match a
+//  LoPassBiquad of its setting to the bit. Then a mono clip is timed through 1 to 32 settings:
+//  rendered once per setting with a LoPassBiquad, through a LoPassFilterBank fed a separate
+//  copy of the input per setting, and through LoPassAudition, which reads the one input. The
+//  last column is what the audition costs in plain renders of one setting.
+//
+//  lopass-audition [settings] [seconds]
+//
+
+#include "LoPassAudition.hpp"
+#include "LoPassParameters.h"
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static constexpr double kSampleRate             = 48000.0;
+static constexpr unsigned kDefaultSettings      = 16;
+static constexpr double kDefaultSeconds         = 10.0;
+static constexpr unsigned kMaxSettings          = 256;
+static constexpr unsigned kCheckChannels        = 2;
+static constexpr unsigned kCheckFrames          = 48000;
+static constexpr unsigned kTimingBlockSize      = 1024;
+static constexpr unsigned kTimingRuns           = 3;
+
+static const unsigned kBlockSizes[]     = { 64, 441, 512, 4096 };
+static const unsigned kSettingCounts[]  = { 1, 2, 4, 8, 16, 32 };
+
+static uint32_t Random(uint32_t &ioSeed) {
+
+    ioSeed = ioSeed * 1664525u + 1013904223u;
+    return ioSeed >> 8;
+}
+
+static void FillNoise(std::vector<float> &outSamples, uint32_t inSeed) {
+
+    uint32_t noise = inSeed;
+    for (size_t i = 0; i < outSamples.size(); i++) {
+        outSamples[i] = (float)((int32_t)(noise = noise * 1664525u + 1013904223u) * (0.5 / 2147483648.0));
+    }
+}
+
+static double GetSeconds() {
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Setting {
+    double  mCutoff;
+    double  mResonance;
+};
+
+/// The presets first, then each preset again with its cutoff moved up to an octave either
+/// way and its resonance up to 6 dB, as a sound designer would try.
+static std::vector<Setting> MakeSettings(unsigned inCount, uint32_t inSeed) {
+
+    std::vector<Setting> settings;
+    uint32_t seed = inSeed;
+
+    for (unsigned n = 0; n < inCount; n++) {
+
+        const LoPassPresetValues &preset = kPresetValues[n % kNumberOfPresets];
+        Setting setting = { preset.mFrequency, preset.mResonance };
+
+        if (n >= kNumberOfPresets) {
+            setting.mCutoff    *= pow(2.0, (Random(seed) % 2001) / 1000.0 - 1.0);
+            setting.mResonance += (Random(seed) % 1201) / 100.0 - 6.0;
+        }
+
+        settings.push_back(setting);
+    }
+
+    return settings;
+}
+
+/// What LoPassAudition is checked against: the setting run on its own, as LoPassProcessor
+/// runs a settled filter.
+struct Reference {
+    LoPassBiquad        mBiquad;
+    LoPassCoefficients  mCoefficients;
+
+    void SetSetting(const Setting &inSetting) {
+        double freq, resonance;
+        LoPassNormaliseParameters(inSetting.mCutoff, inSetting.mResonance, kSampleRate, freq, resonance);
+        LoPassFilter::CalculateLopassParams(freq, resonance, mCoefficients);
+    }
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Check
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Returns false on any mismatch.
+static bool Check(unsigned inSettings) {
+
+    static constexpr unsigned kChannels = kCheckChannels;
+
+    std::vector<Setting> settings = MakeSettings(inSettings, 1);
+    LoPassAudition audition(kSampleRate, kChannels);
+    std::vector<Reference> references(inSettings * kChannels);
+
+    for (unsigned s = 0; s < inSettings; s++) {
+        audition.AddSetting(settings[s].mCutoff, settings[s].mResonance);
+        for (unsigned c = 0; c < kChannels; c++) { references[s * kChannels + c].SetSetting(settings[s]); }
+    }
+
+    std::vector<std::vector<float> > input(kChannels, std::vector<float>(kCheckFrames));
+    std::vector<std::vector<float> > output(inSettings * kChannels, std::vector<float>(kCheckFrames));
+    std::vector<std::vector<float> > expected(output.size(), std::vector<float>(kCheckFrames));
+
+    for (unsigned c = 0; c < kChannels; c++) { FillNoise(input[c], 10 + c); }
+
+    std::vector<const float *> inputP(kChannels);
+    std::vector<float *> outputP(output.size());
+
+    uint32_t seed = 3;
+    unsigned position = 0, blocks = 0;
+
+    while (position < kCheckFrames) {
+
+        unsigned frames = kBlockSizes[Random(seed) % (sizeof(kBlockSizes) / sizeof(kBlockSizes[0]))];
+        if (frames > kCheckFrames - position) { frames = kCheckFrames - position; }
+
+        // now and then retune a setting, as when a variation is edited while listening
+        if (blocks % 8 == 7) {
+            unsigned s = Random(seed) % inSettings;
+            settings[s] = MakeSettings(kNumberOfPresets + 1, Random(seed)).back();
+            audition.SetSetting(s, settings[s].mCutoff, settings[s].mResonance);
+            for (unsigned c = 0; c < kChannels; c++) { references[s * kChannels + c].SetSetting(settings[s]); }
+        }
+
+        for (unsigned c = 0; c < kChannels; c++) { inputP[c] = &input[c][position]; }
+        for (size_t n = 0; n < output.size(); n++) { outputP[n] = &output[n][position]; }
+
+        audition.Process(&inputP[0], &outputP[0], frames);
+
+        for (size_t n = 0; n < references.size(); n++) {
+            Reference &reference = references[n];
+            reference.mBiquad.Process(reference.mCoefficients, &input[n % kChannels][position], &expected[n][position], frames);
+        }
+
+        position += frames;
+        blocks++;
+    }
+
+    unsigned mismatches = 0;
+
+    for (size_t n = 0; n < output.size(); n++) {
+        if (memcmp(&output[n][0], &expected[n][0], kCheckFrames * sizeof(float)) != 0) { mismatches++; }
+    }
+
+    printf("check: %u settings x %u channels, %u frames in %u blocks: %s\n",
+           inSettings, kChannels, kCheckFrames, blocks, mismatches == 0 ? "bit identical" : "MISMATCH");
+    if (mismatches != 0) { printf("  %u outputs differ\n", mismatches); }
+
+    return mismatches == 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Timing
+//
+// Each way is run kTimingRuns times over the whole clip in kTimingBlockSize blocks, and the
+// best run counts.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Timing {
+    double  mSequential;
+    double  mBank;
+    double  mAudition;
+};
+
+static Timing Time(unsigned inSettings, const std::vector<float> &inInput) {
+
+    const unsigned frames = (unsigned)inInput.size();
+    std::vector<Setting> settings = MakeSettings(inSettings, 2);
+
+    std::vector<Reference> references(inSettings);
+    LoPassFilterBank bank(kSampleRate);
+    LoPassAudition audition(kSampleRate, 1);
+
+    for (unsigned s = 0; s < inSettings; s++) {
+        references[s].SetSetting(settings[s]);
+        bank.AddStream(settings[s].mCutoff, settings[s].mResonance);
+        audition.AddSetting(settings[s].mCutoff, settings[s].mResonance);
+    }
+
+    // a copy of the input per setting for the bank, so it can't take the broadcast path
+    std::vector<std::vector<float> > copies(inSettings, inInput);
+    std::vector<std::vector<float> > output(inSettings, std::vector<float>(frames));
+    std::vector<float *> outputP(inSettings);
+
+    Timing timing = { 1e9, 1e9, 1e9 };
+
+    for (unsigned run = 0; run < kTimingRuns; run++) {
+
+        double start = GetSeconds();
+        for (unsigned s = 0; s < inSettings; s++) {
+            for (unsigned i = 0; i < frames; i += kTimingBlockSize) {
+                unsigned block = frames - i < kTimingBlockSize ? frames - i : kTimingBlockSize;
+                references[s].mBiquad.Process(references[s].mCoefficients, &inInput[i], &output[s][i], block);
+            }
+        }
+        double seconds = GetSeconds() - start;
+        timing.mSequential = seconds < timing.mSequential ? seconds : timing.mSequential;
+
+        start = GetSeconds();
+        for (unsigned i = 0; i < frames; i += kTimingBlockSize) {
+            unsigned block = frames - i < kTimingBlockSize ? frames - i : kTimingBlockSize;
+            for (unsigned s = 0; s < inSettings; s++) { bank.Submit(s, &copies[s][i], &output[s][i], block); }
+            bank.Run();
+        }
+        seconds = GetSeconds() - start;
+        timing.mBank = seconds < timing.mBank ? seconds : timing.mBank;
+
+        start = GetSeconds();
+        for (unsigned i = 0; i < frames; i += kTimingBlockSize) {
+            unsigned block = frames - i < kTimingBlockSize ? frames - i : kTimingBlockSize;
+            const float *inputP = &inInput[i];
+            for (unsigned s = 0; s < inSettings; s++) { outputP[s] = &output[s][i]; }
+            audition.Process(&inputP, &outputP[0], block);
+        }
+        seconds = GetSeconds() - start;
+        timing.mAudition = seconds < timing.mAudition ? seconds : timing.mAudition;
+    }
+
+    return timing;
+}
+
+static void TimeAll(unsigned inSettings, double inSeconds) {
+
+    std::vector<float> input((size_t)(inSeconds * kSampleRate));
+    FillNoise(input, 7);
+
+    double single = Time(1, input).mSequential;
+
+    printf("\ntiming: %.1f s mono clip, %u frame blocks, %s\n", inSeconds, kTimingBlockSize, LoPassFilterBank::GetInstructionSet());
+    printf("%-9s %14s %14s %14s %12s\n", "settings", "sequential ms", "bank ms", "audition ms", "in renders");
+
+    for (size_t n = 0; n < sizeof(kSettingCounts) / sizeof(kSettingCounts[0]); n++) {
+        if (kSettingCounts[n] > inSettings) { break; }
+
+        Timing timing = Time(kSettingCounts[n], input);
+        printf("%-9u %14.2f %14.2f %14.2f %12.2f\n", kSettingCounts[n],
+               1e3 * timing.mSequential, 1e3 * timing.mBank, 1e3 * timing.mAudition, timing.mAudition / single);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, const char *argv[]) {
+
+    unsigned settings   = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : kDefaultSettings;
+    double seconds      = argc > 2 ? strtod(argv[2], NULL) : kDefaultSeconds;
+
+    if (settings == 0 || settings > kMaxSettings || !(seconds > 0.0)) {
+        fprintf(stderr, "usage: lopass-audition [settings, up to %u] [seconds]\n", kMaxSettings);
+        return 2;
+    }
+
+    bool ok = Check(settings);
+    TimeAll(settings < kSettingCounts[5] ? kSettingCounts[5] : settings, seconds);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+//
+//  LoPassBankBench.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Check and benchmark for LoPassFilterBank against one LoPassBiquad per stream.
+//
+//  make lopass-bank
+//
+//  First a few hundred streams of noise, each with its own cutoff, resonance and block size,
+//  go through the bank and through a LoPassBiquad each, while streams are retuned, change
+//  block size, and are removed and added, so they keep moving between groups. Every output
+//  sample must match to the bit. Then all the streams run at one block size and both are
+//  timed: ns per sample through a LoPassBiquad, and ns per stream sample through the bank.
+//
+//  lopass-bank [streams] [block size]
+//
+
+#include "LoPassFilterBank.hpp"
+#include "LoPassParameters.h"
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static constexpr double kSampleRate         = 48000.0;
+static constexpr unsigned kDefaultStreams   = 256;
+static constexpr unsigned kDefaultBlockSize = 128;
+static constexpr unsigned kMaxBlockSize     = 4096;
+static constexpr unsigned kCheckRuns        = 400;
+static constexpr unsigned kTimingFrames     = 48000;    // per stream, per timing run
+static constexpr unsigned kTimingRuns       = 3;
+
+static const unsigned kBlockSizes[] = { 16, 32, 64, 128, 256, 441, 512 };
+
+static uint32_t Random(uint32_t &ioSeed) {
+
+    ioSeed = ioSeed * 1664525u + 1013904223u;
+    return ioSeed >> 8;
+}
+
+/// Log spaced over the audio range.
+static double RandomCutoff(uint32_t &ioSeed) {
+
+    return 20.0 * pow(1000.0, (Random(ioSeed) % 10000) / 10000.0);
+}
+
+static double RandomResonance(uint32_t &ioSeed) {
+
+    return kMinimumValue_LoPass_Resonance + (Random(ioSeed) % 1000) * (kMaximumValue_LoPass_Resonance - kMinimumValue_LoPass_Resonance) / 1000.0;
+}
+
+/// What the bank is checked against: a LoPassBiquad as LoPassProcessor would run it.
+struct Reference {
+    LoPassBiquad        mBiquad;
+    LoPassCoefficients  mCoefficients;
+    unsigned            mBlockSize;
+    uint32_t            mNoise;
+
+    void SetParameters(double inCutoff, double inResonance) {
+        double freq, resonance;
+        LoPassNormaliseParameters(inCutoff, inResonance, kSampleRate, freq, resonance);
+        LoPassFilter::CalculateLopassParams(freq, resonance, mCoefficients);
+    }
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Check
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void AddStream(LoPassFilterBank &ioBank, std::vector<Reference> &ioReferences, uint32_t &ioSeed) {
+
+    double cutoff       = RandomCutoff(ioSeed);
+    double resonance    = RandomResonance(ioSeed);
+    unsigned id         = ioBank.AddStream(cutoff, resonance);
+
+    if (id >= ioReferences.size()) { ioReferences.resize(id + 1); }
+
+    Reference &reference = ioReferences[id];
+    reference.mBiquad       = LoPassBiquad();
+    reference.mBlockSize    = kBlockSizes[Random(ioSeed) % (sizeof(kBlockSizes) / sizeof(kBlockSizes[0]))];
+    reference.mNoise        = Random(ioSeed);
+    reference.SetParameters(cutoff, resonance);
+}
+
+/// Returns false on any mismatch.
+static bool Check(unsigned inStreams) {
+
+    LoPassFilterBank bank(kSampleRate);
+    std::vector<Reference> references;
+    uint32_t seed = 1;
+
+    for (unsigned s = 0; s < inStreams; s++) { AddStream(bank, references, seed); }
+
+    std::vector<float> source(inStreams * kMaxBlockSize), dest(inStreams * kMaxBlockSize), expected(inStreams * kMaxBlockSize);
+    std::vector<float *> output(inStreams);
+    std::vector<unsigned> frames(inStreams);
+
+    const unsigned numberOfBlockSizes = sizeof(kBlockSizes) / sizeof(kBlockSizes[0]);
+    unsigned long samples = 0;
+    unsigned mismatches = 0;
+    unsigned mostGroups = 0;
+
+    for (unsigned run = 0; run < kCheckRuns; run++) {
+
+        // every now and then retune some streams, move some to another block size, and
+        // replace one; the rest carry on as they were
+        if (run % 20 == 19) {
+
+            for (unsigned n = 0; n < inStreams / 4; n++) {
+                unsigned s = Random(seed) % inStreams;
+                double cutoff = RandomCutoff(seed), resonance = RandomResonance(seed);
+                bank.SetParameters(s, cutoff, resonance);
+                references[s].SetParameters(cutoff, resonance);
+            }
+
+            for (unsigned n = 0; n < inStreams / 8; n++) {
+                references[Random(seed) % inStreams].mBlockSize = kBlockSizes[Random(seed) % numberOfBlockSizes];
+            }
+
+            bank.RemoveStream(Random(seed) % inStreams);
+            AddStream(bank, references, seed);
+        }
+
+        for (unsigned s = 0; s < inStreams; s++) {
+
+            // some streams sit a round out
+            frames[s] = Random(seed) % 8 == 0 ? 0 : references[s].mBlockSize;
+            if (frames[s] == 0) { continue; }
+
+            Reference &reference = references[s];
+            float *in = &source[s * kMaxBlockSize];
+
+            for (unsigned i = 0; i < frames[s]; i++) {
+                in[i] = (float)((int32_t)(reference.mNoise = reference.mNoise * 1664525u + 1013904223u) * (0.5 / 2147483648.0));
+            }
+
+            reference.mBiquad.Process(reference.mCoefficients, in, &expected[s * kMaxBlockSize], frames[s]);
+
+            // every other stream in place
+            output[s] = s % 2 == 0 ? &dest[s * kMaxBlockSize] : in;
+            bank.Submit(s, in, output[s], frames[s]);
+        }
+
+        bank.Run();
+
+        unsigned groups = bank.GetNumberOfGroups();
+        mostGroups = groups > mostGroups ? groups : mostGroups;
+
+        for (unsigned s = 0; s < inStreams; s++) {
+            if (frames[s] == 0) { continue; }
+            if (memcmp(output[s], &expected[s * kMaxBlockSize], frames[s] * sizeof(float)) != 0) { mismatches++; }
+            samples += frames[s];
+        }
+    }
+
+    printf("check: %u streams, %lu samples in %u runs, up to %u groups: %s\n",
+           inStreams, samples, kCheckRuns, mostGroups, mismatches == 0 ? "bit identical" : "MISMATCH");
+    if (mismatches != 0) { printf("  %u blocks differ\n", mismatches); }
+
+    return mismatches == 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Timing
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static double GetSeconds() {
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Time(unsigned inStreams, unsigned inBlockSize) {
+
+    LoPassFilterBank bank(kSampleRate);
+    std::vector<Reference> references;
+    uint32_t seed = 2;
+
+    for (unsigned s = 0; s < inStreams; s++) { AddStream(bank, references, seed); }
+
+    std::vector<float> source(inStreams * inBlockSize), dest(inStreams * inBlockSize);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < source.size(); i++) { source[i] = (float)((int32_t)(noise = noise * 1664525u + 1013904223u) * (0.5 / 2147483648.0)); }
+
+    unsigned blocks = (kTimingFrames + inBlockSize - 1) / inBlockSize;
+    double biquadSeconds = 1e9, bankSeconds = 1e9;
+
+    for (unsigned run = 0; run < kTimingRuns; run++) {
+
+        double start = GetSeconds();
+        for (unsigned b = 0; b < blocks; b++) {
+            for (unsigned s = 0; s < inStreams; s++) {
+                Reference &reference = references[s];
+                reference.mBiquad.Process(reference.mCoefficients, &source[s * inBlockSize], &dest[s * inBlockSize], inBlockSize);
+            }
+        }
+        double seconds = GetSeconds() - start;
+        biquadSeconds = seconds < biquadSeconds ? seconds : biquadSeconds;
+
+        start = GetSeconds();
+        for (unsigned b = 0; b < blocks; b++) {
+            for (unsigned s = 0; s < inStreams; s++) { bank.Submit(s, &source[s * inBlockSize], &dest[s * inBlockSize], inBlockSize); }
+            bank.Run();
+        }
+        seconds = GetSeconds() - start;
+        bankSeconds = seconds < bankSeconds ? seconds : bankSeconds;
+    }
+
+    double samples  = (double)blocks * inBlockSize * inStreams;
+    double biquadNs = 1e9 * biquadSeconds / samples;
+    double bankNs   = 1e9 * bankSeconds / samples;
+
+    printf("\ntiming: %u streams at %u frames, %u groups, %s\n",
+           inStreams, inBlockSize, bank.GetNumberOfGroups(), LoPassFilterBank::GetInstructionSet());
+    printf("%-26s %12s %22s\n", "", "ns/sample", "48 kHz streams / core");
+    printf("%-26s %12.3f %22.0f\n", "LoPassBiquad per stream", biquadNs, 1e9 / (biquadNs * kSampleRate));
+    printf("%-26s %12.3f %22.0f\n", "LoPassFilterBank", bankNs, 1e9 / (bankNs * kSampleRate));
+    printf("speedup %.1fx\n", biquadNs / bankNs);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, const char *argv[]) {
+
+    unsigned streams    = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : kDefaultStreams;
+    unsigned blockSize  = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : kDefaultBlockSize;
+
+    if (streams == 0 || blockSize == 0 || blockSize > kMaxBlockSize) {
+        fprintf(stderr, "usage: lopass-bank [streams] [block size, 1 to %u]\n", kMaxBlockSize);
+        return 2;
+    }
+
+    bool ok = Check(streams);
+    Time(streams, blockSize);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,604 @@
+//
+//  LoPassBatch.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassBatch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRenderOptions::LoPassRenderOptions()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassRenderOptions::LoPassRenderOptions() :
+    mSettings(),
+    mBlockSize(65536),
+    mWriteFloat(false),
+    mKeepLatency(false),
+    mParallel(NULL),
+    mBackend(kLoPassIO_Map),
+    mQueueDepth(4) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRenderer::LoPassRenderer()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassRenderer::LoPassRenderer(const LoPassRenderOptions &inOptions) :
+    mOptions(inOptions),
+    mInputFile(-1),
+    mOutputFile(-1) {
+    
+    if (mOptions.mQueueDepth == 0) { mOptions.mQueueDepth = 1; }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRenderer::Configure()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassRenderer::Processors &LoPassRenderer::Configure(double inSampleRate, unsigned inChannels) {
+    
+    // the designs depend on the sample rate, so each rate has its own processors
+    size_t b = 0;
+    while (b < mBanks.size() && mBanks[b].mSampleRate != inSampleRate) { b++; }
+    
+    if (b == mBanks.size()) {
+        mBanks.push_back(Bank());
+        mBanks[b].mSampleRate = inSampleRate;
+    }
+    
+    Processors &processors = mBanks[b].mProcessors;
+    
+    while (processors.size() < inChannels) {
+        
+        LoPassProcessor *processor = new LoPassProcessor(inSampleRate);
+        
+        if (mOptions.mSettings.mLinearPhase) { processor->Prepare(mOptions.mSettings); }
+        processor->SetParallel(mOptions.mParallel);
+        
+        processors.push_back(std::unique_ptr<LoPassProcessor>(processor));
+    }
+    
+    while (mInput.size() < inChannels) {
+        mInput.push_back(std::vector<float>(mOptions.mBlockSize));
+        mOutput.push_back(std::vector<float>(mOptions.mBlockSize));
+        mInputP.push_back(&mInput.back()[0]);
+        mOutputP.push_back(NULL);
+    }
+    
+    // start every file from a clean state, as a freshly reset AudioUnit would
+    for (unsigned c = 0; c < inChannels; c++) { processors[c]->Reset(); }
+    
+    return processors;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRenderer::Render()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassRenderer::Render(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats) {
+    
+    memset(&outStats, 0, sizeof(outStats));
+    
+    if (mOptions.mBackend == kLoPassIO_Map) { return RenderMapped(inInputPath, inOutputPath, outStats); }
+    
+    return RenderStreamed(inInputPath, inOutputPath, outStats);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRenderer::RenderMapped()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassRenderer::RenderMapped(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats) {
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    if (!mReader.Open(inInputPath)) { return Fail(mReader.GetError()); }
+    
+    // truncating the file that is mapped for reading would crash the read
+    struct stat input, output;
+    if (stat(inInputPath, &input) == 0 && stat(inOutputPath, &output) == 0 &&
+        input.st_dev == output.st_dev && input.st_ino == output.st_ino) {
+        return Fail(std::string(inOutputPath) + ": would overwrite the input");
+    }
+    
+    const LoPassWaveFormat &inputFormat = mReader.GetFormat();
+    const unsigned channels     = inputFormat.mChannels;
+    const unsigned frames       = mOptions.mBlockSize;
+    const uint64_t totalFrames  = mReader.GetFrameCount();
+    
+    LoPassWaveFormat outputFormat = inputFormat;
+    
+    if (mOptions.mWriteFloat) {
+        outputFormat.mFloat         = true;
+        outputFormat.mBitsPerSample = 32;
+    }
+    
+    if (!mWriter.Open(inOutputPath, outputFormat, totalFrames)) { return Fail(mWriter.GetError()); }
+    
+    mOutputPath = inOutputPath;
+    
+    const double srate = inputFormat.mSampleRate;
+    Processors &processors = Configure(srate, channels);
+    
+    // Latency compensation: the first `latency` output frames are dropped, and the same
+    // number of zeros are fed in after the end of the input to flush the rest out.
+    const LoPassSettings &settings = mOptions.mSettings;
+    const uint64_t latency = mOptions.mKeepLatency ? 0 : LoPassProcessor::GetLatencyFrames(settings, srate);
+    
+    uint64_t processed  = 0;    // frames into the processors, including the flush
+    uint64_t written    = 0;
+    
+    while (written < totalFrames) {
+        
+        unsigned count = mReader.Read(&mInputP[0], frames);
+        
+        // past the end of the input, flush with silence
+        uint64_t wanted = totalFrames + latency - processed;
+        unsigned block  = wanted < frames ? (unsigned)wanted : frames;
+        
+        for (unsigned c = 0; c < channels; c++) {
+            memset(&mInput[c][count], 0, (block - count) * sizeof(float));
+            processors[c]->Process(settings, &mInput[c][0], &mOutput[c][0], block);
+        }
+        
+        // skip whatever part of this block is still inside the latency
+        uint64_t skip   = processed < latency ? std::min<uint64_t>(latency - processed, block) : 0;
+        unsigned keep   = (unsigned)(block - skip);
+        processed      += block;
+        
+        if (keep == 0) { continue; }
+        
+        for (unsigned c = 0; c < channels; c++) { mOutputP[c] = &mOutput[c][skip]; }
+        
+        if (!mWriter.Write(&mOutputP[0], keep)) { return Fail(mWriter.GetError()); }
+        
+        written += keep;
+    }
+    
+    if (!mWriter.Close()) { return Fail(mWriter.GetError()); }
+    
+    mOutputPath.clear();
+    
+    outStats.mFrames        = totalFrames;
+    outStats.mChannels      = channels;
+    outStats.mSampleRate    = srate;
+    outStats.mBytes         = totalFrames * inputFormat.GetBytesPerFrame();
+    outStats.mSeconds       = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    mReader.Close();
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRenderer::RenderStreamed()
+//
+// The first mQueueDepth pool buffers hold input blocks, block k in buffer k % depth, and
+// the rest hold encoded output waiting to be written. Reads are refilled as soon as a
+// block is decoded and writes are only waited for when every output buffer is busy, so
+// with io_uring the transfers in both directions overlap the filtering.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassRenderer::RenderStreamed(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats) {
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    const unsigned depth = mOptions.mQueueDepth;
+    
+    if (!mIO) {
+        mIO.reset(LoPassAsyncIO::Create(mOptions.mBackend, 2 * depth, kRender_IOBufferBytes));
+        if (!mIO) { return Fail("can't allocate the I/O buffers"); }
+        mTransfers.assign(2 * depth, Transfer());
+    }
+    
+    mInputFile = open(inInputPath, O_RDONLY);
+    if (mInputFile < 0) { return Fail(std::string(inInputPath) + ": " + strerror(errno)); }
+    
+    LoPassWaveFormat inputFormat;
+    uint64_t dataOffset, totalFrames;
+    std::string error;
+    
+    if (!LoPassWaveReader::ReadHeader(mInputFile, inputFormat, dataOffset, totalFrames, error)) {
+        return Fail(std::string(inInputPath) + ": " + error);
+    }
+    
+    posix_fadvise(mInputFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+    
+    // truncating the input before it has been read would lose it
+    struct stat input, output;
+    if (fstat(mInputFile, &input) == 0 && stat(inOutputPath, &output) == 0 &&
+        input.st_dev == output.st_dev && input.st_ino == output.st_ino) {
+        return Fail(std::string(inOutputPath) + ": would overwrite the input");
+    }
+    
+    LoPassWaveFormat outputFormat = inputFormat;
+    
+    if (mOptions.mWriteFloat) {
+        outputFormat.mFloat         = true;
+        outputFormat.mBitsPerSample = 32;
+    }
+    
+    mOutputFile = open(inOutputPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (mOutputFile < 0) { return Fail(std::string(inOutputPath) + ": " + strerror(errno)); }
+    
+    mOutputPath = inOutputPath;
+    
+    LoPassWaveWriter::MakeHeader(outputFormat, totalFrames, mHeader);
+    
+    if (pwrite(mOutputFile, &mHeader[0], mHeader.size(), 0) != (ssize_t)mHeader.size()) {
+        return Fail(std::string(inOutputPath) + ": " + strerror(errno));
+    }
+    
+    const unsigned channels     = inputFormat.mChannels;
+    const unsigned inputBPF     = inputFormat.GetBytesPerFrame();
+    const unsigned outputBPF    = outputFormat.GetBytesPerFrame();
+    const size_t largestBPF     = std::max(inputBPF, outputBPF);
+    const unsigned frames       = (unsigned)std::min<size_t>(mOptions.mBlockSize, kRender_IOBufferBytes / largestBPF);
+    const uint64_t readBlocks   = (totalFrames + frames - 1) / frames;
+    
+    const double srate = inputFormat.mSampleRate;
+    Processors &processors = Configure(srate, channels);
+    
+    // latency compensation as in RenderMapped()
+    const LoPassSettings &settings = mOptions.mSettings;
+    const uint64_t latency = mOptions.mKeepLatency ? 0 : LoPassProcessor::GetLatencyFrames(settings, srate);
+    
+    for (size_t i = 0; i < mTransfers.size(); i++) { mTransfers[i].mBusy = false; }
+    
+    uint64_t requested  = 0;    // input blocks queued for reading
+    uint64_t decoded    = 0;    // input blocks taken out of the pool
+    uint64_t processed  = 0;
+    uint64_t written    = 0;
+    
+    while (written < totalFrames) {
+        
+        // keep the read-ahead full, then start it before filtering
+        while (requested < readBlocks && requested < decoded + depth) {
+            
+            unsigned slot       = (unsigned)(requested % depth);
+            uint64_t first      = requested * frames;
+            Transfer &transfer  = mTransfers[slot];
+            
+            transfer.mOffset    = dataOffset + first * inputBPF;
+            transfer.mBytes     = (unsigned)std::min<uint64_t>(frames, totalFrames - first) * inputBPF;
+            transfer.mBusy      = true;
+            transfer.mDone      = false;
+            
+            if (!mIO->SubmitRead(mInputFile, slot, transfer.mOffset, transfer.mBytes, slot)) {
+                return Fail(std::string(inInputPath) + ": can't queue a read");
+            }
+            
+            requested++;
+        }
+        
+        mIO->Flush();
+        
+        unsigned count = 0;
+        
+        if (decoded < readBlocks) {
+            
+            unsigned slot = (unsigned)(decoded % depth);
+            
+            while (!mTransfers[slot].mDone) {
+                if (!Complete(inInputPath, inOutputPath)) { return false; }
+            }
+            
+            count = mTransfers[slot].mBytes / inputBPF;
+            LoPassWaveDecode(inputFormat, mIO->GetBuffer(slot), &mInputP[0], count);
+            
+            mTransfers[slot].mBusy = false;
+            decoded++;
+        }
+        
+        // past the end of the input, flush with silence
+        uint64_t wanted = totalFrames + latency - processed;
+        unsigned block  = wanted < frames ? (unsigned)wanted : frames;
+        
+        for (unsigned c = 0; c < channels; c++) {
+            memset(&mInput[c][count], 0, (block - count) * sizeof(float));
+            processors[c]->Process(settings, &mInput[c][0], &mOutput[c][0], block);
+        }
+        
+        uint64_t skip   = processed < latency ? std::min<uint64_t>(latency - processed, block) : 0;
+        unsigned keep   = (unsigned)(block - skip);
+        processed      += block;
+        
+        if (keep == 0) { continue; }
+        
+        // an output buffer whose last write has finished
+        unsigned slot = depth;
+        
+        for (;;) {
+            while (slot < 2 * depth && mTransfers[slot].mBusy && !mTransfers[slot].mDone) { slot++; }
+            if (slot < 2 * depth) { break; }
+            if (!Complete(inInputPath, inOutputPath)) { return false; }
+            slot = depth;
+        }
+        
+        for (unsigned c = 0; c < channels; c++) { mOutputP[c] = &mOutput[c][skip]; }
+        
+        LoPassWaveEncode(outputFormat, &mOutputP[0], mIO->GetBuffer(slot), keep);
+        
+        Transfer &transfer  = mTransfers[slot];
+        transfer.mOffset    = mHeader.size() + written * outputBPF;
+        transfer.mBytes     = keep * outputBPF;
+        transfer.mBusy      = true;
+        transfer.mDone      = false;
+        
+        if (!mIO->SubmitWrite(mOutputFile, slot, transfer.mOffset, transfer.mBytes, slot)) {
+            return Fail(std::string(inOutputPath) + ": can't queue a write");
+        }
+        
+        mIO->Flush();
+        written += keep;
+    }
+    
+    // pad byte for an odd sized data chunk
+    const uint64_t dataBytes = totalFrames * outputBPF;
+    
+    if ((dataBytes & 1) != 0) {
+        const uint8_t pad = 0;
+        if (pwrite(mOutputFile, &pad, 1, (off_t)(mHeader.size() + dataBytes)) != 1) {
+            return Fail(std::string(inOutputPath) + ": " + strerror(errno));
+        }
+    }
+    
+    while (mIO->GetPending() > 0) {
+        if (!Complete(inInputPath, inOutputPath)) { return false; }
+    }
+    
+    int closed = close(mOutputFile);
+    mOutputFile = -1;
+    
+    if (closed != 0) { return Fail(std::string(inOutputPath) + ": " + strerror(errno)); }
+    
+    mOutputPath.clear();
+    
+    close(mInputFile);
+    mInputFile = -1;
+    
+    outStats.mFrames        = totalFrames;
+    outStats.mChannels      = channels;
+    outStats.mSampleRate    = srate;
+    outStats.mBytes         = totalFrames * inputBPF;
+    outStats.mSeconds       = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRenderer::Complete()
+//
+// Waits for one request. A short read or write is finished off synchronously; on regular
+// files that only happens near the end of the disk or of a truncated file.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassRenderer::Complete(const char *inInputPath, const char *inOutputPath) {
+    
+    uint64_t tag;
+    int result;
+    
+    if (!mIO->Wait(tag, result)) { return Fail("lost an I/O request"); }
+    
+    const unsigned slot = (unsigned)tag;
+    const bool write    = slot >= mOptions.mQueueDepth;
+    const char *path    = write ? inOutputPath : inInputPath;
+    Transfer &transfer  = mTransfers[slot];
+    
+    if (result < 0) { return Fail(std::string(path) + ": " + strerror(-result)); }
+    
+    uint8_t *buffer = mIO->GetBuffer(slot);
+    unsigned done   = (unsigned)result;
+    
+    while (done < transfer.mBytes) {
+        
+        off_t offset    = (off_t)(transfer.mOffset + done);
+        ssize_t n       = write ? pwrite(mOutputFile, buffer + done, transfer.mBytes - done, offset)
+                                : pread(mInputFile, buffer + done, transfer.mBytes - done, offset);
+        
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n < 0) { return Fail(std::string(path) + ": " + strerror(errno)); }
+        if (n == 0) { return Fail(std::string(path) + ": unexpected end of file"); }
+        
+        done += (unsigned)n;
+    }
+    
+    transfer.mDone = true;
+    return true;
+}
+
+bool LoPassRenderer::Fail(const std::string &inMessage) {
+    
+    mError = inMessage;
+    mWriter.Close();
+    mReader.Close();
+    
+    // the kernel may still be using the pool and the files
+    if (mIO) {
+        uint64_t tag;
+        int result;
+        while (mIO->Wait(tag, result)) { }
+    }
+    
+    if (mInputFile >= 0) { close(mInputFile); }
+    if (mOutputFile >= 0) { close(mOutputFile); }
+    mInputFile = mOutputFile = -1;
+    
+    // don't leave a file behind whose header promises more than it holds
+    if (!mOutputPath.empty()) {
+        unlink(mOutputPath.c_str());
+        mOutputPath.clear();
+    }
+    
+    return false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBatch::LoPassBatch()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassBatch::LoPassBatch(const LoPassRenderOptions &inOptions, unsigned inThreads) :
+    mJobs(NULL),
+    mResults(NULL),
+    mSteals(0),
+    mSeconds(0.0) {
+    
+    if (inThreads == 0) { inThreads = std::thread::hardware_concurrency(); }
+    if (inThreads == 0) { inThreads = 1; }
+    
+    // files are the unit of parallelism here, each one is filtered serially
+    LoPassRenderOptions options = inOptions;
+    options.mParallel = NULL;
+    
+    for (unsigned i = 0; i < inThreads; i++) {
+        mRenderers.push_back(std::unique_ptr<LoPassRenderer>(new LoPassRenderer(options)));
+        mQueues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBatch::MakeTasks()
+//
+// Consecutive jobs are gathered until they add up to kBatch_TaskBytes; a large file is a
+// task on its own. Sizes come from stat(), a missing file counts as empty and fails later.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBatch::MakeTasks() {
+    
+    const std::vector<LoPassBatchJob> &jobs = *mJobs;
+    
+    mTasks.clear();
+    
+    uint64_t bytes = 0;
+    Task task = { 0, 0 };
+    
+    for (unsigned i = 0; i < jobs.size(); i++) {
+        
+        struct stat info;
+        uint64_t size = stat(jobs[i].mInputPath.c_str(), &info) == 0 ? (uint64_t)info.st_size : 0;
+        
+        task.mEnd = i + 1;
+        bytes += size;
+        
+        if (bytes >= kBatch_TaskBytes || task.mEnd - task.mFirst >= kBatch_MaxTaskFiles) {
+            mTasks.push_back(task);
+            task.mFirst = task.mEnd;
+            bytes = 0;
+        }
+    }
+    
+    if (task.mEnd > task.mFirst) { mTasks.push_back(task); }
+    
+    // an even share of consecutive tasks for each worker, taken from the back
+    const unsigned workers = GetThreads();
+    
+    for (unsigned w = 0; w < workers; w++) {
+        
+        Queue &queue = *mQueues[w];
+        queue.mTasks.clear();
+        
+        unsigned first  = (unsigned)((uint64_t)mTasks.size() * w / workers);
+        unsigned end    = (unsigned)((uint64_t)mTasks.size() * (w + 1) / workers);
+        
+        for (unsigned t = end; t > first; t--) { queue.mTasks.push_back(t - 1); }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBatch::Take()
+//
+// No tasks are added during a run, so once every deque is empty the worker is done.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassBatch::Take(unsigned inWorker, unsigned &outTask) {
+    
+    {
+        Queue &own = *mQueues[inWorker];
+        std::lock_guard<std::mutex> lock(own.mMutex);
+        
+        if (!own.mTasks.empty()) {
+            outTask = own.mTasks.back();
+            own.mTasks.pop_back();
+            return true;
+        }
+    }
+    
+    // steal the oldest task of the next worker along that has any
+    const unsigned workers = GetThreads();
+    
+    for (unsigned i = 1; i < workers; i++) {
+        
+        Queue &victim = *mQueues[(inWorker + i) % workers];
+        std::lock_guard<std::mutex> lock(victim.mMutex);
+        
+        if (!victim.mTasks.empty()) {
+            outTask = victim.mTasks.front();
+            victim.mTasks.pop_front();
+            mSteals++;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBatch::Work()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBatch::Work(unsigned inWorker) {
+    
+    LoPassRenderer &renderer = *mRenderers[inWorker];
+    unsigned task;
+    
+    while (Take(inWorker, task)) {
+        
+        for (unsigned j = mTasks[task].mFirst; j < mTasks[task].mEnd; j++) {
+            
+            const LoPassBatchJob &job   = (*mJobs)[j];
+            LoPassBatchResult &result   = (*mResults)[j];
+            
+            result.mOK      = renderer.Render(job.mInputPath.c_str(), job.mOutputPath.c_str(), result.mStats);
+            result.mError   = result.mOK ? std::string() : renderer.GetError();
+            result.mWorker  = inWorker;
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBatch::Run()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassBatch::Run(const std::vector<LoPassBatchJob> &inJobs, std::vector<LoPassBatchResult> &outResults) {
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    mJobs       = &inJobs;
+    mResults    = &outResults;
+    mSteals     = 0;
+    
+    outResults.assign(inJobs.size(), LoPassBatchResult());
+    
+    MakeTasks();
+    
+    std::vector<std::thread> threads;
+    
+    for (unsigned w = 1; w < GetThreads(); w++) { threads.push_back(std::thread(&LoPassBatch::Work, this, w)); }
+    
+    Work(0);
+    
+    for (size_t i = 0; i < threads.size(); i++) { threads[i].join(); }
+    
+    mJobs       = NULL;
+    mResults    = NULL;
+    mSeconds    = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,178 @@
+//
+//  LoPassBatch.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  File rendering for lopass-render: one file at a time, or many across a thread pool.
+//
+
+#ifndef LoPassBatch_hpp
+#define LoPassBatch_hpp
+
+#include "LoPassAsyncIO.hpp"
+#include "LoPassProcessor.hpp"
+#include "LoPassWave.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Renderer
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// With kLoPassIO_Map the input is mapped and the output goes through stdio, so every page
+// fault and every flush stalls the filter. The other backends stream both files through
+// a LoPassAsyncIO pool instead: mQueueDepth blocks are read ahead, and each filtered block
+// is queued for writing and left to finish while the next one is filtered.
+
+/// Bytes in each buffer of the I/O pool; long blocks are split to fit.
+static constexpr size_t kRender_IOBufferBytes = 1 << 20;
+
+struct LoPassRenderOptions {
+    LoPassSettings          mSettings;
+    unsigned                mBlockSize;     // frames per block
+    bool                    mWriteFloat;    // 32 bit float rather than the input format
+    bool                    mKeepLatency;   // otherwise the output is aligned with the input
+    LoPassParallelBiquad    *mParallel;     // NULL to run the filter serially
+    LoPassIOBackend         mBackend;
+    unsigned                mQueueDepth;    // reads, and writes, in flight per file
+    
+    LoPassRenderOptions();
+};
+
+struct LoPassRenderStats {
+    uint64_t    mFrames;
+    unsigned    mChannels;
+    double      mSampleRate;
+    uint64_t    mBytes;         // of input sample data
+    double      mSeconds;       // wall clock
+};
+
+/// Renders files one after another with the same processors and buffers. Between files the
+/// processors are reset, as LoPassKernel::Reset() does, rather than rebuilt. Processors are
+/// kept per sample rate, and processors and buffers only grow for more channels.
+class LoPassRenderer {
+    
+public:
+    LoPassRenderer(const LoPassRenderOptions &inOptions);
+    
+    /// Returns false, with GetError() set, if either file failed.
+    bool Render(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats);
+    
+    const std::string &GetError() const { return mError; }
+    
+    /// The backend actually in use, once a file has been rendered; io_uring may have been
+    /// refused, in which case this is kLoPassIO_Sync.
+    LoPassIOBackend GetBackend() const { return mIO ? mIO->GetBackend() : mOptions.mBackend; }
+    
+private:
+    typedef std::vector<std::unique_ptr<LoPassProcessor> > Processors;
+    
+    struct Bank {
+        double      mSampleRate;
+        Processors  mProcessors;
+    };
+    
+    /// A request on a slot of the I/O pool.
+    struct Transfer {
+        uint64_t    mOffset;
+        unsigned    mBytes;
+        bool        mBusy;
+        bool        mDone;
+    };
+    
+    Processors &Configure(double inSampleRate, unsigned inChannels);
+    bool RenderMapped(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats);
+    bool RenderStreamed(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats);
+    bool Complete(const char *inInputPath, const char *inOutputPath);
+    bool Fail(const std::string &inMessage);
+    
+    LoPassRenderOptions                             mOptions;
+    LoPassWaveReader                                mReader;
+    LoPassWaveWriter                                mWriter;
+    std::unique_ptr<LoPassAsyncIO>                  mIO;
+    std::vector<Transfer>                           mTransfers;     // one per pool buffer
+    std::vector<uint8_t>                            mHeader;
+    int                                             mInputFile;
+    int                                             mOutputFile;
+    
+    std::vector<Bank>                               mBanks;
+    std::vector<std::vector<float> >                mInput;
+    std::vector<std::vector<float> >                mOutput;
+    std::vector<float *>                            mInputP;
+    std::vector<const float *>                      mOutputP;
+    std::string                                     mOutputPath;    // while being written
+    std::string                                     mError;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Batch
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Jobs are grouped into tasks of roughly kBatch_TaskBytes of input, so a run of short clips
+// costs one queue operation rather than one each. Each worker starts with an even share of
+// consecutive tasks in its own deque, takes work from the back of it, and once it runs dry
+// steals from the front of the others. Every worker owns a LoPassRenderer for the lifetime
+// of the LoPassBatch, so nothing is allocated per file once the buffers have grown.
+
+/// Input bytes gathered into one task, and the most files in one.
+static constexpr uint64_t kBatch_TaskBytes      = 4 << 20;
+static constexpr unsigned kBatch_MaxTaskFiles   = 256;
+
+struct LoPassBatchJob {
+    std::string mInputPath;
+    std::string mOutputPath;
+};
+
+struct LoPassBatchResult {
+    bool                mOK;
+    std::string         mError;
+    LoPassRenderStats   mStats;
+    unsigned            mWorker;
+};
+
+class LoPassBatch {
+    
+public:
+    /// inThreads of 0 uses one worker per core.
+    LoPassBatch(const LoPassRenderOptions &inOptions, unsigned inThreads = 0);
+    
+    unsigned GetThreads() const { return (unsigned)mRenderers.size(); }
+    
+    /// Renders every job; outResults is in the same order as inJobs.
+    void Run(const std::vector<LoPassBatchJob> &inJobs, std::vector<LoPassBatchResult> &outResults);
+    
+    /// Of the last Run().
+    double GetSeconds() const { return mSeconds; }
+    unsigned GetTaskCount() const { return (unsigned)mTasks.size(); }
+    unsigned GetSteals() const { return mSteals.load(); }
+    LoPassIOBackend GetBackend() const { return mRenderers[0]->GetBackend(); }
+    
+private:
+    struct Task {
+        unsigned    mFirst;
+        unsigned    mEnd;
+    };
+    
+    struct Queue {
+        std::mutex              mMutex;
+        std::deque<unsigned>    mTasks;
+    };
+    
+    void MakeTasks();
+    bool Take(unsigned inWorker, unsigned &outTask);
+    void Work(unsigned inWorker);
+    
+    std::vector<std::unique_ptr<LoPassRenderer> >   mRenderers;
+    std::vector<std::unique_ptr<Queue> >            mQueues;
+    std::vector<Task>                               mTasks;
+    
+    const std::vector<LoPassBatchJob>               *mJobs;
+    std::vector<LoPassBatchResult>                  *mResults;
+    std::atomic<unsigned>                           mSteals;
+    double                                          mSeconds;
+};
+
+#endif /* LoPassBatch_hpp */
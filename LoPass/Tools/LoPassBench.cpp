@@ -0,0 +1,286 @@
+//
+//  LoPassBench.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Microbenchmark suite: every kernel the effect can run, over block sizes, channel counts,
+//  automation rates and kinds of input, reported as JSON.
+//
+//  make lopass-bench
+//
+//  The standard set runs each kernel at 256 frames and 2 channels with every automation
+//  rate and input, then sweeps block sizes from 1 to 8192 frames and channel counts from 1
+//  to 64 (see LoPassBenchSuite.hpp). --full crosses every axis instead, and each axis can be
+//  narrowed to a comma separated list. The JSON report goes to stdout or --output, with the
+//  host, and per case the median ns per sample and its spread, time stamp counter cycles
+//  per sample and samples per second; a table of the same goes to stderr as it runs.
+//  --counters adds instructions per cycle and cache misses, branch misses and floating
+//  point assists per sample from the hardware counters, where the machine allows it (see
+//  LoPassPerfCounters.hpp); where it doesn't, it says why and carries on with timings.
+//  lopass-bench-compare checks the cases against a stored baseline.
+//
+//  lopass-bench [options]
+//
+
+#include "LoPassBenchSuite.hpp"
+#include "LoPassToolOptions.hpp"
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void PrintUsage(FILE *inFile) {
+
+    LoPassBenchOptions defaults;
+
+    fprintf(inFile,
+            "usage: lopass-bench [options]\n"
+            "\n"
+            "  -k, --kernel LIST        kernels to run (default all)\n"
+            "  -b, --block LIST         block sizes in frames\n"
+            "  -c, --channels LIST      channel counts\n"
+            "  -a, --automation LIST    automation rates\n"
+            "  -i, --input LIST         inputs\n"
+            "  -f, --full               every combination, rather than the standard set\n"
+            "  -t, --time SECONDS       length of each run (default %g)\n"
+            "  -n, --runs N             runs of each case (default %u)\n"
+            "  -r, --rate HZ            sample rate (default %g)\n"
+            "  -e, --counters           read hardware performance counters too (Linux)\n"
+            "  -o, --output FILE        write the report to FILE rather than stdout\n"
+            "  -l, --list               list the cases and exit\n"
+            "  -q, --quiet              no table\n"
+            "\n"
+            "Giving any of block, channels, automation or input crosses the lists given with the\n"
+            "standard values of the rest.\n"
+            "\n",
+            defaults.mSecondsPerRun, defaults.mRuns, defaults.mSampleRate);
+
+    fprintf(inFile, "kernels:");
+    for (int i = 0; i < kNumberOfBenchKernels; i++) { fprintf(inFile, " %s", LoPassBenchKernelName((LoPassBenchKernel)i)); }
+    fprintf(inFile, "\nautomation:");
+    for (int i = 0; i < kNumberOfBenchAutomations; i++) { fprintf(inFile, " %s", LoPassBenchAutomationName((LoPassBenchAutomation)i)); }
+    fprintf(inFile, "\ninputs:");
+    for (int i = 0; i < kNumberOfBenchInputs; i++) { fprintf(inFile, " %s", LoPassBenchInputName((LoPassBenchInput)i)); }
+    fprintf(inFile, "\n");
+}
+
+/// Splits a comma separated list, looking each item up with inFind.
+template <class T, class Find>
+static bool ParseList(const char *inText, Find inFind, std::vector<T> &outValues) {
+
+    std::string text = inText;
+    size_t start = 0;
+
+    outValues.clear();
+
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) { comma = text.size(); }
+
+        T value;
+        if (!inFind(text.substr(start, comma - start).c_str(), value)) { return false; }
+        outValues.push_back(value);
+
+        start = comma + 1;
+    }
+
+    return !outValues.empty();
+}
+
+static bool FindCount(const char *inText, unsigned &outValue) {
+
+    double value;
+    if (!LoPassParseNumber(inText, value) || value < 1.0 || value > 65536.0 || value != (unsigned)value) { return false; }
+    outValue = (unsigned)value;
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "kernel",         required_argument,  NULL, 'k' },
+        { "block",          required_argument,  NULL, 'b' },
+        { "channels",       required_argument,  NULL, 'c' },
+        { "automation",     required_argument,  NULL, 'a' },
+        { "input",          required_argument,  NULL, 'i' },
+        { "full",           no_argument,        NULL, 'f' },
+        { "time",           required_argument,  NULL, 't' },
+        { "runs",           required_argument,  NULL, 'n' },
+        { "rate",           required_argument,  NULL, 'r' },
+        { "counters",       no_argument,        NULL, 'e' },
+        { "output",         required_argument,  NULL, 'o' },
+        { "list",           no_argument,        NULL, 'l' },
+        { "quiet",          no_argument,        NULL, 'q' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+
+    LoPassBenchOptions options;
+    std::vector<LoPassBenchKernel> kernels;
+    std::vector<unsigned> blockSizes;
+    std::vector<unsigned> channels;
+    std::vector<LoPassBenchAutomation> automations;
+    std::vector<LoPassBenchInput> inputs;
+    const char *outputPath = NULL;
+    double runs = options.mRuns;
+    bool full   = false;
+    bool list   = false;
+    bool quiet  = false;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "k:b:c:a:i:ft:n:r:eo:lqh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'k': ok = ParseList(optarg, LoPassBenchFindKernel, kernels); break;
+            case 'b': ok = ParseList(optarg, FindCount, blockSizes); break;
+            case 'c': ok = ParseList(optarg, FindCount, channels); break;
+            case 'a': ok = ParseList(optarg, LoPassBenchFindAutomation, automations); break;
+            case 'i': ok = ParseList(optarg, LoPassBenchFindInput, inputs); break;
+            case 'f': full = true; break;
+            case 't': ok = LoPassParseNumber(optarg, options.mSecondsPerRun) && options.mSecondsPerRun > 0.0 && options.mSecondsPerRun <= 60.0; break;
+            case 'n': ok = LoPassParseNumber(optarg, runs) && runs >= 1.0 && runs <= 1000.0; break;
+            case 'r': ok = LoPassParseNumber(optarg, options.mSampleRate) && options.mSampleRate >= 8000.0 && options.mSampleRate <= 768000.0; break;
+            case 'e': options.mCounters = true; break;
+            case 'o': outputPath = optarg; break;
+            case 'l': list = true; break;
+            case 'q': quiet = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-bench: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    options.mRuns = (unsigned)runs;
+
+    if (kernels.empty()) {
+        for (int i = 0; i < kNumberOfBenchKernels; i++) { kernels.push_back((LoPassBenchKernel)i); }
+    }
+
+    std::vector<LoPassBenchCase> cases;
+
+    if (full || !blockSizes.empty() || !channels.empty() || !automations.empty() || !inputs.empty()) {
+
+        // what isn't given is every value with --full, otherwise the centre
+        if (blockSizes.empty()) {
+            blockSizes = full ? kBench_BlockSizes : std::vector<unsigned>(1, kBench_CentreBlockSize);
+        }
+        if (channels.empty()) {
+            channels = full ? kBench_ChannelCounts : std::vector<unsigned>(1, kBench_CentreChannels);
+        }
+        if (automations.empty()) {
+            for (int i = 0; i < kNumberOfBenchAutomations; i++) {
+                if (full || i == kBenchAutomation_Static) { automations.push_back((LoPassBenchAutomation)i); }
+            }
+        }
+        if (inputs.empty()) {
+            for (int i = 0; i < kNumberOfBenchInputs; i++) {
+                if (full || i == kBenchInput_Noise) { inputs.push_back((LoPassBenchInput)i); }
+            }
+        }
+
+        cases = LoPassBenchCrossCases(kernels, blockSizes, channels, automations, inputs);
+
+    } else {
+        cases = LoPassBenchStandardCases(kernels);
+    }
+
+    if (list) {
+        for (size_t n = 0; n < cases.size(); n++) { printf("%s\n", cases[n].GetName().c_str()); }
+        return 0;
+    }
+
+    FILE *output = stdout;
+
+    if (outputPath != NULL) {
+        output = fopen(outputPath, "w");
+        if (output == NULL) {
+            fprintf(stderr, "lopass-bench: can't write %s: %s\n", outputPath, strerror(errno));
+            return 1;
+        }
+    }
+
+    LoPassBenchHost host = LoPassBenchGetHost();
+
+    // without counters the timings still stand; the report says there were none
+    if (options.mCounters) {
+        LoPassPerfCounters probe;
+        if (!probe.Open()) {
+            fprintf(stderr, "lopass-bench: no performance counters: %s\n", probe.GetError().c_str());
+            options.mCounters = false;
+        } else if (!quiet) {
+            for (int i = 0; i < kNumberOfPerfCounters; i++) {
+                if (!probe.IsAvailable((LoPassPerfCounter)i)) {
+                    fprintf(stderr, "lopass-bench: %s not available\n", LoPassPerfCounterName((LoPassPerfCounter)i));
+                }
+            }
+        }
+    }
+
+    if (!quiet) {
+        fprintf(stderr, "%s, %s, %u cores; %zu cases of %u x %g s\n\n", host.mCPU.c_str(), host.mInstructionSet.c_str(),
+                host.mCores, cases.size(), options.mRuns, options.mSecondsPerRun);
+        fprintf(stderr, "%-44s %10s %8s %10s %12s", "case", "ns/sample", "mad %", "cycles", "samples/s");
+        if (options.mCounters) { fprintf(stderr, " %6s %8s %8s %8s %8s", "ipc", "l1d", "llc", "branch", "assists"); }
+        fprintf(stderr, "\n");
+    }
+
+    std::vector<LoPassBenchResult> results;
+
+    for (size_t n = 0; n < cases.size(); n++) {
+
+        results.push_back(LoPassBenchRun(cases[n], options));
+
+        if (!quiet) {
+            const LoPassBenchResult &result = results.back();
+            fprintf(stderr, "%-44s %10.3f %8.1f %10.2f %12.4g", cases[n].GetName().c_str(), result.mNsPerSample,
+                    result.mNsPerSample > 0.0 ? 100.0 * result.mNsPerSampleMAD / result.mNsPerSample : 0.0,
+                    result.mCyclesPerSample, result.mSamplesPerSecond);
+
+            // misses and assists per sample; - where a counter wasn't read
+            if (options.mCounters) {
+                if (result.GetIPC() >= 0.0) {
+                    fprintf(stderr, " %6.2f", result.GetIPC());
+                } else {
+                    fprintf(stderr, " %6s", "-");
+                }
+                for (int i = kPerfCounter_L1DMisses; i < kNumberOfPerfCounters; i++) {
+                    if (result.mCounters[i] >= 0.0) {
+                        fprintf(stderr, " %8.4f", result.mCounters[i]);
+                    } else {
+                        fprintf(stderr, " %8s", "-");
+                    }
+                }
+            }
+            fprintf(stderr, "\n");
+        }
+    }
+
+    LoPassBenchWriteJSON(output, host, options, results);
+
+    if (output != stdout && fclose(output) != 0) {
+        fprintf(stderr, "lopass-bench: can't write %s: %s\n", outputPath, strerror(errno));
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,428 @@
+//
+//  LoPassBenchCompare.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Performance regression gate: runs the lopass-bench cases of a stored baseline on this
+//  machine and fails if any has slowed down.
+//
+//  make lopass-bench-compare       (make check-bench runs it)
+//
+//  Baselines are lopass-bench reports kept in Baselines/, one per class of machine, named
+//  after the host class in the report (see LoPassBenchGetHost()), since timings only mean
+//  something against the same kind of processor. Each case of the baseline is run again
+//  with its sample rate, run length and number of runs, interleaved with the others as the
+//  baseline was (see LoPassBenchRunInterleaved()), and the medians compared.
+//
+//  On a shared or virtual machine a case's median moves by more from one stretch of
+//  seconds to the next than the runs within one stretch suggest, and by more for some
+//  kernels than others: the speed of a core, and the cache it shares, depend on what else
+//  the host is running at the time. So --update records the cases --trials times over and
+//  keeps the median of the trials' medians, along with how far apart those were: the
+//  noise of each case on this machine, taken to be no less than the median noise of its
+//  kernel's cases. A case fails when it is slower than the baseline by more than
+//  --threshold percent and by more than one and a half times its noise. Every case is
+//  first measured once; while any fails, all are measured again in another trial, up to
+//  --trials in all, and those that failed compared by the median of their trials' medians,
+//  so a stretch of load elsewhere on the machine doesn't fail the gate.
+//
+//  Exits 0 when nothing has regressed, 1 when something has, and 2 when it couldn't
+//  compare: bad options, or no baseline for this class. --update records one, from the
+//  baseline's cases if there is one already, otherwise the standard set.
+//
+//  lopass-bench-compare [options]
+//
+
+#include "LoPassBenchSuite.hpp"
+#include "LoPassToolOptions.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr double kDefaultThreshold       = 10.0;    // percent
+static constexpr unsigned kDefaultTrials        = 7;
+
+/// A slowdown must also be this many times the spread between the baseline's trials.
+static constexpr double kCompare_NoiseScale     = 1.5;
+
+static const char *const kBaselineDirectory     = "Baselines";
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-bench-compare [options]\n"
+            "\n"
+            "  -b, --baseline FILE      baseline report (default %s/CLASS.json for this machine)\n"
+            "  -c, --current FILE       compare this lopass-bench report rather than running\n"
+            "  -k, --kernel LIST        only these kernels\n"
+            "  -p, --threshold PERCENT  least slowdown that fails the gate (default %g)\n"
+            "  -T, --trials N           trials recorded by --update, and of a slower case before it\n"
+            "                           fails (default %u)\n"
+            "  -t, --time SECONDS       length of each run (default the baseline's)\n"
+            "  -n, --runs N             runs of each case (default the baseline's)\n"
+            "  -o, --output FILE        write this run's report to FILE\n"
+            "  -u, --update             record this run as the baseline instead of comparing\n"
+            "  -q, --quiet              only print the cases that changed\n",
+            kBaselineDirectory, kDefaultThreshold, kDefaultTrials);
+}
+
+static bool ParseKernels(const char *inText, std::vector<LoPassBenchKernel> &outKernels) {
+
+    std::string text = inText;
+    size_t start = 0;
+
+    outKernels.clear();
+
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) { comma = text.size(); }
+
+        LoPassBenchKernel kernel;
+        if (!LoPassBenchFindKernel(text.substr(start, comma - start).c_str(), kernel)) { return false; }
+        outKernels.push_back(kernel);
+
+        start = comma + 1;
+    }
+
+    return !outKernels.empty();
+}
+
+static bool WriteReport(const char                              *inPath,
+                        const LoPassBenchHost                   &inHost,
+                        const LoPassBenchOptions                &inOptions,
+                        const std::vector<LoPassBenchResult>    &inResults) {
+
+    FILE *file = fopen(inPath, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "lopass-bench-compare: can't write %s: %s\n", inPath, strerror(errno));
+        return false;
+    }
+
+    LoPassBenchWriteJSON(file, inHost, inOptions, inResults);
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "lopass-bench-compare: can't write %s: %s\n", inPath, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Comparison
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+enum Verdict {
+    kVerdict_Same,
+    kVerdict_Faster,
+    kVerdict_Regressed
+};
+
+struct Comparison {
+    double  mChange;        // fraction, positive is slower
+    double  mTolerance;     // fraction either way that isn't a change
+    Verdict mVerdict;
+};
+
+/// inNoiseFloor is the least noise the baseline's case is taken to have.
+static Comparison Compare(const LoPassBenchResult   &inBaseline,
+                          const LoPassBenchResult   &inCurrent,
+                          double                    inThreshold,
+                          double                    inNoiseFloor) {
+
+    Comparison comparison;
+
+    comparison.mChange = inBaseline.mNsPerSample > 0.0 ? inCurrent.mNsPerSample / inBaseline.mNsPerSample - 1.0 : 0.0;
+    comparison.mTolerance = std::max(inThreshold, kCompare_NoiseScale * std::max(inBaseline.mNoise, inNoiseFloor));
+
+    if (comparison.mChange > comparison.mTolerance) {
+        comparison.mVerdict = kVerdict_Regressed;
+    } else if (comparison.mChange < -comparison.mTolerance) {
+        comparison.mVerdict = kVerdict_Faster;
+    } else {
+        comparison.mVerdict = kVerdict_Same;
+    }
+
+    return comparison;
+}
+
+/// One result from several trials of a case: the median of their medians, with their
+/// spread as its noise, and all their runs.
+static LoPassBenchResult MergeTrials(const std::vector<LoPassBenchResult> &inTrials) {
+
+    LoPassBenchResult result = inTrials[0];
+    if (inTrials.size() == 1) { return result; }
+
+    std::vector<double> medians, cycles, counters[kNumberOfPerfCounters];
+    result.mRunNs.clear();
+
+    for (size_t t = 0; t < inTrials.size(); t++) {
+        medians.push_back(inTrials[t].mNsPerSample);
+        cycles.push_back(inTrials[t].mCyclesPerSample);
+        for (int i = 0; i < kNumberOfPerfCounters; i++) { counters[i].push_back(inTrials[t].mCounters[i]); }
+        result.mRunNs.insert(result.mRunNs.end(), inTrials[t].mRunNs.begin(), inTrials[t].mRunNs.end());
+    }
+
+    double mad;
+    LoPassBenchMedian(medians, result.mNsPerSample, mad);
+    LoPassBenchMedian(cycles, result.mCyclesPerSample, mad);
+    for (int i = 0; i < kNumberOfPerfCounters; i++) { LoPassBenchMedian(counters[i], result.mCounters[i], mad); }
+
+    std::vector<double> runs = result.mRunNs;
+    double median;
+    LoPassBenchMedian(runs, median, result.mNsPerSampleMAD);
+
+    // sorted by LoPassBenchMedian()
+    result.mNoise = result.mNsPerSample > 0.0 ? (medians.back() - medians.front()) / result.mNsPerSample : 0.0;
+    result.mSamplesPerSecond = result.mNsPerSample > 0.0 ? 1e9 / result.mNsPerSample : 0.0;
+
+    return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "baseline",       required_argument,  NULL, 'b' },
+        { "current",        required_argument,  NULL, 'c' },
+        { "kernel",         required_argument,  NULL, 'k' },
+        { "threshold",      required_argument,  NULL, 'p' },
+        { "trials",         required_argument,  NULL, 'T' },
+        { "time",           required_argument,  NULL, 't' },
+        { "runs",           required_argument,  NULL, 'n' },
+        { "output",         required_argument,  NULL, 'o' },
+        { "update",         no_argument,        NULL, 'u' },
+        { "quiet",          no_argument,        NULL, 'q' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+
+    std::string baselinePath;
+    const char *currentPath = NULL;
+    const char *outputPath  = NULL;
+    std::vector<LoPassBenchKernel> kernels;
+    double threshold    = kDefaultThreshold;
+    double trials       = kDefaultTrials;
+    double seconds      = 0.0;
+    double runs         = 0.0;
+    bool update         = false;
+    bool quiet          = false;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "b:c:k:p:T:t:n:o:uqh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'b': baselinePath = optarg; break;
+            case 'c': currentPath = optarg; break;
+            case 'k': ok = ParseKernels(optarg, kernels); break;
+            case 'p': ok = LoPassParseNumber(optarg, threshold) && threshold >= 0.0; break;
+            case 'T': ok = LoPassParseNumber(optarg, trials) && trials >= 1.0 && trials <= 100.0; break;
+            case 't': ok = LoPassParseNumber(optarg, seconds) && seconds > 0.0 && seconds <= 60.0; break;
+            case 'n': ok = LoPassParseNumber(optarg, runs) && runs >= 1.0 && runs <= 1000.0; break;
+            case 'o': outputPath = optarg; break;
+            case 'u': update = true; break;
+            case 'q': quiet = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-bench-compare: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc || (update && currentPath != NULL)) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    LoPassBenchHost host = LoPassBenchGetHost();
+
+    if (baselinePath.empty()) { baselinePath = std::string(kBaselineDirectory) + "/" + host.mClass + ".json"; }
+
+    LoPassBenchHost baselineHost;
+    LoPassBenchOptions options;
+    std::vector<LoPassBenchResult> baseline;
+    unsigned skipped = 0;
+    std::string error;
+
+    bool haveBaseline = LoPassBenchReadJSON(baselinePath.c_str(), baselineHost, options, baseline, skipped, error);
+
+    if (!haveBaseline && !update) {
+        fprintf(stderr, "lopass-bench-compare: %s\n", error.c_str());
+        fprintf(stderr, "lopass-bench-compare: no baseline for %s; record one with --update\n", host.mClass.c_str());
+        return 2;
+    }
+
+    if (haveBaseline && baselineHost.mClass != host.mClass && currentPath == NULL) {
+        fprintf(stderr, "lopass-bench-compare: warning: baseline is from %s, this is %s\n",
+                baselineHost.mClass.c_str(), host.mClass.c_str());
+    }
+
+    if (skipped > 0) {
+        fprintf(stderr, "lopass-bench-compare: warning: %u baseline cases this build can't run\n", skipped);
+    }
+
+    if (seconds > 0.0) { options.mSecondsPerRun = seconds; }
+    if (runs > 0.0) { options.mRuns = (unsigned)runs; }
+
+    // the cases to run: the baseline's, or for a first baseline the standard set
+    std::vector<LoPassBenchCase> cases;
+
+    if (haveBaseline) {
+        for (size_t n = 0; n < baseline.size(); n++) {
+            if (kernels.empty() || std::find(kernels.begin(), kernels.end(), baseline[n].mCase.mKernel) != kernels.end()) {
+                cases.push_back(baseline[n].mCase);
+            }
+        }
+    } else {
+        if (kernels.empty()) {
+            for (int i = 0; i < kNumberOfBenchKernels; i++) { kernels.push_back((LoPassBenchKernel)i); }
+        }
+        cases = LoPassBenchStandardCases(kernels);
+    }
+
+    std::vector<LoPassBenchResult> current;
+    std::vector<std::vector<LoPassBenchResult> > measured;  // each trial of each case, when we measure
+
+    if (currentPath != NULL) {
+
+        LoPassBenchOptions currentOptions;
+        if (!LoPassBenchReadJSON(currentPath, host, currentOptions, current, skipped, error)) {
+            fprintf(stderr, "lopass-bench-compare: %s\n", error.c_str());
+            return 2;
+        }
+
+    } else {
+
+        // a baseline is recorded over every trial, a comparison starts with one
+        unsigned count = update ? (unsigned)trials : 1;
+
+        if (!quiet) {
+            fprintf(stderr, "%s, %s: %zu cases of %u x %g s, %u %s\n", host.mCPU.c_str(), host.mClass.c_str(),
+                    cases.size(), options.mRuns, options.mSecondsPerRun, count, count == 1 ? "trial" : "trials");
+        }
+
+        measured.resize(cases.size());
+
+        for (unsigned t = 0; t < count; t++) {
+            std::vector<LoPassBenchResult> results = LoPassBenchRunInterleaved(cases, options);
+            for (size_t n = 0; n < cases.size(); n++) { measured[n].push_back(results[n]); }
+        }
+
+        for (size_t n = 0; n < cases.size(); n++) { current.push_back(MergeTrials(measured[n])); }
+
+        if (outputPath != NULL && !WriteReport(outputPath, host, options, current)) { return 2; }
+    }
+
+    if (update) {
+        if (!WriteReport(baselinePath.c_str(), host, options, current)) { return 2; }
+        printf("recorded %zu cases to %s\n", current.size(), baselinePath.c_str());
+        return 0;
+    }
+
+    // pair each case with its results; cases come from the baseline, so it has them all
+    std::vector<const LoPassBenchResult*> bases(cases.size(), NULL);
+    std::vector<LoPassBenchResult*> nows(cases.size(), NULL);
+    std::vector<Comparison> comparisons(cases.size());
+    unsigned suspects = 0;
+
+    // a case is taken to be at least as noisy as its kernel's cases typically are, since a
+    // handful of trials can happen to agree closely
+    double kernelNoise[kNumberOfBenchKernels];
+
+    for (int k = 0; k < kNumberOfBenchKernels; k++) {
+        std::vector<double> noise;
+        for (size_t b = 0; b < baseline.size(); b++) {
+            if (baseline[b].mCase.mKernel == k) { noise.push_back(baseline[b].mNoise); }
+        }
+        double mad;
+        LoPassBenchMedian(noise, kernelNoise[k], mad);
+    }
+
+    for (size_t n = 0; n < cases.size(); n++) {
+
+        std::string name = cases[n].GetName();
+
+        for (size_t b = 0; b < baseline.size() && bases[n] == NULL; b++) {
+            if (baseline[b].mCase.GetName() == name) { bases[n] = &baseline[b]; }
+        }
+        for (size_t c = 0; c < current.size() && nows[n] == NULL; c++) {
+            if (current[c].mCase.GetName() == name) { nows[n] = &current[c]; }
+        }
+
+        if (nows[n] != NULL) {
+            comparisons[n] = Compare(*bases[n], *nows[n], 0.01 * threshold, kernelNoise[cases[n].mKernel]);
+            if (comparisons[n].mVerdict == kVerdict_Regressed) { suspects++; }
+        }
+    }
+
+    // measure the regressions again, when we're the ones measuring, until the median of
+    // their trials is back within the tolerance or the trials run out. Each is a whole
+    // trial, every case interleaved as before, so the trials are as far apart as the
+    // baseline's were: a few runs of one case straight after each other would all land in
+    // the same stretch of load.
+    for (unsigned trial = 1; trial < (unsigned)trials && suspects > 0 && !measured.empty(); trial++) {
+
+        if (!quiet) { fprintf(stderr, "measuring again for %u cases\n", suspects); }
+
+        std::vector<LoPassBenchResult> again = LoPassBenchRunInterleaved(cases, options);
+        suspects = 0;
+
+        for (size_t n = 0; n < cases.size(); n++) {
+            if (nows[n] == NULL || comparisons[n].mVerdict != kVerdict_Regressed) { continue; }
+
+            measured[n].push_back(again[n]);
+            *nows[n] = MergeTrials(measured[n]);
+
+            comparisons[n] = Compare(*bases[n], *nows[n], 0.01 * threshold, kernelNoise[cases[n].mKernel]);
+            if (comparisons[n].mVerdict == kVerdict_Regressed) { suspects++; }
+        }
+    }
+
+    printf("%-44s %10s %10s %8s %9s %6s\n", "case", "baseline", "current", "change", "tolerance", "trials");
+
+    unsigned regressed = 0, faster = 0, missing = 0;
+
+    for (size_t n = 0; n < cases.size(); n++) {
+
+        std::string name = cases[n].GetName();
+
+        if (nows[n] == NULL) {
+            printf("%-44s %10.3f %10s\n", name.c_str(), bases[n]->mNsPerSample, "missing");
+            missing++;
+            continue;
+        }
+
+        const char *verdict = "";
+        switch (comparisons[n].mVerdict) {
+            case kVerdict_Regressed:    verdict = "REGRESSED"; regressed++; break;
+            case kVerdict_Faster:       verdict = "faster"; faster++; break;
+            default: break;
+        }
+
+        if (!quiet || comparisons[n].mVerdict != kVerdict_Same) {
+            printf("%-44s %10.3f %10.3f %+7.1f%% %8.1f%% %6zu  %s\n", name.c_str(), bases[n]->mNsPerSample, nows[n]->mNsPerSample,
+                   100.0 * comparisons[n].mChange, 100.0 * comparisons[n].mTolerance, measured.empty() ? (size_t)1 : measured[n].size(), verdict);
+        }
+    }
+
+    printf("\n%zu cases: %u regressed, %u faster, %u missing (threshold %g%%, or %g times the noise, up to %u trials)\n",
+           cases.size(), regressed, faster, missing, threshold, kCompare_NoiseScale, (unsigned)trials);
+
+    return regressed > 0 ? 1 : 0;
+}
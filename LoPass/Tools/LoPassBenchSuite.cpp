@@ -0,0 +1,1003 @@
+//
+//  LoPassBenchSuite.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassBenchSuite.hpp"
+#include "LoPassFilterBank.hpp"
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <math.h>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define LOPASS_BENCH_TSC    1
+#else
+    #define LOPASS_BENCH_TSC    0
+#endif
+
+#if defined(__APPLE__)
+    #include <sys/sysctl.h>
+#endif
+
+static const char *const kKernelNames[kNumberOfBenchKernels]            = { "filter", "biquad", "multirate", "linear-phase", "bank", "design" };
+static const char *const kAutomationNames[kNumberOfBenchAutomations]    = { "static", "block", "slice", "sample" };
+static const char *const kInputNames[kNumberOfBenchInputs]              = { "silence", "denormal", "noise" };
+
+const std::vector<unsigned> kBench_BlockSizes       = { 1, 16, 64, 256, 1024, 8192 };
+const std::vector<unsigned> kBench_ChannelCounts    = { 1, 2, 8, 16, 64 };
+
+/// The sweep the cutoff follows under automation, in Hz, and how far along it each change
+/// moves: a full sweep every few thousand changes.
+static constexpr double kBench_LowCutoff            = 200.0;
+static constexpr double kBench_HighCutoff           = 8000.0;
+static constexpr double kBench_SweepStep            = 0.002;
+
+/// Fraction of a run spent warming up first, and the fewest blocks in a run.
+static constexpr double kBench_WarmUp               = 0.1;
+static constexpr unsigned kBench_MinBlocks          = 4;
+
+typedef std::chrono::steady_clock Clock;
+
+const char *LoPassBenchKernelName(LoPassBenchKernel inKernel)               { return kKernelNames[inKernel]; }
+const char *LoPassBenchAutomationName(LoPassBenchAutomation inAutomation)   { return kAutomationNames[inAutomation]; }
+const char *LoPassBenchInputName(LoPassBenchInput inInput)                  { return kInputNames[inInput]; }
+
+template <class T>
+static bool FindName(const char *const *inNames, int inCount, const char *inName, T &outValue) {
+
+    for (int i = 0; i < inCount; i++) {
+        if (strcasecmp(inNames[i], inName) == 0) {
+            outValue = (T)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LoPassBenchFindKernel(const char *inName, LoPassBenchKernel &outKernel) {
+    return FindName(kKernelNames, kNumberOfBenchKernels, inName, outKernel);
+}
+
+bool LoPassBenchFindAutomation(const char *inName, LoPassBenchAutomation &outAutomation) {
+    return FindName(kAutomationNames, kNumberOfBenchAutomations, inName, outAutomation);
+}
+
+bool LoPassBenchFindInput(const char *inName, LoPassBenchInput &outInput) {
+    return FindName(kInputNames, kNumberOfBenchInputs, inName, outInput);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBenchCase::GetName()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+std::string LoPassBenchCase::GetName() const {
+
+    if (mKernel == kBenchKernel_Design) { return kKernelNames[mKernel]; }
+
+    char name[128];
+    snprintf(name, sizeof(name), "%s/%uf/%uch/%s/%s", kKernelNames[mKernel], mBlockSize, mChannels,
+             kAutomationNames[mAutomation], kInputNames[mInput]);
+    return name;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Case sets
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void AddCase(std::vector<LoPassBenchCase> &ioCases, const LoPassBenchCase &inCase) {
+
+    std::string name = inCase.GetName();
+    for (size_t i = 0; i < ioCases.size(); i++) {
+        if (ioCases[i].GetName() == name) { return; }
+    }
+    ioCases.push_back(inCase);
+}
+
+static LoPassBenchCase MakeCase(LoPassBenchKernel       inKernel,
+                                unsigned                inBlockSize,
+                                unsigned                inChannels,
+                                LoPassBenchAutomation   inAutomation,
+                                LoPassBenchInput        inInput) {
+
+    LoPassBenchCase benchCase = { inKernel, inBlockSize, inChannels, inAutomation, inInput };
+
+    if (inKernel == kBenchKernel_Design) {
+        benchCase.mBlockSize    = 1;
+        benchCase.mChannels     = 1;
+        benchCase.mAutomation   = kBenchAutomation_Sample;
+        benchCase.mInput        = kBenchInput_Silence;
+    }
+
+    return benchCase;
+}
+
+std::vector<LoPassBenchCase> LoPassBenchStandardCases(const std::vector<LoPassBenchKernel> &inKernels) {
+
+    std::vector<LoPassBenchCase> cases;
+
+    for (size_t k = 0; k < inKernels.size(); k++) {
+
+        LoPassBenchKernel kernel = inKernels[k];
+
+        for (int a = 0; a < kNumberOfBenchAutomations; a++) {
+            for (int i = 0; i < kNumberOfBenchInputs; i++) {
+                AddCase(cases, MakeCase(kernel, kBench_CentreBlockSize, kBench_CentreChannels, (LoPassBenchAutomation)a, (LoPassBenchInput)i));
+            }
+        }
+
+        for (size_t b = 0; b < kBench_BlockSizes.size(); b++) {
+            AddCase(cases, MakeCase(kernel, kBench_BlockSizes[b], kBench_CentreChannels, kBenchAutomation_Static, kBenchInput_Noise));
+        }
+
+        for (size_t c = 0; c < kBench_ChannelCounts.size(); c++) {
+            AddCase(cases, MakeCase(kernel, kBench_CentreBlockSize, kBench_ChannelCounts[c], kBenchAutomation_Static, kBenchInput_Noise));
+        }
+    }
+
+    return cases;
+}
+
+std::vector<LoPassBenchCase> LoPassBenchCrossCases(const std::vector<LoPassBenchKernel>        &inKernels,
+                                                   const std::vector<unsigned>                 &inBlockSizes,
+                                                   const std::vector<unsigned>                 &inChannels,
+                                                   const std::vector<LoPassBenchAutomation>    &inAutomations,
+                                                   const std::vector<LoPassBenchInput>         &inInputs) {
+
+    std::vector<LoPassBenchCase> cases;
+
+    for (size_t k = 0; k < inKernels.size(); k++) {
+        for (size_t b = 0; b < inBlockSizes.size(); b++) {
+            for (size_t c = 0; c < inChannels.size(); c++) {
+                for (size_t a = 0; a < inAutomations.size(); a++) {
+                    for (size_t i = 0; i < inInputs.size(); i++) {
+                        AddCase(cases, MakeCase(inKernels[k], inBlockSizes[b], inChannels[c], inAutomations[a], inInputs[i]));
+                    }
+                }
+            }
+        }
+    }
+
+    return cases;
+}
+
+LoPassBenchOptions::LoPassBenchOptions() : mSampleRate(48000.0),
+                                           mSecondsPerRun(0.02),
+                                           mRuns(5),
+                                           mCounters(false) {
+}
+
+LoPassBenchResult::LoPassBenchResult() : mNsPerSample(0.0),
+                                         mNsPerSampleMAD(0.0),
+                                         mNoise(0.0),
+                                         mCyclesPerSample(-1.0),
+                                         mSamplesPerSecond(0.0) {
+
+    LoPassBenchCase none = { kBenchKernel_Filter, kBench_CentreBlockSize, kBench_CentreChannels, kBenchAutomation_Static, kBenchInput_Noise };
+    mCase = none;
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) { mCounters[i] = -1.0; }
+}
+
+double LoPassBenchResult::GetIPC() const {
+
+    double instructions = mCounters[kPerfCounter_Instructions];
+    double cycles = mCounters[kPerfCounter_Cycles];
+    return instructions >= 0.0 && cycles > 0.0 ? instructions / cycles : -1.0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Kernels
+//
+// Each runs every channel over [inOffset, inOffset + inFrames) of the block, and takes a new
+// cutoff for all of them with SetCutoff(), through whatever path a parameter change takes
+// in it.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class BenchKernel {
+
+public:
+    virtual ~BenchKernel() { }
+
+    virtual void SetCutoff(double inCutoff) = 0;
+    virtual void Process(const float *const *inSources, float *const *outDests, unsigned inOffset, unsigned inFrames) = 0;
+};
+
+class ProcessorKernel : public BenchKernel {
+
+public:
+    ProcessorKernel(double inSampleRate, unsigned inChannels, LoPassBenchKernel inKernel) {
+
+        mSettings.mLinearPhase  = inKernel == kBenchKernel_LinearPhase;
+        mSettings.mMultirate    = inKernel == kBenchKernel_Multirate;
+
+        for (unsigned c = 0; c < inChannels; c++) {
+            mProcessors.emplace_back(new LoPassProcessor(inSampleRate));
+            if (mSettings.mLinearPhase) { mProcessors.back()->Prepare(mSettings); }
+        }
+    }
+
+    virtual void SetCutoff(double inCutoff) { mSettings.mCutoff = inCutoff; }
+
+    virtual void Process(const float *const *inSources, float *const *outDests, unsigned inOffset, unsigned inFrames) {
+        for (size_t c = 0; c < mProcessors.size(); c++) {
+            mProcessors[c]->Process(mSettings, inSources[c] + inOffset, outDests[c] + inOffset, inFrames);
+        }
+    }
+
+private:
+    LoPassSettings                                  mSettings;
+    std::vector<std::unique_ptr<LoPassProcessor> >  mProcessors;
+};
+
+class BiquadKernel : public BenchKernel {
+
+public:
+    BiquadKernel(double inSampleRate, unsigned inChannels) : mSampleRate(inSampleRate),
+                                                             mBiquads(inChannels) {
+        SetCutoff(kDefaultValue_LoPass_Frequency);
+    }
+
+    virtual void SetCutoff(double inCutoff) {
+        double freq, resonance;
+        LoPassNormaliseParameters(inCutoff, kDefaultValue_LoPass_Resonance, mSampleRate, freq, resonance);
+        LoPassFilter::CalculateLopassParams(freq, resonance, mCoefficients);
+    }
+
+    virtual void Process(const float *const *inSources, float *const *outDests, unsigned inOffset, unsigned inFrames) {
+        for (size_t c = 0; c < mBiquads.size(); c++) {
+            mBiquads[c].Process(mCoefficients, inSources[c] + inOffset, outDests[c] + inOffset, inFrames);
+        }
+    }
+
+private:
+    double                      mSampleRate;
+    std::vector<LoPassBiquad>   mBiquads;
+    LoPassCoefficients          mCoefficients;
+};
+
+class BankKernel : public BenchKernel {
+
+public:
+    BankKernel(double inSampleRate, unsigned inChannels) : mBank(inSampleRate) {
+        for (unsigned c = 0; c < inChannels; c++) { mBank.AddStream(kDefaultValue_LoPass_Frequency, kDefaultValue_LoPass_Resonance); }
+    }
+
+    virtual void SetCutoff(double inCutoff) {
+        for (unsigned s = 0; s < mBank.GetNumberOfStreams(); s++) { mBank.SetParameters(s, inCutoff, kDefaultValue_LoPass_Resonance); }
+    }
+
+    virtual void Process(const float *const *inSources, float *const *outDests, unsigned inOffset, unsigned inFrames) {
+        for (unsigned s = 0; s < mBank.GetNumberOfStreams(); s++) { mBank.Submit(s, inSources[s] + inOffset, outDests[s] + inOffset, inFrames); }
+        mBank.Run();
+    }
+
+private:
+    LoPassFilterBank mBank;
+};
+
+/// A design per frame, over a sweep fine enough that no two in a row are the same.
+class DesignKernel : public BenchKernel {
+
+public:
+    explicit DesignKernel(double inSampleRate) : mSampleRate(inSampleRate), mPhase(0.0), mSink(0.0) { }
+
+    virtual void SetCutoff(double) { }
+
+    virtual void Process(const float *const *, float *const *, unsigned, unsigned inFrames) {
+        for (unsigned i = 0; i < inFrames; i++) {
+            mPhase = mPhase < 1.0 ? mPhase + 1e-4 : 0.0;
+
+            double freq, resonance;
+            LoPassNormaliseParameters(kBench_LowCutoff + mPhase * (kBench_HighCutoff - kBench_LowCutoff),
+                                      kDefaultValue_LoPass_Resonance, mSampleRate, freq, resonance);
+
+            LoPassCoefficients coefficients;
+            LoPassFilter::CalculateLopassParams(freq, resonance, coefficients);
+            mSink += coefficients.mB1;
+        }
+    }
+
+    double GetSink() const { return mSink; }
+
+private:
+    double  mSampleRate;
+    double  mPhase;
+    double  mSink;      // so the designs can't be optimised away
+};
+
+static BenchKernel *NewKernel(const LoPassBenchCase &inCase, double inSampleRate) {
+
+    switch (inCase.mKernel) {
+        case kBenchKernel_Biquad:   return new BiquadKernel(inSampleRate, inCase.mChannels);
+        case kBenchKernel_Bank:     return new BankKernel(inSampleRate, inCase.mChannels);
+        case kBenchKernel_Design:   return new DesignKernel(inSampleRate);
+        default:                    return new ProcessorKernel(inSampleRate, inCase.mChannels, inCase.mKernel);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Input
+//
+// Denormal noise is full scale noise scaled down by 2^-140, so every sample is between the
+// smallest float denormal and the smallest normal float.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void FillInput(LoPassBenchInput inInput, uint32_t inSeed, std::vector<float> &outSamples) {
+
+    uint32_t noise = inSeed;
+    double scale = inInput == kBenchInput_Noise ? 1.0 : inInput == kBenchInput_Denormal ? ldexp(1.0, -140) : 0.0;
+
+    for (size_t i = 0; i < outSamples.size(); i++) {
+        noise = noise * 1664525u + 1013904223u;
+        outSamples[i] = (float)((int32_t)noise * (scale / 2147483648.0));
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Running
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct BenchState {
+    BenchKernel         *mKernel;
+    unsigned            mBlockSize;
+    unsigned            mStep;          // frames between cutoff changes; 0 for none
+    std::vector<float*> mInput;
+    std::vector<float*> mOutput;
+    double              mPhase;
+};
+
+static inline void RunBlock(BenchState &ioState) {
+
+    if (ioState.mStep == 0) {
+        ioState.mKernel->Process(&ioState.mInput[0], &ioState.mOutput[0], 0, ioState.mBlockSize);
+        return;
+    }
+
+    for (unsigned offset = 0; offset < ioState.mBlockSize; offset += ioState.mStep) {
+
+        ioState.mPhase += kBench_SweepStep;
+        if (ioState.mPhase >= 2.0 * M_PI) { ioState.mPhase -= 2.0 * M_PI; }
+
+        // evenly in octaves between the two ends
+        double position = 0.5 + 0.5 * sin(ioState.mPhase);
+        ioState.mKernel->SetCutoff(kBench_LowCutoff * pow(kBench_HighCutoff / kBench_LowCutoff, position));
+
+        unsigned frames = std::min(ioState.mStep, ioState.mBlockSize - offset);
+        ioState.mKernel->Process(&ioState.mInput[0], &ioState.mOutput[0], offset, frames);
+    }
+}
+
+static inline uint64_t ReadTimeStamp() {
+
+#if LOPASS_BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+void LoPassBenchMedian(std::vector<double> &ioValues, double &outMedian, double &outMAD) {
+
+    if (ioValues.empty()) {
+        outMedian = outMAD = 0.0;
+        return;
+    }
+
+    std::sort(ioValues.begin(), ioValues.end());
+    size_t n = ioValues.size();
+    outMedian = n % 2 ? ioValues[n / 2] : 0.5 * (ioValues[n / 2 - 1] + ioValues[n / 2]);
+
+    std::vector<double> deviations(n);
+    for (size_t i = 0; i < n; i++) { deviations[i] = fabs(ioValues[i] - outMedian); }
+
+    std::sort(deviations.begin(), deviations.end());
+    outMAD = n % 2 ? deviations[n / 2] : 0.5 * (deviations[n / 2 - 1] + deviations[n / 2]);
+}
+
+/// Per sample measurements of each run of a case; < 0 where there's no such measurement.
+struct RunSamples {
+    std::vector<double> mNs;
+    std::vector<double> mCycles;
+    std::vector<double> mCounters[kNumberOfPerfCounters];
+};
+
+static LoPassBenchResult Summarise(const LoPassBenchCase &inCase, RunSamples &ioSamples) {
+
+    LoPassBenchResult result;
+    result.mCase    = inCase;
+    result.mRunNs   = ioSamples.mNs;
+
+    double mad;
+    LoPassBenchMedian(ioSamples.mNs, result.mNsPerSample, result.mNsPerSampleMAD);
+    LoPassBenchMedian(ioSamples.mCycles, result.mCyclesPerSample, mad);
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) {
+        LoPassBenchMedian(ioSamples.mCounters[i], result.mCounters[i], mad);
+    }
+
+    result.mSamplesPerSecond = result.mNsPerSample > 0.0 ? 1e9 / result.mNsPerSample : 0.0;
+
+    return result;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBenchRun()
+//
+// The kernel is built once and warmed up, so the runs see it settled: designs made, the
+// linear phase filter prepared, the bank's groups placed. Each run then times whole blocks
+// until mSecondsPerRun has passed.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassBenchResult LoPassBenchRun(const LoPassBenchCase &inCase, const LoPassBenchOptions &inOptions) {
+
+    std::unique_ptr<BenchKernel> kernel(NewKernel(inCase, inOptions.mSampleRate));
+
+    std::vector<std::vector<float> > input(inCase.mChannels, std::vector<float>(inCase.mBlockSize));
+    std::vector<std::vector<float> > output(inCase.mChannels, std::vector<float>(inCase.mBlockSize));
+
+    BenchState state;
+    state.mKernel       = kernel.get();
+    state.mBlockSize    = inCase.mBlockSize;
+    state.mPhase        = 0.0;
+
+    switch (inCase.mAutomation) {
+        case kBenchAutomation_Block:    state.mStep = inCase.mBlockSize; break;
+        case kBenchAutomation_Slice:    state.mStep = kControlRate_MaxInterval; break;
+        case kBenchAutomation_Sample:   state.mStep = 1; break;
+        default:                        state.mStep = 0; break;
+    }
+
+    for (unsigned c = 0; c < inCase.mChannels; c++) {
+        FillInput(inCase.mInput, 1 + c, input[c]);
+        state.mInput.push_back(&input[c][0]);
+        state.mOutput.push_back(&output[c][0]);
+    }
+
+    const double samplesPerBlock = (double)inCase.mBlockSize * inCase.mChannels;
+
+    // warm up
+    Clock::time_point warmUpEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(kBench_WarmUp * inOptions.mSecondsPerRun));
+    unsigned warmUpBlocks = 0;
+    while (Clock::now() < warmUpEnd || warmUpBlocks < kBench_MinBlocks) {
+        RunBlock(state);
+        warmUpBlocks++;
+    }
+
+    LoPassPerfCounters counters;
+    if (inOptions.mCounters) { counters.Open(); }
+
+    RunSamples samples;
+
+    for (unsigned run = 0; run < inOptions.mRuns; run++) {
+
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(inOptions.mSecondsPerRun));
+        counters.Start();
+        uint64_t ticks = ReadTimeStamp();
+        uint64_t blocks = 0;
+
+        // the clock is only read every few blocks at small block sizes
+        unsigned check = inCase.mBlockSize * inCase.mChannels >= 256 ? 1 : 256 / (inCase.mBlockSize * inCase.mChannels);
+        Clock::time_point now = start;
+
+        while (now < end || blocks < kBench_MinBlocks) {
+            for (unsigned n = 0; n < check; n++) { RunBlock(state); }
+            blocks += check;
+            now = Clock::now();
+        }
+
+        ticks = ReadTimeStamp() - ticks;
+        counters.Stop();
+        double seconds = std::chrono::duration<double>(now - start).count();
+        double sampleCount = blocks * samplesPerBlock;
+
+        samples.mNs.push_back(1e9 * seconds / sampleCount);
+        samples.mCycles.push_back(LOPASS_BENCH_TSC ? ticks / sampleCount : -1.0);
+
+        for (int i = 0; i < kNumberOfPerfCounters; i++) {
+            double count = counters.Read((LoPassPerfCounter)i);
+            samples.mCounters[i].push_back(count >= 0.0 ? count / sampleCount : -1.0);
+        }
+    }
+
+    return Summarise(inCase, samples);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBenchRunInterleaved()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+std::vector<LoPassBenchResult> LoPassBenchRunInterleaved(const std::vector<LoPassBenchCase> &inCases, const LoPassBenchOptions &inOptions) {
+
+    LoPassBenchOptions single = inOptions;
+    single.mRuns = 1;
+
+    std::vector<RunSamples> samples(inCases.size());
+
+    for (unsigned run = 0; run < inOptions.mRuns; run++) {
+        for (size_t n = 0; n < inCases.size(); n++) {
+            LoPassBenchResult result = LoPassBenchRun(inCases[n], single);
+            samples[n].mNs.push_back(result.mRunNs[0]);
+            samples[n].mCycles.push_back(result.mCyclesPerSample);
+            for (int i = 0; i < kNumberOfPerfCounters; i++) { samples[n].mCounters[i].push_back(result.mCounters[i]); }
+        }
+    }
+
+    std::vector<LoPassBenchResult> results;
+    for (size_t n = 0; n < inCases.size(); n++) { results.push_back(Summarise(inCases[n], samples[n])); }
+
+    return results;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBenchGetHost()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static std::string GetCPUName() {
+
+#if defined(__APPLE__)
+    char name[256];
+    size_t size = sizeof(name);
+    if (sysctlbyname("machdep.cpu.brand_string", name, &size, NULL, 0) == 0) { return name; }
+#elif defined(__linux__)
+    FILE *file = fopen("/proc/cpuinfo", "r");
+    if (file != NULL) {
+        char line[512];
+        std::string name;
+        while (name.empty() && fgets(line, sizeof(line), file) != NULL) {
+            // "model name" on x86, "Model" or "CPU part" elsewhere
+            if (strncmp(line, "model name", 10) == 0 || strncmp(line, "Model", 5) == 0) {
+                const char *colon = strchr(line, ':');
+                if (colon != NULL) { name.assign(colon + 2, strcspn(colon + 2, "\n")); }
+            }
+        }
+        fclose(file);
+        if (!name.empty()) { return name; }
+    }
+#endif
+    return "unknown";
+}
+
+/// Lower case letters and digits, anything else one dash.
+static std::string MakeSlug(const std::string &inText) {
+
+    std::string slug;
+    for (size_t i = 0; i < inText.size(); i++) {
+        char c = inText[i];
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            slug += c;
+        } else if (c >= 'A' && c <= 'Z') {
+            slug += (char)(c - 'A' + 'a');
+        } else if (!slug.empty() && slug[slug.size() - 1] != '-') {
+            slug += '-';
+        }
+    }
+    while (!slug.empty() && slug[slug.size() - 1] == '-') { slug.erase(slug.size() - 1); }
+    return slug;
+}
+
+LoPassBenchHost LoPassBenchGetHost() {
+
+    LoPassBenchHost host;
+    host.mCPU               = GetCPUName();
+    host.mInstructionSet    = LoPassFilterBank::GetInstructionSet();
+    host.mCores             = std::thread::hardware_concurrency();
+
+#if defined(__x86_64__)
+    host.mArchitecture = "x86_64";
+#elif defined(__aarch64__)
+    host.mArchitecture = "arm64";
+#elif defined(__i386__)
+    host.mArchitecture = "x86";
+#else
+    host.mArchitecture = "other";
+#endif
+
+#if defined(__clang__)
+    host.mCompiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    host.mCompiler = std::string("gcc ") + __VERSION__;
+#else
+    host.mCompiler = "unknown";
+#endif
+
+    // the model without the clock speed, which varies within a family
+    std::string model = host.mCPU;
+    size_t at = model.find(" @ ");
+    if (at != std::string::npos) { model.erase(at); }
+
+    host.mClass = MakeSlug(host.mArchitecture + " " + host.mInstructionSet + " " + model);
+    return host;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBenchWriteJSON()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static std::string Quote(const std::string &inText) {
+
+    std::string quoted = "\"";
+    for (size_t i = 0; i < inText.size(); i++) {
+        unsigned char c = (unsigned char)inText[i];
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += (char)c;
+        } else if (c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += (char)c;
+        }
+    }
+    return quoted + "\"";
+}
+
+/// A measurement, or null where there's none.
+static void WriteNumber(FILE *inFile, const char *inFormat, double inValue) {
+
+    if (inValue >= 0.0) {
+        fprintf(inFile, inFormat, inValue);
+    } else {
+        fprintf(inFile, "null");
+    }
+}
+
+void LoPassBenchWriteJSON(FILE                                  *inFile,
+                          const LoPassBenchHost                 &inHost,
+                          const LoPassBenchOptions              &inOptions,
+                          const std::vector<LoPassBenchResult>  &inResults) {
+
+    fprintf(inFile, "{\n");
+    fprintf(inFile, "  \"suite\": \"lopass-bench\",\n");
+    fprintf(inFile, "  \"version\": 1,\n");
+    fprintf(inFile, "  \"host\": {\n");
+    fprintf(inFile, "    \"cpu\": %s,\n", Quote(inHost.mCPU).c_str());
+    fprintf(inFile, "    \"class\": %s,\n", Quote(inHost.mClass).c_str());
+    fprintf(inFile, "    \"architecture\": %s,\n", Quote(inHost.mArchitecture).c_str());
+    fprintf(inFile, "    \"instruction_set\": %s,\n", Quote(inHost.mInstructionSet).c_str());
+    fprintf(inFile, "    \"compiler\": %s,\n", Quote(inHost.mCompiler).c_str());
+    fprintf(inFile, "    \"cores\": %u\n", inHost.mCores);
+    fprintf(inFile, "  },\n");
+    fprintf(inFile, "  \"sample_rate\": %g,\n", inOptions.mSampleRate);
+    fprintf(inFile, "  \"seconds_per_run\": %g,\n", inOptions.mSecondsPerRun);
+    fprintf(inFile, "  \"runs\": %u,\n", inOptions.mRuns);
+    fprintf(inFile, "  \"counters\": %s,\n", inOptions.mCounters ? "true" : "false");
+    fprintf(inFile, "  \"cases\": [");
+
+    for (size_t n = 0; n < inResults.size(); n++) {
+
+        const LoPassBenchResult &result = inResults[n];
+        const LoPassBenchCase &benchCase = result.mCase;
+
+        fprintf(inFile, "%s\n    {\n", n == 0 ? "" : ",");
+        fprintf(inFile, "      \"name\": %s,\n", Quote(benchCase.GetName()).c_str());
+        fprintf(inFile, "      \"kernel\": \"%s\",\n", kKernelNames[benchCase.mKernel]);
+        fprintf(inFile, "      \"block_size\": %u,\n", benchCase.mBlockSize);
+        fprintf(inFile, "      \"channels\": %u,\n", benchCase.mChannels);
+        fprintf(inFile, "      \"automation\": \"%s\",\n", kAutomationNames[benchCase.mAutomation]);
+        fprintf(inFile, "      \"input\": \"%s\",\n", kInputNames[benchCase.mInput]);
+        fprintf(inFile, "      \"ns_per_sample\": %.4f,\n", result.mNsPerSample);
+        fprintf(inFile, "      \"ns_per_sample_mad\": %.4f,\n", result.mNsPerSampleMAD);
+        if (result.mNoise > 0.0) { fprintf(inFile, "      \"noise\": %.4f,\n", result.mNoise); }
+
+        fprintf(inFile, "      \"cycles_per_sample\": ");
+        WriteNumber(inFile, "%.3f", result.mCyclesPerSample);
+        fprintf(inFile, ",\n");
+
+        fprintf(inFile, "      \"samples_per_second\": %.0f,\n", result.mSamplesPerSecond);
+
+        if (inOptions.mCounters) {
+            // per sample, like the times
+            fprintf(inFile, "      \"counters\": {");
+            for (int i = 0; i < kNumberOfPerfCounters; i++) {
+                fprintf(inFile, "%s\"%s\": ", i == 0 ? "" : ", ", LoPassPerfCounterName((LoPassPerfCounter)i));
+                WriteNumber(inFile, "%.4f", result.mCounters[i]);
+            }
+            fprintf(inFile, ", \"ipc\": ");
+            WriteNumber(inFile, "%.3f", result.GetIPC());
+            fprintf(inFile, "},\n");
+        }
+        fprintf(inFile, "      \"runs_ns_per_sample\": [");
+        for (size_t r = 0; r < result.mRunNs.size(); r++) { fprintf(inFile, "%s%.4f", r == 0 ? "" : ", ", result.mRunNs[r]); }
+        fprintf(inFile, "]\n    }");
+    }
+
+    fprintf(inFile, "\n  ]\n}\n");
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Reading
+//
+// Enough of JSON for the reports: objects, arrays, strings, numbers, true, false and null.
+// Unicode escapes outside ASCII come back as '?', which only the host strings could have.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct JSONValue {
+    enum Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+    Type                                            mType;
+    double                                          mNumber;
+    std::string                                     mString;
+    std::vector<JSONValue>                          mElements;
+    std::vector<std::pair<std::string, JSONValue> > mMembers;
+
+    JSONValue() : mType(kNull), mNumber(0.0) { }
+
+    const JSONValue *Find(const char *inKey, Type inType) const {
+        for (size_t i = 0; i < mMembers.size(); i++) {
+            if (mMembers[i].first == inKey) { return mMembers[i].second.mType == inType ? &mMembers[i].second : NULL; }
+        }
+        return NULL;
+    }
+};
+
+class JSONParser {
+
+public:
+    explicit JSONParser(const std::string &inText) : mText(inText), mPosition(0) { }
+
+    bool Parse(JSONValue &outValue) {
+        if (!ParseValue(outValue, 0)) { return false; }
+        SkipSpace();
+        return mPosition == mText.size();
+    }
+
+    size_t GetPosition() const { return mPosition; }
+
+private:
+    static constexpr int kMaxDepth = 32;
+
+    void SkipSpace() {
+        while (mPosition < mText.size() && strchr(" \t\r\n", mText[mPosition]) != NULL) { mPosition++; }
+    }
+
+    bool Expect(char inCharacter) {
+        SkipSpace();
+        if (mPosition < mText.size() && mText[mPosition] == inCharacter) {
+            mPosition++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ParseLiteral(const char *inLiteral) {
+        size_t length = strlen(inLiteral);
+        if (mText.compare(mPosition, length, inLiteral) != 0) { return false; }
+        mPosition += length;
+        return true;
+    }
+
+    bool ParseString(std::string &outString) {
+        if (!Expect('"')) { return false; }
+        outString.clear();
+
+        while (mPosition < mText.size()) {
+            char c = mText[mPosition++];
+            if (c == '"') { return true; }
+            if (c != '\\') {
+                outString += c;
+                continue;
+            }
+            if (mPosition >= mText.size()) { return false; }
+
+            char escape = mText[mPosition++];
+            switch (escape) {
+                case 'b': outString += '\b'; break;
+                case 'f': outString += '\f'; break;
+                case 'n': outString += '\n'; break;
+                case 'r': outString += '\r'; break;
+                case 't': outString += '\t'; break;
+                case 'u': {
+                    if (mPosition + 4 > mText.size()) { return false; }
+                    unsigned long code = strtoul(mText.substr(mPosition, 4).c_str(), NULL, 16);
+                    outString += code < 0x80 ? (char)code : '?';
+                    mPosition += 4;
+                    break;
+                }
+                default: outString += escape; break;
+            }
+        }
+        return false;
+    }
+
+    bool ParseValue(JSONValue &outValue, int inDepth) {
+        if (inDepth > kMaxDepth) { return false; }
+        SkipSpace();
+        if (mPosition >= mText.size()) { return false; }
+
+        char c = mText[mPosition];
+
+        if (c == '{') {
+            mPosition++;
+            outValue.mType = JSONValue::kObject;
+            if (Expect('}')) { return true; }
+            do {
+                std::pair<std::string, JSONValue> member;
+                if (!ParseString(member.first) || !Expect(':') || !ParseValue(member.second, inDepth + 1)) { return false; }
+                outValue.mMembers.push_back(member);
+            } while (Expect(','));
+            return Expect('}');
+        }
+
+        if (c == '[') {
+            mPosition++;
+            outValue.mType = JSONValue::kArray;
+            if (Expect(']')) { return true; }
+            do {
+                outValue.mElements.push_back(JSONValue());
+                if (!ParseValue(outValue.mElements.back(), inDepth + 1)) { return false; }
+            } while (Expect(','));
+            return Expect(']');
+        }
+
+        if (c == '"') {
+            outValue.mType = JSONValue::kString;
+            return ParseString(outValue.mString);
+        }
+
+        if (c == 't' || c == 'f') {
+            outValue.mType = JSONValue::kBool;
+            outValue.mNumber = c == 't' ? 1.0 : 0.0;
+            return ParseLiteral(c == 't' ? "true" : "false");
+        }
+
+        if (c == 'n') {
+            outValue.mType = JSONValue::kNull;
+            return ParseLiteral("null");
+        }
+
+        const char *start = mText.c_str() + mPosition;
+        char *end;
+        outValue.mType = JSONValue::kNumber;
+        outValue.mNumber = strtod(start, &end);
+        mPosition += end - start;
+        return end != start;
+    }
+
+    const std::string   &mText;
+    size_t              mPosition;
+};
+
+static double GetNumber(const JSONValue &inObject, const char *inKey, double inDefault) {
+
+    const JSONValue *value = inObject.Find(inKey, JSONValue::kNumber);
+    return value != NULL ? value->mNumber : inDefault;
+}
+
+static std::string GetString(const JSONValue &inObject, const char *inKey) {
+
+    const JSONValue *value = inObject.Find(inKey, JSONValue::kString);
+    return value != NULL ? value->mString : std::string();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassBenchReadJSON()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassBenchReadJSON(const char                     *inPath,
+                         LoPassBenchHost                &outHost,
+                         LoPassBenchOptions             &outOptions,
+                         std::vector<LoPassBenchResult> &outResults,
+                         unsigned                       &outSkipped,
+                         std::string                    &outError) {
+
+    outResults.clear();
+    outSkipped = 0;
+
+    FILE *file = fopen(inPath, "r");
+    if (file == NULL) {
+        outError = std::string("can't open ") + inPath + ": " + strerror(errno);
+        return false;
+    }
+
+    std::string text;
+    char buffer[65536];
+    size_t bytes;
+    while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0) { text.append(buffer, bytes); }
+
+    bool failed = ferror(file) != 0;
+    fclose(file);
+
+    if (failed) {
+        outError = std::string("can't read ") + inPath;
+        return false;
+    }
+
+    JSONValue report;
+    JSONParser parser(text);
+
+    if (!parser.Parse(report) || report.mType != JSONValue::kObject) {
+        char position[32];
+        snprintf(position, sizeof(position), "%zu", parser.GetPosition());
+        outError = std::string(inPath) + ": bad JSON near byte " + position;
+        return false;
+    }
+
+    const JSONValue *cases = report.Find("cases", JSONValue::kArray);
+
+    if (GetString(report, "suite") != "lopass-bench" || cases == NULL) {
+        outError = std::string(inPath) + ": not a lopass-bench report";
+        return false;
+    }
+
+    if (GetNumber(report, "version", 0.0) != 1.0) {
+        outError = std::string(inPath) + ": unknown report version";
+        return false;
+    }
+
+    const JSONValue *host = report.Find("host", JSONValue::kObject);
+    if (host != NULL) {
+        outHost.mCPU            = GetString(*host, "cpu");
+        outHost.mClass          = GetString(*host, "class");
+        outHost.mArchitecture   = GetString(*host, "architecture");
+        outHost.mInstructionSet = GetString(*host, "instruction_set");
+        outHost.mCompiler       = GetString(*host, "compiler");
+        outHost.mCores          = (unsigned)GetNumber(*host, "cores", 0.0);
+    }
+
+    outOptions.mSampleRate      = GetNumber(report, "sample_rate", outOptions.mSampleRate);
+    outOptions.mSecondsPerRun   = GetNumber(report, "seconds_per_run", outOptions.mSecondsPerRun);
+    outOptions.mRuns            = (unsigned)GetNumber(report, "runs", outOptions.mRuns);
+
+    const JSONValue *counters = report.Find("counters", JSONValue::kBool);
+    outOptions.mCounters = counters != NULL && counters->mNumber != 0.0;
+
+    for (size_t n = 0; n < cases->mElements.size(); n++) {
+
+        const JSONValue &entry = cases->mElements[n];
+        LoPassBenchResult result;
+        LoPassBenchCase &benchCase = result.mCase;
+
+        if (entry.mType != JSONValue::kObject
+            || !LoPassBenchFindKernel(GetString(entry, "kernel").c_str(), benchCase.mKernel)
+            || !LoPassBenchFindAutomation(GetString(entry, "automation").c_str(), benchCase.mAutomation)
+            || !LoPassBenchFindInput(GetString(entry, "input").c_str(), benchCase.mInput)) {
+            outSkipped++;
+            continue;
+        }
+
+        benchCase.mBlockSize    = (unsigned)GetNumber(entry, "block_size", 0.0);
+        benchCase.mChannels     = (unsigned)GetNumber(entry, "channels", 0.0);
+
+        if (benchCase.mBlockSize < 1 || benchCase.mBlockSize > 65536 || benchCase.mChannels < 1 || benchCase.mChannels > 65536) {
+            outSkipped++;
+            continue;
+        }
+
+        result.mNsPerSample         = GetNumber(entry, "ns_per_sample", 0.0);
+        result.mNsPerSampleMAD      = GetNumber(entry, "ns_per_sample_mad", 0.0);
+        result.mNoise               = GetNumber(entry, "noise", 0.0);
+        result.mCyclesPerSample     = GetNumber(entry, "cycles_per_sample", -1.0);
+        result.mSamplesPerSecond    = GetNumber(entry, "samples_per_second", 0.0);
+
+        const JSONValue *caseCounters = entry.Find("counters", JSONValue::kObject);
+        if (caseCounters != NULL) {
+            for (int i = 0; i < kNumberOfPerfCounters; i++) {
+                result.mCounters[i] = GetNumber(*caseCounters, LoPassPerfCounterName((LoPassPerfCounter)i), -1.0);
+            }
+        }
+
+        const JSONValue *runs = entry.Find("runs_ns_per_sample", JSONValue::kArray);
+        if (runs != NULL) {
+            for (size_t r = 0; r < runs->mElements.size(); r++) {
+                if (runs->mElements[r].mType == JSONValue::kNumber) { result.mRunNs.push_back(runs->mElements[r].mNumber); }
+            }
+        }
+
+        outResults.push_back(result);
+    }
+
+    return true;
+}
@@ -0,0 +1,170 @@
+//
+//  LoPassBenchSuite.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  The microbenchmark cases behind lopass-bench, and their JSON report.
+//
+
+#ifndef LoPassBenchSuite_hpp
+#define LoPassBenchSuite_hpp
+
+#include "LoPassPerfCounters.hpp"
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Bench Suite
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A case is one kernel at one block size and channel count, with the cutoff automated at
+// some rate, over some kind of input. The kernels are what a channel of the effect can run:
+// LoPassProcessor in each of its modes, which is all LoPassKernel::Process() does, the bare
+// recursion, the filter bank, and LoPassFilter::CalculateLopassParams() alone.
+// Every channel has its own kernel, run one after another the way AUEffectBase runs the
+// kernels of a buffer, except the bank, which takes them all as streams.
+//
+// Automation moves the cutoff along a slow sweep, once per block, once per slice of
+// kControlRate_MaxInterval frames, or before every sample, each change going through the
+// kernel's own parameter path. The input is silence, full scale noise, or noise in the
+// float denormal range, as a tail decays into; a block is filtered over and over from the
+// same input, so the filter state settles into that range too.
+//
+// A run repeats the case for a fixed time and counts samples, a sample being one frame of
+// one channel, or one design for the design kernel. Each case is run several times and the
+// median is reported, with the median absolute deviation as its spread.
+
+enum LoPassBenchKernel {
+    kBenchKernel_Filter         = 0,    // LoPassProcessor, IIR mode
+    kBenchKernel_Biquad         = 1,    // LoPassBiquad alone
+    kBenchKernel_Multirate      = 2,    // LoPassProcessor, multirate mode
+    kBenchKernel_LinearPhase    = 3,    // LoPassProcessor, linear phase mode
+    kBenchKernel_Bank           = 4,    // LoPassFilterBank, a stream per channel
+    kBenchKernel_Design         = 5,    // LoPassFilter::CalculateLopassParams()
+    kNumberOfBenchKernels       = 6
+};
+
+enum LoPassBenchAutomation {
+    kBenchAutomation_Static     = 0,
+    kBenchAutomation_Block      = 1,
+    kBenchAutomation_Slice      = 2,
+    kBenchAutomation_Sample     = 3,
+    kNumberOfBenchAutomations   = 4
+};
+
+enum LoPassBenchInput {
+    kBenchInput_Silence         = 0,
+    kBenchInput_Denormal        = 1,
+    kBenchInput_Noise           = 2,
+    kNumberOfBenchInputs        = 3
+};
+
+const char *LoPassBenchKernelName(LoPassBenchKernel inKernel);
+const char *LoPassBenchAutomationName(LoPassBenchAutomation inAutomation);
+const char *LoPassBenchInputName(LoPassBenchInput inInput);
+
+/// By name; false if there's no such one.
+bool LoPassBenchFindKernel(const char *inName, LoPassBenchKernel &outKernel);
+bool LoPassBenchFindAutomation(const char *inName, LoPassBenchAutomation &outAutomation);
+bool LoPassBenchFindInput(const char *inName, LoPassBenchInput &outInput);
+
+struct LoPassBenchCase {
+    LoPassBenchKernel       mKernel;
+    unsigned                mBlockSize;
+    unsigned                mChannels;
+    LoPassBenchAutomation   mAutomation;
+    LoPassBenchInput        mInput;
+
+    /// kernel/frames/channels/automation/input, "filter/256f/2ch/static/noise"; the design
+    /// kernel, which has none of these, is just "design". Stable, so reports can be compared case by case.
+    std::string GetName() const;
+};
+
+/// The values each axis takes in the standard set, and where it sits while another is
+/// swept. --full in lopass-bench crosses them all.
+extern const std::vector<unsigned> kBench_BlockSizes;
+extern const std::vector<unsigned> kBench_ChannelCounts;
+static constexpr unsigned kBench_CentreBlockSize    = 256;
+static constexpr unsigned kBench_CentreChannels     = 2;
+
+/// Every kernel at the centre with each automation rate and input, then swept over block
+/// sizes and channel counts with the cutoff static and noise in.
+std::vector<LoPassBenchCase> LoPassBenchStandardCases(const std::vector<LoPassBenchKernel> &inKernels);
+
+/// Every combination of the values given; the design kernel appears once.
+std::vector<LoPassBenchCase> LoPassBenchCrossCases(const std::vector<LoPassBenchKernel>        &inKernels,
+                                                   const std::vector<unsigned>                 &inBlockSizes,
+                                                   const std::vector<unsigned>                 &inChannels,
+                                                   const std::vector<LoPassBenchAutomation>    &inAutomations,
+                                                   const std::vector<LoPassBenchInput>         &inInputs);
+
+struct LoPassBenchOptions {
+    double      mSampleRate;
+    double      mSecondsPerRun;
+    unsigned    mRuns;
+    bool        mCounters;          // read hardware counters around each run, where allowed
+
+    LoPassBenchOptions();
+};
+
+struct LoPassBenchResult {
+    LoPassBenchCase     mCase;
+    std::vector<double> mRunNs;             // ns per sample of each run, in order
+    double              mNsPerSample;       // median of the runs
+    double              mNsPerSampleMAD;    // median absolute deviation from it
+    double              mNoise;             // spread of the medians of separate trials, as a fraction of
+                                            // mNsPerSample; 0 when measured once
+    double              mCyclesPerSample;   // time stamp counter ticks; < 0 where there's none
+    double              mSamplesPerSecond;
+    double              mCounters[kNumberOfPerfCounters];   // per sample, median; < 0 where not read
+
+    LoPassBenchResult();
+
+    /// Instructions per core cycle, < 0 without both counters.
+    double GetIPC() const;
+};
+
+LoPassBenchResult LoPassBenchRun(const LoPassBenchCase &inCase, const LoPassBenchOptions &inOptions);
+
+/// Every case, a run of each in turn, mRuns times over, so the runs of a case are spread
+/// across the whole session and their spread takes in whatever drifts over it (clock
+/// speed, other load) and not only the noise between one run and the next. Each run builds
+/// and warms the kernel afresh. Slower than running the cases one by one, and what the
+/// baselines are measured with.
+std::vector<LoPassBenchResult> LoPassBenchRunInterleaved(const std::vector<LoPassBenchCase> &inCases, const LoPassBenchOptions &inOptions);
+
+/// What the numbers were measured on. mClass names a family of machines whose numbers can
+/// be compared: the architecture, the vector unit the filter bank picked, and the model.
+struct LoPassBenchHost {
+    std::string mCPU;
+    std::string mClass;
+    std::string mArchitecture;
+    std::string mInstructionSet;
+    std::string mCompiler;
+    unsigned    mCores;
+};
+
+LoPassBenchHost LoPassBenchGetHost();
+
+/// Median and median absolute deviation of inValues, which is reordered.
+void LoPassBenchMedian(std::vector<double> &ioValues, double &outMedian, double &outMAD);
+
+/// The whole report, see lopass-bench.
+void LoPassBenchWriteJSON(FILE                                  *inFile,
+                          const LoPassBenchHost                 &inHost,
+                          const LoPassBenchOptions              &inOptions,
+                          const std::vector<LoPassBenchResult>  &inResults);
+
+/// Reads back a report written by LoPassBenchWriteJSON(). Cases naming a kernel, automation
+/// or input this build doesn't have are left out and counted in outSkipped. False, with
+/// the reason in outError, if the file can't be read or isn't a report.
+bool LoPassBenchReadJSON(const char                     *inPath,
+                         LoPassBenchHost                &outHost,
+                         LoPassBenchOptions             &outOptions,
+                         std::vector<LoPassBenchResult> &outResults,
+                         unsigned                       &outSkipped,
+                         std::string                    &outError);
+
+#endif /* LoPassBenchSuite_hpp */
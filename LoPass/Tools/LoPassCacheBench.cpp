@@ -0,0 +1,259 @@
+//
+//  LoPassCacheBench.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Check and benchmark for the shared LoPassCoefficientCache.
+//
+//  make lopass-cache
+//
+//  First a session: a few hundred processors, each on one of the factory presets and some
+//  in multirate mode, render while the presets are changed under them, once with the cache
+//  off and once with it on. The outputs must match to the bit, and the hit and miss counts
+//  show how much designing was shared. Then preset recalls alone are timed with and without
+//  the cache. Last, a few threads design from a pool of settings bigger than the table, so
+//  entries are evicted and rewritten while others read them, and every design must still
+//  match LoPassFilter::CalculateLopassParams(). Build with -fsanitize=thread to check the
+//  table itself.
+//
+//  lopass-cache [instances] [threads]
+//
+
+#include "LoPassCoefficientCache.hpp"
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+static constexpr double kSampleRate         = 48000.0;
+static constexpr unsigned kDefaultInstances = 512;
+static constexpr unsigned kDefaultThreads   = 4;
+static constexpr unsigned kBlockSize        = 256;
+static constexpr unsigned kSessionBlocks    = 240;
+static constexpr unsigned kRecallRuns       = 50;
+static constexpr unsigned kStressSettings   = 4 * kCoefficientCache_Entries;
+static constexpr unsigned kStressDesigns    = 400000;   // per thread
+
+static uint32_t Random(uint32_t &ioSeed) {
+
+    ioSeed = ioSeed * 1664525u + 1013904223u;
+    return ioSeed >> 8;
+}
+
+static double GetSeconds() {
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void PrintStatistics(const char *inLabel) {
+
+    LoPassCoefficientCacheStatistics statistics = LoPassCoefficientCache::GetStatistics();
+    uint64_t lookups = statistics.mHits + statistics.mMisses;
+
+    printf("  %-10s %10llu hits %8llu misses %8llu evictions  (%.1f%% hit)\n", inLabel,
+           (unsigned long long)statistics.mHits, (unsigned long long)statistics.mMisses,
+           (unsigned long long)statistics.mEvictions, lookups ? 100.0 * statistics.mHits / lookups : 0.0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Session
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static LoPassSettings GetPresetSettings(unsigned inPreset, bool inMultirate) {
+
+    LoPassSettings settings;
+    settings.mCutoff    = kPresetValues[inPreset].mFrequency;
+    settings.mResonance = kPresetValues[inPreset].mResonance;
+    settings.mMultirate = inMultirate;
+    return settings;
+}
+
+/// Renders the session and returns every instance's output, one after another.
+static std::vector<float> RenderSession(unsigned inInstances) {
+
+    std::vector<std::unique_ptr<LoPassProcessor> > processors;
+    for (unsigned n = 0; n < inInstances; n++) { processors.emplace_back(new LoPassProcessor(kSampleRate)); }
+
+    std::vector<float> input(kBlockSize);
+    std::vector<float> output((size_t)inInstances * kSessionBlocks * kBlockSize);
+    uint32_t noise = 1;
+
+    for (unsigned block = 0; block < kSessionBlocks; block++) {
+
+        for (unsigned i = 0; i < kBlockSize; i++) {
+            input[i] = (float)((int32_t)(noise = noise * 1664525u + 1013904223u) * (0.5 / 2147483648.0));
+        }
+
+        // every 60 blocks the whole session moves to the next preset, smoothed
+        unsigned recall = block / 60;
+
+        for (unsigned n = 0; n < inInstances; n++) {
+            LoPassSettings settings = GetPresetSettings((n + recall) % kNumberOfPresets, n % 8 == 7);
+            float *out = &output[((size_t)n * kSessionBlocks + block) * kBlockSize];
+            processors[n]->Process(settings, &input[0], out, kBlockSize);
+        }
+    }
+
+    return output;
+}
+
+/// Returns false if the cache changed the output.
+static bool Session(unsigned inInstances) {
+
+    LoPassCoefficientCache::SetEnabled(false);
+    std::vector<float> reference = RenderSession(inInstances);
+
+    LoPassCoefficientCache::Clear();
+    LoPassCoefficientCache::SetEnabled(true);
+    std::vector<float> cached = RenderSession(inInstances);
+
+    bool same = memcmp(&reference[0], &cached[0], reference.size() * sizeof(float)) == 0;
+
+    printf("session: %u instances on %u presets, %u blocks of %u: %s\n",
+           inInstances, kNumberOfPresets, kSessionBlocks, kBlockSize, same ? "bit identical" : "MISMATCH");
+    PrintStatistics("cache");
+
+    return same;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Recall timing
+//
+// Each instance's smoother jumps straight to a preset, as on a recall with smoothing off,
+// so each SetTarget() is one design.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static double TimeRecalls(unsigned inInstances) {
+
+    std::vector<LoPassControlRate> controls(inInstances, LoPassControlRate(kSampleRate));
+    double best = 1e9;
+
+    for (unsigned run = 0; run < kRecallRuns; run++) {
+
+        double start = GetSeconds();
+        for (unsigned n = 0; n < inInstances; n++) {
+            const LoPassPresetValues &preset = kPresetValues[(n + run) % kNumberOfPresets];
+            double freq, resonance;
+            LoPassNormaliseParameters(preset.mFrequency, preset.mResonance, kSampleRate, freq, resonance);
+            controls[n].SetTarget(freq, resonance);
+        }
+        double seconds = GetSeconds() - start;
+        best = seconds < best ? seconds : best;
+    }
+
+    return best / inInstances;
+}
+
+static void Recalls(unsigned inInstances) {
+
+    LoPassCoefficientCache::SetEnabled(false);
+    double uncached = TimeRecalls(inInstances);
+
+    LoPassCoefficientCache::Clear();
+    LoPassCoefficientCache::SetEnabled(true);
+    double cached = TimeRecalls(inInstances);
+
+    printf("\nrecall: %u instances\n", inInstances);
+    printf("%-26s %12s\n", "", "ns/design");
+    printf("%-26s %12.1f\n", "designed every time", 1e9 * uncached);
+    printf("%-26s %12.1f\n", "through the cache", 1e9 * cached);
+    PrintStatistics("cache");
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Stress
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Setting {
+    double              mSampleRate;
+    double              mFreq;
+    double              mResonance;
+    LoPassDesignMode    mMode;
+    LoPassCoefficients  mCoefficients;
+};
+
+static void StressThread(const std::vector<Setting> &inSettings, uint32_t inSeed, unsigned *outMismatches) {
+
+    uint32_t seed = inSeed;
+    unsigned mismatches = 0;
+
+    for (unsigned n = 0; n < kStressDesigns; n++) {
+        // a few settings much more often than the rest, as in a real session
+        unsigned pick = Random(seed);
+        const Setting &setting = inSettings[pick % 4 == 0 ? pick % 16 : pick % inSettings.size()];
+
+        LoPassCoefficients coefficients;
+        LoPassCoefficientCache::Design(setting.mSampleRate, setting.mFreq, setting.mResonance, setting.mMode, coefficients);
+
+        if (memcmp(&coefficients, &setting.mCoefficients, sizeof(coefficients)) != 0) { mismatches++; }
+    }
+
+    *outMismatches = mismatches;
+}
+
+/// Returns false on any wrong design.
+static bool Stress(unsigned inThreads) {
+
+    static const double kSampleRates[] = { 44100.0, 48000.0, 96000.0 };
+
+    std::vector<Setting> settings(kStressSettings);
+    uint32_t seed = 7;
+
+    for (unsigned n = 0; n < kStressSettings; n++) {
+        Setting &setting = settings[n];
+        setting.mSampleRate = kSampleRates[Random(seed) % 3];
+        setting.mFreq       = (1 + Random(seed) % 100000) / 100001.0;
+        setting.mResonance  = kMinimumValue_LoPass_Resonance + (Random(seed) % 1000) * (kMaximumValue_LoPass_Resonance - kMinimumValue_LoPass_Resonance) / 1000.0;
+        setting.mMode       = (LoPassDesignMode)(Random(seed) % kNumberOfLoPassDesignModes);
+        LoPassFilter::CalculateLopassParams(setting.mFreq, setting.mResonance, setting.mCoefficients);
+    }
+
+    LoPassCoefficientCache::Clear();
+    LoPassCoefficientCache::SetEnabled(true);
+
+    std::vector<unsigned> mismatches(inThreads);
+    std::vector<std::thread> threads;
+
+    double start = GetSeconds();
+    for (unsigned t = 0; t < inThreads; t++) { threads.emplace_back(StressThread, std::cref(settings), 100 + t, &mismatches[t]); }
+    for (unsigned t = 0; t < inThreads; t++) { threads[t].join(); }
+    double seconds = GetSeconds() - start;
+
+    unsigned total = 0;
+    for (unsigned t = 0; t < inThreads; t++) { total += mismatches[t]; }
+
+    printf("\nstress: %u threads, %u designs each over %u settings in %.2f s: %s\n",
+           inThreads, kStressDesigns, kStressSettings, seconds, total == 0 ? "all exact" : "MISMATCH");
+    PrintStatistics("cache");
+    if (total != 0) { printf("  %u designs wrong\n", total); }
+
+    return total == 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, const char *argv[]) {
+
+    unsigned instances  = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : kDefaultInstances;
+    unsigned threads    = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : kDefaultThreads;
+
+    if (instances == 0 || threads == 0) {
+        fprintf(stderr, "usage: lopass-cache [instances] [threads]\n");
+        return 2;
+    }
+
+    bool ok = Session(instances);
+    Recalls(instances);
+    ok = Stress(threads) && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,477 @@
+//
+//  LoPassDeadlineSim.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Render deadline simulator: a host audio thread calling the effect once per buffer period,
+//  with every render timed against its deadline.
+//
+//  make lopass-deadline
+//
+//  The audio thread sleeps until an absolute wake time each period, as a host's IO thread
+//  waits on the device, renders a LoPassProcessor per channel, and records when it woke
+//  and how long the render took. It asks for SCHED_FIFO (the usual priority of an audio
+//  thread, above LoPassWorkerPool's workers) and says whether it got it. A render whose
+//  wake-up lateness plus its own time passes the end of its period is an xrun: the device
+//  would have played silence or garbage. The thread then skips the periods it missed, as a
+//  host does, and those count as dropped buffers.
+//
+//  --load starts threads that keep the other cores busy while it runs: cpu spins on
+//  arithmetic, memory streams over a buffer bigger than the last level cache, so the audio
+//  thread loses its cache and shares the memory bus. By default one per core but the one
+//  the audio thread is on; none on a single core machine.
+//
+//  Each configuration, every channel count given with automation off and on, runs for
+//  --seconds. Automation moves the cutoff every buffer, as a host playing back an automation
+//  lane does, so the smoothing and the coefficient updates run all the time. For each it
+//  prints the xruns, the wake-up jitter and render time at the median, 99th, 99.9th
+//  percentile and worst, the worst case latency from the wake time to the end of the
+//  render, and a histogram of that latency as a share of the period, since averages hide
+//  exactly the spikes that cause dropouts.
+//
+//  lopass-deadline [options]
+//
+
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include "LoPassToolOptions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+static constexpr unsigned kDefaultFrames        = 128;
+static constexpr double kDefaultSampleRate      = 48000.0;
+static constexpr double kDefaultSeconds         = 5.0;
+static const unsigned kDefaultChannels[]        = { 2, 8, 32 };
+
+/// A load thread's memory buffer, to be well past any last level cache.
+static constexpr size_t kLoadMemoryBytes        = 256 << 20;
+
+/// Latency histogram bins, in tenths of the period; the last is everything past it.
+static constexpr unsigned kHistogramBins        = 11;
+static constexpr unsigned kHistogramWidth       = 50;
+
+/// The automation lane: a sweep between these cutoffs, once every few seconds.
+static constexpr double kAutomationLow          = 200.0;
+static constexpr double kAutomationHigh         = 8000.0;
+static constexpr double kAutomationSeconds      = 3.0;
+
+enum LoadKind {
+    kLoad_CPU       = 0,
+    kLoad_Memory    = 1
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Time
+//
+// Nanoseconds on the monotonic clock. On Linux the audio thread waits with
+// clock_nanosleep() on an absolute time, so a late wake-up doesn't push every later one
+// back.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void SleepUntil(int64_t inTime) {
+
+#if defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC on Linux
+    struct timespec time;
+    time.tv_sec = inTime / 1000000000;
+    time.tv_nsec = inTime % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, NULL) == EINTR) { }
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(inTime)));
+#endif
+}
+
+static bool SetRealtime(pthread_t inThread, int inOffset) {
+
+    sched_param param;
+    param.sched_priority = std::min(sched_get_priority_min(SCHED_FIFO) + inOffset, sched_get_priority_max(SCHED_FIFO));
+    return pthread_setschedparam(inThread, SCHED_FIFO, &param) == 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Load
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Load {
+
+public:
+    Load(LoadKind inKind, unsigned inThreads, int inAvoidCore) : mStop(false), mSink(0.0) {
+        for (unsigned n = 0; n < inThreads; n++) {
+            mThreads.push_back(std::thread(inKind == kLoad_Memory ? &Load::Stream : &Load::Spin, this));
+#if defined(__linux__)
+            // anywhere but the audio thread's core, if there's anywhere else
+            cpu_set_t cores;
+            CPU_ZERO(&cores);
+            unsigned count = std::thread::hardware_concurrency();
+            for (unsigned c = 0; c < count; c++) {
+                if ((int)c != inAvoidCore || count == 1) { CPU_SET(c, &cores); }
+            }
+            pthread_setaffinity_np(mThreads.back().native_handle(), sizeof(cores), &cores);
+#else
+            (void)inAvoidCore;
+#endif
+        }
+    }
+
+    ~Load() {
+        mStop = true;
+        for (size_t n = 0; n < mThreads.size(); n++) { mThreads[n].join(); }
+    }
+
+private:
+    void Spin() {
+        double x = 1.0;
+        while (!mStop.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < 4096; i++) { x = x * 1.0000001 + 1e-9; }
+        }
+        mSink = x;
+    }
+
+    void Stream() {
+        std::vector<uint64_t> memory(kLoadMemoryBytes / sizeof(uint64_t), 1);
+        uint64_t sum = 0;
+        while (!mStop.load(std::memory_order_relaxed)) {
+            // a read and a write per cache line
+            for (size_t i = 0; i < memory.size() && !mStop.load(std::memory_order_relaxed); i += 8) {
+                sum += memory[i];
+                memory[i] = sum;
+            }
+        }
+        mSink = (double)sum;
+    }
+
+    std::vector<std::thread>    mThreads;
+    std::atomic<bool>           mStop;
+    volatile double             mSink;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Simulation
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Configuration {
+    unsigned        mChannels;
+    bool            mAutomation;
+    LoPassSettings  mSettings;
+};
+
+struct Options {
+    unsigned    mFrames;
+    double      mSampleRate;
+    double      mSeconds;
+    bool        mRealtime;
+    int         mCore;          // < 0 for wherever the scheduler likes
+};
+
+/// Per period, in nanoseconds.
+struct Record {
+    int64_t mLateness;          // woke this long after the period started
+    int64_t mRender;
+    bool    mXrun;
+};
+
+struct Outcome {
+    std::vector<Record> mRecords;
+    uint64_t            mDropped;   // periods skipped after an xrun
+    bool                mRealtime;
+};
+
+static void Simulate(const Configuration &inConfiguration, const Options &inOptions, Outcome &outOutcome) {
+
+    const unsigned frames = inOptions.mFrames;
+    const int64_t period = (int64_t)llround(1e9 * frames / inOptions.mSampleRate);
+    const uint64_t periods = (uint64_t)(inOptions.mSeconds * 1e9 / period);
+
+    outOutcome.mRealtime = inOptions.mRealtime && SetRealtime(pthread_self(), 70);
+    outOutcome.mDropped = 0;
+    outOutcome.mRecords.clear();
+    outOutcome.mRecords.reserve(periods);
+
+#if defined(__linux__)
+    if (inOptions.mCore >= 0) {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        CPU_SET(inOptions.mCore, &cores);
+        pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+    }
+#endif
+
+    // everything allocated before the first period, as it would be in a host
+    std::vector<std::unique_ptr<LoPassProcessor> > processors;
+    std::vector<float> input((size_t)inConfiguration.mChannels * frames);
+    std::vector<float> output(input.size());
+    uint32_t noise = 1;
+
+    for (unsigned c = 0; c < inConfiguration.mChannels; c++) {
+        processors.emplace_back(new LoPassProcessor(inOptions.mSampleRate));
+        processors.back()->Prepare(inConfiguration.mSettings);
+    }
+
+    LoPassSettings settings = inConfiguration.mSettings;
+    const double sweepStep = 2.0 * M_PI * frames / (kAutomationSeconds * inOptions.mSampleRate);
+    double phase = 0.0;
+
+    int64_t start = Now() + period;
+
+    for (uint64_t p = 0; p < periods; p++) {
+
+        // the device's buffer: fresh input, as a driver would have copied in
+        for (size_t i = 0; i < input.size(); i++) {
+            input[i] = (float)((int32_t)(noise = noise * 1664525u + 1013904223u) * (0.5 / 2147483648.0));
+        }
+
+        SleepUntil(start);
+        int64_t woke = Now();
+
+        if (inConfiguration.mAutomation) {
+            phase += sweepStep;
+            settings.mCutoff = kAutomationLow * pow(kAutomationHigh / kAutomationLow, 0.5 + 0.5 * sin(phase));
+        }
+
+        for (unsigned c = 0; c < inConfiguration.mChannels; c++) {
+            processors[c]->Process(settings, &input[(size_t)c * frames], &output[(size_t)c * frames], frames);
+        }
+
+        int64_t done = Now();
+
+        Record record;
+        record.mLateness    = woke - start;
+        record.mRender      = done - woke;
+        record.mXrun        = done > start + period;
+        outOutcome.mRecords.push_back(record);
+
+        // after an xrun the host picks up at the next period still ahead of it
+        start += period;
+        if (done > start) {
+            uint64_t skipped = (uint64_t)((done - start) / period) + 1;
+            start += (int64_t)skipped * period;
+            outOutcome.mDropped += skipped;
+            p += skipped;
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Report
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static double Percentile(const std::vector<int64_t> &inSorted, double inFraction) {
+
+    size_t index = (size_t)ceil(inFraction * inSorted.size());
+    return 1e-3 * inSorted[std::min(inSorted.size(), std::max<size_t>(index, 1)) - 1];
+}
+
+static void PrintDistribution(const char *inName, std::vector<int64_t> &ioValues) {
+
+    std::sort(ioValues.begin(), ioValues.end());
+    printf("  %-10s median %8.1f   p99 %8.1f   p99.9 %8.1f   worst %8.1f us\n", inName,
+           Percentile(ioValues, 0.5), Percentile(ioValues, 0.99), Percentile(ioValues, 0.999), 1e-3 * ioValues.back());
+}
+
+static void Report(const Configuration &inConfiguration, const Options &inOptions, const Outcome &inOutcome) {
+
+    const std::vector<Record> &records = inOutcome.mRecords;
+    const double period = 1e9 * inOptions.mFrames / inOptions.mSampleRate;
+
+    std::vector<int64_t> lateness, render, latency;
+    uint64_t histogram[kHistogramBins] = { 0 };
+    uint64_t xruns = 0;
+
+    for (size_t n = 0; n < records.size(); n++) {
+        lateness.push_back(records[n].mLateness);
+        render.push_back(records[n].mRender);
+        latency.push_back(records[n].mLateness + records[n].mRender);
+
+        unsigned bin = (unsigned)(10.0 * latency.back() / period);
+        histogram[std::min(bin, kHistogramBins - 1)]++;
+        if (records[n].mXrun) { xruns++; }
+    }
+
+    printf("\n%u channels, automation %s: %zu buffers, %llu xruns, %llu dropped%s\n", inConfiguration.mChannels,
+           inConfiguration.mAutomation ? "on" : "off", records.size(), (unsigned long long)xruns,
+           (unsigned long long)inOutcome.mDropped, inOutcome.mRealtime ? "" : " (not realtime)");
+
+    if (records.empty()) { return; }
+
+    PrintDistribution("wake-up", lateness);
+    PrintDistribution("render", render);
+    PrintDistribution("latency", latency);
+
+    // a log scale bar, so the rare bins still show
+    uint64_t most = *std::max_element(histogram, histogram + kHistogramBins);
+
+    for (unsigned b = 0; b < kHistogramBins; b++) {
+        char label[16];
+        if (b + 1 < kHistogramBins) {
+            snprintf(label, sizeof(label), "%3u-%3u%%", 10 * b, 10 * (b + 1));
+        } else {
+            snprintf(label, sizeof(label), "   >100%%");
+        }
+
+        unsigned width = histogram[b] == 0 ? 0 : 1 + (unsigned)((kHistogramWidth - 1) * log((double)histogram[b]) / log((double)std::max<uint64_t>(most, 2)));
+        printf("  %s %10llu %s\n", label, (unsigned long long)histogram[b], std::string(width, '#').c_str());
+    }
+}
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-deadline [options]\n"
+            "\n"
+            "  -f, --frames N           buffer size (default %u)\n"
+            "  -r, --rate HZ            sample rate (default %g)\n"
+            "  -c, --channels LIST      channel counts (default 2,8,32)\n"
+            "  -a, --automation MODE    off, on or both (default both)\n"
+            "  -s, --seconds S          length of each run (default %g)\n"
+            "  -L, --load N             background load threads (default one per other core)\n"
+            "  -k, --load-kind KIND     cpu or memory (default memory)\n"
+            "  -p, --pin CORE           run the audio thread on this core\n"
+            "  -n, --no-realtime        don't ask for SCHED_FIFO\n"
+            "  -l, --linear-phase       linear phase mode\n"
+            "  -m, --multirate          multirate mode\n",
+            kDefaultFrames, kDefaultSampleRate, kDefaultSeconds);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "frames",         required_argument,  NULL, 'f' },
+        { "rate",           required_argument,  NULL, 'r' },
+        { "channels",       required_argument,  NULL, 'c' },
+        { "automation",     required_argument,  NULL, 'a' },
+        { "seconds",        required_argument,  NULL, 's' },
+        { "load",           required_argument,  NULL, 'L' },
+        { "load-kind",      required_argument,  NULL, 'k' },
+        { "pin",            required_argument,  NULL, 'p' },
+        { "no-realtime",    no_argument,        NULL, 'n' },
+        { "linear-phase",   no_argument,        NULL, 'l' },
+        { "multirate",      no_argument,        NULL, 'm' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+
+    Options options;
+    options.mFrames     = kDefaultFrames;
+    options.mSampleRate = kDefaultSampleRate;
+    options.mSeconds    = kDefaultSeconds;
+    options.mRealtime   = true;
+    options.mCore       = -1;
+
+    std::vector<unsigned> channels(kDefaultChannels, kDefaultChannels + sizeof(kDefaultChannels) / sizeof(kDefaultChannels[0]));
+    std::vector<bool> automation = { false, true };
+    LoPassSettings settings;
+    LoadKind loadKind = kLoad_Memory;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    double loadThreads = cores - 1;
+    double value;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "f:r:c:a:s:L:k:p:nlmh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'f': ok = LoPassParseNumber(optarg, value) && value >= 1.0 && value <= 65536.0; options.mFrames = (unsigned)value; break;
+            case 'r': ok = LoPassParseNumber(optarg, options.mSampleRate) && options.mSampleRate >= 8000.0 && options.mSampleRate <= 768000.0; break;
+            case 's': ok = LoPassParseNumber(optarg, options.mSeconds) && options.mSeconds > 0.0 && options.mSeconds <= 3600.0; break;
+            case 'L': ok = LoPassParseNumber(optarg, loadThreads) && loadThreads >= 0.0 && loadThreads <= 1024.0; break;
+            case 'p': ok = LoPassParseNumber(optarg, value) && value >= 0.0 && value < cores; options.mCore = (int)value; break;
+            case 'n': options.mRealtime = false; break;
+            case 'l': settings.mLinearPhase = true; break;
+            case 'm': settings.mMultirate = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+
+            case 'c': {
+                channels.clear();
+                for (const char *p = optarg; ok; ) {
+                    char *end;
+                    long count = strtol(p, &end, 10);
+                    ok = end != p && count >= 1 && count <= 1024 && (*end == '\0' || *end == ',');
+                    if (ok) { channels.push_back((unsigned)count); }
+                    if (*end != ',') { break; }
+                    p = end + 1;
+                }
+                break;
+            }
+
+            case 'a':
+                if (strcmp(optarg, "off") == 0) {
+                    automation = { false };
+                } else if (strcmp(optarg, "on") == 0) {
+                    automation = { true };
+                } else {
+                    ok = strcmp(optarg, "both") == 0;
+                }
+                break;
+
+            case 'k':
+                ok = strcmp(optarg, "cpu") == 0 || strcmp(optarg, "memory") == 0;
+                loadKind = strcmp(optarg, "cpu") == 0 ? kLoad_CPU : kLoad_Memory;
+                break;
+
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-deadline: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    printf("%u frames at %g Hz, a %.0f us period%s%s; %u %s load threads on %u cores\n", options.mFrames, options.mSampleRate,
+           1e6 * options.mFrames / options.mSampleRate, settings.mLinearPhase ? ", linear phase" : "",
+           settings.mMultirate ? ", multirate" : "", (unsigned)loadThreads, loadKind == kLoad_CPU ? "cpu" : "memory", cores);
+
+    Load load(loadKind, (unsigned)loadThreads, options.mCore);
+    bool refused = false;
+
+    for (size_t c = 0; c < channels.size(); c++) {
+        for (size_t a = 0; a < automation.size(); a++) {
+
+            Configuration configuration = { channels[c], automation[a], settings };
+            Outcome outcome;
+
+            // a thread of its own for each run, so its priority starts clean
+            std::thread audio(Simulate, std::cref(configuration), std::cref(options), std::ref(outcome));
+            audio.join();
+
+            if (options.mRealtime && !outcome.mRealtime) { refused = true; }
+            Report(configuration, options, outcome);
+        }
+    }
+
+    if (refused) { fprintf(stderr, "\nlopass-deadline: SCHED_FIFO refused (needs CAP_SYS_NICE or an rtprio limit); ran at normal priority\n"); }
+
+    return 0;
+}
@@ -0,0 +1,468 @@
+//
+//  LoPassDensityBench.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Instance density: how many instances of the effect one core renders within the buffer
+//  period, at 64, 128 and 256 frames and 48 and 96 kHz.
+//
+//  make lopass-density
+//
+//  Each instance is what AUEffectBase::Render() runs for LoPassUnit, without CoreAudio: its
+//  own input and output buffers, an indexed parameter table read through a virtual call as
+//  AUElement's is, and a LoPassProcessor per channel, each reading the settings afresh the
+//  way LoPassKernel::Process() does. The host graph renders the instances one after another
+//  on one thread, each over its own track, writing fresh input into every track before each
+//  buffer as the nodes upstream would. A trial renders N instances for --buffers buffers and
+//  takes the 99.9th percentile of the time each buffer took; N is doubled until that misses
+//  the deadline and then bisected to within a percent or so. The deadline is the buffer
+//  period, or --budget percent of it, to leave headroom for the rest of the graph. Buffers
+//  are rendered back to back unless --paced, which sleeps until the next period the way a
+//  host's audio thread does and so pays for caches gone cold in between, at the cost of
+//  running in real time.
+//
+//  Then the cost of one instance is fitted to a + b * frames over block sizes from 16 to
+//  1024 frames: a is the fixed overhead of a render, whatever its length, and b over the
+//  channel count the cost per sample. The maximum N at a block size is about the period
+//  over a + b * frames, so this says whether smaller buffers are paying for the overhead or
+//  the filtering. Runs at realtime priority when it's allowed.
+//
+//  lopass-density [options]
+//
+
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include "LoPassToolOptions.hpp"
+#include <algorithm>
+#include <chrono>
+#include <getopt.h>
+#include <math.h>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr unsigned kDefaultChannels      = 2;
+static constexpr unsigned kDefaultBuffers       = 2000;
+static constexpr double kDefaultBudget          = 100.0;    // percent of the period
+static constexpr unsigned kMaxInstances         = 1 << 16;
+static constexpr unsigned kWarmUpBuffers        = 32;
+static constexpr unsigned kTrialAttempts        = 2;
+
+/// Stop bisecting when the bracket is within this fraction of the answer.
+static constexpr double kSearchPrecision        = 0.01;
+
+/// The fit: block sizes, the instances rendered in turn at each, and buffers per size.
+static const unsigned kFitFrames[]              = { 16, 32, 64, 128, 256, 512, 1024 };
+static constexpr unsigned kFitInstances         = 32;
+static constexpr unsigned kFitBuffers           = 400;
+
+static const unsigned kDefaultFrames[]          = { 64, 128, 256 };
+static const double kDefaultRates[]             = { 48000.0, 96000.0 };
+
+typedef std::chrono::steady_clock Clock;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//
+// Everything one instance touches in a render. Virtual so the parameter reads are calls,
+// as they are into AUBase.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Instance {
+
+public:
+    Instance(double inSampleRate, unsigned inChannels, unsigned inMaxFrames, const LoPassSettings &inSettings, double inCutoff) :
+        mParameters(kNumberOfParameters),
+        mInput((size_t)inChannels * inMaxFrames),
+        mOutput((size_t)inChannels * inMaxFrames),
+        mChannels(inChannels) {
+
+        mParameters[kParameter_CutoffFrequency] = inCutoff;
+        mParameters[kParameter_Resonance]       = inSettings.mResonance;
+        mParameters[kParameter_Smoothing]       = inSettings.mSmoothing;
+        mParameters[kParameter_LinearPhase]     = inSettings.mLinearPhase ? 1.0f : 0.0f;
+        mParameters[kParameter_Multirate]       = inSettings.mMultirate ? 1.0f : 0.0f;
+
+        for (unsigned c = 0; c < inChannels; c++) {
+            mKernels.emplace_back(new LoPassProcessor(inSampleRate));
+            mKernels.back()->Prepare(GetSettings());
+        }
+    }
+
+    virtual ~Instance() { }
+
+    virtual float GetParameter(unsigned inID) const { return mParameters[inID]; }
+
+    LoPassSettings GetSettings() const {
+
+        LoPassSettings settings;
+        settings.mCutoff        = GetParameter(kParameter_CutoffFrequency);
+        settings.mResonance     = GetParameter(kParameter_Resonance);
+        settings.mSmoothing     = GetParameter(kParameter_Smoothing);
+        settings.mLinearPhase   = GetParameter(kParameter_LinearPhase) != 0.0;
+        settings.mMultirate     = GetParameter(kParameter_Multirate) != 0.0;
+        return settings;
+    }
+
+    void Render(unsigned inFrames) {
+        for (unsigned c = 0; c < mChannels; c++) {
+            mKernels[c]->Process(GetSettings(), &mInput[(size_t)c * inFrames], &mOutput[(size_t)c * inFrames], inFrames);
+        }
+    }
+
+    float *GetInput() { return &mInput[0]; }
+
+private:
+    std::vector<float>                              mParameters;
+    std::vector<std::unique_ptr<LoPassProcessor> >  mKernels;
+    std::vector<float>                              mInput;
+    std::vector<float>                              mOutput;
+    unsigned                                        mChannels;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Graph
+//
+// The instances of one configuration, grown as the search needs more. Cutoffs are spread
+// across the audio band so no two instances do quite the same work.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Graph {
+
+public:
+    Graph(double inSampleRate, unsigned inChannels, unsigned inMaxFrames, const LoPassSettings &inSettings) :
+        mSampleRate(inSampleRate),
+        mChannels(inChannels),
+        mMaxFrames(inMaxFrames),
+        mSettings(inSettings),
+        mNoise(4096 + (size_t)inChannels * inMaxFrames),
+        mNoiseOffset(0) {
+
+        uint32_t noise = 1;
+        for (size_t i = 0; i < mNoise.size(); i++) {
+            mNoise[i] = (float)((int32_t)(noise = noise * 1664525u + 1013904223u) * (0.5 / 2147483648.0));
+        }
+    }
+
+    void Grow(unsigned inInstances) {
+        while (mInstances.size() < inInstances) {
+            double cutoff = 100.0 * pow(100.0, (mInstances.size() % 97) / 97.0);
+            mInstances.emplace_back(new Instance(mSampleRate, mChannels, mMaxFrames, mSettings, cutoff));
+        }
+    }
+
+    /// What the upstream nodes would have written into each track.
+    void FillInputs(unsigned inInstances, unsigned inFrames) {
+        size_t samples = (size_t)mChannels * inFrames;
+        for (unsigned i = 0; i < inInstances; i++) {
+            memcpy(mInstances[i]->GetInput(), &mNoise[mNoiseOffset], samples * sizeof(float));
+            mNoiseOffset = (mNoiseOffset + 257) % 4096;
+        }
+    }
+
+    void Render(unsigned inInstances, unsigned inFrames) {
+        for (unsigned i = 0; i < inInstances; i++) { mInstances[i]->Render(inFrames); }
+    }
+
+    double GetSampleRate() const { return mSampleRate; }
+
+private:
+    double                                  mSampleRate;
+    unsigned                                mChannels;
+    unsigned                                mMaxFrames;
+    LoPassSettings                          mSettings;
+    std::vector<std::unique_ptr<Instance> > mInstances;
+    std::vector<float>                      mNoise;
+    size_t                                  mNoiseOffset;
+};
+
+/// The time of each of inBuffers renders of the first inInstances, in seconds, sorted.
+static std::vector<double> Measure(Graph &ioGraph, unsigned inInstances, unsigned inFrames, unsigned inBuffers, bool inPaced) {
+
+    ioGraph.Grow(inInstances);
+
+    for (unsigned b = 0; b < kWarmUpBuffers; b++) {
+        ioGraph.FillInputs(inInstances, inFrames);
+        ioGraph.Render(inInstances, inFrames);
+    }
+
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(inFrames / ioGraph.GetSampleRate()));
+    Clock::time_point next = Clock::now();
+    std::vector<double> seconds(inBuffers);
+
+    for (unsigned b = 0; b < inBuffers; b++) {
+
+        ioGraph.FillInputs(inInstances, inFrames);
+
+        if (inPaced) {
+            std::this_thread::sleep_until(next);
+            next += period;
+        }
+
+        Clock::time_point start = Clock::now();
+        ioGraph.Render(inInstances, inFrames);
+        seconds[b] = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+    return seconds;
+}
+
+static double Percentile(const std::vector<double> &inSorted, double inFraction) {
+
+    size_t index = (size_t)ceil(inFraction * inSorted.size());
+    return inSorted[std::min(inSorted.size(), std::max<size_t>(index, 1)) - 1];
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Trial
+//
+// Whether inInstances make the deadline at the 99.9th percentile. One stall of the machine
+// in a trial is enough to fail it, so a miss is measured again before it's believed.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Trial {
+    unsigned    mFrames;
+    unsigned    mBuffers;
+    double      mDeadline;
+    bool        mPaced;
+    bool        mVerbose;
+};
+
+static bool RunTrial(Graph &ioGraph, const Trial &inTrial, unsigned inInstances, double &outP999) {
+
+    for (unsigned attempt = 0; attempt < kTrialAttempts; attempt++) {
+
+        std::vector<double> seconds = Measure(ioGraph, inInstances, inTrial.mFrames, inTrial.mBuffers, inTrial.mPaced);
+        outP999 = Percentile(seconds, 0.999);
+
+        if (inTrial.mVerbose) {
+            fprintf(stderr, "  %u instances: median %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n", inInstances,
+                    1e6 * Percentile(seconds, 0.5), 1e6 * Percentile(seconds, 0.99), 1e6 * outP999, 1e6 * seconds.back());
+        }
+
+        if (outP999 <= inTrial.mDeadline) { return true; }
+    }
+
+    return false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Search
+//
+// The most instances that pass, and their p99.9: doubling until a trial fails, then
+// bisecting between the last pass and the first failure.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static unsigned Search(Graph &ioGraph, const Trial &inTrial, double &outP999) {
+
+    unsigned pass = 0, fail = 0;
+    double passP999 = 0.0, p999;
+
+    for (unsigned n = 1; n <= kMaxInstances; n *= 2) {
+        if (!RunTrial(ioGraph, inTrial, n, p999)) {
+            fail = n;
+            break;
+        }
+        pass = n;
+        passP999 = p999;
+    }
+
+    while (fail > 0 && fail - pass > std::max(1.0, kSearchPrecision * pass)) {
+        unsigned n = pass + (fail - pass) / 2;
+        if (RunTrial(ioGraph, inTrial, n, p999)) {
+            pass = n;
+            passP999 = p999;
+        } else {
+            fail = n;
+        }
+    }
+
+    outP999 = passP999;
+    return pass;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Fit
+//
+// Least squares of the median time per instance against the block size.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void Fit(double inSampleRate, unsigned inChannels, const LoPassSettings &inSettings, double &outFixed, double &outPerFrame) {
+
+    const size_t sizes = sizeof(kFitFrames) / sizeof(kFitFrames[0]);
+    Graph graph(inSampleRate, inChannels, kFitFrames[sizes - 1], inSettings);
+
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+
+    for (size_t s = 0; s < sizes; s++) {
+        std::vector<double> seconds = Measure(graph, kFitInstances, kFitFrames[s], kFitBuffers, false);
+        double x = kFitFrames[s];
+        double y = Percentile(seconds, 0.5) / kFitInstances;
+
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+
+    outPerFrame = (sizes * sumXY - sumX * sumY) / (sizes * sumXX - sumX * sumX);
+    outFixed = (sumY - outPerFrame * sumX) / sizes;
+}
+
+static bool SetRealtime() {
+
+    struct sched_param parameters;
+    memset(&parameters, 0, sizeof(parameters));
+    parameters.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+}
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-density [options]\n"
+            "\n"
+            "  -f, --frames LIST        buffer sizes (default 64,128,256)\n"
+            "  -r, --rates LIST         sample rates (default 48000,96000)\n"
+            "  -c, --channels N         channels per instance (default %u)\n"
+            "  -n, --buffers N          buffers per trial (default %u)\n"
+            "  -b, --budget PERCENT     share of the period the instances may take (default %g)\n"
+            "  -p, --paced              one buffer per period, as a host renders\n"
+            "  -l, --linear-phase       instances in linear phase mode\n"
+            "  -m, --multirate          instances in multirate mode\n"
+            "  -v, --verbose            print every trial\n",
+            kDefaultChannels, kDefaultBuffers, kDefaultBudget);
+}
+
+/// A comma separated list of positive numbers.
+static bool ParseList(const char *inText, std::vector<double> &outValues) {
+
+    outValues.clear();
+
+    for (const char *p = inText; ; ) {
+        char *end;
+        double value = strtod(p, &end);
+        if (end == p || !(value > 0.0)) { return false; }
+        outValues.push_back(value);
+        if (*end == '\0') { return true; }
+        if (*end != ',') { return false; }
+        p = end + 1;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "frames",         required_argument,  NULL, 'f' },
+        { "rates",          required_argument,  NULL, 'r' },
+        { "channels",       required_argument,  NULL, 'c' },
+        { "buffers",        required_argument,  NULL, 'n' },
+        { "budget",         required_argument,  NULL, 'b' },
+        { "paced",          no_argument,        NULL, 'p' },
+        { "linear-phase",   no_argument,        NULL, 'l' },
+        { "multirate",      no_argument,        NULL, 'm' },
+        { "verbose",        no_argument,        NULL, 'v' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+
+    std::vector<double> frames(kDefaultFrames, kDefaultFrames + sizeof(kDefaultFrames) / sizeof(kDefaultFrames[0]));
+    std::vector<double> rates(kDefaultRates, kDefaultRates + sizeof(kDefaultRates) / sizeof(kDefaultRates[0]));
+    LoPassSettings settings;
+    double channels = kDefaultChannels;
+    double buffers  = kDefaultBuffers;
+    double budget   = kDefaultBudget;
+    bool paced      = false;
+    bool verbose    = false;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "f:r:c:n:b:plmvh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'f': ok = ParseList(optarg, frames); break;
+            case 'r': ok = ParseList(optarg, rates); break;
+            case 'c': ok = LoPassParseNumber(optarg, channels) && channels >= 1.0 && channels <= 64.0; break;
+            case 'n': ok = LoPassParseNumber(optarg, buffers) && buffers >= 100.0 && buffers <= 1e6; break;
+            case 'b': ok = LoPassParseNumber(optarg, budget) && budget > 0.0 && budget <= 100.0; break;
+            case 'p': paced = true; break;
+            case 'l': settings.mLinearPhase = true; break;
+            case 'm': settings.mMultirate = true; break;
+            case 'v': verbose = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        for (size_t i = 0; ok && i < frames.size(); i++) { ok = frames[i] <= 1 << 16; }
+        for (size_t i = 0; ok && i < rates.size(); i++) { ok = rates[i] >= 8000.0 && rates[i] <= 768000.0; }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-density: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    bool realtime = SetRealtime();
+    double maxFrames = *std::max_element(frames.begin(), frames.end());
+
+    printf("%u channel instances%s%s, p99.9 of %.0f buffers %s, deadline %g%% of the period%s\n",
+           (unsigned)channels, settings.mLinearPhase ? ", linear phase" : "", settings.mMultirate ? ", multirate" : "",
+           buffers, paced ? "paced" : "back to back", budget, realtime ? ", realtime" : " (realtime refused, normal priority)");
+    printf("\n%-7s %8s %10s %10s %10s %12s %14s\n", "frames", "rate", "period", "deadline", "instances", "p99.9", "per instance");
+
+    for (size_t r = 0; r < rates.size(); r++) {
+
+        Graph graph(rates[r], (unsigned)channels, (unsigned)maxFrames, settings);
+
+        for (size_t f = 0; f < frames.size(); f++) {
+
+            unsigned blockFrames = (unsigned)frames[f];
+            double period = blockFrames / rates[r];
+            double deadline = 0.01 * budget * period;
+            double p999 = 0.0;
+
+            Trial trial = { blockFrames, (unsigned)buffers, deadline, paced, verbose };
+            unsigned instances = Search(graph, trial, p999);
+
+            char perInstance[32] = "-";
+            if (instances > 0) { snprintf(perInstance, sizeof(perInstance), "%.2f us", 1e6 * p999 / instances); }
+
+            printf("%-7u %8.0f %7.0f us %7.0f us %10u %9.1f us %14s\n", blockFrames, rates[r], 1e6 * period, 1e6 * deadline,
+                   instances, 1e6 * p999, perInstance);
+            fflush(stdout);
+        }
+    }
+
+    printf("\nper instance render, fitted over %u to %u frames:\n", kFitFrames[0], kFitFrames[sizeof(kFitFrames) / sizeof(kFitFrames[0]) - 1]);
+
+    for (size_t r = 0; r < rates.size(); r++) {
+        double fixed, perFrame;
+        Fit(rates[r], (unsigned)channels, settings, fixed, perFrame);
+        printf("  %6.0f Hz: %7.1f ns fixed + %6.2f ns per sample (%.2f ns per frame of %u channels)\n",
+               rates[r], 1e9 * fixed, 1e9 * perFrame / channels, 1e9 * perFrame, (unsigned)channels);
+    }
+
+    return 0;
+}
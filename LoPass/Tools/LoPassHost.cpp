@@ -0,0 +1,639 @@
+//
+//  LoPassHost.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Mock host for the AudioUnit itself: LoPassUnit with AUEffectBase, AUBase, the input and
+//  output elements and the plug-in dispatch, built on Linux against the stand-ins in
+//  Compat/ and driven only through AudioComponent and AudioUnit calls, the way a DAW
+//  drives the bundle.
+//
+//  make lopass-host
+//  make lopass-host-asan
+//
+//  The host registers LoPassUnitFactory as the bundle's Info.plist would, opens instances,
+//  negotiates the stream format on both buses and the largest slice, saves and restores
+//  the class info, installs a render callback for the input and initializes. Each buffer
+//  it schedules the cutoff automation as parameter events, immediate or ramped, and pulls
+//  the output with AudioUnitRender(), timing every call. At the end it reads each
+//  instance's render telemetry through the custom property.
+//
+//  Alongside every render the same input goes through a LoPassProcessor per channel, cut
+//  into the slices AUBase::ProcessForScheduledParams() makes, with the value each slice
+//  sees. The output of the unit must match it to the bit; the difference in time between
+//  the two is what the framework costs on top of the kernels. Linear phase designs its
+//  filters on another thread, so with automation its output isn't compared; and where the
+//  kernels dominate, as they do in linear phase, the two differ by a few percent either
+//  way with where their buffers land, which is more than the framework's share.
+//
+//  With --gaps the input stops and starts again, the silence flagged to the unit for longer
+//  than its latency and tail, at a resonant low cutoff whose ringing outlasts a short tail,
+//  so the kernels skip buffers and clear their state. There is no automation, and the
+//  reference runs straight through the silence; the unit must stay within kGapTolerance.
+//
+//  lopass-host links LoPassRealtimeCheck.cpp; with --realtime each AudioUnitScheduleParameters()
+//  and AudioUnitRender() runs in a LoPassRealtimeScope, so the first allocation, lock or
+//  blocking call anywhere in AUBase, AUEffectBase or the kernels fails the run with a stack.
+//  lopass-host-asan leaves it out, as AddressSanitizer replaces the allocator itself.
+//
+//  lopass-host [options]
+//
+
+#include <AudioUnit/AudioUnit.h>
+#include "LoPassToolOptions.hpp"
+#include "LoPassUnit.hpp"
+#if LOPASS_HOST_REALTIME_CHECK
+    #include "LoPassRealtimeCheck.hpp"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <getopt.h>
+#include <math.h>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+extern "C" void *LoPassUnitFactory(const AudioComponentDescription *inDesc);
+
+static constexpr unsigned kDefaultInstances     = 1;
+static constexpr unsigned kDefaultChannels      = 2;
+static constexpr unsigned kDefaultFrames        = 512;
+static constexpr double kDefaultSampleRate      = 48000.0;
+static constexpr double kDefaultSeconds         = 10.0;
+static constexpr unsigned kDefaultEvents        = 4;
+
+/// Most parameter events scheduled in one buffer.
+static constexpr unsigned kMaxEvents            = 512;
+
+/// Cutoff used in multirate mode, low enough for the decimated path to engage.
+static constexpr double kMultirateCutoff        = 60.0;
+
+/// --gaps: a resonant design that rings for ~100 ms, bursts of input and how far past the
+/// latency and tail each gap runs, and how close the output must stay to the reference.
+static constexpr double kGapCutoff              = 200.0;
+static constexpr double kGapResonance           = 12.0;
+static constexpr double kGapBurstSeconds        = 0.25;
+static constexpr double kGapMarginSeconds       = 0.1;
+static constexpr float kGapTolerance            = 1e-6f;
+
+/// The percentile reported besides the mean and the extremes.
+static constexpr double kPercentile             = 0.99;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Options {
+    unsigned    mInstances;
+    unsigned    mChannels;
+    unsigned    mFrames;
+    double      mSampleRate;
+    double      mSeconds;
+    unsigned    mEvents;        // per buffer, on every instance
+    bool        mRamped;
+    bool        mLinearPhase;
+    bool        mMultirate;
+    bool        mGaps;
+    bool        mRealtime;
+    uint64_t    mBurstFrames;   // with mGaps, each a whole number of buffers
+    uint64_t    mGapFrames;
+};
+
+/// The automated cutoff at a given time, different on every instance.
+static float Cutoff(unsigned inInstance, double inSeconds) {
+
+    return (float)(300.0 * pow(20.0, 0.5 + 0.5 * sin(2.0 * M_PI * 0.25 * inSeconds + inInstance)));
+}
+
+/// A LoPassRealtimeScope with --realtime, nothing otherwise.
+class RealtimeScope {
+
+public:
+    explicit RealtimeScope(bool inEnabled) : mEnabled(inEnabled) {
+#if LOPASS_HOST_REALTIME_CHECK
+        if (mEnabled) { LoPassRealtimeCheck::Enter(); }
+#endif
+    }
+
+    ~RealtimeScope() {
+#if LOPASS_HOST_REALTIME_CHECK
+        if (mEnabled) { LoPassRealtimeCheck::Leave(); }
+#endif
+    }
+
+private:
+    RealtimeScope(const RealtimeScope&);
+    RealtimeScope &operator=(const RealtimeScope&);
+
+    bool mEnabled;
+};
+
+static bool IsRealtimeCheckAvailable() {
+#if LOPASS_HOST_REALTIME_CHECK
+    return LoPassRealtimeCheck::IsAvailable();
+#else
+    return false;
+#endif
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static bool Check(OSStatus inResult, const char *inCall) {
+
+    if (inResult != noErr) { fprintf(stderr, "lopass-host: %s failed: %d\n", inCall, (int)inResult); }
+    return inResult == noErr;
+}
+
+static AudioBufferList *NewBufferList(unsigned inChannels) {
+
+    AudioBufferList *list = (AudioBufferList *)calloc(1, offsetof(AudioBufferList, mBuffers) + inChannels * sizeof(AudioBuffer));
+    list->mNumberBuffers = inChannels;
+    return list;
+}
+
+class Instance {
+
+public:
+    Instance(unsigned inIndex, const Options &inOptions) :
+        mIndex(inIndex),
+        mOptions(inOptions),
+        mUnit(NULL),
+        mInput((size_t)inOptions.mChannels * inOptions.mFrames),
+        mOutput(mInput.size()),
+        mReference(mInput.size()),
+        mOutputList(NewBufferList(inOptions.mChannels), free),
+        mNoise(inIndex * 2654435761u + 1),
+        mSilent(false),
+        mMaxError(0.0f) {}
+
+    ~Instance() {
+        if (mUnit != NULL) {
+            AudioUnitUninitialize(mUnit);
+            AudioComponentInstanceDispose(mUnit);
+        }
+    }
+
+    /// Everything a host does between finding the component and the first render.
+    bool Open(AudioComponent inComponent) {
+
+        if (!Check(AudioComponentInstanceNew(inComponent, &mUnit), "AudioComponentInstanceNew")) { return false; }
+
+        if (mOptions.mLinearPhase) { mSettings.mLinearPhase = true; }
+        if (mOptions.mGaps) {
+            mSettings.mCutoff = kGapCutoff;
+            mSettings.mResonance = kGapResonance;
+        }
+        if (mOptions.mMultirate) {
+            mSettings.mMultirate = true;
+            mSettings.mCutoff = kMultirateCutoff;
+        }
+        if (!SetParameter(kParameter_CutoffFrequency, (float)mSettings.mCutoff) ||
+            !SetParameter(kParameter_Resonance, (float)mSettings.mResonance) ||
+            !SetParameter(kParameter_LinearPhase, mSettings.mLinearPhase) ||
+            !SetParameter(kParameter_Multirate, mSettings.mMultirate)) { return false; }
+
+        AudioStreamBasicDescription format;
+        memset(&format, 0, sizeof(format));
+        format.mSampleRate          = mOptions.mSampleRate;
+        format.mFormatID            = kAudioFormatLinearPCM;
+        format.mFormatFlags         = kAudioFormatFlagsNativeFloatPacked | kAudioFormatFlagIsNonInterleaved;
+        format.mBytesPerPacket      = sizeof(Float32);
+        format.mFramesPerPacket     = 1;
+        format.mBytesPerFrame       = sizeof(Float32);
+        format.mChannelsPerFrame    = mOptions.mChannels;
+        format.mBitsPerChannel      = 32;
+
+        UInt32 maxFrames = mOptions.mFrames;
+        AURenderCallbackStruct callback = { InputCallback, this };
+
+        if (!Check(AudioUnitSetProperty(mUnit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, &format, sizeof(format)),
+                   "setting the input format") ||
+            !Check(AudioUnitSetProperty(mUnit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, 0, &format, sizeof(format)),
+                   "setting the output format") ||
+            !Check(AudioUnitSetProperty(mUnit, kAudioUnitProperty_MaximumFramesPerSlice, kAudioUnitScope_Global, 0, &maxFrames,
+                                        sizeof(maxFrames)), "setting the maximum frames per slice") ||
+            !Check(AudioUnitSetProperty(mUnit, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Input, 0, &callback,
+                                        sizeof(callback)), "setting the render callback")) { return false; }
+
+        // what a host stores with its session and hands back when reopening it
+        CFPropertyListRef classInfo = NULL;
+        UInt32 size = sizeof(classInfo);
+        if (!Check(AudioUnitGetProperty(mUnit, kAudioUnitProperty_ClassInfo, kAudioUnitScope_Global, 0, &classInfo, &size),
+                   "getting the class info")) { return false; }
+        OSStatus result = AudioUnitSetProperty(mUnit, kAudioUnitProperty_ClassInfo, kAudioUnitScope_Global, 0, &classInfo, size);
+        CFRelease(classInfo);
+        if (!Check(result, "restoring the class info")) { return false; }
+
+        if (!Check(AudioUnitInitialize(mUnit), "AudioUnitInitialize")) { return false; }
+
+        // the kernels' Reset() and Prepare() on Initialize()
+        for (unsigned c = 0; c < mOptions.mChannels; c++) {
+            mProcessors.emplace_back(new LoPassProcessor(mOptions.mSampleRate));
+            mProcessors.back()->Prepare(mSettings);
+        }
+
+        for (unsigned c = 0; c < mOptions.mChannels; c++) {
+            mOutputList->mBuffers[c].mNumberChannels = 1;
+            mOutputList->mBuffers[c].mData = &mOutput[(size_t)c * mOptions.mFrames];
+        }
+        return true;
+    }
+
+    AudioUnit GetUnit() const { return mUnit; }
+    float GetMaxError() const { return mMaxError; }
+
+    /// The input for the buffer at inPosition; with --gaps, silent and flagged so in each gap.
+    void Fill(uint64_t inPosition) {
+
+        mSilent = mOptions.mGaps && inPosition % (mOptions.mBurstFrames + mOptions.mGapFrames) >= mOptions.mBurstFrames;
+        if (mSilent) {
+            std::fill(mInput.begin(), mInput.end(), 0.0f);
+            return;
+        }
+
+        for (float &sample : mInput) {
+            sample = (float)((int32_t)(mNoise = mNoise * 1664525u + 1013904223u) * (0.25 / 2147483648.0));
+        }
+    }
+
+    /// Schedules this buffer's automation and pulls the output, returning the time taken.
+    uint64_t Render(uint64_t inPosition) {
+
+        unsigned frames = mOptions.mFrames;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        RealtimeScope scope(mOptions.mRealtime);
+
+        if (mOptions.mEvents > 0) {
+            AudioUnitParameterEvent events[kMaxEvents];
+            unsigned count = mOptions.mEvents;
+
+            for (unsigned e = 0; e < count; e++) {
+                AudioUnitParameterEvent &event = events[e];
+                event.scope     = kAudioUnitScope_Global;
+                event.element   = 0;
+                event.parameter = kParameter_CutoffFrequency;
+
+                unsigned offset = EventOffset(e);
+                if (mOptions.mRamped) {
+                    event.eventType = kParameterEvent_Ramped;
+                    event.eventValues.ramp.startBufferOffset = offset;
+                    event.eventValues.ramp.durationInFrames = EventOffset(e + 1) - offset;
+                    event.eventValues.ramp.startValue = EventValue(inPosition, e);
+                    event.eventValues.ramp.endValue = EventValue(inPosition, e + 1);
+                } else {
+                    event.eventType = kParameterEvent_Immediate;
+                    event.eventValues.immediate.bufferOffset = offset;
+                    event.eventValues.immediate.value = EventValue(inPosition, e);
+                }
+            }
+            AudioUnitScheduleParameters(mUnit, events, count);
+        }
+
+        for (unsigned c = 0; c < mOptions.mChannels; c++) { mOutputList->mBuffers[c].mDataByteSize = frames * sizeof(Float32); }
+
+        AudioUnitRenderActionFlags flags = 0;
+        AudioTimeStamp timeStamp;
+        memset(&timeStamp, 0, sizeof(timeStamp));
+        timeStamp.mSampleTime = (Float64)inPosition;
+        timeStamp.mFlags = kAudioTimeStampSampleTimeValid;
+
+        AudioUnitRender(mUnit, &flags, &timeStamp, 0, frames, mOutputList.get());
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// The same buffer through the kernels alone, returning the time taken.
+    uint64_t RenderReference(uint64_t inPosition) {
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        unsigned slices = std::max(mOptions.mEvents, 1u);
+
+        // AUBase hands a ramp to the kernels as its start value for every slice in it
+        for (unsigned e = 0; e < slices; e++) {
+            unsigned begin = EventOffset(e);
+            unsigned end = EventOffset(e + 1);
+            if (end == begin) { continue; }
+            if (mOptions.mEvents > 0) { mSettings.mCutoff = EventValue(inPosition, e); }
+
+            for (unsigned c = 0; c < mOptions.mChannels; c++) {
+                size_t at = (size_t)c * mOptions.mFrames + begin;
+                mProcessors[c]->Process(mSettings, &mInput[at], &mReference[at], end - begin);
+            }
+        }
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// False when the unit's output isn't the reference's to the bit, or with --gaps, within
+    /// kGapTolerance: the ringing dropped with the skipped buffers is 120 dB down.
+    bool Compare() {
+
+        bool same = memcmp(mOutput.data(), mReference.data(), mOutput.size() * sizeof(float)) == 0;
+        float error = 0.0f;
+        for (size_t i = 0; !same && i < mOutput.size(); i++) {
+            error = std::max(error, fabsf(mOutput[i] - mReference[i]));
+            if (mOutput[i] != mOutput[i]) { error = INFINITY; }
+        }
+        mMaxError = std::max(mMaxError, error);
+        return same || (mOptions.mGaps && error <= kGapTolerance);
+    }
+
+private:
+    bool SetParameter(AudioUnitParameterID inID, AudioUnitParameterValue inValue) {
+
+        return Check(AudioUnitSetParameter(mUnit, inID, kAudioUnitScope_Global, 0, inValue, 0), "AudioUnitSetParameter");
+    }
+
+    unsigned EventOffset(unsigned inEvent) const {
+
+        unsigned events = std::max(mOptions.mEvents, 1u);
+        return (unsigned)((uint64_t)mOptions.mFrames * inEvent / events);
+    }
+
+    /// Parameter values are Float32 on the way in, so the reference rounds the same way.
+    float EventValue(uint64_t inPosition, unsigned inEvent) const {
+
+        return Cutoff(mIndex, (inPosition + EventOffset(inEvent)) / mOptions.mSampleRate);
+    }
+
+    static OSStatus InputCallback(void                          *inRefCon,
+                                  AudioUnitRenderActionFlags    *ioActionFlags,
+                                  const AudioTimeStamp          *inTimeStamp,
+                                  UInt32                        inBusNumber,
+                                  UInt32                        inNumberFrames,
+                                  AudioBufferList               *ioData) {
+
+        Instance *instance = (Instance *)inRefCon;
+        if (ioData->mNumberBuffers != instance->mOptions.mChannels || inNumberFrames != instance->mOptions.mFrames) {
+            return kAudioUnitErr_CannotDoInCurrentContext;
+        }
+        for (UInt32 c = 0; c < ioData->mNumberBuffers; c++) {
+            memcpy(ioData->mBuffers[c].mData, &instance->mInput[(size_t)c * inNumberFrames], inNumberFrames * sizeof(Float32));
+        }
+        if (instance->mSilent) { *ioActionFlags |= kAudioUnitRenderAction_OutputIsSilence; }
+        return noErr;
+    }
+
+    unsigned                                        mIndex;
+    const Options                                   &mOptions;
+    AudioUnit                                       mUnit;
+
+    LoPassSettings                                  mSettings;
+    std::vector<std::unique_ptr<LoPassProcessor> >  mProcessors;
+
+    std::vector<float>                              mInput;
+    std::vector<float>                              mOutput;
+    std::vector<float>                              mReference;
+    std::unique_ptr<AudioBufferList, void (*)(void *)> mOutputList;
+    uint32_t                                        mNoise;
+    bool                                            mSilent;
+    float                                           mMaxError;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Report
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void PrintTimes(const char *inName, std::vector<uint64_t> &ioTimes, uint64_t inFramesPerRender) {
+
+    std::sort(ioTimes.begin(), ioTimes.end());
+
+    double total = 0.0;
+    for (uint64_t time : ioTimes) { total += time; }
+
+    double mean = total / std::max<size_t>(ioTimes.size(), 1);
+    uint64_t percentile = ioTimes[std::min(ioTimes.size() - 1, (size_t)(kPercentile * ioTimes.size()))];
+
+    printf("%-18s %8zu %8.2f %8.2f %8.2f %8.2f %9.2f\n", inName, ioTimes.size(), 1e-3 * ioTimes.front(), 1e-3 * mean,
+           1e-3 * percentile, 1e-3 * ioTimes.back(), mean / inFramesPerRender);
+}
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-host [options]\n"
+            "\n"
+            "  -n, --instances N    instances, rendered one after another (default %u)\n"
+            "  -c, --channels N     channels on each bus (default %u)\n"
+            "  -f, --frames N       buffer size, also the largest slice (default %u)\n"
+            "  -r, --rate HZ        sample rate (default %g)\n"
+            "  -s, --seconds S      seconds of audio to render (default %g)\n"
+            "  -e, --events N       cutoff events scheduled each buffer, 0 for none (default %u)\n"
+            "  -R, --ramped         schedule ramps rather than immediate events\n"
+            "  -l, --linear-phase   linear phase mode\n"
+            "  -m, --multirate      multirate mode, at a %g Hz cutoff unless automated\n"
+            "  -g, --gaps           stop and start the input, at %g Hz and %g dB without automation,\n"
+            "                       and check the output against one render straight through\n"
+            "  -x, --realtime       fail on the first allocation, lock or blocking call made while\n"
+            "                       scheduling or rendering (not in lopass-host-asan)\n",
+            kDefaultInstances, kDefaultChannels, kDefaultFrames, kDefaultSampleRate, kDefaultSeconds, kDefaultEvents, kMultirateCutoff,
+            kGapCutoff, kGapResonance);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "instances",      required_argument,  NULL, 'n' },
+        { "channels",       required_argument,  NULL, 'c' },
+        { "frames",         required_argument,  NULL, 'f' },
+        { "rate",           required_argument,  NULL, 'r' },
+        { "seconds",        required_argument,  NULL, 's' },
+        { "events",         required_argument,  NULL, 'e' },
+        { "ramped",         no_argument,        NULL, 'R' },
+        { "linear-phase",   no_argument,        NULL, 'l' },
+        { "multirate",      no_argument,        NULL, 'm' },
+        { "gaps",           no_argument,        NULL, 'g' },
+        { "realtime",       no_argument,        NULL, 'x' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+
+    double instances = kDefaultInstances;
+    double channels = kDefaultChannels;
+    double frames = kDefaultFrames;
+    double events = kDefaultEvents;
+    Options options = { 0, 0, 0, kDefaultSampleRate, kDefaultSeconds, 0, false, false, false, false, false, 0, 0 };
+    int option;
+
+    while ((option = getopt_long(argc, argv, "n:c:f:r:s:e:Rlmgxh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'n': ok = LoPassParseNumber(optarg, instances) && instances >= 1.0 && instances <= 1000.0; break;
+            case 'c': ok = LoPassParseNumber(optarg, channels) && channels >= 1.0 && channels <= 64.0; break;
+            case 'f': ok = LoPassParseNumber(optarg, frames) && frames >= 1.0 && frames <= 4096.0; break;
+            case 'r': ok = LoPassParseNumber(optarg, options.mSampleRate) && options.mSampleRate >= 8000.0 && options.mSampleRate <= 768000.0; break;
+            case 's': ok = LoPassParseNumber(optarg, options.mSeconds) && options.mSeconds > 0.0 && options.mSeconds <= 3600.0; break;
+            case 'e': ok = LoPassParseNumber(optarg, events) && events >= 0.0 && events <= kMaxEvents; break;
+            case 'R': options.mRamped = true; break;
+            case 'l': options.mLinearPhase = true; break;
+            case 'm': options.mMultirate = true; break;
+            case 'g': options.mGaps = true; break;
+            case 'x': options.mRealtime = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-host: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    if (options.mRealtime && !IsRealtimeCheckAvailable()) {
+        fprintf(stderr, "lopass-host: --realtime isn't available in this build or on this platform\n");
+        return 2;
+    }
+
+    options.mInstances = (unsigned)instances;
+    options.mChannels = (unsigned)channels;
+    options.mFrames = (unsigned)frames;
+    options.mEvents = options.mGaps ? 0 : std::min((unsigned)events, options.mFrames);
+
+    // what the system does with the bundle's AudioComponents entry
+    AudioComponentDescription description = { kAudioUnitType_Effect, LoPass_COMP_SUBTYPE, LoPass_COMP_MANF, 0, 0 };
+    AudioComponentRegister(&description, CFSTR("DAVE: LoPass Filter"), kLoPassVersion, (AudioComponentFactoryFunction)LoPassUnitFactory);
+
+    AudioComponentDescription wanted = { kAudioUnitType_Effect, LoPass_COMP_SUBTYPE, LoPass_COMP_MANF, 0, 0 };
+    AudioComponent component = AudioComponentFindNext(NULL, &wanted);
+
+    CFStringRef name = NULL;
+    UInt32 version = 0;
+    if (component == NULL || AudioComponentCopyName(component, &name) != noErr || AudioComponentGetVersion(component, &version) != noErr) {
+        fprintf(stderr, "lopass-host: no component\n");
+        return 1;
+    }
+    printf("%s, version %u.%u.%u\n", CFStringGetCStringPtr(name, kCFStringEncodingUTF8), (unsigned)version >> 16,
+           (unsigned)(version >> 8) & 0xFF, (unsigned)version & 0xFF);
+    CFRelease(name);
+
+    std::vector<std::unique_ptr<Instance> > session;
+    for (unsigned i = 0; i < options.mInstances; i++) {
+        session.emplace_back(new Instance(i, options));
+        if (!session.back()->Open(component)) { return 1; }
+    }
+
+    Float64 latency = 0.0, tail = 0.0;
+    UInt32 size = sizeof(Float64);
+    AudioUnitGetProperty(session[0]->GetUnit(), kAudioUnitProperty_Latency, kAudioUnitScope_Global, 0, &latency, &size);
+    AudioUnitGetProperty(session[0]->GetUnit(), kAudioUnitProperty_TailTime, kAudioUnitScope_Global, 0, &tail, &size);
+
+    uint64_t buffers = (uint64_t)ceil(options.mSeconds * options.mSampleRate / options.mFrames);
+    bool compared = !(options.mLinearPhase && options.mEvents > 0);
+
+    printf("%u instance%s, %u channel%s at %g Hz, %llu buffers of %u frames, %u %s event%s a buffer\n", options.mInstances,
+           options.mInstances == 1 ? "" : "s", options.mChannels, options.mChannels == 1 ? "" : "s", options.mSampleRate,
+           (unsigned long long)buffers, options.mFrames, options.mEvents, options.mRamped ? "ramped" : "immediate",
+           options.mEvents == 1 ? "" : "s");
+    printf("latency %.0f frames, tail %.1f ms\n", latency * options.mSampleRate, 1e3 * tail);
+
+    if (options.mGaps) {
+        double buffer = options.mFrames / options.mSampleRate;
+        options.mBurstFrames = (uint64_t)ceil(kGapBurstSeconds / buffer) * options.mFrames;
+        options.mGapFrames = (uint64_t)ceil((latency + tail + kGapMarginSeconds) / buffer) * options.mFrames;
+        printf("gaps: %.0f ms of input, then %.0f ms of silence\n", 1e3 * options.mBurstFrames / options.mSampleRate,
+               1e3 * options.mGapFrames / options.mSampleRate);
+    }
+
+#if LOPASS_HOST_REALTIME_CHECK
+    static char context[128];
+    snprintf(context, sizeof(context), "lopass-host: %u channels, %u frames, %u %s events", options.mChannels, options.mFrames,
+             options.mEvents, options.mRamped ? "ramped" : "immediate");
+    LoPassRealtimeCheck::SetContext(context);
+#endif
+
+    std::vector<uint64_t> unitTimes, kernelTimes;
+    unitTimes.reserve(buffers * options.mInstances);
+    kernelTimes.reserve(buffers * options.mInstances);
+    uint64_t mismatches = 0;
+
+    for (uint64_t b = 0; b < buffers; b++) {
+        uint64_t position = b * options.mFrames;
+        for (std::unique_ptr<Instance> &instance : session) {
+            instance->Fill(position);
+            unitTimes.push_back(instance->Render(position));
+            kernelTimes.push_back(instance->RenderReference(position));
+            if (compared) { mismatches += !instance->Compare(); }
+        }
+    }
+
+    printf("\n%-18s %8s %8s %8s %8s %8s %9s\n", "", "renders", "min us", "avg us", "p99 us", "max us", "ns/frame");
+
+    // both sides do the same work on each buffer, so the difference is taken render by render;
+    // the median keeps a designer thread or a big FFT block in one of them out of it
+    std::vector<int64_t> overheads(unitTimes.size());
+    double unitTotal = 0.0;
+    for (size_t i = 0; i < unitTimes.size(); i++) {
+        overheads[i] = (int64_t)unitTimes[i] - (int64_t)kernelTimes[i];
+        unitTotal += unitTimes[i];
+    }
+    std::sort(overheads.begin(), overheads.end());
+    int64_t overhead = overheads[overheads.size() / 2];
+
+    PrintTimes("AudioUnitRender", unitTimes, options.mFrames);
+    PrintTimes("kernels alone", kernelTimes, options.mFrames);
+
+    uint64_t kernelMedian = kernelTimes[kernelTimes.size() / 2];
+    printf("\nframework %.2f us a render at the median, %.1f%% on top of the kernels; %.1f%% of real time\n", 1e-3 * overhead,
+           100.0 * overhead / std::max<uint64_t>(kernelMedian, 1), 100.0 * 1e-9 * unitTotal / options.mSeconds);
+
+    // what a host's meter reads through the property
+    LoPassTelemetrySnapshot snapshot;
+    size = sizeof(snapshot);
+    if (AudioUnitGetProperty(session[0]->GetUnit(), kAudioUnitCustomProperty_RenderTelemetry, kAudioUnitScope_Global, 0, &snapshot,
+                             &size) == noErr) {
+        printf("telemetry: %llu renders, %.2f slices a render, %.2f designs a render, %llu late\n", (unsigned long long)snapshot.mRenders,
+               (double)snapshot.mSlices / std::max<uint64_t>(snapshot.mRenders, 1),
+               (double)snapshot.mDesigns / std::max<uint64_t>(snapshot.mRenders, 1), (unsigned long long)snapshot.mOverDeadline);
+
+        if (options.mGaps && snapshot.mSilentBuffers == 0) {
+            printf("FAIL: no silent buffers were skipped\n");
+            return 1;
+        }
+    }
+
+    if (options.mRealtime) {
+        printf("realtime: %zu scheduling and render calls checked, no violations\n", unitTimes.size());
+    }
+
+    if (!compared) {
+        printf("output not compared: linear phase redesigns on another thread\n");
+        return 0;
+    }
+
+    float maxError = 0.0f;
+    for (std::unique_ptr<Instance> &instance : session) { maxError = std::max(maxError, instance->GetMaxError()); }
+
+    if (mismatches != 0) {
+        printf("FAIL: %llu of %llu renders differ from LoPassProcessor, max error %g\n", (unsigned long long)mismatches,
+               (unsigned long long)unitTimes.size(), maxError);
+        return 1;
+    }
+
+    if (options.mGaps) {
+        printf("output within %g of LoPassProcessor straight through, max error %g\n", kGapTolerance, maxError);
+        return 0;
+    }
+
+    printf("output matches LoPassProcessor to the bit\n");
+    return 0;
+}
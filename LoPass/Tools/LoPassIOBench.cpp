@@ -0,0 +1,233 @@
+//
+//  LoPassIOBench.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  File I/O backends of the offline renderer, compared on a cold page cache.
+//
+//  make lopass-iobench
+//
+//  Two workloads are written to a scratch directory: one large 24 bit stereo file, and
+//  many short 16 bit stereo clips. Each is rendered by a LoPassBatch with every backend in
+//  turn. Before each run the inputs are dropped from the page cache with posix_fadvise(),
+//  so the reads really go to the device, and the outputs are deleted. "render" is the wall
+//  clock of LoPassBatch::Run(); "+sync" adds the syncfs() that gets the outputs to disk.
+//  The best of kRuns is reported.
+//
+//  On tmpfs there is no device and the differences come down to system call counts.
+//
+//  lopass-iobench [directory] [large file MB] [clips] [workers]
+//
+
+#include "LoPassBatch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static constexpr unsigned kRuns             = 3;
+static constexpr double kSampleRate         = 48000.0;
+static constexpr unsigned kClipFrames       = 24000;    // half a second
+static constexpr unsigned kWriteBlock       = 65536;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Workloads
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Stereo white noise at -6 dB.
+static bool WriteNoise(const std::string &inPath, unsigned inBits, uint64_t inFrames, uint32_t &ioSeed) {
+    
+    LoPassWaveFormat format;
+    format.mSampleRate      = kSampleRate;
+    format.mChannels        = 2;
+    format.mBitsPerSample   = inBits;
+    
+    LoPassWaveWriter writer;
+    if (!writer.Open(inPath.c_str(), format, inFrames)) {
+        fprintf(stderr, "lopass-iobench: %s\n", writer.GetError().c_str());
+        return false;
+    }
+    
+    std::vector<float> left(kWriteBlock), right(kWriteBlock);
+    const float *channels[2] = { &left[0], &right[0] };
+    
+    for (uint64_t done = 0; done < inFrames; ) {
+        
+        unsigned count = (unsigned)std::min<uint64_t>(kWriteBlock, inFrames - done);
+        
+        for (unsigned i = 0; i < count; i++) {
+            ioSeed = ioSeed * 1664525u + 1013904223u;
+            left[i] = (float)((int32_t)ioSeed * (0.5 / 2147483648.0));
+            ioSeed = ioSeed * 1664525u + 1013904223u;
+            right[i] = (float)((int32_t)ioSeed * (0.5 / 2147483648.0));
+        }
+        
+        if (!writer.Write(channels, count)) { break; }
+        done += count;
+    }
+    
+    if (!writer.Close()) {
+        fprintf(stderr, "lopass-iobench: %s\n", writer.GetError().c_str());
+        return false;
+    }
+    
+    return true;
+}
+
+/// Writes back and drops the cached pages of a file.
+static void Evict(const std::string &inPath) {
+    
+    int file = open(inPath.c_str(), O_RDONLY);
+    if (file < 0) { return; }
+    
+    fdatasync(file);
+    posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+    close(file);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Runs
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Timing {
+    double  mRender;
+    double  mSynced;
+    bool    mOK;
+};
+
+static Timing Run(LoPassIOBackend inBackend, unsigned inWorkers, const std::vector<LoPassBatchJob> &inJobs, LoPassIOBackend &outUsed) {
+    
+    Timing best = { 1e30, 1e30, true };
+    
+    LoPassRenderOptions options;
+    options.mBackend = inBackend;
+    
+    LoPassBatch batch(options, inWorkers);
+    std::vector<LoPassBatchResult> results;
+    
+    for (unsigned run = 0; run < kRuns; run++) {
+        
+        for (size_t i = 0; i < inJobs.size(); i++) {
+            Evict(inJobs[i].mInputPath);
+            unlink(inJobs[i].mOutputPath.c_str());
+        }
+        
+        batch.Run(inJobs, results);
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        int file = open(inJobs[0].mOutputPath.c_str(), O_RDONLY);
+        if (file >= 0) {
+            syncfs(file);
+            close(file);
+        }
+        
+        double synced = batch.GetSeconds() + std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        for (size_t i = 0; i < results.size(); i++) {
+            if (!results[i].mOK) {
+                fprintf(stderr, "lopass-iobench: %s\n", results[i].mError.c_str());
+                best.mOK = false;
+            }
+        }
+        
+        best.mRender = std::min(best.mRender, batch.GetSeconds());
+        best.mSynced = std::min(best.mSynced, synced);
+    }
+    
+    outUsed = batch.GetBackend();
+    
+    for (size_t i = 0; i < inJobs.size(); i++) { unlink(inJobs[i].mOutputPath.c_str()); }
+    
+    return best;
+}
+
+static bool Compare(const char *inName, unsigned inWorkers, const std::vector<LoPassBatchJob> &inJobs, uint64_t inBytes) {
+    
+    const LoPassIOBackend backends[] = { kLoPassIO_Map, kLoPassIO_Sync, kLoPassIO_Uring };
+    bool ok = true;
+    
+    printf("\n%s: %zu files, %.1f MB, %u workers\n", inName, inJobs.size(), inBytes / 1e6, inWorkers);
+    printf("  %-8s %10s %10s %10s %10s\n", "backend", "render s", "MB/s", "files/s", "+sync s");
+    
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        
+        LoPassIOBackend used;
+        Timing timing = Run(backends[b], inWorkers, inJobs, used);
+        ok = ok && timing.mOK;
+        
+        printf("  %-8s %10.3f %10.1f %10.1f %10.3f%s\n",
+               LoPassIOBackendName(backends[b]),
+               timing.mRender,
+               inBytes / timing.mRender / 1e6,
+               inJobs.size() / timing.mRender,
+               timing.mSynced,
+               used != backends[b] ? "  (io_uring unavailable, ran sync)" : "");
+    }
+    
+    return ok;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, const char *argv[]) {
+    
+    std::string directory   = argc > 1 ? argv[1] : ".";
+    double largeMB          = argc > 2 ? atof(argv[2]) : 256.0;
+    unsigned clips          = argc > 3 ? (unsigned)atoi(argv[3]) : 2000;
+    unsigned workers        = argc > 4 ? (unsigned)atoi(argv[4]) : 0;
+    
+    if (workers == 0) { workers = std::max(1u, std::thread::hardware_concurrency()); }
+    
+    std::string scratch = directory + "/lopass-iobench.XXXXXX";
+    if (mkdtemp(&scratch[0]) == NULL) {
+        fprintf(stderr, "lopass-iobench: %s: %s\n", directory.c_str(), strerror(errno));
+        return 1;
+    }
+    
+    uint32_t seed = 1;
+    bool ok = true;
+    
+    // one large 24 bit file
+    const uint64_t largeFrames = (uint64_t)(largeMB * 1e6 / 6.0);
+    std::vector<LoPassBatchJob> large(1);
+    large[0].mInputPath     = scratch + "/large.wav";
+    large[0].mOutputPath    = scratch + "/large-out.wav";
+    
+    printf("writing test files to %s\n", scratch.c_str());
+    ok = WriteNoise(large[0].mInputPath, 24, largeFrames, seed);
+    
+    // many short 16 bit clips
+    std::vector<LoPassBatchJob> small(clips);
+    
+    for (unsigned i = 0; ok && i < clips; i++) {
+        
+        char name[32];
+        snprintf(name, sizeof(name), "/clip%05u", i);
+        
+        small[i].mInputPath     = scratch + name + ".wav";
+        small[i].mOutputPath    = scratch + name + "-out.wav";
+        ok = WriteNoise(small[i].mInputPath, 16, kClipFrames, seed);
+    }
+    
+    if (ok) {
+        ok = Compare("large file", workers, large, largeFrames * 6);
+        if (clips > 0) { ok = Compare("small files", workers, small, (uint64_t)clips * kClipFrames * 4) && ok; }
+    }
+    
+    for (unsigned i = 0; i < small.size(); i++) { unlink(small[i].mInputPath.c_str()); }
+    unlink(large[0].mInputPath.c_str());
+    rmdir(scratch.c_str());
+    
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,721 @@
+//
+//  LoPassInvariance.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Block size and slicing invariance suite: every kernel variant is run over random
+//  formats, parameter schedules and block partitions, each partition of a stream has to
+//  give the output of rendering it in one call, and the variants that implement the plain
+//  filter are measured against a double precision reference.
+//
+//  make lopass-invariance
+//
+//  Each trial draws a sample rate, a channel count, an input signal (noise, a sine or an
+//  impulse train), a smoothing time and a schedule of parameter events at random frames,
+//  each a new cutoff and resonance, as a host's ScheduleParameters() would give them. The
+//  events always split the stream, as AUBase::ProcessForScheduledParams() slices a buffer
+//  at each one, so "one call" is the stream in as few calls as the schedule allows. The
+//  other partitions add cuts: every frame on its own, random cuts, and host buffers of a
+//  random size. Each must give the one call output bit for bit, except on the threaded
+//  parallel biquad, which may differ by its documented tolerance.
+//
+//  The variants:
+//
+//    biquad            LoPassBiquad
+//    parallel          the same through a four thread LoPassParallelBiquad
+//    bank              one LoPassFilterBank stream per channel
+//    smoothed          LoPassSmoothedBiquad with smoothing off
+//    processor         LoPassProcessor in IIR mode with smoothing off
+//    processor-smooth  the same with the trial's smoothing
+//    multirate         LoPassProcessor in multirate mode with the trial's smoothing
+//    linear-phase      LoPassProcessor in linear phase mode, static parameters only, since
+//                      the FIR designer thread picks up a new target whenever it gets to it
+//
+//  The reference is CalculateLopassParams() worked through with libm in double and run as
+//  a Direct Form 1 in double, switching coefficients at each event with the history carried
+//  over. The first four variants and processor implement exactly that and are held to a
+//  minimum SNR against it; the smoothed, multirate and linear phase paths are different
+//  filters on purpose and are checked for invariance only. The report gives each variant's
+//  worst SNR and largest error against the reference and its largest difference between
+//  partitions. A failure prints the seed and trial, which --seed and --trial reproduce.
+//
+//  lopass-invariance [options]
+//
+
+#include "LoPassBiquad.hpp"
+#include "LoPassFilterBank.hpp"
+#include "LoPassParallel.hpp"
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include "LoPassToolOptions.hpp"
+#include <algorithm>
+#include <getopt.h>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static constexpr unsigned kDefaultTrials        = 100;
+static constexpr unsigned kDefaultFrames        = 4096;
+static constexpr uint32_t kDefaultSeed          = 1;
+
+/// Most parameter events in a trial, and most channels.
+static constexpr unsigned kMaxEvents            = 12;
+static constexpr unsigned kMaxChannels          = 8;
+
+/// Threads for the parallel variant, whatever the machine has.
+static constexpr unsigned kParallelThreads      = 4;
+
+/// Largest difference between partitions of the parallel variant, relative to the peak
+/// output; LoPassParallel.hpp measured 6.3e-8 at its default tolerance.
+static constexpr double kParallelTolerance      = 1e-6;
+
+/// Failures printed in full; the rest are only counted.
+static constexpr unsigned kPrintedFailures      = 10;
+
+static const double kSampleRates[]              = { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+enum Signal { kSignal_Noise, kSignal_Sine, kSignal_Impulses, kNumberOfSignals };
+static const char *const kSignalNames[]         = { "noise", "sine", "impulses" };
+
+enum PartitionKind { kPartition_OneCall, kPartition_Frames, kPartition_Random, kPartition_Buffers, kNumberOfPartitionKinds };
+static const char *const kPartitionNames[]      = { "one call", "single frames", "random cuts", "host buffers" };
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Trials
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// A parameter change from mFrame on; the first is always at frame 0.
+struct Event {
+    unsigned    mFrame;
+    double      mCutoff;        // Hz
+    double      mResonance;     // dB
+};
+
+struct Trial {
+    unsigned            mIndex;
+    double              mSampleRate;
+    unsigned            mChannels;
+    unsigned            mFrames;
+    Signal              mSignal;
+    double              mSmoothing;     // ms
+    std::vector<Event>  mSchedule;
+};
+
+/// Slice starts, ascending from 0; a slice runs to the next start or the end.
+typedef std::vector<unsigned> Partition;
+
+/// xorshift32, so a trial is the same everywhere.
+class Random {
+
+public:
+    explicit Random(uint32_t inSeed) : mState(inSeed != 0 ? inSeed : 0x9e3779b9u) { }
+
+    uint32_t Next() {
+        mState ^= mState << 13;
+        mState ^= mState >> 17;
+        mState ^= mState << 5;
+        return mState;
+    }
+
+    double Uniform(double inLow, double inHigh) { return inLow + (inHigh - inLow) * (Next() / 4294967296.0); }
+    unsigned Below(unsigned inCount) { return (unsigned)(Next() % inCount); }
+
+private:
+    uint32_t mState;
+};
+
+static Event RandomEvent(Random &ioRandom, unsigned inFrame, double inSampleRate) {
+
+    Event event;
+    event.mFrame        = inFrame;
+    event.mCutoff       = 20.0 * pow(0.5 * inSampleRate / 20.0, ioRandom.Uniform(0.0, 1.0));
+    event.mResonance    = ioRandom.Uniform(kMinimumValue_LoPass_Resonance, kMaximumValue_LoPass_Resonance);
+    return event;
+}
+
+static Trial NewTrial(uint32_t inSeed, unsigned inIndex, unsigned inFrames) {
+
+    Random random(inSeed * 2654435761u + inIndex * 2246822519u + 1);
+
+    Trial trial;
+    trial.mIndex        = inIndex;
+    trial.mSampleRate   = kSampleRates[random.Below(sizeof(kSampleRates) / sizeof(kSampleRates[0]))];
+    trial.mChannels     = 1 + random.Below(kMaxChannels);
+    trial.mFrames       = inFrames;
+    trial.mSignal       = (Signal)random.Below(kNumberOfSignals);
+    trial.mSmoothing    = random.Uniform(1.0, 100.0);
+
+    // a quarter of the trials hold still
+    unsigned events = random.Below(4) == 0 ? 0 : random.Below(kMaxEvents) + 1;
+
+    trial.mSchedule.push_back(RandomEvent(random, 0, trial.mSampleRate));
+    for (unsigned e = 0; e < events; e++) { trial.mSchedule.push_back(RandomEvent(random, 1 + random.Below(inFrames - 1), trial.mSampleRate)); }
+
+    std::sort(trial.mSchedule.begin(), trial.mSchedule.end(), [](const Event &a, const Event &b) { return a.mFrame < b.mFrame; });
+
+    // one event per frame; a later one at the same frame replaces it
+    std::vector<Event> schedule;
+    for (size_t e = 0; e < trial.mSchedule.size(); e++) {
+        if (!schedule.empty() && schedule.back().mFrame == trial.mSchedule[e].mFrame) { schedule.pop_back(); }
+        schedule.push_back(trial.mSchedule[e]);
+    }
+    trial.mSchedule.swap(schedule);
+
+    return trial;
+}
+
+static void MakeInput(const Trial &inTrial, std::vector<float> &outInput) {
+
+    Random random(inTrial.mIndex * 747796405u + 1);
+    outInput.resize((size_t)inTrial.mChannels * inTrial.mFrames);
+
+    for (unsigned c = 0; c < inTrial.mChannels; c++) {
+        float *channel = &outInput[(size_t)c * inTrial.mFrames];
+        double freq = random.Uniform(20.0, 0.45 * inTrial.mSampleRate);
+        unsigned spacing = 16 + random.Below(500);
+
+        for (unsigned i = 0; i < inTrial.mFrames; i++) {
+            switch (inTrial.mSignal) {
+                case kSignal_Noise:     channel[i] = (float)random.Uniform(-0.5, 0.5); break;
+                case kSignal_Sine:      channel[i] = (float)(0.5 * sin(2.0 * M_PI * freq * i / inTrial.mSampleRate)); break;
+                default:                channel[i] = i % spacing == 0 ? 0.5f : 0.0f; break;
+            }
+        }
+    }
+}
+
+/// The cuts the schedule forces, plus those of the kind asked for.
+static void MakePartition(const Trial &inTrial, PartitionKind inKind, Random &ioRandom, Partition &outPartition) {
+
+    outPartition.clear();
+    for (size_t e = 0; e < inTrial.mSchedule.size(); e++) { outPartition.push_back(inTrial.mSchedule[e].mFrame); }
+
+    switch (inKind) {
+        case kPartition_Frames:
+            for (unsigned i = 0; i < inTrial.mFrames; i++) { outPartition.push_back(i); }
+            break;
+        case kPartition_Random: {
+            unsigned cuts = 1 + ioRandom.Below(64);
+            for (unsigned n = 0; n < cuts; n++) { outPartition.push_back(ioRandom.Below(inTrial.mFrames)); }
+            break;
+        }
+        case kPartition_Buffers: {
+            unsigned buffer = 1 + ioRandom.Below(1024);
+            for (unsigned i = 0; i < inTrial.mFrames; i += buffer) { outPartition.push_back(i); }
+            break;
+        }
+        default:
+            break;
+    }
+
+    std::sort(outPartition.begin(), outPartition.end());
+    outPartition.erase(std::unique(outPartition.begin(), outPartition.end()), outPartition.end());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Reference
+//
+// The design without LoPassFastMath.h, and Direct Form 1 without rounding to float.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct ReferenceCoefficients {
+    double mA0, mA1, mA2, mB1, mB2;
+};
+
+static void ReferenceDesign(double inFreq, double inResonance, ReferenceCoefficients &out) {
+
+    double r        = pow(10.0, 0.05 * -inResonance);
+    double sinHalf  = sin(0.5 * M_PI * inFreq);
+    double s        = sinHalf * sinHalf;
+    double k        = 0.5 * r * sin(M_PI * inFreq);
+    double scale    = 1.0 / (1.0 + k);
+
+    out.mA0 = s * scale;
+    out.mA1 = 2.0 * s * scale;
+    out.mA2 = s * scale;
+    out.mB1 = -2.0 * cos(M_PI * inFreq) * scale;
+    out.mB2 = (1.0 - k) * scale;
+}
+
+static void ReferenceFilter(const Trial &inTrial, const std::vector<float> &inInput, std::vector<double> &outOutput) {
+
+    outOutput.resize(inInput.size());
+
+    for (unsigned c = 0; c < inTrial.mChannels; c++) {
+        const float *source = &inInput[(size_t)c * inTrial.mFrames];
+        double *dest = &outOutput[(size_t)c * inTrial.mFrames];
+
+        double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+        ReferenceCoefficients k = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+        size_t next = 0;
+
+        for (unsigned i = 0; i < inTrial.mFrames; i++) {
+            if (next < inTrial.mSchedule.size() && inTrial.mSchedule[next].mFrame == i) {
+                double freq, resonance;
+                LoPassNormaliseParameters(inTrial.mSchedule[next].mCutoff, inTrial.mSchedule[next].mResonance,
+                                          inTrial.mSampleRate, freq, resonance);
+                ReferenceDesign(freq, resonance, k);
+                next++;
+            }
+
+            double x = source[i];
+            double y = k.mA0 * x + k.mA1 * x1 + k.mA2 * x2 - k.mB1 * y1 - k.mB2 * y2;
+            x2 = x1; x1 = x; y2 = y1; y1 = y;
+            dest[i] = y;
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Variants
+//
+// Process() is given one channel's slice with the event in force over it, which changes
+// only at the start of a slice; Run() follows each slice of every channel.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Variant {
+
+public:
+    virtual ~Variant() { }
+
+    virtual void Process(unsigned inChannel, const Event &inEvent, const float *inSourceP, float *inDestP, unsigned inFrames) = 0;
+    virtual void Run() { }
+};
+
+class BiquadVariant : public Variant {
+
+public:
+    explicit BiquadVariant(const Trial &inTrial, LoPassParallelBiquad *inParallel = NULL) :
+        mSampleRate(inTrial.mSampleRate),
+        mParallel(inParallel),
+        mChannels(inTrial.mChannels) {
+
+        for (size_t c = 0; c < mChannels.size(); c++) { mChannels[c].mEvent = NULL; }
+    }
+
+    void Process(unsigned inChannel, const Event &inEvent, const float *inSourceP, float *inDestP, unsigned inFrames) {
+
+        Channel &channel = mChannels[inChannel];
+
+        if (channel.mEvent != &inEvent) {
+            double freq, resonance;
+            LoPassNormaliseParameters(inEvent.mCutoff, inEvent.mResonance, mSampleRate, freq, resonance);
+            LoPassFilter::CalculateLopassParams(freq, resonance, channel.mCoefficients);
+            channel.mEvent = &inEvent;
+        }
+
+        if (mParallel != NULL) {
+            mParallel->Process(channel.mBiquad, channel.mCoefficients, inSourceP, inDestP, inFrames);
+        } else {
+            channel.mBiquad.Process(channel.mCoefficients, inSourceP, inDestP, inFrames);
+        }
+    }
+
+private:
+    struct Channel {
+        LoPassBiquad        mBiquad;
+        LoPassCoefficients  mCoefficients;
+        const Event         *mEvent;
+    };
+
+    double                  mSampleRate;
+    LoPassParallelBiquad    *mParallel;
+    std::vector<Channel>    mChannels;
+};
+
+class ParallelVariant : public BiquadVariant {
+
+public:
+    explicit ParallelVariant(const Trial &inTrial) :
+        BiquadVariant(inTrial, &mParallel),
+        mParallel(kParallelThreads) { }
+
+private:
+    LoPassParallelBiquad    mParallel;
+};
+
+class BankVariant : public Variant {
+
+public:
+    explicit BankVariant(const Trial &inTrial) :
+        mBank(inTrial.mSampleRate),
+        mEvents(inTrial.mChannels, (const Event *)NULL) {
+
+        for (unsigned c = 0; c < inTrial.mChannels; c++) {
+            mStreams.push_back(mBank.AddStream(inTrial.mSchedule[0].mCutoff, inTrial.mSchedule[0].mResonance));
+        }
+    }
+
+    void Process(unsigned inChannel, const Event &inEvent, const float *inSourceP, float *inDestP, unsigned inFrames) {
+
+        if (mEvents[inChannel] != &inEvent) {
+            mBank.SetParameters(mStreams[inChannel], inEvent.mCutoff, inEvent.mResonance);
+            mEvents[inChannel] = &inEvent;
+        }
+
+        mBank.Submit(mStreams[inChannel], inSourceP, inDestP, inFrames);
+    }
+
+    void Run() { mBank.Run(); }
+
+private:
+    LoPassFilterBank            mBank;
+    std::vector<unsigned>       mStreams;
+    std::vector<const Event *>  mEvents;
+};
+
+class SmoothedVariant : public Variant {
+
+public:
+    explicit SmoothedVariant(const Trial &inTrial) : mSampleRate(inTrial.mSampleRate) {
+
+        for (unsigned c = 0; c < inTrial.mChannels; c++) {
+            mFilters.emplace_back(new LoPassSmoothedBiquad(inTrial.mSampleRate));
+            mFilters.back()->GetControlRate().SetSmoothingTime(0.0);
+        }
+    }
+
+    void Process(unsigned inChannel, const Event &inEvent, const float *inSourceP, float *inDestP, unsigned inFrames) {
+
+        double freq, resonance;
+        LoPassNormaliseParameters(inEvent.mCutoff, inEvent.mResonance, mSampleRate, freq, resonance);
+
+        mFilters[inChannel]->SetTarget(freq, resonance);
+        mFilters[inChannel]->Process(inSourceP, inDestP, inFrames);
+    }
+
+private:
+    double                                              mSampleRate;
+    std::vector<std::unique_ptr<LoPassSmoothedBiquad> > mFilters;
+};
+
+enum ProcessorMode { kProcessor_IIR, kProcessor_Smoothed, kProcessor_Multirate, kProcessor_LinearPhase };
+
+class ProcessorVariant : public Variant {
+
+public:
+    ProcessorVariant(const Trial &inTrial, ProcessorMode inMode) {
+
+        mSettings.mLinearPhase  = inMode == kProcessor_LinearPhase;
+        mSettings.mMultirate    = inMode == kProcessor_Multirate;
+        mSettings.mSmoothing    = inMode == kProcessor_IIR ? 0.0 : inTrial.mSmoothing;
+        mSettings.mCutoff       = inTrial.mSchedule[0].mCutoff;
+        mSettings.mResonance    = inTrial.mSchedule[0].mResonance;
+
+        for (unsigned c = 0; c < inTrial.mChannels; c++) {
+            mProcessors.emplace_back(new LoPassProcessor(inTrial.mSampleRate));
+            mProcessors.back()->Prepare(mSettings);
+        }
+    }
+
+    void Process(unsigned inChannel, const Event &inEvent, const float *inSourceP, float *inDestP, unsigned inFrames) {
+
+        mSettings.mCutoff       = inEvent.mCutoff;
+        mSettings.mResonance    = inEvent.mResonance;
+
+        mProcessors[inChannel]->Process(mSettings, inSourceP, inDestP, inFrames);
+    }
+
+private:
+    LoPassSettings                                  mSettings;
+    std::vector<std::unique_ptr<LoPassProcessor> >  mProcessors;
+};
+
+struct VariantInfo {
+    const char  *mName;
+    Variant     *(*mNew)(const Trial &inTrial);
+    double      mMinimumSNR;        // dB against the reference; 0 for none
+    double      mTolerance;         // between partitions, relative to the peak
+    bool        mStaticOnly;
+};
+
+/// The plain filter is held to the 120 dB LoPassBiquad.hpp promises.
+static const VariantInfo kVariants[] = {
+    { "biquad",             [](const Trial &t) -> Variant * { return new BiquadVariant(t); },                                120.0, 0.0, false },
+    { "parallel",           [](const Trial &t) -> Variant * { return new ParallelVariant(t); },                              120.0, kParallelTolerance, false },
+    { "bank",               [](const Trial &t) -> Variant * { return new BankVariant(t); },                                  120.0, 0.0, false },
+    { "smoothed",           [](const Trial &t) -> Variant * { return new SmoothedVariant(t); },                              120.0, 0.0, false },
+    { "processor",          [](const Trial &t) -> Variant * { return new ProcessorVariant(t, kProcessor_IIR); },             120.0, 0.0, false },
+    { "processor-smooth",   [](const Trial &t) -> Variant * { return new ProcessorVariant(t, kProcessor_Smoothed); },       0.0, 0.0, false },
+    { "multirate",          [](const Trial &t) -> Variant * { return new ProcessorVariant(t, kProcessor_Multirate); },      0.0, 0.0, false },
+    { "linear-phase",       [](const Trial &t) -> Variant * { return new ProcessorVariant(t, kProcessor_LinearPhase); },    0.0, 0.0, true },
+};
+
+static constexpr unsigned kNumberOfVariants = sizeof(kVariants) / sizeof(kVariants[0]);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Render()
+//
+// A fresh variant through one partition of the trial.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void Render(const VariantInfo &inVariant, const Trial &inTrial, const Partition &inPartition,
+                   const std::vector<float> &inInput, std::vector<float> &outOutput) {
+
+    std::unique_ptr<Variant> variant(inVariant.mNew(inTrial));
+    outOutput.assign(inInput.size(), 0.0f);
+
+    size_t event = 0;
+
+    for (size_t s = 0; s < inPartition.size(); s++) {
+        unsigned begin  = inPartition[s];
+        unsigned end    = s + 1 < inPartition.size() ? inPartition[s + 1] : inTrial.mFrames;
+
+        while (event + 1 < inTrial.mSchedule.size() && inTrial.mSchedule[event + 1].mFrame <= begin) { event++; }
+
+        for (unsigned c = 0; c < inTrial.mChannels; c++) {
+            size_t at = (size_t)c * inTrial.mFrames + begin;
+            variant->Process(c, inTrial.mSchedule[event], &inInput[at], &outOutput[at], end - begin);
+        }
+        variant->Run();
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Results
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Result {
+    unsigned    mTrials;
+    unsigned    mPartitions;
+    unsigned    mExact;             // partitions identical to the one call
+    unsigned    mFailures;
+    double      mWorstSNR;
+    double      mSumSNR;
+    double      mMaxError;
+    double      mMaxDifference;     // between partitions, relative to the peak
+
+    Result() : mTrials(0), mPartitions(0), mExact(0), mFailures(0), mWorstSNR(INFINITY), mSumSNR(0.0), mMaxError(0.0), mMaxDifference(0.0) { }
+};
+
+/// Worst channel's SNR against the reference, and the largest error anywhere.
+static void Measure(const Trial &inTrial, const std::vector<float> &inOutput, const std::vector<double> &inReference,
+                    double &outSNR, double &outMaxError) {
+
+    outSNR = INFINITY;
+    outMaxError = 0.0;
+
+    for (unsigned c = 0; c < inTrial.mChannels; c++) {
+        double signal = 0.0, noise = 0.0;
+
+        for (unsigned i = 0; i < inTrial.mFrames; i++) {
+            size_t at = (size_t)c * inTrial.mFrames + i;
+            double error = inOutput[at] - inReference[at];
+
+            signal += inReference[at] * inReference[at];
+            noise += error * error;
+            outMaxError = std::max(outMaxError, fabs(error));
+        }
+
+        // a silent reference can only be matched exactly
+        double snr = noise == 0.0 ? INFINITY : signal == 0.0 ? -INFINITY : 10.0 * log10(signal / noise);
+        outSNR = std::min(outSNR, snr);
+    }
+}
+
+static void PrintFailure(uint32_t inSeed, const Trial &inTrial, const char *inVariant, const char *inWhat) {
+
+    printf("FAIL %s, seed %u trial %u: %s\n", inVariant, inSeed, inTrial.mIndex, inWhat);
+    printf("     %g Hz, %u ch, %u frames, %s, %.1f ms smoothing, %zu events:", inTrial.mSampleRate, inTrial.mChannels,
+           inTrial.mFrames, kSignalNames[inTrial.mSignal], inTrial.mSmoothing, inTrial.mSchedule.size());
+
+    for (size_t e = 0; e < inTrial.mSchedule.size(); e++) {
+        printf(" %u:%.1fHz/%.1fdB", inTrial.mSchedule[e].mFrame, inTrial.mSchedule[e].mCutoff, inTrial.mSchedule[e].mResonance);
+    }
+    printf("\n");
+}
+
+static void PrintTable(const Result *inResults) {
+
+    printf("\n%-17s %6s %6s %8s %9s %9s %11s %11s %5s\n", "variant", "trials", "parts", "exact", "min SNR", "mean SNR",
+           "max error", "max diff", "fail");
+
+    for (unsigned v = 0; v < kNumberOfVariants; v++) {
+        const Result &result = inResults[v];
+        if (result.mTrials == 0) { continue; }
+
+        char worst[16] = "-", mean[16] = "-", error[16] = "-";
+
+        if (kVariants[v].mMinimumSNR > 0.0 && result.mTrials > 0) {
+            snprintf(worst, sizeof(worst), "%.1f", result.mWorstSNR);
+            snprintf(mean, sizeof(mean), "%.1f", result.mSumSNR / result.mTrials);
+            snprintf(error, sizeof(error), "%.3g", result.mMaxError);
+        }
+
+        printf("%-17s %6u %6u %7.1f%% %9s %9s %11s %11.3g %5u\n", kVariants[v].mName, result.mTrials, result.mPartitions,
+               100.0 * result.mExact / std::max(result.mPartitions, 1u), worst, mean, error, result.mMaxDifference, result.mFailures);
+    }
+}
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-invariance [options]\n"
+            "\n"
+            "  -n, --trials N       random trials (default %u)\n"
+            "  -f, --frames N       frames per trial (default %u)\n"
+            "  -s, --seed N         seed for the trials (default %u)\n"
+            "  -t, --trial N        run only trial N of the seed\n"
+            "  -V, --variant NAME   run only this variant\n"
+            "  -v, --verbose        print each trial\n",
+            kDefaultTrials, kDefaultFrames, kDefaultSeed);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "trials",     required_argument,  NULL, 'n' },
+        { "frames",     required_argument,  NULL, 'f' },
+        { "seed",       required_argument,  NULL, 's' },
+        { "trial",      required_argument,  NULL, 't' },
+        { "variant",    required_argument,  NULL, 'V' },
+        { "verbose",    no_argument,        NULL, 'v' },
+        { "help",       no_argument,        NULL, 'h' },
+        { NULL,         0,                  NULL, 0 }
+    };
+
+    double trials = kDefaultTrials;
+    double frames = kDefaultFrames;
+    double seed = kDefaultSeed;
+    double only = -1.0;
+    const char *variantName = NULL;
+    bool verbose = false;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "n:f:s:t:V:vh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'n': ok = LoPassParseNumber(optarg, trials) && trials >= 1.0 && trials <= 1e7; break;
+            case 'f': ok = LoPassParseNumber(optarg, frames) && frames >= 2.0 && frames <= 1048576.0; break;
+            case 's': ok = LoPassParseNumber(optarg, seed) && seed >= 0.0 && seed < 4294967296.0 && seed == floor(seed); break;
+            case 't': ok = LoPassParseNumber(optarg, only) && only >= 0.0 && only == floor(only); break;
+            case 'V':
+                variantName = optarg;
+                ok = false;
+                for (unsigned v = 0; v < kNumberOfVariants; v++) { ok = ok || strcmp(optarg, kVariants[v].mName) == 0; }
+                break;
+            case 'v': verbose = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-invariance: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    unsigned first = only >= 0.0 ? (unsigned)only : 0;
+    unsigned last = only >= 0.0 ? (unsigned)only + 1 : (unsigned)trials;
+
+    Result results[kNumberOfVariants];
+    unsigned failures = 0;
+
+    std::vector<float> input, whole, sliced;
+    std::vector<double> reference;
+    Partition partition;
+
+    for (unsigned t = first; t < last; t++) {
+        Trial trial = NewTrial((uint32_t)seed, t, (unsigned)frames);
+        MakeInput(trial, input);
+        ReferenceFilter(trial, input, reference);
+
+        if (verbose) {
+            printf("trial %u: %g Hz, %u ch, %s, %zu events\n", t, trial.mSampleRate, trial.mChannels,
+                   kSignalNames[trial.mSignal], trial.mSchedule.size());
+        }
+
+        for (unsigned v = 0; v < kNumberOfVariants; v++) {
+            const VariantInfo &variant = kVariants[v];
+            Result &result = results[v];
+
+            if (variantName != NULL && strcmp(variantName, variant.mName) != 0) { continue; }
+
+            Trial held = trial;
+            if (variant.mStaticOnly) { held.mSchedule.resize(1); }
+
+            Random random((uint32_t)seed ^ (t * 2654435761u) ^ (v * 40503u));
+
+            MakePartition(held, kPartition_OneCall, random, partition);
+            Render(variant, held, partition, input, whole);
+
+            result.mTrials++;
+
+            if (variant.mMinimumSNR > 0.0) {
+                double snr, error;
+                Measure(held, whole, reference, snr, error);
+
+                result.mWorstSNR = std::min(result.mWorstSNR, snr);
+                result.mSumSNR += std::min(snr, 300.0);
+                result.mMaxError = std::max(result.mMaxError, error);
+
+                if (snr < variant.mMinimumSNR) {
+                    char what[128];
+                    snprintf(what, sizeof(what), "%.1f dB SNR against the reference, under %.0f dB", snr, variant.mMinimumSNR);
+                    if (result.mFailures++ == 0 || failures < kPrintedFailures) { PrintFailure((uint32_t)seed, held, variant.mName, what); }
+                    failures++;
+                }
+            }
+
+            double peak = 0.0;
+            for (size_t i = 0; i < whole.size(); i++) { peak = std::max(peak, (double)fabsf(whole[i])); }
+
+            for (unsigned k = kPartition_OneCall + 1; k < kNumberOfPartitionKinds; k++) {
+                MakePartition(held, (PartitionKind)k, random, partition);
+                Render(variant, held, partition, input, sliced);
+
+                size_t first = sliced.size();
+                double difference = 0.0;
+
+                for (size_t i = 0; i < sliced.size(); i++) {
+                    if (sliced[i] != whole[i] && !(sliced[i] != sliced[i] && whole[i] != whole[i])) {
+                        if (first == sliced.size()) { first = i; }
+                        difference = std::max(difference, (double)fabsf(sliced[i] - whole[i]));
+                    }
+                }
+
+                double relative = peak > 0.0 ? difference / peak : difference;
+
+                result.mPartitions++;
+                if (first == sliced.size()) { result.mExact++; }
+                result.mMaxDifference = std::max(result.mMaxDifference, relative);
+
+                if (first != sliced.size() && !(relative <= variant.mTolerance)) {
+                    char what[160];
+                    snprintf(what, sizeof(what), "%s differs from one call from channel %zu frame %zu, by up to %.3g of the peak",
+                             kPartitionNames[k], first / held.mFrames, first % held.mFrames, relative);
+                    if (result.mFailures++ == 0 || failures < kPrintedFailures) { PrintFailure((uint32_t)seed, held, variant.mName, what); }
+                    failures++;
+                }
+            }
+        }
+    }
+
+    printf("%u trials of %u frames, seed %u\n", last - first, (unsigned)frames, (unsigned)seed);
+    PrintTable(results);
+
+    if (failures > 0) {
+        printf("\n%u failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+//
+//  LoPassPerfCounters.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassPerfCounters.hpp"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+static const char *const kCounterNames[kNumberOfPerfCounters] = {
+    "instructions", "cycles", "l1d_misses", "llc_misses", "branch_misses", "fp_assists"
+};
+
+const char *LoPassPerfCounterName(LoPassPerfCounter inCounter) {
+    return kCounterNames[inCounter];
+}
+
+LoPassPerfCounters::LoPassPerfCounters() {
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) { mFiles[i] = -1; }
+}
+
+LoPassPerfCounters::~LoPassPerfCounters() {
+    Close();
+}
+
+bool LoPassPerfCounters::IsAnyAvailable() const {
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) {
+        if (mFiles[i] >= 0) { return true; }
+    }
+    return false;
+}
+
+#if defined(__linux__)
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// FP assist event
+//
+// The raw event for the processor in /proc/cpuinfo, or 0 if it has none we know. Intel
+// family 6 models from Ice Lake on count assists with ASSISTS.FP (0xC1, umask 0x02), and
+// before that with FP_ASSIST.ANY (0xCA, umask 0x1E).
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static uint64_t GetFPAssistEvent() {
+
+    FILE *file = fopen("/proc/cpuinfo", "r");
+    if (file == NULL) { return 0; }
+
+    char line[512];
+    bool intel = false;
+    long family = -1, model = -1;
+
+    while (fgets(line, sizeof(line), file) != NULL && (family < 0 || model < 0)) {
+        const char *colon = strchr(line, ':');
+        if (colon == NULL) { continue; }
+
+        if (strncmp(line, "vendor_id", 9) == 0) {
+            intel = strstr(colon, "GenuineIntel") != NULL;
+        } else if (strncmp(line, "cpu family", 10) == 0) {
+            family = strtol(colon + 1, NULL, 10);
+        } else if (strncmp(line, "model\t", 6) == 0) {
+            model = strtol(colon + 1, NULL, 10);
+        }
+    }
+    fclose(file);
+
+    if (!intel || family != 6) { return 0; }
+
+    static const long kIceLakeAndLater[] = { 0x6A, 0x6C, 0x7D, 0x7E, 0x8C, 0x8D, 0x8F, 0x97, 0x9A, 0xA7, 0xAA, 0xAC, 0xB7, 0xBA, 0xBF, 0xCF };
+
+    for (size_t i = 0; i < sizeof(kIceLakeAndLater) / sizeof(kIceLakeAndLater[0]); i++) {
+        if (model == kIceLakeAndLater[i]) { return 0x02C1; }
+    }
+
+    return 0x1ECA;
+}
+
+static int OpenCounter(uint32_t inType, uint64_t inConfig) {
+
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size             = sizeof(attributes);
+    attributes.type             = inType;
+    attributes.config           = inConfig;
+    attributes.disabled         = 1;
+    attributes.exclude_kernel   = 1;
+    attributes.exclude_hv       = 1;
+    attributes.read_format      = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+static uint64_t CacheMissConfig(uint64_t inCache) {
+    return inCache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPerfCounters::Open()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassPerfCounters::Open() {
+
+    Close();
+
+    uint64_t assist = GetFPAssistEvent();
+
+    struct { uint32_t mType; uint64_t mConfig; } events[kNumberOfPerfCounters] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HW_CACHE, CacheMissConfig(PERF_COUNT_HW_CACHE_L1D) },
+        { PERF_TYPE_HW_CACHE, CacheMissConfig(PERF_COUNT_HW_CACHE_LL) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_RAW,      assist }
+    };
+
+    int firstError = 0;
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) {
+        if (i == kPerfCounter_FPAssists && assist == 0) { continue; }
+
+        mFiles[i] = OpenCounter(events[i].mType, events[i].mConfig);
+        if (mFiles[i] < 0 && firstError == 0) { firstError = errno; }
+    }
+
+    if (IsAnyAvailable()) {
+        mError.clear();
+        return true;
+    }
+
+    switch (firstError) {
+        case ENOENT:
+        case ENODEV:
+        case EOPNOTSUPP:
+            mError = "no hardware counters on this machine (a virtual machine without a virtual PMU?)";
+            break;
+        case EACCES:
+        case EPERM:
+            mError = "not permitted to open counters (see /proc/sys/kernel/perf_event_paranoid)";
+            break;
+        case ENOSYS:
+            mError = "the kernel has no perf_event_open";
+            break;
+        default:
+            mError = std::string("perf_event_open failed: ") + strerror(firstError);
+            break;
+    }
+
+    return false;
+}
+
+void LoPassPerfCounters::Close() {
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) {
+        if (mFiles[i] >= 0) { close(mFiles[i]); }
+        mFiles[i] = -1;
+    }
+}
+
+void LoPassPerfCounters::Start() {
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) {
+        if (mFiles[i] < 0) { continue; }
+        ioctl(mFiles[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(mFiles[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void LoPassPerfCounters::Stop() {
+
+    for (int i = 0; i < kNumberOfPerfCounters; i++) {
+        if (mFiles[i] >= 0) { ioctl(mFiles[i], PERF_EVENT_IOC_DISABLE, 0); }
+    }
+}
+
+double LoPassPerfCounters::Read(LoPassPerfCounter inCounter) const {
+
+    if (mFiles[inCounter] < 0) { return -1.0; }
+
+    // value, time enabled, time running
+    uint64_t values[3];
+    if (read(mFiles[inCounter], values, sizeof(values)) != (ssize_t)sizeof(values) || values[2] == 0) { return -1.0; }
+
+    return (double)values[0] * ((double)values[1] / (double)values[2]);
+}
+
+#else
+
+bool LoPassPerfCounters::Open() {
+
+    mError = "hardware counters are only read on Linux";
+    return false;
+}
+
+void LoPassPerfCounters::Close() { }
+void LoPassPerfCounters::Start() { }
+void LoPassPerfCounters::Stop() { }
+
+double LoPassPerfCounters::Read(LoPassPerfCounter) const {
+    return -1.0;
+}
+
+#endif
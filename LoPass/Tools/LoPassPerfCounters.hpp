@@ -0,0 +1,77 @@
+//
+//  LoPassPerfCounters.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Hardware performance counters around a stretch of the calling thread (Linux).
+//
+
+#ifndef LoPassPerfCounters_hpp
+#define LoPassPerfCounters_hpp
+
+#include <stdint.h>
+#include <string>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Perf Counters
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// What the processor did while a kernel ran, to tell apart what limits it: few instructions
+// per cycle with few misses is the latency of the recursion, misses per sample are memory,
+// and floating point assists are denormals being handled in microcode. Each counter is
+// opened with perf_event_open() on its own, counting user space in the calling thread only,
+// so anything a kernel hands to other threads isn't counted. Counters the processor or the
+// kernel won't give are left out and read as unavailable; on a machine that gives none,
+// under a hypervisor without a virtual PMU, with perf_event_paranoid too high, or off
+// Linux, Open() says why and the rest still works. When there are more counters than the
+// processor has registers the kernel takes turns, and the counts are scaled up by the time
+// each was actually counting.
+//
+// Floating point assists have no generic event, so it is the raw Intel event: FP_ASSIST.ANY
+// up to Skylake, ASSISTS.FP from Ice Lake on. Elsewhere it's unavailable.
+
+enum LoPassPerfCounter {
+    kPerfCounter_Instructions   = 0,
+    kPerfCounter_Cycles         = 1,    // core cycles, unlike the time stamp counter
+    kPerfCounter_L1DMisses      = 2,    // L1 data cache read misses
+    kPerfCounter_LLCMisses      = 3,    // last level cache read misses
+    kPerfCounter_BranchMisses   = 4,
+    kPerfCounter_FPAssists      = 5,
+    kNumberOfPerfCounters       = 6
+};
+
+/// The JSON key, "l1d_misses".
+const char *LoPassPerfCounterName(LoPassPerfCounter inCounter);
+
+class LoPassPerfCounters {
+
+public:
+    LoPassPerfCounters();
+    ~LoPassPerfCounters();
+
+    /// Opens every counter it can. False if none could be, with the reason in GetError().
+    bool Open();
+    void Close();
+
+    bool IsAvailable(LoPassPerfCounter inCounter) const { return mFiles[inCounter] >= 0; }
+    bool IsAnyAvailable() const;
+    const std::string &GetError() const { return mError; }
+
+    /// Zero and start every open counter / stop them. Start() and Stop() are a system call
+    /// per counter, so they belong around a stretch of work, not inside it.
+    void Start();
+    void Stop();
+
+    /// Count between the last Start() and Stop(); < 0 if the counter isn't available or
+    /// never got a turn.
+    double Read(LoPassPerfCounter inCounter) const;
+
+private:
+    LoPassPerfCounters(const LoPassPerfCounters&);
+    LoPassPerfCounters &operator=(const LoPassPerfCounters&);
+
+    int         mFiles[kNumberOfPerfCounters];
+    std::string mError;
+};
+
+#endif /* LoPassPerfCounters_hpp */
@@ -0,0 +1,511 @@
+//
+//  LoPassPipeline.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassPipeline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr unsigned kPipeline_Stages = 5;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassScheduler::LoPassScheduler()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassScheduler::LoPassScheduler(unsigned inThreads) :
+    mQuit(false) {
+    
+    if (inThreads == 0) { inThreads = std::thread::hardware_concurrency(); }
+    if (inThreads == 0) { inThreads = 1; }
+    
+    for (unsigned i = 0; i < inThreads; i++) { mThreads.push_back(std::thread(&LoPassScheduler::Run, this)); }
+}
+
+LoPassScheduler::~LoPassScheduler() {
+    
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+    }
+    
+    mWake.notify_all();
+    
+    for (size_t i = 0; i < mThreads.size(); i++) { mThreads[i].join(); }
+}
+
+void LoPassScheduler::Post(std::coroutine_handle<> inCoroutine) {
+    
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReady.push_back(inCoroutine);
+    }
+    
+    mWake.notify_one();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassScheduler::Run()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassScheduler::Run() {
+    
+    std::unique_lock<std::mutex> lock(mMutex);
+    
+    for (;;) {
+    
+        mWake.wait(lock, [this] { return mQuit || !mReady.empty(); });
+        
+        if (mReady.empty()) { return; }
+        
+        std::coroutine_handle<> coroutine = mReady.front();
+        mReady.pop_front();
+        
+        lock.unlock();
+        coroutine.resume();
+        lock.lock();
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Block
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct LoPassPipeline::Block {
+    std::vector<uint8_t>                mInput;     // raw input sample data
+    std::vector<std::vector<float> >    mSource;    // decoded, one buffer per channel
+    std::vector<std::vector<float> >    mDest;      // filtered
+    std::vector<float *>                mSourceP;
+    std::vector<const float *>          mDestP;
+    std::vector<uint8_t>                mOutput;    // encoded
+    
+    unsigned    mFrames;        // read from the input
+    unsigned    mLength;        // through the processors, including the latency flush
+    unsigned    mSkip;          // of those, still inside the latency
+    uint64_t    mWritten;       // output frames before this block
+    bool        mLast;          // no data, just the end of the stream
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Stage
+//
+// A stage starts suspended and is posted to the scheduler by Render(). When it finishes it
+// tells the pipeline from final_suspend(), where the frame is already suspended and can
+// safely be destroyed by the thread waiting in Render().
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct LoPassPipeline::Stage {
+    
+    struct promise_type {
+        
+        LoPassPipeline *mPipeline;
+        
+        template <class... Queues>
+        promise_type(LoPassPipeline &inPipeline, Queues &...) : mPipeline(&inPipeline) { }
+        
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> inCoroutine) noexcept { inCoroutine.promise().mPipeline->Finished(); }
+            void await_resume() noexcept { }
+        };
+        
+        Stage get_return_object() { return Stage { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return std::suspend_always(); }
+        FinalAwaiter final_suspend() noexcept { return FinalAwaiter(); }
+        void return_void() { }
+        void unhandled_exception() { std::terminate(); }
+    };
+    
+    std::coroutine_handle<promise_type> mCoroutine;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::LoPassPipeline()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassPipeline::LoPassPipeline(const LoPassRenderOptions &inOptions, LoPassScheduler &inScheduler, unsigned inDepth) :
+    mOptions(inOptions),
+    mScheduler(inScheduler),
+    mSampleRate(0.0),
+    mInputFile(-1),
+    mOutputFile(-1),
+    mDataOffset(0),
+    mFrameCount(0),
+    mHeaderSize(0),
+    mLatency(0),
+    mFailed(false),
+    mInFlight(0),
+    mHighWater(0),
+    mRunning(0) {
+    
+    // the end of the stream needs a block of its own behind the last one with data
+    inDepth = std::max(2u, inDepth);
+    
+    for (unsigned i = 0; i < inDepth; i++) { mBlocks.push_back(std::unique_ptr<Block>(new Block())); }
+}
+
+LoPassPipeline::~LoPassPipeline() {
+    
+    if (mInputFile >= 0) { close(mInputFile); }
+    if (mOutputFile >= 0) { close(mOutputFile); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Read()
+//
+// Decides the block boundaries for the whole stream, including the silence that flushes
+// the latency out and the part of each block that is dropped for it, exactly as
+// LoPassRenderer::Render() does.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassPipeline::Stage LoPassPipeline::Read(Queue &inFree, Queue &outNext) {
+    
+    const unsigned frames   = mOptions.mBlockSize;
+    const unsigned bpf      = mInputFormat.GetBytesPerFrame();
+    const uint64_t total    = mFrameCount + mLatency;
+    
+    uint64_t position   = 0;    // input frames read
+    uint64_t processed  = 0;
+    uint64_t written    = 0;
+    
+    while (processed < total && !mFailed.load(std::memory_order_relaxed)) {
+    
+        Block *block = co_await inFree.Pop();
+        
+        block->mFrames  = (unsigned)std::min<uint64_t>(frames, mFrameCount - position);
+        block->mLength  = (unsigned)std::min<uint64_t>(frames, total - processed);
+        block->mSkip    = (unsigned)(processed < mLatency ? std::min<uint64_t>(mLatency - processed, block->mLength) : 0);
+        block->mWritten = written;
+        block->mLast    = false;
+        
+        size_t bytes    = (size_t)block->mFrames * bpf;
+        size_t done     = 0;
+        
+        while (done < bytes) {
+            
+            ssize_t n = pread(mInputFile, &block->mInput[done], bytes - done, (off_t)(mDataOffset + position * bpf + done));
+            
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) {
+                SetError(mInputPath + ": " + (n < 0 ? strerror(errno) : "unexpected end of file"));
+                break;
+            }
+            
+            done += (size_t)n;
+        }
+        
+        position   += block->mFrames;
+        processed  += block->mLength;
+        written    += block->mLength - block->mSkip;
+        
+        unsigned inFlight = mInFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (inFlight > mHighWater) { mHighWater = inFlight; }
+        
+        co_await outNext.Push(block);
+    }
+    
+    Block *end = co_await inFree.Pop();
+    end->mLast = true;
+    co_await outNext.Push(end);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Decode()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassPipeline::Stage LoPassPipeline::Decode(Queue &inPrevious, Queue &outNext) {
+    
+    for (;;) {
+    
+        Block *block = co_await inPrevious.Pop();
+        
+        if (!block->mLast && !mFailed.load(std::memory_order_relaxed)) {
+            
+            LoPassWaveDecode(mInputFormat, &block->mInput[0], &block->mSourceP[0], block->mFrames);
+            
+            // past the end of the input, flush with silence
+            for (unsigned c = 0; c < mInputFormat.mChannels; c++) {
+                float *source = block->mSource[c].data();
+                std::fill(source + block->mFrames, source + block->mLength, 0.0f);
+            }
+        }
+        
+        bool last = block->mLast;
+        co_await outNext.Push(block);
+        
+        if (last) { break; }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Filter()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassPipeline::Stage LoPassPipeline::Filter(Queue &inPrevious, Queue &outNext) {
+    
+    const LoPassSettings &settings = mOptions.mSettings;
+    
+    for (;;) {
+    
+        Block *block = co_await inPrevious.Pop();
+        
+        if (!block->mLast && !mFailed.load(std::memory_order_relaxed)) {
+            for (unsigned c = 0; c < mInputFormat.mChannels; c++) {
+                mProcessors[c]->Process(settings, &block->mSource[c][0], &block->mDest[c][0], block->mLength);
+            }
+        }
+        
+        bool last = block->mLast;
+        co_await outNext.Push(block);
+        
+        if (last) { break; }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Encode()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassPipeline::Stage LoPassPipeline::Encode(Queue &inPrevious, Queue &outNext) {
+    
+    for (;;) {
+    
+        Block *block = co_await inPrevious.Pop();
+        
+        unsigned keep = block->mLength - block->mSkip;
+        
+        if (!block->mLast && keep > 0 && !mFailed.load(std::memory_order_relaxed)) {
+            for (unsigned c = 0; c < mOutputFormat.mChannels; c++) { block->mDestP[c] = &block->mDest[c][block->mSkip]; }
+            LoPassWaveEncode(mOutputFormat, &block->mDestP[0], &block->mOutput[0], keep);
+        }
+        
+        bool last = block->mLast;
+        co_await outNext.Push(block);
+        
+        if (last) { break; }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Write()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassPipeline::Stage LoPassPipeline::Write(Queue &inPrevious, Queue &outFree) {
+    
+    const unsigned bpf = mOutputFormat.GetBytesPerFrame();
+    
+    for (;;) {
+    
+        Block *block = co_await inPrevious.Pop();
+        
+        if (block->mLast) { break; }
+        
+        size_t bytes    = (size_t)(block->mLength - block->mSkip) * bpf;
+        size_t done     = 0;
+        off_t offset    = (off_t)(mHeaderSize + block->mWritten * bpf);
+        
+        while (done < bytes && !mFailed.load(std::memory_order_relaxed)) {
+            
+            ssize_t n = pwrite(mOutputFile, &block->mOutput[done], bytes - done, offset + (off_t)done);
+            
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) {
+                SetError(mOutputPath + ": " + (n < 0 ? strerror(errno) : "nothing written"));
+                break;
+            }
+            
+            done += (size_t)n;
+        }
+        
+        mInFlight.fetch_sub(1, std::memory_order_relaxed);
+        co_await outFree.Push(block);
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassPipeline::Render()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassPipeline::Render(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats) {
+    
+    memset(&outStats, 0, sizeof(outStats));
+    mError.clear();
+    mInputPath  = inInputPath;
+    mOutputPath = inOutputPath;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    mInputFile = open(inInputPath, O_RDONLY);
+    if (mInputFile < 0) { return Fail(std::string(inInputPath) + ": " + strerror(errno)); }
+    
+    std::string error;
+    
+    if (!LoPassWaveReader::ReadHeader(mInputFile, mInputFormat, mDataOffset, mFrameCount, error)) {
+        return Fail(std::string(inInputPath) + ": " + error);
+    }
+    
+    posix_fadvise(mInputFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+    
+    // truncating the input before it has been read would lose it
+    struct stat input, output;
+    if (fstat(mInputFile, &input) == 0 && stat(inOutputPath, &output) == 0 &&
+        input.st_dev == output.st_dev && input.st_ino == output.st_ino) {
+        return Fail(std::string(inOutputPath) + ": would overwrite the input");
+    }
+    
+    mOutputFormat = mInputFormat;
+    
+    if (mOptions.mWriteFloat) {
+        mOutputFormat.mFloat            = true;
+        mOutputFormat.mBitsPerSample    = 32;
+    }
+    
+    mOutputFile = open(inOutputPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (mOutputFile < 0) { return Fail(std::string(inOutputPath) + ": " + strerror(errno)); }
+    
+    std::vector<uint8_t> header;
+    LoPassWaveWriter::MakeHeader(mOutputFormat, mFrameCount, header);
+    mHeaderSize = header.size();
+    
+    if (pwrite(mOutputFile, &header[0], header.size(), 0) != (ssize_t)header.size()) {
+        unlink(inOutputPath);
+        return Fail(std::string(inOutputPath) + ": " + strerror(errno));
+    }
+    
+    // processors for this sample rate, reset as LoPassRenderer does between files
+    const unsigned channels = mInputFormat.mChannels;
+    const double srate      = mInputFormat.mSampleRate;
+    
+    if (srate != mSampleRate) {
+        mProcessors.clear();
+        mSampleRate = srate;
+    }
+    
+    while (mProcessors.size() < channels) {
+    
+        LoPassProcessor *processor = new LoPassProcessor(srate);
+        if (mOptions.mSettings.mLinearPhase) { processor->Prepare(mOptions.mSettings); }
+        
+        mProcessors.push_back(std::unique_ptr<LoPassProcessor>(processor));
+    }
+    
+    for (unsigned c = 0; c < channels; c++) { mProcessors[c]->Reset(); }
+    
+    // the blocks only ever grow
+    const unsigned frames = mOptions.mBlockSize;
+    
+    for (size_t b = 0; b < mBlocks.size(); b++) {
+    
+        Block &block = *mBlocks[b];
+        
+        block.mInput.resize(std::max<size_t>(block.mInput.size(), (size_t)frames * mInputFormat.GetBytesPerFrame()));
+        block.mOutput.resize(std::max<size_t>(block.mOutput.size(), (size_t)frames * mOutputFormat.GetBytesPerFrame()));
+        
+        while (block.mSource.size() < channels) {
+            block.mSource.push_back(std::vector<float>(frames));
+            block.mDest.push_back(std::vector<float>(frames));
+            block.mSourceP.push_back(&block.mSource.back()[0]);
+            block.mDestP.push_back(NULL);
+        }
+    }
+    
+    mLatency    = mOptions.mKeepLatency ? 0 : LoPassProcessor::GetLatencyFrames(mOptions.mSettings, srate);
+    mFailed     = false;
+    mInFlight   = 0;
+    mHighWater  = 0;
+    mRunning    = kPipeline_Stages;
+    
+    // every queue can hold every block, so only the reader ever waits for space
+    const unsigned depth = (unsigned)mBlocks.size();
+    Queue unused(mScheduler, depth);
+    Queue read(mScheduler, depth);
+    Queue decoded(mScheduler, depth);
+    Queue filtered(mScheduler, depth);
+    Queue encoded(mScheduler, depth);
+    
+    for (size_t b = 0; b < mBlocks.size(); b++) { unused.TryPush(mBlocks[b].get()); }
+    
+    Stage stages[kPipeline_Stages] = {
+        Read(unused, read),
+        Decode(read, decoded),
+        Filter(decoded, filtered),
+        Encode(filtered, encoded),
+        Write(encoded, unused)
+    };
+    
+    for (unsigned s = 0; s < kPipeline_Stages; s++) { mScheduler.Post(stages[s].mCoroutine); }
+    
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this] { return mRunning == 0; });
+    }
+    
+    for (unsigned s = 0; s < kPipeline_Stages; s++) { stages[s].mCoroutine.destroy(); }
+    
+    if (mFailed) {
+        unlink(inOutputPath);
+        return Fail(mError);
+    }
+    
+    // pad byte for an odd sized data chunk
+    const uint64_t dataBytes = mFrameCount * mOutputFormat.GetBytesPerFrame();
+    
+    if ((dataBytes & 1) != 0) {
+        const uint8_t pad = 0;
+        if (pwrite(mOutputFile, &pad, 1, (off_t)(mHeaderSize + dataBytes)) != 1) {
+            unlink(inOutputPath);
+            return Fail(std::string(inOutputPath) + ": " + strerror(errno));
+        }
+    }
+    
+    int closed = close(mOutputFile);
+    mOutputFile = -1;
+    
+    if (closed != 0) {
+        unlink(inOutputPath);
+        return Fail(std::string(inOutputPath) + ": " + strerror(errno));
+    }
+    
+    close(mInputFile);
+    mInputFile = -1;
+    
+    outStats.mFrames        = mFrameCount;
+    outStats.mChannels      = channels;
+    outStats.mSampleRate    = srate;
+    outStats.mBytes         = mFrameCount * mInputFormat.GetBytesPerFrame();
+    outStats.mSeconds       = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    return true;
+}
+
+void LoPassPipeline::Finished() {
+    
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (--mRunning == 0) { mDone.notify_all(); }
+}
+
+void LoPassPipeline::SetError(const std::string &inMessage) {
+    
+    std::lock_guard<std::mutex> lock(mMutex);
+    
+    if (!mFailed) { mError = inMessage; }
+    mFailed = true;
+}
+
+bool LoPassPipeline::Fail(const std::string &inMessage) {
+    
+    mError = inMessage;
+    
+    if (mInputFile >= 0) { close(mInputFile); }
+    if (mOutputFile >= 0) { close(mOutputFile); }
+    mInputFile = mOutputFile = -1;
+    
+    return false;
+}
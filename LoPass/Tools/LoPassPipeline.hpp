@@ -0,0 +1,249 @@
+//
+//  LoPassPipeline.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Coroutine streaming pipeline for the offline tools (C++20, POSIX only).
+//
+
+#ifndef LoPassPipeline_hpp
+#define LoPassPipeline_hpp
+
+#include "LoPassBatch.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Scheduler
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A small pool of threads resuming coroutines in the order they were posted. The run
+// queue is only touched when a stage starts or wakes up, once per block at most, so a
+// mutex is cheap enough here; the per-block hand-overs go through LoPassStageQueue.
+
+class LoPassScheduler {
+    
+public:
+    /// inThreads of 0 uses one thread per core.
+    explicit LoPassScheduler(unsigned inThreads = 0);
+    ~LoPassScheduler();
+    
+    unsigned GetThreads() const { return (unsigned)mThreads.size(); }
+    
+    /// Resume inCoroutine on one of the pool threads.
+    void Post(std::coroutine_handle<> inCoroutine);
+    
+private:
+    void Run();
+    
+    std::mutex                              mMutex;
+    std::condition_variable                 mWake;
+    std::deque<std::coroutine_handle<> >    mReady;
+    bool                                    mQuit;
+    std::vector<std::thread>                mThreads;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Stage Queue
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Bounded single producer / single consumer ring between two stages. Push() and Pop() are
+// awaitable: a stage that finds the ring full (or empty) parks its coroutine in an atomic
+// slot and the other side posts it back to the scheduler after its next Pop() (or Push()).
+//
+// Parking is race free without a lock: the parked side checks the ring again after
+// publishing itself, and whichever of the two sides takes the handle out of the slot is
+// the one that resumes it. The transfer itself happens in await_resume(), so nothing is
+// written while the coroutine may already be running on another thread.
+
+template <class T>
+class LoPassStageQueue {
+    
+public:
+    /// inCapacity is rounded up to a power of two.
+    LoPassStageQueue(LoPassScheduler &inScheduler, unsigned inCapacity) :
+        mScheduler(inScheduler),
+        mHead(0),
+        mTail(0),
+        mParkedProducer(nullptr),
+        mParkedConsumer(nullptr) {
+        
+        unsigned capacity = 1;
+        while (capacity < inCapacity) { capacity <<= 1; }
+        
+        mSlots.resize(capacity);
+        mMask = capacity - 1;
+    }
+    
+    bool TryPush(const T &inValue) {
+    
+        unsigned tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) > mMask) { return false; }
+        
+        mSlots[tail & mMask] = inValue;
+        mTail.store(tail + 1, std::memory_order_seq_cst);
+        
+        Wake(mParkedConsumer);
+        return true;
+    }
+    
+    bool TryPop(T &outValue) {
+    
+        unsigned head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) { return false; }
+        
+        outValue = mSlots[head & mMask];
+        mHead.store(head + 1, std::memory_order_seq_cst);
+        
+        Wake(mParkedProducer);
+        return true;
+    }
+    
+    struct PushAwaiter {
+        LoPassStageQueue    &mQueue;
+        T                   mValue;
+        
+        bool await_ready() const { return mQueue.HasSpace(); }
+        bool await_suspend(std::coroutine_handle<> inCoroutine) const {
+            LoPassStageQueue *queue = &mQueue;
+            return queue->Park(queue->mParkedProducer, inCoroutine, &LoPassStageQueue::HasSpace);
+        }
+        // there is only one producer, so the space we saw or were woken for is still there
+        void await_resume() { mQueue.TryPush(mValue); }
+    };
+    
+    struct PopAwaiter {
+        LoPassStageQueue    &mQueue;
+        
+        bool await_ready() const { return mQueue.HasData(); }
+        bool await_suspend(std::coroutine_handle<> inCoroutine) const {
+            LoPassStageQueue *queue = &mQueue;
+            return queue->Park(queue->mParkedConsumer, inCoroutine, &LoPassStageQueue::HasData);
+        }
+        T await_resume() {
+            T value = T();
+            mQueue.TryPop(value);
+            return value;
+        }
+    };
+    
+    PushAwaiter Push(const T &inValue) { return PushAwaiter { *this, inValue }; }
+    PopAwaiter Pop() { return PopAwaiter { *this }; }
+    
+private:
+    bool HasSpace() const { return mTail.load(std::memory_order_relaxed) - mHead.load(std::memory_order_seq_cst) <= mMask; }
+    bool HasData() const { return mHead.load(std::memory_order_relaxed) != mTail.load(std::memory_order_seq_cst); }
+    
+    /// Returns whether the coroutine should stay suspended. Only the queue is looked at
+    /// once the handle is published, never the awaiter, which lives in the coroutine frame.
+    bool Park(std::atomic<void *> &ioSlot, std::coroutine_handle<> inCoroutine, bool (LoPassStageQueue::*inReady)() const) {
+    
+        void *self = inCoroutine.address();
+        ioSlot.store(self, std::memory_order_seq_cst);
+        
+        if (!(this->*inReady)()) { return true; }
+        
+        // ready after all; carry on unless the other side already took the handle
+        return ioSlot.exchange(nullptr, std::memory_order_seq_cst) != self;
+    }
+    
+    void Wake(std::atomic<void *> &ioSlot) {
+    
+        if (ioSlot.load(std::memory_order_seq_cst) == nullptr) { return; }
+        
+        void *parked = ioSlot.exchange(nullptr, std::memory_order_seq_cst);
+        if (parked != nullptr) { mScheduler.Post(std::coroutine_handle<>::from_address(parked)); }
+    }
+    
+    LoPassScheduler                 &mScheduler;
+    std::vector<T>                  mSlots;
+    unsigned                        mMask;
+    
+    alignas(64) std::atomic<unsigned>   mHead;
+    alignas(64) std::atomic<unsigned>   mTail;
+    alignas(64) std::atomic<void *>     mParkedProducer;
+    alignas(64) std::atomic<void *>     mParkedConsumer;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Pipeline
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Renders a file as five coroutines, one per stage, linked by LoPassStageQueues:
+//
+//  read    pread() raw sample data into a pooled block
+//  decode  PCM variant to one float buffer per channel (LoPassWaveDecode)
+//  filter  a LoPassProcessor per channel, with the latency compensation of LoPassRenderer
+//  encode  float to the output PCM variant (LoPassWaveEncode)
+//  write   pwrite() at the block's place in the output file
+//
+// The stages run concurrently on a LoPassScheduler, so the I/O and format conversion of
+// one block overlap the filtering of the next. Blocks go back to the reader after they
+// have been written, and the reader waits for one when all are in use, so memory is
+// inDepth blocks whatever the length of the file. The output is the same, byte for byte,
+// as LoPassRenderer gives with the same options.
+
+class LoPassPipeline {
+    
+public:
+    /// Up to inDepth blocks of inOptions.mBlockSize frames are in flight at once.
+    LoPassPipeline(const LoPassRenderOptions &inOptions, LoPassScheduler &inScheduler, unsigned inDepth = 8);
+    ~LoPassPipeline();
+    
+    /// Returns false, with GetError() set, if either file failed.
+    bool Render(const char *inInputPath, const char *inOutputPath, LoPassRenderStats &outStats);
+    
+    const std::string &GetError() const { return mError; }
+    
+    /// The furthest any stage got ahead of the writer, in blocks, during the last Render().
+    unsigned GetHighWater() const { return mHighWater; }
+    
+private:
+    struct Block;
+    struct Stage;
+    
+    typedef LoPassStageQueue<Block *> Queue;
+    
+    Stage Read(Queue &inFree, Queue &outNext);
+    Stage Decode(Queue &inPrevious, Queue &outNext);
+    Stage Filter(Queue &inPrevious, Queue &outNext);
+    Stage Encode(Queue &inPrevious, Queue &outNext);
+    Stage Write(Queue &inPrevious, Queue &outFree);
+    
+    void Finished();
+    void SetError(const std::string &inMessage);
+    bool Fail(const std::string &inMessage);
+    
+    LoPassRenderOptions                                 mOptions;
+    LoPassScheduler                                     &mScheduler;
+    std::vector<std::unique_ptr<Block> >                mBlocks;
+    
+    double                                              mSampleRate;
+    std::vector<std::unique_ptr<LoPassProcessor> >      mProcessors;
+    
+    //~~~~ the file being rendered
+    std::string                                         mInputPath;
+    std::string                                         mOutputPath;
+    int                                                 mInputFile;
+    int                                                 mOutputFile;
+    LoPassWaveFormat                                    mInputFormat;
+    LoPassWaveFormat                                    mOutputFormat;
+    uint64_t                                            mDataOffset;
+    uint64_t                                            mFrameCount;
+    uint64_t                                            mHeaderSize;
+    uint64_t                                            mLatency;
+    std::atomic<bool>                                   mFailed;
+    std::atomic<unsigned>                               mInFlight;
+    unsigned                                            mHighWater;
+    
+    std::mutex                                          mMutex;
+    std::condition_variable                             mDone;
+    unsigned                                            mRunning;
+    std::string                                         mError;
+};
+
+#endif /* LoPassPipeline_hpp */
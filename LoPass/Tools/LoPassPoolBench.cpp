@@ -0,0 +1,224 @@
+//
+//  LoPassPoolBench.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Benchmark for LoPassWorkerPool: wide formats rendered a buffer at a time, each channel's
+//  LoPassProcessor run in turn on one thread, or in groups across the pool the way
+//  AUEffectBase::ProcessBufferListsT() runs the kernels with a scheduler set.
+//
+//  make lopass-pool
+//
+//  Buffers are paced at the real buffer period, so the workers sleep between buffers as
+//  they would under a host, and each buffer's time includes waking them. For 32 to 256
+//  frames it prints the median and 99th percentile time per buffer against the buffer
+//  period, the speedup, and how much of the work the workers actually picked up. The empty
+//  run is the cost of handing out a buffer with no work in it, the wake-up alone. Both
+//  renders must match to the bit. Asks for realtime priority for the workers and says
+//  whether it got it.
+//
+//  lopass-pool [channels] [sample rate] [workers]
+//
+//  With no arguments, 64 channels at 48 kHz (third order ambisonics and up) and 12 at
+//  384 kHz (7.1.4).
+//
+
+#include "LoPassProcessor.hpp"
+#include "LoPassWorkerPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+static constexpr double kSecondsPerRun      = 0.5;
+static const unsigned kBlockSizes[]         = { 32, 64, 128, 256 };
+
+typedef std::chrono::steady_clock Clock;
+
+/// One buffer of a deinterleaved wide format, and a processor per channel.
+struct Bus {
+    std::vector<std::unique_ptr<LoPassProcessor> > mProcessors;
+    std::vector<float>  mInput;
+    std::vector<float>  mOutput;
+    LoPassSettings      mSettings;
+    unsigned            mChannels;
+    unsigned            mFrames;
+    bool                mEmpty;     // do nothing, to time the hand-out alone
+
+    Bus(unsigned inChannels, unsigned inFrames, double inSampleRate) :
+        mInput((size_t)inChannels * inFrames),
+        mOutput((size_t)inChannels * inFrames),
+        mChannels(inChannels),
+        mFrames(inFrames),
+        mEmpty(false) {
+
+        mSettings.mCutoff = inSampleRate / 20.0;
+        for (unsigned c = 0; c < inChannels; c++) { mProcessors.emplace_back(new LoPassProcessor(inSampleRate)); }
+    }
+};
+
+static void ProcessChannels(void *inContext, unsigned inBegin, unsigned inEnd) {
+
+    Bus &bus = *(Bus *)inContext;
+    if (bus.mEmpty) { return; }
+
+    for (unsigned c = inBegin; c < inEnd; c++) {
+        bus.mProcessors[c]->Process(bus.mSettings, &bus.mInput[(size_t)c * bus.mFrames], &bus.mOutput[(size_t)c * bus.mFrames], bus.mFrames);
+    }
+}
+
+static void FillInput(Bus &ioBus, uint32_t &ioNoise) {
+
+    for (size_t i = 0; i < ioBus.mInput.size(); i++) {
+        ioBus.mInput[i] = (float)((int32_t)(ioNoise = ioNoise * 1664525u + 1013904223u) * (0.5 / 2147483648.0));
+    }
+}
+
+struct Timing {
+    double      mMedian;
+    double      mP99;
+    unsigned    mOverruns;  // buffers that took longer than the period
+};
+
+static Timing Summarise(std::vector<double> &ioSeconds, double inPeriod) {
+
+    std::sort(ioSeconds.begin(), ioSeconds.end());
+
+    Timing timing;
+    timing.mMedian      = ioSeconds[ioSeconds.size() / 2];
+    timing.mP99         = ioSeconds[ioSeconds.size() * 99 / 100];
+    timing.mOverruns    = (unsigned)(ioSeconds.end() - std::upper_bound(ioSeconds.begin(), ioSeconds.end(), inPeriod));
+
+    return timing;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Render
+//
+// Renders kSecondsPerRun worth of buffers, one per period, through the pool if given.
+// Returns the time each took and appends the output to outOutput.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static std::vector<double> Render(Bus &ioBus, LoPassWorkerPool *inPool, double inSampleRate, std::vector<float> *outOutput) {
+
+    const double period = ioBus.mFrames / inSampleRate;
+    const unsigned buffers = (unsigned)(kSecondsPerRun / period);
+
+    std::vector<double> seconds(buffers);
+    uint32_t noise = 1;
+
+    Clock::time_point next = Clock::now();
+
+    for (unsigned b = 0; b < buffers; b++) {
+
+        FillInput(ioBus, noise);
+
+        std::this_thread::sleep_until(next);
+        next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+
+        Clock::time_point start = Clock::now();
+        if (inPool != NULL) {
+            inPool->Run(ioBus.mChannels, ProcessChannels, &ioBus);
+        } else {
+            ProcessChannels(&ioBus, 0, ioBus.mChannels);
+        }
+        seconds[b] = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (outOutput != NULL) { outOutput->insert(outOutput->end(), ioBus.mOutput.begin(), ioBus.mOutput.end()); }
+    }
+
+    return seconds;
+}
+
+/// Returns false if the pool changed the output.
+static bool Bench(unsigned inChannels, double inSampleRate, unsigned inWorkers) {
+
+    LoPassWorkerPool pool(inWorkers);
+    bool realtime = pool.SetRealtime(kBlockSizes[0] / inSampleRate);
+    bool same = true;
+
+    printf("\n%u channels at %.0f Hz, %u workers%s\n", inChannels, inSampleRate, pool.GetWorkers(),
+           pool.GetWorkers() == 0 ? "" : realtime ? ", realtime" : " (realtime refused, normal priority)");
+    printf("%-7s %9s %20s %20s %9s %9s %8s %9s\n", "frames", "period", "serial med / p99", "pool med / p99",
+           "speedup", "overruns", "workers", "empty");
+
+    for (size_t n = 0; n < sizeof(kBlockSizes) / sizeof(kBlockSizes[0]); n++) {
+
+        unsigned frames = kBlockSizes[n];
+        double period = frames / inSampleRate;
+
+        std::vector<float> serialOutput, poolOutput;
+
+        Bus serialBus(inChannels, frames, inSampleRate);
+        std::vector<double> serialSeconds = Render(serialBus, NULL, inSampleRate, &serialOutput);
+
+        LoPassWorkerPoolStatistics before = pool.GetStatistics();
+        Bus poolBus(inChannels, frames, inSampleRate);
+        std::vector<double> poolSeconds = Render(poolBus, &pool, inSampleRate, &poolOutput);
+        LoPassWorkerPoolStatistics after = pool.GetStatistics();
+
+        Bus emptyBus(inChannels, frames, inSampleRate);
+        emptyBus.mEmpty = true;
+        std::vector<double> emptySeconds = Render(emptyBus, &pool, inSampleRate, NULL);
+
+        if (serialOutput != poolOutput) { same = false; }
+
+        Timing serial   = Summarise(serialSeconds, period);
+        Timing parallel = Summarise(poolSeconds, period);
+        Timing empty    = Summarise(emptySeconds, period);
+
+        uint64_t groups = after.mGroups - before.mGroups;
+        uint64_t workerGroups = after.mWorkerGroups - before.mWorkerGroups;
+
+        char serialText[32], poolText[32], overrunText[32];
+        snprintf(serialText, sizeof(serialText), "%.1f / %.1f us", 1e6 * serial.mMedian, 1e6 * serial.mP99);
+        snprintf(poolText, sizeof(poolText), "%.1f / %.1f us", 1e6 * parallel.mMedian, 1e6 * parallel.mP99);
+        snprintf(overrunText, sizeof(overrunText), "%u / %u", serial.mOverruns, parallel.mOverruns);
+
+        printf("%-7u %6.0f us %20s %20s %8.2fx %9s %7.0f%% %6.1f us\n", frames, 1e6 * period, serialText, poolText,
+               serial.mMedian / parallel.mMedian, overrunText, groups ? 100.0 * workerGroups / groups : 0.0, 1e6 * empty.mMedian);
+    }
+
+    LoPassWorkerPoolStatistics statistics = pool.GetStatistics();
+    printf("%llu of %llu buffers run inline, %llu fallbacks; output %s\n", (unsigned long long)statistics.mInlineRuns,
+           (unsigned long long)statistics.mRuns, (unsigned long long)statistics.mFallbacks, same ? "bit identical" : "MISMATCH");
+
+    return same;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, const char *argv[]) {
+
+    unsigned cores = std::thread::hardware_concurrency();
+    unsigned defaultWorkers = cores > 1 ? cores - 1 : 0;
+    if (defaultWorkers > kWorkerPool_MaxWorkers) { defaultWorkers = kWorkerPool_MaxWorkers; }
+
+    unsigned channels   = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 0;
+    double sampleRate   = argc > 2 ? strtod(argv[2], NULL) : 48000.0;
+    unsigned workers    = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : defaultWorkers;
+
+    if ((argc > 1 && channels == 0) || sampleRate < 8000.0) {
+        fprintf(stderr, "usage: lopass-pool [channels] [sample rate] [workers, up to %u]\n", kWorkerPool_MaxWorkers);
+        return 2;
+    }
+
+    bool ok = true;
+
+    if (channels != 0) {
+        ok = Bench(channels, sampleRate, workers);
+    } else {
+        ok = Bench(64, 48000.0, workers) && ok;
+        ok = Bench(12, 384000.0, workers) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
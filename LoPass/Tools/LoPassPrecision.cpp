@@ -0,0 +1,256 @@
+//
+//  LoPassPrecision.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Accuracy / throughput report for LoPassBiquad.
+//
+//  c++ -O2 -std=c++11 -I../Source LoPassPrecision.cpp ../Source/LoPassBiquad.cpp ../Source/LoPassFilter.cpp ../Source/LoPassState.cpp -o lopass-precision
+//
+//  The biquad is run across the whole clamped cutoff range (20 Hz at 192 kHz up to 0.99 of
+//  Nyquist) and the resonance range, on white noise, an impulse train and sines across the
+//  band, and compared with a long double Direct Form 1 reference built from long double
+//  coefficients. The SNR for a design is the worst over the signals. The "legacy" column is
+//  the original kernel loop (double coefficients, float output fed back).
+//
+//  The "then" column runs the design for half of each signal and then moves on to a low
+//  cutoff (kHandoverFreq), carrying the history across as LoPassBiquad does under automation,
+//  SNR taken over the whole signal. Whatever the first design leaves in the history rings on
+//  through the low cutoff, against an output that may be far smaller.
+//
+//  Exits non-zero if the biquad is ever below kMinimumSNR, steady or after the handover.
+//
+//  lopass-precision [sample rate, for the cutoffs in Hz]
+//
+
+#include "LoPassBiquad.hpp"
+#include "LoPassParameters.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+/// What LoPassBiquad.hpp promises.
+static constexpr double kMinimumSNR         = 120.0;
+
+static constexpr unsigned kNumberOfSamples  = 1 << 16;      // noise
+static constexpr unsigned kToneSamples      = 1 << 14;      // each sine and the impulses
+static constexpr unsigned kNumberOfSines    = 12;           // up to 0.9 of Nyquist
+static constexpr unsigned kImpulseSpacing   = 97;
+static constexpr unsigned kTimingRuns       = 3;
+
+static constexpr unsigned kCutoffSteps      = 32;
+static constexpr double kMinimumFreq        = 2.0 * 20.0 / 192000.0;
+static constexpr double kMaximumFreq        = 0.99;         // LoPassNormaliseParameters() clamps here
+static constexpr unsigned kResonanceSteps   = 17;
+
+static constexpr double kHandoverFreq       = 2.0 * 50.0 / 48000.0;
+static constexpr double kHandoverResonance  = 0.0;
+
+static const long double kPi = 3.141592653589793238462643383279502884L;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Reference
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct ReferenceCoefficients {
+    long double mA0, mA1, mA2, mB1, mB2;
+};
+
+static ReferenceCoefficients ReferenceDesign(double inFreq, double inResonance) {
+
+    long double r   = powl(10.0L, 0.05L * -inResonance);
+    long double s   = sinl(kPi * inFreq / 2.0L) * sinl(kPi * inFreq / 2.0L);
+    long double k   = 0.5L * r * sinl(kPi * inFreq);
+    long double K   = 1.0L + k;
+
+    return { s / K, 2.0L * s / K, s / K, -2.0L * cosl(kPi * inFreq) / K, (1.0L - k) / K };
+}
+
+/// inDesigns[0] up to inSwitch, inDesigns[1] from there on.
+static void ReferenceFilter(const ReferenceCoefficients inDesigns[2], size_t inSwitch,
+                            const std::vector<float> &inSource, std::vector<double> &outDest) {
+
+    outDest.resize(inSource.size());
+
+    long double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+    for (size_t i = 0; i < inSource.size(); i++) {
+        const ReferenceCoefficients &c = inDesigns[i < inSwitch ? 0 : 1];
+        long double x = inSource[i];
+        long double y = c.mA0*x + c.mA1*x1 + c.mA2*x2 - c.mB1*y1 - c.mB2*y2;
+        x2 = x1; x1 = x; y2 = y1; y1 = y;
+        outDest[i] = (double)y;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The original kernel loop
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void LegacyFilter(const LoPassCoefficients &c, const std::vector<float> &inSource, std::vector<float> &outDest) {
+
+    outDest.resize(inSource.size());
+
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+    for (size_t i = 0; i < inSource.size(); i++) {
+        float input = inSource[i];
+        float output = c.mA0*input + c.mA1*x1 + c.mA2*x2 - c.mB1*y1 - c.mB2*y2;
+        x2 = x1; x1 = input; y2 = y1; y1 = output;
+        outDest[i] = output;
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Measurements
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static double SignalToNoise(const std::vector<double> &inReference, const std::vector<float> &inTest) {
+
+    double signal = 0.0, noise = 0.0;
+
+    for (size_t i = 0; i < inReference.size(); i++) {
+        double error = inTest[i] - inReference[i];
+        signal  += inReference[i] * inReference[i];
+        noise   += error * error;
+    }
+
+    if (noise == 0.0) { return 999.0; }
+    return 10.0 * log10(signal / noise);
+}
+
+template <class Function>
+static double NanosecondsPerSample(Function inFunction) {
+
+    double best = 1e30;
+
+    for (unsigned run = 0; run < kTimingRuns; run++) {
+        auto start = std::chrono::steady_clock::now();
+        inFunction();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) { best = elapsed.count(); }
+    }
+
+    return best / kNumberOfSamples;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Signals
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// White noise, an impulse train and sines from 0.9 / kNumberOfSines up to 0.9 of Nyquist.
+static void MakeSignals(std::vector<std::vector<float> > &outSignals) {
+
+    outSignals.assign(2 + kNumberOfSines, std::vector<float>(kToneSamples, 0.0f));
+
+    outSignals[0].resize(kNumberOfSamples);
+    srand(1);
+    for (unsigned i = 0; i < kNumberOfSamples; i++) { outSignals[0][i] = 2.0f * rand() / RAND_MAX - 1.0f; }
+
+    for (unsigned i = 0; i < kToneSamples; i += kImpulseSpacing) { outSignals[1][i] = 1.0f; }
+
+    for (unsigned n = 1; n <= kNumberOfSines; n++) {
+        double freq = 0.9 * n / kNumberOfSines;
+        for (unsigned i = 0; i < kToneSamples; i++) { outSignals[1 + n][i] = (float)sin(M_PI * freq * i); }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, const char *argv[]) {
+
+    const double srate = argc > 1 ? atof(argv[1]) : 48000.0;
+
+    std::vector<std::vector<float> > signals;
+    MakeSignals(signals);
+
+    std::vector<float> dest;
+    std::vector<double> reference;
+
+    LoPassCoefficients handover;
+    LoPassFilter::CalculateLopassParams(kHandoverFreq, kHandoverResonance, handover);
+
+    printf("SNR in dB against a long double reference, worst of noise, impulses and %u sines\n", kNumberOfSines);
+    printf("\"then\": moving on to %.0f Hz at %g dB halfway through\n\n", 0.5 * kHandoverFreq * srate, kHandoverResonance);
+    printf("%8s %8s %6s %10s | %8s %8s | %8s\n", "freq", "Hz", "res", "radius", "legacy", "biquad", "then");
+
+    double worstSNR = 1e30, worstFreq = 0.0, worstResonance = 0.0;
+
+    for (unsigned i = 0; i < kCutoffSteps; i++) {
+
+        double freq = kMinimumFreq * pow(kMaximumFreq / kMinimumFreq, i / (double)(kCutoffSteps - 1));
+
+        for (unsigned j = 0; j < kResonanceSteps; j++) {
+
+            double resonance = kMinimumValue_LoPass_Resonance +
+                               (kMaximumValue_LoPass_Resonance - kMinimumValue_LoPass_Resonance) * j / (kResonanceSteps - 1);
+
+            LoPassCoefficients coefficients;
+            LoPassFilter::CalculateLopassParams(freq, resonance, coefficients);
+
+            const ReferenceCoefficients steady[2] = { ReferenceDesign(freq, resonance), ReferenceDesign(freq, resonance) };
+            const ReferenceCoefficients moved[2] = { ReferenceDesign(freq, resonance), ReferenceDesign(kHandoverFreq, kHandoverResonance) };
+
+            double legacy = 1e30, snr = 1e30, then = 1e30;
+
+            for (const std::vector<float> &source : signals) {
+
+                unsigned frames = (unsigned)source.size(), half = frames / 2;
+
+                ReferenceFilter(steady, frames, source, reference);
+
+                LegacyFilter(coefficients, source, dest);
+                legacy = fmin(legacy, SignalToNoise(reference, dest));
+
+                LoPassBiquad biquad;
+                biquad.Process(coefficients, &source[0], &dest[0], frames);
+                snr = fmin(snr, SignalToNoise(reference, dest));
+
+                ReferenceFilter(moved, half, source, reference);
+
+                biquad.Reset();
+                biquad.Process(coefficients, &source[0], &dest[0], half);
+                biquad.Process(handover, &source[half], &dest[half], frames - half);
+                then = fmin(then, SignalToNoise(reference, dest));
+            }
+
+            double worst = fmin(snr, then);
+            if (worst < worstSNR) {
+                worstSNR        = worst;
+                worstFreq       = freq;
+                worstResonance  = resonance;
+            }
+
+            printf("%8.6f %8.0f %6g %10.7f | %8.1f %8.1f | %8.1f\n",
+                   freq, 0.5 * freq * srate, resonance, sqrt(fabs(coefficients.mB2)), legacy, snr, then);
+        }
+    }
+
+    printf("\nworst SNR %.1f dB (freq %g, resonance %g dB)\n", worstSNR, worstFreq, worstResonance);
+
+    // throughput doesn't depend on the coefficients, so one representative design will do
+    const std::vector<float> &source = signals[0];
+    dest.resize(source.size());
+
+    LoPassCoefficients coefficients;
+    LoPassFilter::CalculateLopassParams(2.0 * 1000.0 / srate, 0.0, coefficients);
+
+    LoPassBiquad biquad;
+
+    printf("\nthroughput, ns/sample\n");
+    printf("%10s %8.2f\n", "legacy", NanosecondsPerSample([&] { LegacyFilter(coefficients, source, dest); }));
+    printf("%10s %8.2f\n", "biquad", NanosecondsPerSample([&] { biquad.Process(coefficients, &source[0], &dest[0], kNumberOfSamples); }));
+
+    if (worstSNR < kMinimumSNR) {
+        printf("\nFAIL: the biquad is under %g dB SNR\n", kMinimumSNR);
+        return EXIT_FAILURE;
+    }
+
+    printf("\nPASS: the biquad holds %g dB SNR\n", kMinimumSNR);
+    return EXIT_SUCCESS;
+}
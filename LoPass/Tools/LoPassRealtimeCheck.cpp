@@ -0,0 +1,505 @@
+//
+//  LoPassRealtimeCheck.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+// the fortified inline wrappers for read() and the like would clash with the definitions below
+#undef _FORTIFY_SOURCE
+
+#include "LoPassRealtimeCheck.hpp"
+#include <atomic>
+
+#if defined(__linux__) && defined(__GLIBC__)
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+/// Violations that print a stack when carrying on; the rest are only counted.
+static constexpr unsigned kRealtimeCheck_Stacks     = 8;
+
+/// Deepest stack printed.
+static constexpr unsigned kRealtimeCheck_Frames     = 48;
+
+static __thread int sDepth;         // render scopes the thread is inside
+static __thread int sSuspended;     // inside the checker itself
+
+static std::atomic<const char *>    sContext(NULL);
+static std::atomic<bool>            sKeepGoing(false);
+static std::atomic<bool>            sStrict(false);
+static std::atomic<uint64_t>        sViolations(0);
+
+static inline bool IsChecking() {
+    return sDepth > 0 && sSuspended == 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Forwarding
+//
+// malloc() and the rest go to glibc's own __libc_ entry points, which need no lookup and
+// so can't recurse through dlsym(). Everything else is looked up once with RTLD_NEXT;
+// the condition variable calls by version, since an unversioned lookup finds the old ones.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+extern "C" {
+    void *__libc_malloc(size_t);
+    void *__libc_calloc(size_t, size_t);
+    void *__libc_realloc(void *, size_t);
+    void __libc_free(void *);
+    void *__libc_memalign(size_t, size_t);
+    void *__libc_valloc(size_t);
+    void *__libc_pvalloc(size_t);
+    void *__cxa_allocate_exception(size_t) noexcept;
+}
+
+static void *Resolve(const char *inName, const char *inVersion = NULL) {
+
+    void *symbol = inVersion != NULL ? dlvsym(RTLD_NEXT, inName, inVersion) : NULL;
+    if (symbol == NULL) { symbol = dlsym(RTLD_NEXT, inName); }
+
+    if (symbol == NULL) {
+        static const char kMessage[] = "lopass realtime check: can't find a libc function\n";
+        syscall(SYS_write, STDERR_FILENO, kMessage, sizeof(kMessage) - 1);
+        _exit(1);
+    }
+
+    return symbol;
+}
+
+#define LOPASS_FORWARD(name, ...) \
+    static decltype(&name) sNext_##name; \
+    static decltype(&name) Next_##name() { \
+        if (sNext_##name == NULL) { sNext_##name = (decltype(&name))Resolve(#name, ##__VA_ARGS__); } \
+        return sNext_##name; \
+    }
+
+LOPASS_FORWARD(pthread_mutex_lock)
+LOPASS_FORWARD(pthread_mutex_trylock)
+LOPASS_FORWARD(pthread_mutex_timedlock)
+LOPASS_FORWARD(pthread_mutex_unlock)
+LOPASS_FORWARD(pthread_cond_wait, "GLIBC_2.3.2")
+LOPASS_FORWARD(pthread_cond_timedwait, "GLIBC_2.3.2")
+LOPASS_FORWARD(pthread_cond_signal, "GLIBC_2.3.2")
+LOPASS_FORWARD(pthread_cond_broadcast, "GLIBC_2.3.2")
+LOPASS_FORWARD(sem_wait)
+LOPASS_FORWARD(sem_timedwait)
+LOPASS_FORWARD(sem_post)
+LOPASS_FORWARD(read)
+LOPASS_FORWARD(write)
+LOPASS_FORWARD(close)
+LOPASS_FORWARD(open)
+LOPASS_FORWARD(openat)
+LOPASS_FORWARD(mmap)
+LOPASS_FORWARD(munmap)
+LOPASS_FORWARD(madvise)
+LOPASS_FORWARD(nanosleep)
+LOPASS_FORWARD(clock_nanosleep)
+LOPASS_FORWARD(usleep)
+LOPASS_FORWARD(sched_yield)
+LOPASS_FORWARD(syscall)
+LOPASS_FORWARD(__cxa_allocate_exception)
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Report()
+//
+// Runs suspended, so its own allocations and writes aren't violations. Stack lines are
+// "module(symbol+offset) [address]"; the symbols are demangled where they can be.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void PrintFrame(const char *inFrame) {
+
+    const char *open = strchr(inFrame, '(');
+    const char *plus = open != NULL ? strchr(open, '+') : NULL;
+
+    char *name = NULL;
+    if (plus != NULL && plus > open + 1) {
+        std::string mangled(open + 1, plus);
+        int status;
+        name = abi::__cxa_demangle(mangled.c_str(), NULL, NULL, &status);
+    }
+
+    if (name != NULL) {
+        fprintf(stderr, "    %.*s%s%s\n", (int)(open + 1 - inFrame), inFrame, name, plus);
+        free(name);
+    } else {
+        fprintf(stderr, "    %s\n", inFrame);
+    }
+}
+
+static void Report(const char *inCall, long long inArgument = -1) {
+
+    sSuspended++;
+
+    uint64_t count = sViolations.fetch_add(1) + 1;
+
+    if (count <= kRealtimeCheck_Stacks) {
+        const char *context = sContext.load();
+
+        fflush(stdout);
+        if (inArgument >= 0) {
+            fprintf(stderr, "\nrealtime violation: %s(%lld) on thread %ld\n", inCall, inArgument, (long)syscall(SYS_gettid));
+        } else {
+            fprintf(stderr, "\nrealtime violation: %s() on thread %ld\n", inCall, (long)syscall(SYS_gettid));
+        }
+        fprintf(stderr, "  in %s\n", context != NULL ? context : "(no context)");
+
+        void *frames[kRealtimeCheck_Frames];
+        int depth = backtrace(frames, kRealtimeCheck_Frames);
+        char **symbols = backtrace_symbols(frames, depth);
+
+        // frame 0 is this function, 1 the replacement that called it
+        for (int n = 2; n < depth; n++) {
+            if (symbols != NULL) {
+                PrintFrame(symbols[n]);
+            } else {
+                fprintf(stderr, "    [%p]\n", frames[n]);
+            }
+        }
+
+        free(symbols);
+        fflush(stderr);
+    }
+
+    if (!sKeepGoing.load()) { _exit(1); }
+
+    sSuspended--;
+}
+
+/// Resolves everything before main(), and loads the unwinder backtrace() uses, so
+/// neither happens for the first time inside a scope.
+__attribute__((constructor)) static void Prepare() {
+
+    Next_pthread_mutex_lock();
+    Next_pthread_mutex_trylock();
+    Next_pthread_mutex_timedlock();
+    Next_pthread_mutex_unlock();
+    Next_pthread_cond_wait();
+    Next_pthread_cond_timedwait();
+    Next_pthread_cond_signal();
+    Next_pthread_cond_broadcast();
+    Next_sem_wait();
+    Next_sem_timedwait();
+    Next_sem_post();
+    Next_read();
+    Next_write();
+    Next_close();
+    Next_open();
+    Next_openat();
+    Next_mmap();
+    Next_munmap();
+    Next_madvise();
+    Next_nanosleep();
+    Next_clock_nanosleep();
+    Next_usleep();
+    Next_sched_yield();
+    Next_syscall();
+    Next___cxa_allocate_exception();
+
+    void *frame;
+    backtrace(&frame, 1);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassRealtimeCheck
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassRealtimeCheck::IsAvailable() { return true; }
+void LoPassRealtimeCheck::SetContext(const char *inContext) { sContext.store(inContext); }
+void LoPassRealtimeCheck::SetKeepGoing(bool inKeepGoing) { sKeepGoing.store(inKeepGoing); }
+void LoPassRealtimeCheck::SetStrict(bool inStrict) { sStrict.store(inStrict); }
+uint64_t LoPassRealtimeCheck::GetViolationCount() { return sViolations.load(); }
+void LoPassRealtimeCheck::Enter() { sDepth++; }
+void LoPassRealtimeCheck::Leave() { sDepth--; }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The allocator
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+extern "C" {
+
+void *malloc(size_t inSize) noexcept {
+    if (IsChecking()) { Report("malloc", (long long)inSize); }
+    return __libc_malloc(inSize);
+}
+
+void *calloc(size_t inCount, size_t inSize) noexcept {
+    if (IsChecking()) { Report("calloc", (long long)(inCount * inSize)); }
+    return __libc_calloc(inCount, inSize);
+}
+
+void *realloc(void *inPointer, size_t inSize) noexcept {
+    if (IsChecking()) { Report("realloc", (long long)inSize); }
+    return __libc_realloc(inPointer, inSize);
+}
+
+void free(void *inPointer) noexcept {
+    if (inPointer != NULL && IsChecking()) { Report("free"); }
+    __libc_free(inPointer);
+}
+
+void *memalign(size_t inAlignment, size_t inSize) noexcept {
+    if (IsChecking()) { Report("memalign", (long long)inSize); }
+    return __libc_memalign(inAlignment, inSize);
+}
+
+void *aligned_alloc(size_t inAlignment, size_t inSize) noexcept {
+    if (IsChecking()) { Report("aligned_alloc", (long long)inSize); }
+    return __libc_memalign(inAlignment, inSize);
+}
+
+int posix_memalign(void **outPointer, size_t inAlignment, size_t inSize) noexcept {
+    if (IsChecking()) { Report("posix_memalign", (long long)inSize); }
+    if (inAlignment < sizeof(void *) || (inAlignment & (inAlignment - 1)) != 0) { return EINVAL; }
+
+    void *pointer = __libc_memalign(inAlignment, inSize);
+    if (pointer == NULL) { return ENOMEM; }
+
+    *outPointer = pointer;
+    return 0;
+}
+
+void *valloc(size_t inSize) noexcept {
+    if (IsChecking()) { Report("valloc", (long long)inSize); }
+    return __libc_valloc(inSize);
+}
+
+void *pvalloc(size_t inSize) noexcept {
+    if (IsChecking()) { Report("pvalloc", (long long)inSize); }
+    return __libc_pvalloc(inSize);
+}
+
+}
+
+// operator new would only show up as malloc(); these say which it was
+
+static void *New(const char *inCall, size_t inSize) {
+
+    if (IsChecking()) { Report(inCall, (long long)inSize); }
+
+    void *pointer = __libc_malloc(inSize != 0 ? inSize : 1);
+    if (pointer == NULL) { throw std::bad_alloc(); }
+    return pointer;
+}
+
+static void Delete(const char *inCall, void *inPointer) {
+
+    if (inPointer != NULL && IsChecking()) { Report(inCall); }
+    __libc_free(inPointer);
+}
+
+void *operator new(size_t inSize) { return New("operator new", inSize); }
+void *operator new[](size_t inSize) { return New("operator new[]", inSize); }
+
+void *operator new(size_t inSize, const std::nothrow_t&) noexcept {
+    if (IsChecking()) { Report("operator new", (long long)inSize); }
+    return __libc_malloc(inSize != 0 ? inSize : 1);
+}
+
+void *operator new[](size_t inSize, const std::nothrow_t&) noexcept {
+    if (IsChecking()) { Report("operator new[]", (long long)inSize); }
+    return __libc_malloc(inSize != 0 ? inSize : 1);
+}
+
+void operator delete(void *inPointer) noexcept { Delete("operator delete", inPointer); }
+void operator delete[](void *inPointer) noexcept { Delete("operator delete[]", inPointer); }
+void operator delete(void *inPointer, const std::nothrow_t&) noexcept { Delete("operator delete", inPointer); }
+void operator delete[](void *inPointer, const std::nothrow_t&) noexcept { Delete("operator delete[]", inPointer); }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Locks, waits and system calls
+//
+// An uncontended mutex never enters the kernel, but the one that's contended on the night
+// waits behind whatever holds it, so every lock counts, try-locks included.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+extern "C" {
+
+int pthread_mutex_lock(pthread_mutex_t *inMutex) noexcept {
+    if (IsChecking()) { Report("pthread_mutex_lock"); }
+    return Next_pthread_mutex_lock()(inMutex);
+}
+
+int pthread_mutex_trylock(pthread_mutex_t *inMutex) noexcept {
+    if (IsChecking()) { Report("pthread_mutex_trylock"); }
+    return Next_pthread_mutex_trylock()(inMutex);
+}
+
+int pthread_mutex_timedlock(pthread_mutex_t *inMutex, const struct timespec *inTimeout) noexcept {
+    if (IsChecking()) { Report("pthread_mutex_timedlock"); }
+    return Next_pthread_mutex_timedlock()(inMutex, inTimeout);
+}
+
+int pthread_mutex_unlock(pthread_mutex_t *inMutex) noexcept {
+    if (IsChecking()) { Report("pthread_mutex_unlock"); }
+    return Next_pthread_mutex_unlock()(inMutex);
+}
+
+int pthread_cond_wait(pthread_cond_t *inCondition, pthread_mutex_t *inMutex) {
+    if (IsChecking()) { Report("pthread_cond_wait"); }
+    return Next_pthread_cond_wait()(inCondition, inMutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t *inCondition, pthread_mutex_t *inMutex, const struct timespec *inTimeout) {
+    if (IsChecking()) { Report("pthread_cond_timedwait"); }
+    return Next_pthread_cond_timedwait()(inCondition, inMutex, inTimeout);
+}
+
+int pthread_cond_signal(pthread_cond_t *inCondition) noexcept {
+    if (IsChecking()) { Report("pthread_cond_signal"); }
+    return Next_pthread_cond_signal()(inCondition);
+}
+
+int pthread_cond_broadcast(pthread_cond_t *inCondition) noexcept {
+    if (IsChecking()) { Report("pthread_cond_broadcast"); }
+    return Next_pthread_cond_broadcast()(inCondition);
+}
+
+int sem_wait(sem_t *inSemaphore) {
+    if (IsChecking()) { Report("sem_wait"); }
+    return Next_sem_wait()(inSemaphore);
+}
+
+int sem_timedwait(sem_t *inSemaphore, const struct timespec *inTimeout) {
+    if (IsChecking()) { Report("sem_timedwait"); }
+    return Next_sem_timedwait()(inSemaphore, inTimeout);
+}
+
+int sem_post(sem_t *inSemaphore) noexcept {
+    if (IsChecking()) { Report("sem_post"); }
+    return Next_sem_post()(inSemaphore);
+}
+
+ssize_t read(int inFile, void *outData, size_t inSize) {
+    if (IsChecking()) { Report("read", inFile); }
+    return Next_read()(inFile, outData, inSize);
+}
+
+ssize_t write(int inFile, const void *inData, size_t inSize) {
+    if (IsChecking()) { Report("write", inFile); }
+    return Next_write()(inFile, inData, inSize);
+}
+
+int close(int inFile) {
+    if (IsChecking()) { Report("close", inFile); }
+    return Next_close()(inFile);
+}
+
+int open(const char *inPath, int inFlags, ...) {
+
+    va_list arguments;
+    va_start(arguments, inFlags);
+    mode_t mode = (mode_t)va_arg(arguments, unsigned);
+    va_end(arguments);
+
+    if (IsChecking()) { Report("open"); }
+    return Next_open()(inPath, inFlags, mode);
+}
+
+int openat(int inDirectory, const char *inPath, int inFlags, ...) {
+
+    va_list arguments;
+    va_start(arguments, inFlags);
+    mode_t mode = (mode_t)va_arg(arguments, unsigned);
+    va_end(arguments);
+
+    if (IsChecking()) { Report("openat"); }
+    return Next_openat()(inDirectory, inPath, inFlags, mode);
+}
+
+void *mmap(void *inAddress, size_t inSize, int inProtection, int inFlags, int inFile, off_t inOffset) noexcept {
+    if (IsChecking()) { Report("mmap", (long long)inSize); }
+    return Next_mmap()(inAddress, inSize, inProtection, inFlags, inFile, inOffset);
+}
+
+int munmap(void *inAddress, size_t inSize) noexcept {
+    if (IsChecking()) { Report("munmap", (long long)inSize); }
+    return Next_munmap()(inAddress, inSize);
+}
+
+int madvise(void *inAddress, size_t inSize, int inAdvice) noexcept {
+    if (IsChecking()) { Report("madvise", (long long)inSize); }
+    return Next_madvise()(inAddress, inSize, inAdvice);
+}
+
+int nanosleep(const struct timespec *inTime, struct timespec *outRemaining) {
+    if (IsChecking()) { Report("nanosleep"); }
+    return Next_nanosleep()(inTime, outRemaining);
+}
+
+int clock_nanosleep(clockid_t inClock, int inFlags, const struct timespec *inTime, struct timespec *outRemaining) {
+    if (IsChecking()) { Report("clock_nanosleep"); }
+    return Next_clock_nanosleep()(inClock, inFlags, inTime, outRemaining);
+}
+
+int usleep(useconds_t inMicroseconds) {
+    if (IsChecking()) { Report("usleep", inMicroseconds); }
+    return Next_usleep()(inMicroseconds);
+}
+
+int sched_yield() noexcept {
+    if (IsChecking()) { Report("sched_yield"); }
+    return Next_sched_yield()();
+}
+
+long syscall(long inNumber, ...) noexcept {
+
+    va_list arguments;
+    va_start(arguments, inNumber);
+    long a = va_arg(arguments, long);
+    long b = va_arg(arguments, long);
+    long c = va_arg(arguments, long);
+    long d = va_arg(arguments, long);
+    long e = va_arg(arguments, long);
+    long f = va_arg(arguments, long);
+    va_end(arguments);
+
+    if (IsChecking()) {
+        bool wake = inNumber == SYS_futex && (b & FUTEX_CMD_MASK) == FUTEX_WAKE;
+        if (!wake || sStrict.load()) { Report(wake ? "futex wake" : "syscall", inNumber); }
+    }
+
+    return Next_syscall()(inNumber, a, b, c, d, e, f);
+}
+
+// every throw allocates its exception here first
+void *__cxa_allocate_exception(size_t inSize) noexcept {
+    if (IsChecking()) { Report("throw", (long long)inSize); }
+
+    sSuspended++;
+    void *exception = Next___cxa_allocate_exception()(inSize);
+    sSuspended--;
+
+    return exception;
+}
+
+}
+
+#else
+
+bool LoPassRealtimeCheck::IsAvailable() { return false; }
+void LoPassRealtimeCheck::SetContext(const char *) { }
+void LoPassRealtimeCheck::SetKeepGoing(bool) { }
+void LoPassRealtimeCheck::SetStrict(bool) { }
+uint64_t LoPassRealtimeCheck::GetViolationCount() { return 0; }
+void LoPassRealtimeCheck::Enter() { }
+void LoPassRealtimeCheck::Leave() { }
+
+#endif
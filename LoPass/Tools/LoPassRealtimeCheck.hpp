@@ -0,0 +1,67 @@
+//
+//  LoPassRealtimeCheck.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#ifndef LoPassRealtimeCheck_hpp
+#define LoPassRealtimeCheck_hpp
+
+#include <stdint.h>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Realtime Check
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Catches a thread doing what a render call mustn't: allocating or freeing memory, taking
+// or waiting on a lock, throwing, or making a system call that can block. Linking
+// LoPassRealtimeCheck.cpp into a test program replaces malloc() and the rest of the
+// allocator, operator new and delete, the pthread mutex, condition variable and semaphore
+// calls, the start of every C++ throw, and the libc wrappers for the system calls audio
+// code is tempted into (file and memory mapping calls, sleeps, yields and raw syscall()).
+// Outside a LoPassRealtimeScope each one goes straight through to libc; inside one it
+// prints what was called, the case set with SetContext() and a stack, and exits with
+// status 1. Link with -rdynamic so the stack has names.
+//
+// Only calls made through libc's exported symbols are seen: libc calling itself, or a
+// system call made inline, goes past. The one system call the render path makes on
+// purpose, waking LoPassWorkerPool's threads with FUTEX_WAKE, is let through unless strict.
+// Everywhere but Linux with glibc nothing is replaced and IsAvailable() is false.
+
+class LoPassRealtimeCheck {
+
+public:
+    /// False where the calls can't be replaced; scopes then check nothing.
+    static bool IsAvailable();
+
+    /// Printed with each violation, on whichever thread it happens. The string must
+    /// outlive the scopes it describes.
+    static void SetContext(const char *inContext);
+
+    /// Count violations and carry on rather than exit on the first. Only the first few
+    /// print a stack.
+    static void SetKeepGoing(bool inKeepGoing);
+
+    /// Treat futex wakes as violations too.
+    static void SetStrict(bool inStrict);
+
+    static uint64_t GetViolationCount();
+
+    /// What LoPassRealtimeScope calls; scopes nest.
+    static void Enter();
+    static void Leave();
+};
+
+/// Everything the calling thread does until this goes out of scope is checked.
+class LoPassRealtimeScope {
+
+public:
+    LoPassRealtimeScope() { LoPassRealtimeCheck::Enter(); }
+    ~LoPassRealtimeScope() { LoPassRealtimeCheck::Leave(); }
+
+private:
+    LoPassRealtimeScope(const LoPassRealtimeScope&);
+    LoPassRealtimeScope &operator=(const LoPassRealtimeScope&);
+};
+
+#endif /* LoPassRealtimeCheck_hpp */
@@ -0,0 +1,431 @@
+//
+//  LoPassRealtimeTest.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Realtime safety check of the render path: LoPass rendered through a matrix of formats,
+//  automation, bypass and filter modes, with every render call inside a LoPassRealtimeScope,
+//  so the first allocation, lock, throw or blocking system call on the way fails the run
+//  with the call, the case and a stack.
+//
+//  make lopass-rtcheck
+//
+//  Each case renders the way LoPassUnit does under AUEffectBase, without CoreAudio: a
+//  LoPassProcessor per channel, built and prepared before rendering starts as Initialize()
+//  builds the kernels, a LoPassTelemetry around each render, the buffer sliced at each
+//  scheduled parameter event as AUBase::ProcessForScheduledParams() does, wide formats
+//  shared out on a LoPassWorkerPool with each channel group checked on whichever thread
+//  runs it, and buffers skipped once the input has been silent for longer than the latency
+//  and tail. Bypass copies the input through, and turning it off resets the kernels from
+//  outside the render, as AUEffectBase's property call does. Hosts don't always render the
+//  full slice, so every other buffer is shorter and an odd length.
+//
+//  The matrix is every combination of:
+//
+//    channels      1, 2, 6 and 16, the last on the worker pool
+//    sample rate   44.1 and 96 kHz
+//    buffer        16, 256 and 1156 frames, AUBase's default largest slice
+//    automation    none, a new value each buffer, ramps of scheduled events within each
+//                  buffer, and the linear phase and multirate switches thrown mid-stream
+//    bypass        off, on, and toggled every few buffers
+//    mode          IIR, linear phase and multirate to start with
+//
+//  The input goes quiet for the last quarter of each case. Setting parameters, building
+//  processors and starting threads happen outside the scopes, as they do outside the
+//  render in the AudioUnit; the worker pool's wake-up is allowed unless --strict. With
+//  --keep-going every violation is counted and the first few print a stack. The exit
+//  status is 0 only if there were none.
+//
+//  This stands in for AUBase and AUEffectBase; lopass-host --realtime runs the same check
+//  over the real ones, scheduling parameters and rendering through the AudioUnit calls, and
+//  make check-host runs that too.
+//
+//  lopass-rtcheck [options]
+//
+
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include "LoPassRealtimeCheck.hpp"
+#include "LoPassTelemetry.hpp"
+#include "LoPassToolOptions.hpp"
+#include "LoPassWorkerPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <getopt.h>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static constexpr double kDefaultSeconds         = 0.25;
+
+/// As LoPassUnit.hpp.
+static constexpr unsigned kLoPass_ParallelChannels  = 8;
+static constexpr unsigned kLoPass_ChannelsPerGroup  = 4;
+
+/// Scheduled parameter events per buffer when ramping.
+static constexpr unsigned kAutomationEvents     = 4;
+
+/// Buffers between bypass toggles, and between mode switches.
+static constexpr unsigned kBypassPeriod         = 7;
+static constexpr unsigned kModePeriod           = 11;
+
+static const unsigned kChannels[]               = { 1, 2, 6, 16 };
+static const double kSampleRates[]              = { 44100.0, 96000.0 };
+static const unsigned kFrames[]                 = { 16, 256, 1156 };
+
+enum Automation { kAutomation_None, kAutomation_Buffer, kAutomation_Ramp, kAutomation_Modes, kNumberOfAutomations };
+enum Bypass { kBypass_Off, kBypass_On, kBypass_Toggled, kNumberOfBypasses };
+enum Mode { kMode_IIR, kMode_LinearPhase, kMode_Multirate, kNumberOfModes };
+
+static const char *const kAutomationNames[]     = { "static", "per buffer", "ramped", "mode switches" };
+static const char *const kBypassNames[]         = { "off", "on", "toggled" };
+static const char *const kModeNames[]           = { "iir", "linear phase", "multirate" };
+
+template <class T, size_t N> static constexpr size_t Count(const T (&)[N]) { return N; }
+
+struct Case {
+    unsigned    mChannels;
+    double      mSampleRate;
+    unsigned    mFrames;
+    Automation  mAutomation;
+    Bypass      mBypass;
+    Mode        mMode;
+};
+
+static Case GetCase(unsigned inIndex) {
+
+    Case result;
+    result.mMode        = (Mode)(inIndex % kNumberOfModes);         inIndex /= kNumberOfModes;
+    result.mBypass      = (Bypass)(inIndex % kNumberOfBypasses);    inIndex /= kNumberOfBypasses;
+    result.mAutomation  = (Automation)(inIndex % kNumberOfAutomations); inIndex /= kNumberOfAutomations;
+    result.mFrames      = kFrames[inIndex % Count(kFrames)];        inIndex /= Count(kFrames);
+    result.mSampleRate  = kSampleRates[inIndex % Count(kSampleRates)]; inIndex /= Count(kSampleRates);
+    result.mChannels    = kChannels[inIndex % Count(kChannels)];
+    return result;
+}
+
+static constexpr unsigned kNumberOfCases = (unsigned)(Count(kChannels) * Count(kSampleRates) * Count(kFrames)) *
+                                           kNumberOfAutomations * kNumberOfBypasses * kNumberOfModes;
+
+static std::string Describe(unsigned inIndex, const Case &inCase) {
+
+    char text[256];
+    snprintf(text, sizeof(text), "case %u: %u ch, %g Hz, %u frames, %s automation, bypass %s, %s", inIndex, inCase.mChannels,
+             inCase.mSampleRate, inCase.mFrames, kAutomationNames[inCase.mAutomation], kBypassNames[inCase.mBypass],
+             kModeNames[inCase.mMode]);
+    return text;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Instance {
+
+public:
+    explicit Instance(const Case &inCase) :
+        mCase(inCase),
+        mBypassed(inCase.mBypass == kBypass_On),
+        mSilentTimeout(0),
+        mSilentFrames(0),
+        mSkipping(false),
+        mRenders(0),
+        mSlices(0),
+        mInput((size_t)inCase.mChannels * inCase.mFrames),
+        mOutput(mInput.size()),
+        mNoise(1) {
+
+        mSettings.mLinearPhase  = inCase.mMode == kMode_LinearPhase;
+        mSettings.mMultirate    = inCase.mMode == kMode_Multirate;
+        if (mSettings.mMultirate) { mSettings.mCutoff = 60.0; }
+
+        for (unsigned c = 0; c < mCase.mChannels; c++) {
+            mProcessors.emplace_back(new LoPassProcessor(inCase.mSampleRate));
+            mProcessors.back()->Prepare(mSettings);
+            mReported.push_back(mProcessors.back()->GetDesignCount());
+        }
+
+        if (mCase.mChannels >= kLoPass_ParallelChannels) {
+            unsigned workers = std::min(mCase.mChannels / kLoPass_ChannelsPerGroup - 1, kWorkerPool_MaxWorkers);
+            mPool.reset(new LoPassWorkerPool(workers));
+        }
+
+        UpdateSilentTimeout();
+    }
+
+    uint64_t GetRenders() const { return mRenders; }
+    uint64_t GetSlices() const { return mSlices; }
+
+    /// What the host and the UI do between renders: parameters and bypass.
+    void Control(uint64_t inBuffer, uint64_t inPosition) {
+
+        if (mCase.mBypass == kBypass_Toggled && inBuffer % kBypassPeriod == 0) {
+            mBypassed = !mBypassed;
+            if (!mBypassed) {
+                for (size_t c = 0; c < mProcessors.size(); c++) { mProcessors[c]->Reset(); }
+            }
+        }
+
+        if (mCase.mAutomation == kAutomation_Buffer) {
+            mSettings.mCutoff = Sweep(inPosition);
+            mSettings.mResonance = 12.0 * sin(0.001 * inBuffer);
+        }
+
+        if (mCase.mAutomation == kAutomation_Modes && inBuffer % kModePeriod == kModePeriod - 1) {
+            // IIR, then linear phase, then multirate, round again
+            bool linearPhase = !mSettings.mLinearPhase && !mSettings.mMultirate;
+            mSettings.mMultirate = mSettings.mLinearPhase;
+            mSettings.mLinearPhase = linearPhase;
+            // as LoPassUnit::SetParameter() does, before the render thread sees it
+            for (size_t c = 0; c < mProcessors.size(); c++) { mProcessors[c]->Prepare(mSettings); }
+            UpdateSilentTimeout();
+        }
+    }
+
+    /// The input for this buffer, silent for the last quarter.
+    bool Fill(uint64_t inPosition, uint64_t inLength, unsigned inFrames) {
+
+        if (inPosition >= inLength * 3 / 4) { return true; }
+
+        for (size_t i = 0; i < (size_t)mCase.mChannels * inFrames; i++) {
+            mInput[i] = (float)((int32_t)(mNoise = mNoise * 1664525u + 1013904223u) * (0.25 / 2147483648.0));
+        }
+        return false;
+    }
+
+    /// The render call; everything in it is checked.
+    void Render(uint64_t inPosition, unsigned inFrames, bool inSilent) {
+
+        LoPassRealtimeScope scope;
+
+        mTelemetry.BeginRender();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        mSilentFrames = inSilent ? mSilentFrames + inFrames : 0;
+        bool skipped = !mBypassed && inSilent && mSilentFrames > mSilentTimeout + inFrames;
+
+        if (mBypassed) {
+            memcpy(&mOutput[0], &mInput[0], (size_t)mCase.mChannels * inFrames * sizeof(float));
+        } else if (skipped) {
+            // LoPassKernel clears the state on the first buffer it skips
+            if (!mSkipping) {
+                for (size_t c = 0; c < mProcessors.size(); c++) { mProcessors[c]->Reset(); }
+            }
+            memset(&mOutput[0], 0, (size_t)mCase.mChannels * inFrames * sizeof(float));
+        } else if (mCase.mAutomation != kAutomation_Ramp && mCase.mAutomation != kAutomation_Modes) {
+            ProcessBufferLists(0, inFrames, inFrames);
+        } else {
+            for (unsigned e = 0; e < kAutomationEvents; e++) {
+                unsigned begin = inFrames * e / kAutomationEvents;
+                unsigned end = inFrames * (e + 1) / kAutomationEvents;
+                if (end == begin) { continue; }
+
+                mSettings.mCutoff = Sweep(inPosition + begin);
+                mTelemetry.AddSlice();
+                ProcessBufferLists(begin, end - begin, inFrames);
+            }
+        }
+
+        if (!mBypassed) { mSkipping = skipped; }
+
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        mTelemetry.EndRender(inFrames, elapsed, (uint64_t)(1e9 * inFrames / mCase.mSampleRate), skipped);
+
+        mRenders++;
+    }
+
+private:
+    struct Slice {
+        Instance    *mInstance;
+        unsigned    mOffset;
+        unsigned    mFrames;
+        unsigned    mStride;
+    };
+
+    double Sweep(uint64_t inPosition) const {
+        double low = mSettings.mMultirate ? 20.0 : 200.0;
+        return low * pow(40.0, 0.5 + 0.5 * sin(2.0 * M_PI * 3.0 * inPosition / mCase.mSampleRate));
+    }
+
+    void UpdateSilentTimeout() {
+        mSilentTimeout = LoPassProcessor::GetLatencyFrames(mSettings, mCase.mSampleRate) +
+                         LoPassProcessor::GetTailFrames(mSettings, mCase.mSampleRate);
+    }
+
+    void ProcessBufferLists(unsigned inOffset, unsigned inFrames, unsigned inStride) {
+
+        Slice slice = { this, inOffset, inFrames, inStride };
+        mSlices++;
+
+        if (mPool) {
+            mPool->Run(mCase.mChannels, &Instance::ProcessGroup, &slice);
+        } else {
+            for (unsigned c = 0; c < mCase.mChannels; c++) { ProcessKernel(c, slice); }
+        }
+    }
+
+    /// Checked on the worker that runs it as much as on the render thread.
+    static void ProcessGroup(void *inContext, unsigned inBegin, unsigned inEnd) {
+
+        LoPassRealtimeScope scope;
+
+        Slice &slice = *(Slice *)inContext;
+        for (unsigned c = inBegin; c < inEnd; c++) { slice.mInstance->ProcessKernel(c, slice); }
+    }
+
+    void ProcessKernel(unsigned inChannel, const Slice &inSlice) {
+
+        size_t at = (size_t)inChannel * inSlice.mStride + inSlice.mOffset;
+        mProcessors[inChannel]->Process(mSettings, &mInput[at], &mOutput[at], inSlice.mFrames);
+
+        uint64_t designs = mProcessors[inChannel]->GetDesignCount();
+        mTelemetry.AddDesigns(designs - mReported[inChannel]);
+        mReported[inChannel] = designs;
+    }
+
+    Case                                            mCase;
+    LoPassSettings                                  mSettings;
+    bool                                            mBypassed;
+
+    unsigned                                        mSilentTimeout;
+    uint64_t                                        mSilentFrames;
+    bool                                            mSkipping;
+    uint64_t                                        mRenders;
+    uint64_t                                        mSlices;
+
+    std::vector<std::unique_ptr<LoPassProcessor> >  mProcessors;
+    std::vector<uint64_t>                           mReported;
+    std::unique_ptr<LoPassWorkerPool>               mPool;
+    std::vector<float>                              mInput;
+    std::vector<float>                              mOutput;
+    uint32_t                                        mNoise;
+
+    LoPassTelemetry                                 mTelemetry;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RunCase()
+//
+// Full buffers alternate with shorter ones of an odd length.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void RunCase(const Case &inCase, double inSeconds, uint64_t &ioRenders, uint64_t &ioSlices) {
+
+    Instance instance(inCase);
+
+    uint64_t length = (uint64_t)(inSeconds * inCase.mSampleRate);
+    uint64_t position = 0;
+
+    for (uint64_t b = 0; position < length; b++) {
+        unsigned frames = b % 2 == 0 ? inCase.mFrames : (inCase.mFrames * 2 / 3) | 1;
+
+        instance.Control(b, position);
+        bool silent = instance.Fill(position, length, frames);
+        instance.Render(position, frames, silent);
+
+        position += frames;
+    }
+
+    ioRenders += instance.GetRenders();
+    ioSlices += instance.GetSlices();
+}
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-rtcheck [options]\n"
+            "\n"
+            "  -s, --seconds S      seconds of audio per case (default %g)\n"
+            "  -c, --case N         run only case N, 0 to %u\n"
+            "  -k, --keep-going     count every violation rather than stop at the first\n"
+            "  -S, --strict         count the worker pool's futex wakes as violations\n"
+            "  -v, --verbose        list the cases as they run\n",
+            kDefaultSeconds, kNumberOfCases - 1);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "seconds",    required_argument,  NULL, 's' },
+        { "case",       required_argument,  NULL, 'c' },
+        { "keep-going", no_argument,        NULL, 'k' },
+        { "strict",     no_argument,        NULL, 'S' },
+        { "verbose",    no_argument,        NULL, 'v' },
+        { "help",       no_argument,        NULL, 'h' },
+        { NULL,         0,                  NULL, 0 }
+    };
+
+    double seconds = kDefaultSeconds;
+    double only = -1.0;
+    bool verbose = false;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "s:c:kSvh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 's': ok = LoPassParseNumber(optarg, seconds) && seconds > 0.0 && seconds <= 60.0; break;
+            case 'c': ok = LoPassParseNumber(optarg, only) && only >= 0.0 && only < kNumberOfCases && only == floor(only); break;
+            case 'k': LoPassRealtimeCheck::SetKeepGoing(true); break;
+            case 'S': LoPassRealtimeCheck::SetStrict(true); break;
+            case 'v': verbose = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-rtcheck: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    if (!LoPassRealtimeCheck::IsAvailable()) {
+        fprintf(stderr, "lopass-rtcheck: the realtime check needs Linux and glibc\n");
+        return 2;
+    }
+
+    unsigned first = only >= 0.0 ? (unsigned)only : 0;
+    unsigned last = only >= 0.0 ? (unsigned)only + 1 : kNumberOfCases;
+    uint64_t renders = 0;
+    uint64_t slices = 0;
+
+    for (unsigned i = first; i < last; i++) {
+        Case c = GetCase(i);
+        std::string context = Describe(i, c);
+
+        if (verbose) { printf("%s\n", context.c_str()); }
+
+        LoPassRealtimeCheck::SetContext(context.c_str());
+        RunCase(c, seconds, renders, slices);
+        LoPassRealtimeCheck::SetContext(NULL);
+    }
+
+    uint64_t violations = LoPassRealtimeCheck::GetViolationCount();
+
+    printf("%u cases, %llu renders, %llu slices: ", last - first, (unsigned long long)renders, (unsigned long long)slices);
+    if (violations == 0) {
+        printf("no violations\n");
+    } else {
+        printf("%llu violations\n", (unsigned long long)violations);
+    }
+
+    return violations == 0 ? 0 : 1;
+}
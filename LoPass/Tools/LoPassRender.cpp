@@ -0,0 +1,475 @@
+//
+//  LoPassRender.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Offline renderer: runs the LoPass effect over a WAV / RF64 file.
+//
+//  make lopass-render
+//
+//  Each channel goes through its own LoPassProcessor, the same code LoPassKernel runs, so
+//  the output matches the AudioUnit rendering the file with fixed parameters. The input is
+//  memory mapped and the output streamed, both in blocks, so memory use doesn't depend on
+//  the length of the file. Latency is compensated by default: the output is aligned with
+//  the input and has the same length.
+//
+//  With --threads, the IIR filter runs each block across several cores with
+//  LoPassParallelBiquad; see LoPassParallel.hpp for how close that is to a serial run.
+//
+//  With --output-dir, any number of files are rendered with the same settings by a
+//  LoPassBatch, one file per worker at a time, and --threads sets the number of workers.
+//  Each output has the name of its input. Paths can also be listed, one per line, in a
+//  file given with --list ("-" for stdin), which avoids argument length limits.
+//
+//  --io chooses how the files are read and written (see LoPassAsyncIO.hpp). "map", the
+//  default, is the memory mapped reader and stdio writer. "uring" streams both files through
+//  io_uring with reads ahead of and writes behind the filter, and quietly becomes "sync"
+//  (pread / pwrite) where the kernel doesn't allow it. It pays off when the storage is slower
+//  than the filter and there are cores to spare; lopass-iobench measures it.
+//
+//  With --audition, one file is rendered through every factory preset and every --variant
+//  in one pass by a LoPassAudition, each to its own file in DIR named after the input and
+//  the setting. This is the plain lowpass, as the effect sounds once its parameters have
+//  settled. Sixteen settings take a few times as long as one ordinary render, not sixteen.
+//
+//  lopass-render [options] input.wav output.wav
+//  lopass-render [options] --output-dir DIR [--list FILE] [input.wav ...]
+//  lopass-render [options] --audition DIR [--variant HZ:DB ...] input.wav
+//
+
+#include "LoPassAudition.hpp"
+#include "LoPassBatch.hpp"
+#include "LoPassParameters.h"
+#include "LoPassToolOptions.hpp"
+#include <algorithm>
+#include <chrono>
+#include <getopt.h>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <vector>
+
+static constexpr unsigned kDefaultBlockSize = 65536;
+static constexpr unsigned kMaxBlockSize     = 1 << 26;
+
+/// Block size per thread with --threads, long enough to amortise the reruns at low cutoffs.
+static constexpr unsigned kParallelBlockSize = 1 << 21;
+
+/// Block size with --audition, where every setting has its own output buffers.
+static constexpr unsigned kAuditionBlockSize = 4096;
+
+/// A setting for --audition, and the end of its output file's name.
+struct AuditionSetting {
+    std::string mName;
+    double      mCutoff;
+    double      mResonance;
+};
+
+static void PrintUsage(FILE *inFile) {
+    
+    fprintf(inFile,
+            "usage: lopass-render [options] input.wav output.wav\n"
+            "       lopass-render [options] --output-dir DIR [--list FILE] [input.wav ...]\n"
+            "       lopass-render [options] --audition DIR [--variant HZ:DB ...] input.wav\n"
+            "\n");
+    LoPassSettingOptions::PrintUsage(inFile);
+    fprintf(inFile,
+            "  -b, --block FRAMES       frames per processing block (default %u, or %u per thread)\n"
+            "  -j, --threads N          run the IIR filter across N threads (0 for one per core),\n"
+            "                           or with --output-dir, render N files at once\n"
+            "  -e, --exact              with --threads, insist on bit identical output\n"
+            "  -f, --float              write 32 bit float rather than the input format\n"
+            "  -k, --keep-latency       don't compensate the latency of the chosen mode\n"
+            "  -o, --output-dir DIR     batch mode, writing each output to DIR\n"
+            "  -i, --list FILE          batch mode inputs, one path per line\n"
+            "  -I, --io map|sync|uring  file I/O backend (default map)\n"
+            "  -a, --audition DIR       render every preset and variant in one pass, into DIR\n"
+            "  -v, --variant HZ:DB      with --audition, another cutoff and resonance to try\n"
+            "  -q, --quiet              no progress report\n"
+            "\n",
+            kDefaultBlockSize, kParallelBlockSize);
+    LoPassSettingOptions::PrintPresets(inFile);
+}
+
+static bool FindBackend(const char *inName, LoPassIOBackend &outBackend) {
+    
+    const LoPassIOBackend backends[] = { kLoPassIO_Map, kLoPassIO_Sync, kLoPassIO_Uring };
+    
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strcasecmp(inName, LoPassIOBackendName(backends[i])) == 0) {
+            outBackend = backends[i];
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/// Appends the lines of inPath (stdin for "-") to ioPaths.
+static bool ReadList(const char *inPath, std::vector<std::string> &ioPaths) {
+    
+    FILE *file = strcmp(inPath, "-") == 0 ? stdin : fopen(inPath, "r");
+    if (file == NULL) { return false; }
+    
+    char line[4096];
+    
+    while (fgets(line, sizeof(line), file) != NULL) {
+        size_t length = strcspn(line, "\r\n");
+        if (length > 0) { ioPaths.push_back(std::string(line, length)); }
+    }
+    
+    if (file != stdin) { fclose(file); }
+    return true;
+}
+
+/// HZ:DB for --variant.
+static bool ParseVariant(const char *inText, std::vector<AuditionSetting> &ioVariants) {
+    
+    const char *colon = strchr(inText, ':');
+    if (colon == NULL) { return false; }
+    
+    AuditionSetting variant;
+    if (!LoPassParseNumber(std::string(inText, colon - inText).c_str(), variant.mCutoff) || variant.mCutoff <= 0.0) { return false; }
+    if (!LoPassParseNumber(colon + 1, variant.mResonance)) { return false; }
+    
+    char name[64];
+    snprintf(name, sizeof(name), "%gHz_%gdB", variant.mCutoff, variant.mResonance);
+    variant.mName = name;
+    
+    ioVariants.push_back(variant);
+    return true;
+}
+
+static void PrintStats(const char *inName, const LoPassRenderStats &inStats) {
+    
+    double audio = inStats.mFrames / inStats.mSampleRate;
+    double speed = inStats.mSeconds > 0.0 ? audio / inStats.mSeconds : 0.0;
+    double rate  = inStats.mSeconds > 0.0 ? inStats.mBytes / inStats.mSeconds / 1e6 : 0.0;
+    
+    fprintf(stderr, "%s: %.3f s of audio in %.3f s: %.1fx realtime, %.1f MB/s\n",
+            inName, audio, inStats.mSeconds, speed, rate);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RenderBatch()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static int RenderBatch(const LoPassRenderOptions        &inOptions,
+                       unsigned                         inThreads,
+                       const std::string                &inOutputDir,
+                       const std::vector<std::string>   &inInputs,
+                       bool                             inQuiet) {
+    
+    std::vector<LoPassBatchJob> jobs(inInputs.size());
+    
+    for (size_t i = 0; i < inInputs.size(); i++) {
+        const std::string &input = inInputs[i];
+        size_t slash = input.find_last_of('/');
+        jobs[i].mInputPath  = input;
+        jobs[i].mOutputPath = inOutputDir + "/" + (slash == std::string::npos ? input : input.substr(slash + 1));
+    }
+    
+    LoPassBatch batch(inOptions, inThreads);
+    std::vector<LoPassBatchResult> results;
+    
+    batch.Run(jobs, results);
+    
+    // totals over the files that made it
+    LoPassRenderStats total;
+    memset(&total, 0, sizeof(total));
+    double audio    = 0.0;
+    unsigned failed = 0;
+    
+    for (size_t i = 0; i < results.size(); i++) {
+        
+        const LoPassBatchResult &result = results[i];
+        
+        if (!result.mOK) {
+            fprintf(stderr, "lopass-render: %s: %s\n", jobs[i].mInputPath.c_str(), result.mError.c_str());
+            failed++;
+            continue;
+        }
+        
+        if (!inQuiet) { PrintStats(jobs[i].mInputPath.c_str(), result.mStats); }
+        
+        total.mFrames  += result.mStats.mFrames;
+        total.mBytes   += result.mStats.mBytes;
+        audio          += result.mStats.mFrames / result.mStats.mSampleRate;
+    }
+    
+    if (!inQuiet) {
+        double seconds = batch.GetSeconds();
+        fprintf(stderr, "%zu files (%u failed), %u tasks, %u workers, %u steals, %s I/O\n",
+                jobs.size(), failed, batch.GetTaskCount(), batch.GetThreads(), batch.GetSteals(),
+                LoPassIOBackendName(batch.GetBackend()));
+        fprintf(stderr, "total: %.3f s of audio in %.3f s: %.1fx realtime, %.1f MB/s, %.1f files/s\n",
+                audio, seconds,
+                seconds > 0.0 ? audio / seconds : 0.0,
+                seconds > 0.0 ? total.mBytes / seconds / 1e6 : 0.0,
+                seconds > 0.0 ? jobs.size() / seconds : 0.0);
+    }
+    
+    return failed == 0 ? 0 : 1;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RenderAudition()
+//
+// Reads the input once and writes a file per setting. The time spent filtering is reported
+// apart from the reading and writing, which grow with the number of settings whatever the
+// filter does.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static int RenderAudition(const std::string                     &inInput,
+                          const std::string                     &inOutputDir,
+                          const std::vector<AuditionSetting>    &inSettings,
+                          unsigned                              inBlockSize,
+                          bool                                  inWriteFloat,
+                          bool                                  inQuiet) {
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    LoPassWaveReader reader;
+    if (!reader.Open(inInput.c_str())) {
+        fprintf(stderr, "lopass-render: %s\n", reader.GetError().c_str());
+        return 1;
+    }
+    
+    const LoPassWaveFormat inputFormat = reader.GetFormat();
+    const unsigned channels = inputFormat.mChannels;
+    const unsigned settings = (unsigned)inSettings.size();
+    const uint64_t totalFrames = reader.GetFrameCount();
+    
+    LoPassWaveFormat outputFormat = inputFormat;
+    
+    if (inWriteFloat) {
+        outputFormat.mFloat         = true;
+        outputFormat.mBitsPerSample = 32;
+    }
+    
+    // the input's name without its directory or extension
+    size_t slash = inInput.find_last_of('/');
+    std::string stem = slash == std::string::npos ? inInput : inInput.substr(slash + 1);
+    size_t dot = stem.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) { stem.erase(dot); }
+    
+    LoPassAudition audition(inputFormat.mSampleRate, channels);
+    std::vector<std::unique_ptr<LoPassWaveWriter> > writers(settings);
+    
+    for (unsigned s = 0; s < settings; s++) {
+        
+        audition.AddSetting(inSettings[s].mCutoff, inSettings[s].mResonance);
+        
+        std::string path = inOutputDir + "/" + stem + "-" + inSettings[s].mName + ".wav";
+        writers[s].reset(new LoPassWaveWriter());
+        
+        if (!writers[s]->Open(path.c_str(), outputFormat, totalFrames)) {
+            fprintf(stderr, "lopass-render: %s\n", writers[s]->GetError().c_str());
+            return 1;
+        }
+        
+        if (!inQuiet) { fprintf(stderr, "%s: cutoff %g Hz, resonance %g dB\n", path.c_str(), inSettings[s].mCutoff, inSettings[s].mResonance); }
+    }
+    
+    std::vector<std::vector<float> > input(channels, std::vector<float>(inBlockSize));
+    std::vector<std::vector<float> > output((size_t)settings * channels, std::vector<float>(inBlockSize));
+    std::vector<float *> inputP(channels), outputP(output.size());
+    
+    for (unsigned c = 0; c < channels; c++) { inputP[c] = &input[c][0]; }
+    for (size_t n = 0; n < output.size(); n++) { outputP[n] = &output[n][0]; }
+    
+    double filterSeconds = 0.0;
+    uint64_t written = 0;
+    
+    while (written < totalFrames) {
+        
+        unsigned count = reader.Read(&inputP[0], inBlockSize);
+        if (count == 0) { break; }
+        
+        auto filterStart = std::chrono::steady_clock::now();
+        audition.Process(&inputP[0], &outputP[0], count);
+        filterSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - filterStart).count();
+        
+        for (unsigned s = 0; s < settings; s++) {
+            if (!writers[s]->Write(&outputP[(size_t)s * channels], count)) {
+                fprintf(stderr, "lopass-render: %s\n", writers[s]->GetError().c_str());
+                return 1;
+            }
+        }
+        
+        written += count;
+    }
+    
+    for (unsigned s = 0; s < settings; s++) {
+        if (!writers[s]->Close()) {
+            fprintf(stderr, "lopass-render: %s\n", writers[s]->GetError().c_str());
+            return 1;
+        }
+    }
+    
+    reader.Close();
+    
+    if (!inQuiet) {
+        double audio = totalFrames / inputFormat.mSampleRate;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "%s: %.3f s of audio through %u settings in %.3f s, %.3f s of it filtering: %.1fx realtime per setting\n",
+                inInput.c_str(), audio, settings, seconds, filterSeconds, seconds > 0.0 ? audio * settings / seconds : 0.0);
+    }
+    
+    return 0;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+    
+    static const struct option kOptions[] = {
+        { "cutoff",         required_argument,  NULL, 'c' },
+        { "resonance",      required_argument,  NULL, 'r' },
+        { "preset",         required_argument,  NULL, 'p' },
+        { "smoothing",      required_argument,  NULL, 's' },
+        { "linear-phase",   no_argument,        NULL, 'l' },
+        { "multirate",      no_argument,        NULL, 'm' },
+        { "block",          required_argument,  NULL, 'b' },
+        { "threads",        required_argument,  NULL, 'j' },
+        { "exact",          no_argument,        NULL, 'e' },
+        { "float",          no_argument,        NULL, 'f' },
+        { "keep-latency",   no_argument,        NULL, 'k' },
+        { "output-dir",     required_argument,  NULL, 'o' },
+        { "list",           required_argument,  NULL, 'i' },
+        { "io",             required_argument,  NULL, 'I' },
+        { "audition",       required_argument,  NULL, 'a' },
+        { "variant",        required_argument,  NULL, 'v' },
+        { "quiet",          no_argument,        NULL, 'q' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+    
+    LoPassRenderOptions options;
+    LoPassSettings &settings = options.mSettings;
+    LoPassSettingOptions settingOptions;
+    double blockSize    = 0.0;
+    double threads      = 1.0;
+    bool exact          = false;
+    bool quiet          = false;
+    std::string outputDir;
+    std::string auditionDir;
+    std::vector<AuditionSetting> variants;
+    std::vector<std::string> inputs;
+    int option;
+    
+    while ((option = getopt_long(argc, argv, "c:r:p:s:lmb:j:efko:i:I:a:v:qh", kOptions, NULL)) != -1) {
+        
+        bool ok = true;
+        
+        switch (option) {
+            case 'c': case 'r': case 'p': case 's': case 'l': case 'm': ok = settingOptions.Parse(option, optarg); break;
+            case 'b': ok = LoPassParseNumber(optarg, blockSize) && blockSize >= 1.0 && blockSize <= kMaxBlockSize; break;
+            case 'j': ok = LoPassParseNumber(optarg, threads) && threads >= 0.0 && threads <= 1024.0; break;
+            case 'e': exact = true; break;
+            case 'f': options.mWriteFloat = true; break;
+            case 'k': options.mKeepLatency = true; break;
+            case 'o': outputDir = optarg; break;
+            case 'i': ok = ReadList(optarg, inputs); break;
+            case 'I': ok = FindBackend(optarg, options.mBackend); break;
+            case 'a': auditionDir = optarg; break;
+            case 'v': ok = ParseVariant(optarg, variants); break;
+            case 'q': quiet = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+                
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+        
+        if (!ok) {
+            fprintf(stderr, "lopass-render: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+    
+    settings = settingOptions.GetSettings();
+    
+    bool batch = !outputDir.empty();
+    
+    for (int i = optind; i < argc; i++) { inputs.push_back(argv[i]); }
+    
+    if (!auditionDir.empty()) {
+        
+        if (batch || inputs.size() != 1) {
+            PrintUsage(stderr);
+            return 2;
+        }
+        
+        if (settings.mLinearPhase || settings.mMultirate) {
+            fprintf(stderr, "lopass-render: --audition renders the plain lowpass only\n");
+            return 2;
+        }
+        
+        std::vector<AuditionSetting> auditioned;
+        
+        for (int i = 0; i < kNumberOfPresets; i++) {
+            AuditionSetting preset = { kPresetValues[i].mName, kPresetValues[i].mFrequency, kPresetValues[i].mResonance };
+            auditioned.push_back(preset);
+        }
+        
+        auditioned.insert(auditioned.end(), variants.begin(), variants.end());
+        
+        return RenderAudition(inputs[0], auditionDir, auditioned, blockSize > 0.0 ? (unsigned)blockSize : kAuditionBlockSize,
+                              options.mWriteFloat, quiet);
+    }
+    
+    if (batch ? inputs.empty() : inputs.size() != 2) {
+        PrintUsage(stderr);
+        return 2;
+    }
+    
+    if (batch) {
+        options.mBlockSize = blockSize > 0.0 ? (unsigned)blockSize : kDefaultBlockSize;
+        return RenderBatch(options, (unsigned)threads, outputDir, inputs, quiet);
+    }
+    
+    std::unique_ptr<LoPassParallelBiquad> parallel;
+    
+    if (threads != 1.0) {
+        parallel.reset(new LoPassParallelBiquad((unsigned)threads));
+        parallel->SetTolerance(exact ? 0.0 : kParallel_DefaultTolerance);
+    }
+    
+    if (blockSize == 0.0) {
+        blockSize = parallel ? std::min<double>(kMaxBlockSize, (double)kParallelBlockSize * parallel->GetThreads())
+                             : kDefaultBlockSize;
+    }
+    
+    options.mBlockSize  = (unsigned)blockSize;
+    options.mParallel   = parallel.get();
+    
+    if (!quiet) {
+        fprintf(stderr, "cutoff %g Hz, resonance %g dB%s%s\n",
+                settings.mCutoff, settings.mResonance,
+                settings.mLinearPhase ? ", linear phase" : "",
+                settings.mMultirate && !settings.mLinearPhase ? ", multirate" : "");
+        
+        if (parallel) { fprintf(stderr, "%u threads, %u frame blocks\n", parallel->GetThreads(), options.mBlockSize); }
+    }
+    
+    LoPassRenderer renderer(options);
+    LoPassRenderStats stats;
+    
+    if (!renderer.Render(inputs[0].c_str(), inputs[1].c_str(), stats)) {
+        fprintf(stderr, "lopass-render: %s\n", renderer.GetError().c_str());
+        return 1;
+    }
+    
+    if (!quiet) {
+        PrintStats(inputs[0].c_str(), stats);
+        fprintf(stderr, "%s I/O\n", LoPassIOBackendName(renderer.GetBackend()));
+    }
+    
+    return 0;
+}
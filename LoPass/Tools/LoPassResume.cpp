@@ -0,0 +1,274 @@
+//
+//  LoPassResume.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Checks that a stream split into chunks, and handed from processor to processor through
+//  ExportState() / ImportState(), renders the same as the stream in one go.
+//
+//  make lopass-resume
+//
+//  Noise is run through each mode twice. The reference processes each stretch between
+//  parameter changes in a single call. The resumed run cuts the same stretches into random
+//  chunks, and after a random number of chunks exports its state, throws the processor away
+//  and carries on with a new one built from the blob. The two outputs must match to the
+//  bit. Damaged blobs, and blobs for another sample rate, must be refused.
+//
+//  lopass-resume [seed]
+//
+
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static constexpr double kSampleRate     = 48000.0;
+static constexpr unsigned kFrames       = 240000;   // 5 seconds
+static constexpr unsigned kMaxChunk     = 3000;
+static constexpr unsigned kMaxRun       = 8;        // chunks between hand-overs
+
+/// Settings that apply from mFrame on.
+struct Change {
+    unsigned        mFrame;
+    LoPassSettings  mSettings;
+};
+
+struct Scenario {
+    const char          *mName;
+    std::vector<Change> mChanges;
+};
+
+static uint32_t Random(uint32_t &ioSeed) {
+
+    ioSeed = ioSeed * 1664525u + 1013904223u;
+    return ioSeed >> 8;
+}
+
+static LoPassSettings MakeSettings(double inCutoff, double inResonance, double inSmoothing, bool inMultirate, bool inLinearPhase) {
+
+    LoPassSettings settings;
+    settings.mCutoff        = inCutoff;
+    settings.mResonance     = inResonance;
+    settings.mSmoothing     = inSmoothing;
+    settings.mMultirate     = inMultirate;
+    settings.mLinearPhase   = inLinearPhase;
+    return settings;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Scenarios
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static std::vector<Scenario> MakeScenarios() {
+
+    std::vector<Scenario> scenarios;
+    Scenario scenario;
+
+    // smoothed sweeps, so most hand-overs land mid ramp
+    scenario.mName = "filter, smoothed";
+    scenario.mChanges.clear();
+    for (unsigned i = 0; i < 40; i++) {
+        Change change = { i * (kFrames / 40), MakeSettings(200.0 * (1 + (i * 7) % 40), (i % 5) * 4.0, 20.0, false, false) };
+        scenario.mChanges.push_back(change);
+    }
+    scenarios.push_back(scenario);
+
+    scenario.mName = "filter, unsmoothed";
+    scenario.mChanges.clear();
+    for (unsigned i = 0; i < 10; i++) {
+        Change change = { i * (kFrames / 10), MakeSettings(20000.0 - 1900.0 * i, 10.0, 0.0, false, false) };
+        scenario.mChanges.push_back(change);
+    }
+    scenarios.push_back(scenario);
+
+    // across stage counts, so lanes are warming up and crossfading at some hand-overs
+    scenario.mName = "multirate";
+    scenario.mChanges.clear();
+    const double multirateCutoffs[] = { 30.0, 400.0, 60.0, 1200.0, 15.0, 150.0 };
+    for (unsigned i = 0; i < 6; i++) {
+        Change change = { i * (kFrames / 6), MakeSettings(multirateCutoffs[i], 6.0, 10.0, true, false) };
+        scenario.mChanges.push_back(change);
+    }
+    scenarios.push_back(scenario);
+
+    // one target: a redesign lands whenever the designer thread gets to it
+    scenario.mName = "linear phase";
+    scenario.mChanges.clear();
+    Change change = { 0, MakeSettings(900.0, 12.0, 10.0, false, true) };
+    scenario.mChanges.push_back(change);
+    scenarios.push_back(scenario);
+
+    return scenarios;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Runs
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static unsigned GetEnd(const Scenario &inScenario, size_t inChange) {
+
+    return inChange + 1 < inScenario.mChanges.size() ? inScenario.mChanges[inChange + 1].mFrame : kFrames;
+}
+
+static void RenderReference(const Scenario &inScenario, const std::vector<float> &inSource, std::vector<float> &outDest) {
+
+    LoPassProcessor processor(kSampleRate);
+    processor.Prepare(inScenario.mChanges[0].mSettings);
+
+    for (size_t c = 0; c < inScenario.mChanges.size(); c++) {
+        unsigned start = inScenario.mChanges[c].mFrame;
+        processor.Process(inScenario.mChanges[c].mSettings, &inSource[start], &outDest[start], GetEnd(inScenario, c) - start);
+    }
+}
+
+/// Returns false if an import failed; outResumes and outBytes describe the hand-overs.
+static bool RenderResumed(const Scenario            &inScenario,
+                          const std::vector<float>  &inSource,
+                          std::vector<float>        &outDest,
+                          uint32_t                  &ioSeed,
+                          unsigned                  &outResumes,
+                          size_t                    &outBytes) {
+
+    std::unique_ptr<LoPassProcessor> processor(new LoPassProcessor(kSampleRate));
+    processor->Prepare(inScenario.mChanges[0].mSettings);
+
+    std::vector<uint8_t> state;
+    unsigned untilResume = 1 + Random(ioSeed) % kMaxRun;
+
+    outResumes  = 0;
+    outBytes    = 0;
+
+    for (size_t c = 0; c < inScenario.mChanges.size(); c++) {
+
+        const LoPassSettings &settings = inScenario.mChanges[c].mSettings;
+        unsigned end = GetEnd(inScenario, c);
+
+        for (unsigned frame = inScenario.mChanges[c].mFrame; frame < end; ) {
+
+            unsigned chunk = 1 + Random(ioSeed) % kMaxChunk;
+            if (chunk > end - frame) { chunk = end - frame; }
+
+            processor->Process(settings, &inSource[frame], &outDest[frame], chunk);
+            frame += chunk;
+
+            if (--untilResume != 0) { continue; }
+
+            state.clear();
+            processor->ExportState(state);
+
+            processor.reset(new LoPassProcessor(kSampleRate));
+            if (!processor->ImportState(&state[0], state.size())) { return false; }
+
+            outResumes++;
+            outBytes = state.size() > outBytes ? state.size() : outBytes;
+            untilResume = 1 + Random(ioSeed) % kMaxRun;
+        }
+    }
+
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Bad blobs
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static bool CheckRefused(const std::vector<float> &inSource) {
+
+    LoPassSettings settings = MakeSettings(1000.0, 6.0, 10.0, false, false);
+    std::vector<float> dest(4096);
+
+    LoPassProcessor processor(kSampleRate);
+    processor.Process(settings, &inSource[0], &dest[0], (unsigned)dest.size());
+
+    std::vector<uint8_t> state;
+    processor.ExportState(state);
+
+    bool ok = true;
+
+    // every byte, flipped in turn
+    for (size_t i = 0; i < state.size(); i++) {
+        std::vector<uint8_t> damaged(state);
+        damaged[i] ^= 0x20;
+
+        LoPassProcessor other(kSampleRate);
+        if (other.ImportState(&damaged[0], damaged.size())) {
+            printf("  a blob damaged at byte %zu was accepted\n", i);
+            ok = false;
+        }
+    }
+
+    LoPassProcessor truncated(kSampleRate);
+    if (truncated.ImportState(&state[0], state.size() - 1)) {
+        printf("  a truncated blob was accepted\n");
+        ok = false;
+    }
+
+    LoPassProcessor otherRate(2.0 * kSampleRate);
+    if (otherRate.ImportState(&state[0], state.size())) {
+        printf("  a blob for %g Hz was accepted at %g Hz\n", kSampleRate, 2.0 * kSampleRate);
+        ok = false;
+    }
+
+    LoPassProcessor same(kSampleRate);
+    if (!same.ImportState(&state[0], state.size())) {
+        printf("  the undamaged blob was refused\n");
+        ok = false;
+    }
+
+    return ok;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, const char *argv[]) {
+
+    uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1;
+
+    // white noise at -6 dB
+    std::vector<float> source(kFrames);
+    uint32_t noise = 12345;
+    for (unsigned i = 0; i < kFrames; i++) { source[i] = (float)((int32_t)(noise = noise * 1664525u + 1013904223u) * (0.5 / 2147483648.0)); }
+
+    std::vector<Scenario> scenarios = MakeScenarios();
+    bool ok = true;
+
+    printf("%-20s %8s %10s %12s  %s\n", "mode", "resumes", "blob", "mismatches", "result");
+
+    for (size_t s = 0; s < scenarios.size(); s++) {
+
+        std::vector<float> reference(kFrames), resumed(kFrames);
+        RenderReference(scenarios[s], source, reference);
+
+        unsigned resumes;
+        size_t bytes;
+        bool imported = RenderResumed(scenarios[s], source, resumed, seed, resumes, bytes);
+
+        unsigned mismatches = 0;
+        unsigned first = kFrames;
+
+        for (unsigned i = 0; i < kFrames; i++) {
+            if (memcmp(&reference[i], &resumed[i], sizeof(float)) != 0) {
+                if (mismatches++ == 0) { first = i; }
+            }
+        }
+
+        bool passed = imported && mismatches == 0;
+        ok = ok && passed;
+
+        printf("%-20s %8u %8zu B %12u  %s", scenarios[s].mName, resumes, bytes, mismatches,
+               !imported ? "FAIL (import refused)" : passed ? "ok" : "FAIL");
+        if (mismatches != 0) { printf(", first at frame %u", first); }
+        printf("\n");
+    }
+
+    bool refused = CheckRefused(source);
+    printf("%-20s %s\n", "bad blobs refused", refused ? "ok" : "FAIL");
+
+    return ok && refused ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+//
+//  LoPassStream.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Streaming renderer: lopass-render's single file mode on the coroutine pipeline.
+//
+//  make lopass-stream      (C++20)
+//
+//  Each file goes through a LoPassPipeline, so reading, format conversion, filtering and
+//  writing run as separate stages on a small thread pool, with at most --depth blocks of
+//  --block frames in memory whatever the length of the file. The output is identical to
+//  lopass-render's with the same settings. Several input / output pairs can be given;
+//  they are rendered one after another by the same pipeline.
+//
+//  lopass-stream [options] input.wav output.wav [input.wav output.wav ...]
+//
+
+#include "LoPassPipeline.hpp"
+#include "LoPassToolOptions.hpp"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr unsigned kDefaultBlockSize = 16384;
+static constexpr unsigned kMaxBlockSize     = 1 << 24;
+static constexpr unsigned kDefaultDepth     = 8;
+static constexpr unsigned kDefaultThreads   = 4;
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-stream [options] input.wav output.wav [input.wav output.wav ...]\n"
+            "\n");
+    LoPassSettingOptions::PrintUsage(inFile);
+    fprintf(inFile,
+            "  -b, --block FRAMES       frames per block (default %u)\n"
+            "  -d, --depth N            blocks in flight, the bound on memory use (default %u)\n"
+            "  -j, --threads N          threads running the stages (0 for one per core, default %u)\n"
+            "  -f, --float              write 32 bit float rather than the input format\n"
+            "  -k, --keep-latency       don't compensate the latency of the chosen mode\n"
+            "  -q, --quiet              no progress report\n"
+            "\n",
+            kDefaultBlockSize, kDefaultDepth, kDefaultThreads);
+    LoPassSettingOptions::PrintPresets(inFile);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "cutoff",         required_argument,  NULL, 'c' },
+        { "resonance",      required_argument,  NULL, 'r' },
+        { "preset",         required_argument,  NULL, 'p' },
+        { "smoothing",      required_argument,  NULL, 's' },
+        { "linear-phase",   no_argument,        NULL, 'l' },
+        { "multirate",      no_argument,        NULL, 'm' },
+        { "block",          required_argument,  NULL, 'b' },
+        { "depth",          required_argument,  NULL, 'd' },
+        { "threads",        required_argument,  NULL, 'j' },
+        { "float",          no_argument,        NULL, 'f' },
+        { "keep-latency",   no_argument,        NULL, 'k' },
+        { "quiet",          no_argument,        NULL, 'q' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+
+    LoPassRenderOptions options;
+    LoPassSettings &settings = options.mSettings;
+    LoPassSettingOptions settingOptions;
+    double blockSize    = kDefaultBlockSize;
+    double depth        = kDefaultDepth;
+    double threads      = kDefaultThreads;
+    bool quiet          = false;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "c:r:p:s:lmb:d:j:fkqh", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'c': case 'r': case 'p': case 's': case 'l': case 'm': ok = settingOptions.Parse(option, optarg); break;
+            case 'b': ok = LoPassParseNumber(optarg, blockSize) && blockSize >= 1.0 && blockSize <= kMaxBlockSize; break;
+            case 'd': ok = LoPassParseNumber(optarg, depth) && depth >= 2.0 && depth <= 4096.0; break;
+            case 'j': ok = LoPassParseNumber(optarg, threads) && threads >= 0.0 && threads <= 1024.0; break;
+            case 'f': options.mWriteFloat = true; break;
+            case 'k': options.mKeepLatency = true; break;
+            case 'q': quiet = true; break;
+            case 'h': PrintUsage(stdout); return 0;
+
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-stream: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    int files = argc - optind;
+
+    if (files < 2 || files % 2 != 0) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    settings = settingOptions.GetSettings();
+
+    options.mBlockSize = (unsigned)blockSize;
+
+    LoPassScheduler scheduler((unsigned)threads);
+    LoPassPipeline pipeline(options, scheduler, (unsigned)depth);
+    int status = 0;
+
+    for (int i = optind; i < argc; i += 2) {
+
+        LoPassRenderStats stats;
+
+        if (!pipeline.Render(argv[i], argv[i + 1], stats)) {
+            fprintf(stderr, "lopass-stream: %s\n", pipeline.GetError().c_str());
+            status = 1;
+            continue;
+        }
+
+        if (!quiet) {
+            double audio = stats.mFrames / stats.mSampleRate;
+            fprintf(stderr, "%s: %.3f s of audio in %.3f s: %.1fx realtime, %.1f MB/s, %u of %u blocks in flight\n",
+                    argv[i], audio, stats.mSeconds,
+                    stats.mSeconds > 0.0 ? audio / stats.mSeconds : 0.0,
+                    stats.mSeconds > 0.0 ? stats.mBytes / stats.mSeconds / 1e6 : 0.0,
+                    pipeline.GetHighWater(), (unsigned)depth);
+        }
+    }
+
+    return status;
+}
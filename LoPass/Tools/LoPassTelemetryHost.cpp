@@ -0,0 +1,340 @@
+//
+//  LoPassTelemetryHost.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Test host for the render telemetry: a session of many instances, each keeping the
+//  counters LoPassUnit hands out as kAudioUnitCustomProperty_RenderTelemetry, and a table
+//  of the instances taking the most time.
+//
+//  make lopass-telemetry
+//
+//  Each instance renders the way LoPassUnit does under AUEffectBase, without CoreAudio: a
+//  LoPassProcessor per channel and a LoPassTelemetry around every render, with the same
+//  BeginRender(), AddSlice() and EndRender() calls, slicing a buffer at each scheduled
+//  parameter event as AUBase::ProcessForScheduledParams() does, skipping buffers once the
+//  input has been silent for longer than the latency and tail as AUSilentTimeout lets the
+//  kernels, and reporting designs from each channel as LoPassKernel does. The session is a
+//  deterministic mix: mostly stereo, some mono and wide buses, some tracks automated with
+//  several events a buffer, a few in linear phase or multirate mode, and some that go
+//  quiet after the first second. The buffers are rendered back to back, one instance after
+//  another, and the deadline is the length of the buffer.
+//
+//  At the end each instance's snapshot is read, as a host would through the property, and
+//  the instances are listed from the most render time down with the counters that say why.
+//
+//  lopass-telemetry [options]
+//
+
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include "LoPassTelemetry.hpp"
+#include "LoPassToolOptions.hpp"
+#include <algorithm>
+#include <chrono>
+#include <getopt.h>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static constexpr unsigned kDefaultInstances     = 300;
+static constexpr unsigned kDefaultFrames        = 128;
+static constexpr double kDefaultSampleRate      = 48000.0;
+static constexpr double kDefaultSeconds         = 10.0;
+static constexpr unsigned kDefaultTop           = 20;
+
+/// Scheduled parameter events per buffer on an automated track.
+static constexpr unsigned kAutomationEvents     = 4;
+
+/// Quiet tracks stop after this long.
+static constexpr double kQuietAfterSeconds      = 1.0;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Instance {
+
+public:
+    Instance(unsigned inIndex, unsigned inChannels, const LoPassSettings &inSettings, bool inAutomated, bool inQuiet,
+             double inSampleRate, unsigned inMaxFrames) :
+        mIndex(inIndex),
+        mChannels(inChannels),
+        mSettings(inSettings),
+        mAutomated(inAutomated),
+        mQuiet(inQuiet),
+        mSampleRate(inSampleRate),
+        mSilentTimeout(0),
+        mSilentFrames(0),
+        mSkipping(false),
+        mInput((size_t)inChannels * inMaxFrames),
+        mOutput(mInput.size()),
+        mNoise(inIndex * 2654435761u + 1) {
+
+        for (unsigned c = 0; c < mChannels; c++) {
+            mProcessors.emplace_back(new LoPassProcessor(inSampleRate));
+            mProcessors.back()->Prepare(mSettings);
+        }
+
+        mSilentTimeout = LoPassProcessor::GetLatencyFrames(mSettings, inSampleRate) + LoPassProcessor::GetTailFrames(mSettings, inSampleRate);
+
+        // the kernels are built on Initialize(), so their first designs aren't counted
+        for (unsigned c = 0; c < mChannels; c++) { mReported.push_back(mProcessors[c]->GetDesignCount()); }
+    }
+
+    unsigned GetIndex() const { return mIndex; }
+    unsigned GetChannels() const { return mChannels; }
+    bool IsAutomated() const { return mAutomated; }
+    bool IsQuiet() const { return mQuiet; }
+    const LoPassSettings &GetSettings() const { return mSettings; }
+    const LoPassTelemetry &GetTelemetry() const { return mTelemetry; }
+
+    /// The track upstream fills the input, a silent flag for quiet tracks once they stop.
+    bool Fill(uint64_t inPosition, unsigned inFrames) {
+
+        if (mQuiet && inPosition >= kQuietAfterSeconds * mSampleRate) { return true; }
+
+        for (size_t i = 0; i < (size_t)mChannels * inFrames; i++) {
+            mInput[i] = (float)((int32_t)(mNoise = mNoise * 1664525u + 1013904223u) * (0.25 / 2147483648.0));
+        }
+        return false;
+    }
+
+    void Render(uint64_t inPosition, unsigned inFrames, bool inSilent) {
+
+        mTelemetry.BeginRender();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // AUSilentTimeout: silence only reaches the kernels once the tail has run out
+        mSilentFrames = inSilent ? mSilentFrames + inFrames : 0;
+        bool skipped = inSilent && mSilentFrames > mSilentTimeout + inFrames;
+
+        // LoPassKernel clears the state on the first buffer it skips
+        if (skipped && !mSkipping) {
+            for (std::unique_ptr<LoPassProcessor> &processor : mProcessors) { processor->Reset(); }
+        }
+        mSkipping = skipped;
+
+        if (!skipped && !mAutomated) {
+            Process(mSettings, 0, inFrames, inFrames);
+        } else if (!skipped) {
+            // kAutomationEvents evenly through the buffer, each a slice of its own
+            for (unsigned e = 0; e < kAutomationEvents; e++) {
+                unsigned begin = inFrames * e / kAutomationEvents;
+                unsigned end = inFrames * (e + 1) / kAutomationEvents;
+                if (end == begin) { continue; }
+
+                double seconds = (inPosition + begin) / mSampleRate;
+                mSettings.mCutoff = 300.0 * pow(20.0, 0.5 + 0.5 * sin(2.0 * M_PI * 0.25 * seconds + mIndex));
+
+                mTelemetry.AddSlice();
+                Process(mSettings, begin, end - begin, inFrames);
+            }
+        }
+
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        mTelemetry.EndRender(inFrames, elapsed, (uint64_t)(1e9 * inFrames / mSampleRate), skipped);
+    }
+
+private:
+    void Process(const LoPassSettings &inSettings, unsigned inOffset, unsigned inFrames, unsigned inStride) {
+
+        for (unsigned c = 0; c < mChannels; c++) {
+            size_t at = (size_t)c * inStride + inOffset;
+            mProcessors[c]->Process(inSettings, &mInput[at], &mOutput[at], inFrames);
+
+            uint64_t designs = mProcessors[c]->GetDesignCount();
+            mTelemetry.AddDesigns(designs - mReported[c]);
+            mReported[c] = designs;
+        }
+    }
+
+    unsigned                                        mIndex;
+    unsigned                                        mChannels;
+    LoPassSettings                                  mSettings;
+    bool                                            mAutomated;
+    bool                                            mQuiet;
+    double                                          mSampleRate;
+
+    unsigned                                        mSilentTimeout;
+    uint64_t                                        mSilentFrames;
+    bool                                            mSkipping;
+
+    std::vector<std::unique_ptr<LoPassProcessor> >  mProcessors;
+    std::vector<uint64_t>                           mReported;
+    std::vector<float>                              mInput;
+    std::vector<float>                              mOutput;
+    uint32_t                                        mNoise;
+
+    LoPassTelemetry                                 mTelemetry;
+};
+
+/// A repeatable session: every 50th track linear phase, every 40th multirate, about a
+/// fifth automated and a quarter quiet after a second.
+static Instance *NewInstance(unsigned inIndex, double inSampleRate, unsigned inFrames) {
+
+    static const unsigned kChannels[] = { 2, 2, 2, 2, 2, 1, 1, 6, 8 };
+
+    uint32_t hash = inIndex * 2246822519u + 374761393u;
+    hash = (hash ^ (hash >> 15)) * 2654435761u;
+    hash ^= hash >> 13;
+
+    LoPassSettings settings;
+    settings.mCutoff        = 200.0 * pow(2.0, (hash % 64) / 10.0);
+    settings.mResonance     = (double)((hash >> 6) % 13);
+    settings.mLinearPhase   = inIndex % 50 == 49;
+    settings.mMultirate     = inIndex % 40 == 39;
+
+    if (settings.mMultirate) { settings.mCutoff = 60.0; }
+
+    unsigned channels = kChannels[(hash >> 10) % (sizeof(kChannels) / sizeof(kChannels[0]))];
+    bool automated = (hash >> 14) % 5 == 0;
+    bool quiet = (hash >> 18) % 4 == 0;
+
+    return new Instance(inIndex, channels, settings, automated, quiet, inSampleRate, inFrames);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Report
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct Row {
+    const Instance          *mInstance;
+    LoPassTelemetrySnapshot mSnapshot;
+};
+
+static void PrintTable(const std::vector<Row> &inRows, size_t inCount, uint64_t inTotalNs) {
+
+    printf("\n%5s %3s %-12s %8s %8s %8s %8s %7s %5s %9s %7s %6s %6s\n", "inst", "ch", "mode", "renders", "min us", "avg us",
+           "max us", "slices", "max", "designs", "silent", "late", "share");
+
+    for (size_t n = 0; n < std::min(inCount, inRows.size()); n++) {
+        const Instance &instance = *inRows[n].mInstance;
+        const LoPassTelemetrySnapshot &snapshot = inRows[n].mSnapshot;
+
+        std::string mode = instance.GetSettings().mLinearPhase ? "linear" : instance.GetSettings().mMultirate ? "multirate" : "iir";
+        if (instance.IsAutomated()) { mode += "+auto"; }
+        if (instance.IsQuiet()) { mode += "+quiet"; }
+
+        double renders = (double)std::max<uint64_t>(snapshot.mRenders, 1);
+
+        printf("%5u %3u %-12s %8llu %8.2f %8.2f %8.2f %7.2f %5u %9.2f %7llu %6llu %5.1f%%\n", instance.GetIndex(),
+               instance.GetChannels(), mode.c_str(), (unsigned long long)snapshot.mRenders, 1e-3 * snapshot.mMinRenderNs,
+               1e-3 * snapshot.mTotalRenderNs / renders, 1e-3 * snapshot.mMaxRenderNs, snapshot.mSlices / renders,
+               snapshot.mMaxSlices, snapshot.mDesigns / renders, (unsigned long long)snapshot.mSilentBuffers,
+               (unsigned long long)snapshot.mOverDeadline, 100.0 * snapshot.mTotalRenderNs / std::max<uint64_t>(inTotalNs, 1));
+    }
+}
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-telemetry [options]\n"
+            "\n"
+            "  -n, --instances N    instances in the session (default %u)\n"
+            "  -f, --frames N       buffer size (default %u)\n"
+            "  -r, --rate HZ        sample rate (default %g)\n"
+            "  -s, --seconds S      seconds of audio to render (default %g)\n"
+            "  -t, --top N          instances to list (default %u)\n"
+            "  -a, --all            list every instance\n",
+            kDefaultInstances, kDefaultFrames, kDefaultSampleRate, kDefaultSeconds, kDefaultTop);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "instances",  required_argument,  NULL, 'n' },
+        { "frames",     required_argument,  NULL, 'f' },
+        { "rate",       required_argument,  NULL, 'r' },
+        { "seconds",    required_argument,  NULL, 's' },
+        { "top",        required_argument,  NULL, 't' },
+        { "all",        no_argument,        NULL, 'a' },
+        { "help",       no_argument,        NULL, 'h' },
+        { NULL,         0,                  NULL, 0 }
+    };
+
+    double instances = kDefaultInstances;
+    double frames = kDefaultFrames;
+    double sampleRate = kDefaultSampleRate;
+    double seconds = kDefaultSeconds;
+    double top = kDefaultTop;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "n:f:r:s:t:ah", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'n': ok = LoPassParseNumber(optarg, instances) && instances >= 1.0 && instances <= 10000.0; break;
+            case 'f': ok = LoPassParseNumber(optarg, frames) && frames >= 1.0 && frames <= 65536.0; break;
+            case 'r': ok = LoPassParseNumber(optarg, sampleRate) && sampleRate >= 8000.0 && sampleRate <= 768000.0; break;
+            case 's': ok = LoPassParseNumber(optarg, seconds) && seconds > 0.0 && seconds <= 3600.0; break;
+            case 't': ok = LoPassParseNumber(optarg, top) && top >= 1.0; break;
+            case 'a': top = 1e9; break;
+            case 'h': PrintUsage(stdout); return 0;
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-telemetry: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    unsigned bufferFrames = (unsigned)frames;
+    std::vector<std::unique_ptr<Instance> > session;
+    unsigned channels = 0;
+
+    for (unsigned i = 0; i < (unsigned)instances; i++) {
+        session.emplace_back(NewInstance(i, sampleRate, bufferFrames));
+        channels += session.back()->GetChannels();
+    }
+
+    uint64_t buffers = (uint64_t)ceil(seconds * sampleRate / bufferFrames);
+    printf("%zu instances, %u channels, %llu buffers of %u frames at %g Hz\n", session.size(), channels,
+           (unsigned long long)buffers, bufferFrames, sampleRate);
+
+    for (uint64_t b = 0; b < buffers; b++) {
+        uint64_t position = b * bufferFrames;
+        for (size_t i = 0; i < session.size(); i++) {
+            bool silent = session[i]->Fill(position, bufferFrames);
+            session[i]->Render(position, bufferFrames, silent);
+        }
+    }
+
+    // what a host would read through the property
+    std::vector<Row> rows(session.size());
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < session.size(); i++) {
+        rows[i].mInstance = session[i].get();
+        session[i]->GetTelemetry().GetSnapshot(rows[i].mSnapshot);
+        total += rows[i].mSnapshot.mTotalRenderNs;
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+        return a.mSnapshot.mTotalRenderNs > b.mSnapshot.mTotalRenderNs;
+    });
+
+    printf("%.1f ms rendering %.1f s of audio, %.1f%% of real time\n", 1e-6 * total, seconds, 100.0 * 1e-9 * total / seconds);
+    PrintTable(rows, (size_t)top, total);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+//
+//  LoPassToolOptions.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassToolOptions.hpp"
+#include "LoPassParameters.h"
+#include <stdlib.h>
+#include <strings.h>
+
+bool LoPassParseNumber(const char *inText, double &outValue) {
+
+    char *end;
+    outValue = strtod(inText, &end);
+    return *inText != '\0' && *end == '\0';
+}
+
+int LoPassFindPreset(const char *inName) {
+
+    char *end;
+    long number = strtol(inName, &end, 10);
+
+    if (*inName != '\0' && *end == '\0') { return number >= 0 && number < kNumberOfPresets ? (int)number : -1; }
+
+    for (int i = 0; i < kNumberOfPresets; i++) {
+        if (strcasecmp(inName, kPresetValues[i].mName) == 0) { return i; }
+    }
+
+    return -1;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassSettingOptions
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassSettingOptions::LoPassSettingOptions()
+    : mCutoff(-1.0), mResonance(-1e9) { }
+
+bool LoPassSettingOptions::Parse(int inOption, const char *inArgument) {
+
+    switch (inOption) {
+        case 'c': return LoPassParseNumber(inArgument, mCutoff) && mCutoff > 0.0;
+        case 'r': return LoPassParseNumber(inArgument, mResonance);
+        case 's': return LoPassParseNumber(inArgument, mSettings.mSmoothing) && mSettings.mSmoothing >= 0.0;
+        case 'l': mSettings.mLinearPhase = true; return true;
+        case 'm': mSettings.mMultirate = true; return true;
+
+        case 'p': {
+            int preset = LoPassFindPreset(inArgument);
+            if (preset < 0) { return false; }
+            mSettings.mCutoff    = kPresetValues[preset].mFrequency;
+            mSettings.mResonance = kPresetValues[preset].mResonance;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+LoPassSettings LoPassSettingOptions::GetSettings() const {
+
+    LoPassSettings settings = mSettings;
+
+    if (mCutoff > 0.0) { settings.mCutoff = mCutoff; }
+    if (mResonance > -1e9) { settings.mResonance = mResonance; }
+
+    return settings;
+}
+
+void LoPassSettingOptions::PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "  -c, --cutoff HZ          cutoff frequency (%g to Nyquist, default %g)\n"
+            "  -r, --resonance DB       resonance (%g to %g, default %g)\n"
+            "  -p, --preset NAME|N      start from a factory preset\n"
+            "  -s, --smoothing MS       parameter smoothing time (default %g)\n"
+            "  -l, --linear-phase       linear phase FIR mode\n"
+            "  -m, --multirate          multirate mode, for very low cutoffs\n",
+            kMinimumValue_LoPass_Frequency, kDefaultValue_LoPass_Frequency,
+            kMinimumValue_LoPass_Resonance, kMaximumValue_LoPass_Resonance, kDefaultValue_LoPass_Resonance,
+            kDefaultValue_LoPass_Smoothing);
+}
+
+void LoPassSettingOptions::PrintPresets(FILE *inFile) {
+
+    fprintf(inFile, "presets:");
+    for (int i = 0; i < kNumberOfPresets; i++) { fprintf(inFile, " %d (%s)", i, kPresetValues[i].mName); }
+    fprintf(inFile, "\n");
+}
@@ -0,0 +1,53 @@
+//
+//  LoPassToolOptions.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Command line parsing shared by the tools.
+//
+
+#ifndef LoPassToolOptions_hpp
+#define LoPassToolOptions_hpp
+
+#include "LoPassProcessor.hpp"
+#include <stdio.h>
+
+/// Parses the whole of inText as a number; false if it's empty or anything follows the number.
+bool LoPassParseNumber(const char *inText, double &outValue);
+
+/// Looks a preset up by name or number; returns -1 if there's no such preset.
+int LoPassFindPreset(const char *inName);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Setting Options
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The effect's own settings as the renderers take them: -c / --cutoff, -r / --resonance,
+// -p / --preset, -s / --smoothing, -l / --linear-phase and -m / --multirate. A tool's
+// getopt loop hands these options to Parse() and reads the result from GetSettings() once
+// the loop is done, so an explicit cutoff or resonance overrides the preset whatever the
+// order they were given in.
+
+class LoPassSettingOptions {
+
+public:
+    LoPassSettingOptions();
+
+    /// Takes one of the options above; false if its value is bad.
+    bool Parse(int inOption, const char *inArgument);
+
+    LoPassSettings GetSettings() const;
+
+    /// The usage lines for the options above.
+    static void PrintUsage(FILE *inFile);
+
+    /// The factory presets by number and name, on one line.
+    static void PrintPresets(FILE *inFile);
+
+private:
+    LoPassSettings  mSettings;
+    double          mCutoff;        // -1 until given
+    double          mResonance;     // -1e9 until given
+};
+
+#endif /* LoPassToolOptions_hpp */
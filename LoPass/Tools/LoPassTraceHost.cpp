@@ -0,0 +1,305 @@
+//
+//  LoPassTraceHost.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  Test host for the render tracing: a few host render threads, each rendering its share
+//  of the instances once per buffer period, traced into a Chrome trace event file.
+//
+//  make lopass-trace
+//
+//  Built with LOPASS_TRACE, so AUTRACE() records into LoPassTrace's per-thread rings as it
+//  does in a traced build of the AudioUnit. Each instance hits the trace points the
+//  AudioUnit's render path hits, with the same arguments: DoRender() around the render,
+//  ProcessScheduledSlice() around each slice of an automated instance, ProcessBufferLists()
+//  around the kernels, and LoPassKernel::Process() around each channel. Instances with
+//  kLoPass_ParallelChannels or more share their channels with a LoPassWorkerPool in groups,
+//  traced as channel groups on whichever thread ran them, as LoPassUnit does for wide
+//  formats. A LoPassTraceRecorder drains the rings while it runs.
+//
+//  Open the file at ui.perfetto.dev or chrome://tracing: a track per thread, every render
+//  on it to the nanosecond, the instance in each event's arguments.
+//
+//  lopass-trace [options]
+//
+
+#include "LoPassParameters.h"
+#include "LoPassProcessor.hpp"
+#include "LoPassToolOptions.hpp"
+#include "LoPassTrace.hpp"
+#include "LoPassWorkerPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <getopt.h>
+#include <math.h>
+#include <memory>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifndef AUTRACE
+    #error lopass-trace must be built with LOPASS_TRACE=1
+#endif
+
+static constexpr unsigned kDefaultInstances     = 16;
+static constexpr unsigned kDefaultThreads       = 2;
+static constexpr unsigned kDefaultFrames        = 256;
+static constexpr double kDefaultSampleRate      = 48000.0;
+static constexpr double kDefaultSeconds         = 1.0;
+static const char *const kDefaultPath           = "lopass-trace.json";
+
+/// As LoPassUnit.hpp.
+static constexpr unsigned kLoPass_ParallelChannels  = 8;
+static constexpr unsigned kLoPass_ChannelsPerGroup  = 4;
+
+/// Scheduled parameter events per buffer on an automated instance.
+static constexpr unsigned kAutomationEvents     = 3;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instance
+//
+// The instance's address stands in for its AudioComponentInstance, and for AUBase's this.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class Instance {
+
+public:
+    Instance(unsigned inChannels, bool inAutomated, double inSampleRate, unsigned inMaxFrames) :
+        mChannels(inChannels),
+        mAutomated(inAutomated),
+        mSampleRate(inSampleRate),
+        mInput((size_t)inChannels * inMaxFrames),
+        mOutput(mInput.size()),
+        mNoise(inChannels * 2654435761u + 1) {
+
+        for (unsigned c = 0; c < mChannels; c++) {
+            mProcessors.emplace_back(new LoPassProcessor(inSampleRate));
+            mProcessors.back()->Prepare(mSettings);
+        }
+
+        if (mChannels >= kLoPass_ParallelChannels) {
+            unsigned workers = std::min(mChannels / kLoPass_ChannelsPerGroup - 1, kWorkerPool_MaxWorkers);
+            mPool.reset(new LoPassWorkerPool(workers));
+            mPool->SetRealtime(inMaxFrames / inSampleRate);
+        }
+    }
+
+    unsigned GetChannels() const { return mChannels; }
+
+    void Render(uint64_t inPosition, unsigned inFrames) {
+
+        for (size_t i = 0; i < (size_t)mChannels * inFrames; i++) {
+            mInput[i] = (float)((int32_t)(mNoise = mNoise * 1664525u + 1013904223u) * (0.25 / 2147483648.0));
+        }
+
+        AUTRACE(kCATrace_AUBaseRenderStart, this, (intptr_t)this, 0, inFrames, &mOutput[0]);
+
+        if (!mAutomated) {
+            ProcessBufferLists(0, inFrames, inFrames);
+        } else {
+            for (unsigned e = 0; e < kAutomationEvents; e++) {
+                unsigned begin = inFrames * e / kAutomationEvents;
+                unsigned end = inFrames * (e + 1) / kAutomationEvents;
+                if (end == begin) { continue; }
+
+                mSettings.mCutoff = 300.0 * pow(20.0, 0.5 + 0.5 * sin(2.0 * M_PI * (inPosition + begin) / mSampleRate));
+
+                AUTRACE(kLoPassTrace_ScheduledSliceStart, this, (intptr_t)this, begin, end - begin, inFrames);
+                ProcessBufferLists(begin, end - begin, inFrames);
+                AUTRACE(kLoPassTrace_ScheduledSliceEnd, this, (intptr_t)this, 0, 0, 0);
+            }
+        }
+
+        AUTRACE(kCATrace_AUBaseRenderEnd, this, (intptr_t)this, 0, 0, &mOutput[0]);
+    }
+
+private:
+    struct Slice {
+        Instance    *mInstance;
+        unsigned    mOffset;
+        unsigned    mFrames;
+        unsigned    mStride;
+    };
+
+    void ProcessBufferLists(unsigned inOffset, unsigned inFrames, unsigned inStride) {
+
+        AUTRACE(kLoPassTrace_ProcessBufferListsStart, this, (intptr_t)this, mChannels, inFrames, 0);
+
+        Slice slice = { this, inOffset, inFrames, inStride };
+
+        if (mPool) {
+            mPool->Run(mChannels, &Instance::ProcessGroup, &slice);
+        } else {
+            for (unsigned c = 0; c < mChannels; c++) { ProcessKernel(c, slice); }
+        }
+
+        AUTRACE(kLoPassTrace_ProcessBufferListsEnd, this, (intptr_t)this, 0, 0, 0);
+    }
+
+    static void ProcessGroup(void *inContext, unsigned inBegin, unsigned inEnd) {
+
+        Slice &slice = *(Slice *)inContext;
+        Instance *instance = slice.mInstance;
+
+        AUTRACE(kLoPassTrace_ChannelGroupStart, instance, (intptr_t)instance, inBegin, inEnd, slice.mFrames);
+        for (unsigned c = inBegin; c < inEnd; c++) { instance->ProcessKernel(c, slice); }
+        AUTRACE(kLoPassTrace_ChannelGroupEnd, instance, (intptr_t)instance, 0, 0, 0);
+    }
+
+    void ProcessKernel(unsigned inChannel, const Slice &inSlice) {
+
+        LoPassProcessor *processor = mProcessors[inChannel].get();
+        size_t at = (size_t)inChannel * inSlice.mStride + inSlice.mOffset;
+
+        AUTRACE(kLoPassTrace_KernelStart, this, (intptr_t)processor, inChannel, inSlice.mFrames, 0);
+        uint64_t designs = processor->GetDesignCount();
+        processor->Process(mSettings, &mInput[at], &mOutput[at], inSlice.mFrames);
+        AUTRACE(kLoPassTrace_KernelEnd, this, (intptr_t)processor, processor->GetDesignCount() - designs, 0, 0);
+    }
+
+    unsigned                                        mChannels;
+    bool                                            mAutomated;
+    double                                          mSampleRate;
+    LoPassSettings                                  mSettings;
+
+    std::vector<std::unique_ptr<LoPassProcessor> >  mProcessors;
+    std::unique_ptr<LoPassWorkerPool>               mPool;
+    std::vector<float>                              mInput;
+    std::vector<float>                              mOutput;
+    uint32_t                                        mNoise;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// RenderThread()
+//
+// One of the host's render threads: its instances one after another, then sleep until the
+// next period.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static void RenderThread(unsigned inIndex, std::vector<Instance *> inInstances, unsigned inFrames, double inSampleRate, uint64_t inBuffers) {
+
+#if defined(__linux__)
+    char name[16];
+    snprintf(name, sizeof(name), "render %u", inIndex);
+    pthread_setname_np(pthread_self(), name);
+#else
+    (void)inIndex;
+#endif
+
+    LoPassTrace::RegisterThread();
+
+    std::chrono::nanoseconds period((int64_t)llround(1e9 * inFrames / inSampleRate));
+    std::chrono::steady_clock::time_point wake = std::chrono::steady_clock::now();
+
+    for (uint64_t b = 0; b < inBuffers; b++) {
+        for (size_t i = 0; i < inInstances.size(); i++) { inInstances[i]->Render(b * inFrames, inFrames); }
+
+        wake += period;
+        std::this_thread::sleep_until(wake);
+    }
+}
+
+static void PrintUsage(FILE *inFile) {
+
+    fprintf(inFile,
+            "usage: lopass-trace [options]\n"
+            "\n"
+            "  -n, --instances N    instances (default %u)\n"
+            "  -j, --threads N      host render threads (default %u)\n"
+            "  -f, --frames N       buffer size (default %u)\n"
+            "  -r, --rate HZ        sample rate (default %g)\n"
+            "  -s, --seconds S      how long to run (default %g)\n"
+            "  -o, --output FILE    trace file (default %s)\n",
+            kDefaultInstances, kDefaultThreads, kDefaultFrames, kDefaultSampleRate, kDefaultSeconds, kDefaultPath);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+int main(int argc, char *argv[]) {
+
+    static const struct option kOptions[] = {
+        { "instances",  required_argument,  NULL, 'n' },
+        { "threads",    required_argument,  NULL, 'j' },
+        { "frames",     required_argument,  NULL, 'f' },
+        { "rate",       required_argument,  NULL, 'r' },
+        { "seconds",    required_argument,  NULL, 's' },
+        { "output",     required_argument,  NULL, 'o' },
+        { "help",       no_argument,        NULL, 'h' },
+        { NULL,         0,                  NULL, 0 }
+    };
+
+    double instances = kDefaultInstances;
+    double threads = kDefaultThreads;
+    double frames = kDefaultFrames;
+    double sampleRate = kDefaultSampleRate;
+    double seconds = kDefaultSeconds;
+    const char *path = kDefaultPath;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "n:j:f:r:s:o:h", kOptions, NULL)) != -1) {
+
+        bool ok = true;
+
+        switch (option) {
+            case 'n': ok = LoPassParseNumber(optarg, instances) && instances >= 1.0 && instances <= 1000.0; break;
+            case 'j': ok = LoPassParseNumber(optarg, threads) && threads >= 1.0 && threads <= 64.0; break;
+            case 'f': ok = LoPassParseNumber(optarg, frames) && frames >= 1.0 && frames <= 65536.0; break;
+            case 'r': ok = LoPassParseNumber(optarg, sampleRate) && sampleRate >= 8000.0 && sampleRate <= 768000.0; break;
+            case 's': ok = LoPassParseNumber(optarg, seconds) && seconds > 0.0 && seconds <= 600.0; break;
+            case 'o': path = optarg; break;
+            case 'h': PrintUsage(stdout); return 0;
+            default:
+                PrintUsage(stderr);
+                return 2;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "lopass-trace: bad value for -%c: %s\n", option, optarg);
+            return 2;
+        }
+    }
+
+    if (optind != argc) {
+        PrintUsage(stderr);
+        return 2;
+    }
+
+    // mostly stereo, every fourth automated, every eighth a wide bus
+    std::vector<std::unique_ptr<Instance> > session;
+    for (unsigned i = 0; i < (unsigned)instances; i++) {
+        unsigned channels = i % 8 == 7 ? 16 : i % 5 == 4 ? 1 : 2;
+        session.emplace_back(new Instance(channels, i % 4 == 1, sampleRate, (unsigned)frames));
+    }
+
+    std::vector<std::vector<Instance *> > shares((size_t)threads);
+    for (size_t i = 0; i < session.size(); i++) { shares[i % shares.size()].push_back(session[i].get()); }
+
+    LoPassTraceRecorder recorder;
+    if (!recorder.Start(path)) {
+        fprintf(stderr, "lopass-trace: can't write %s\n", path);
+        return 1;
+    }
+
+    uint64_t buffers = (uint64_t)ceil(seconds * sampleRate / frames);
+    std::vector<std::thread> renderers;
+
+    for (size_t t = 0; t < shares.size(); t++) {
+        renderers.push_back(std::thread(RenderThread, (unsigned)t, shares[t], (unsigned)frames, sampleRate, buffers));
+    }
+    for (size_t t = 0; t < renderers.size(); t++) { renderers[t].join(); }
+
+    recorder.Stop();
+
+    printf("%zu instances on %zu threads, %llu buffers: %llu records, %llu dropped, written to %s\n", session.size(),
+           shares.size(), (unsigned long long)buffers, (unsigned long long)recorder.GetRecordCount(),
+           (unsigned long long)recorder.GetDroppedCount(), path);
+
+    return 0;
+}
@@ -0,0 +1,545 @@
+//
+//  LoPassWave.cpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+
+#include "LoPassWave.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Pages behind the read position are given back in steps of this many bytes.
+static constexpr size_t     kReleaseStep        = 8 << 20;
+
+static constexpr uint16_t   kFormatPCM          = 0x0001;
+static constexpr uint16_t   kFormatFloat        = 0x0003;
+static constexpr uint16_t   kFormatExtensible   = 0xFFFE;
+
+static constexpr uint32_t   kMaxRIFFSize        = 0xFFFFFFFF;
+
+// Header sizes, for choosing between RIFF and RF64
+static constexpr unsigned   kFmtChunkSize       = 16;
+static constexpr unsigned   kExtensibleSize     = 40;
+static constexpr unsigned   kDS64ChunkSize      = 28;
+
+//~~~~ little endian helpers
+
+static uint16_t ReadU16(const uint8_t *inP) { return inP[0] | (inP[1] << 8); }
+static uint32_t ReadU32(const uint8_t *inP) { return ReadU16(inP) | ((uint32_t)ReadU16(inP + 2) << 16); }
+static uint64_t ReadU64(const uint8_t *inP) { return ReadU32(inP) | ((uint64_t)ReadU32(inP + 4) << 32); }
+
+static void PutU16(std::vector<uint8_t> &ioBytes, uint16_t inValue) {
+    ioBytes.push_back(inValue & 0xFF);
+    ioBytes.push_back(inValue >> 8);
+}
+
+static void PutU32(std::vector<uint8_t> &ioBytes, uint32_t inValue) {
+    PutU16(ioBytes, inValue & 0xFFFF);
+    PutU16(ioBytes, inValue >> 16);
+}
+
+static void PutU64(std::vector<uint8_t> &ioBytes, uint64_t inValue) {
+    PutU32(ioBytes, inValue & 0xFFFFFFFF);
+    PutU32(ioBytes, inValue >> 32);
+}
+
+static void PutTag(std::vector<uint8_t> &ioBytes, const char *inTag) {
+    for (unsigned i = 0; i < 4; i++) { ioBytes.push_back((uint8_t)inTag[i]); }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Sample conversion
+//
+// The host is assumed to be little endian, as every target of the plugin is.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassWaveDecode(const LoPassWaveFormat  &inFormat,
+                      const uint8_t           *inSourceP,
+                      float *const            *outChannels,
+                      unsigned                inFrames) {
+    
+    const unsigned channels = inFormat.mChannels;
+    const unsigned bytes    = inFormat.mBitsPerSample / 8;
+    
+    for (unsigned c = 0; c < channels; c++) {
+        
+        const uint8_t *p = inSourceP + c * bytes;
+        float *dest = outChannels[c];
+        const unsigned stride = channels * bytes;
+        
+        if (inFormat.mFloat && bytes == 4) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) { memcpy(&dest[i], p, 4); }
+        } else if (inFormat.mFloat) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                double value;
+                memcpy(&value, p, 8);
+                dest[i] = (float)value;
+            }
+        } else if (bytes == 1) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) { dest[i] = (p[0] - 128) * (1.0f / 128.0f); }
+        } else if (bytes == 2) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                int16_t value;
+                memcpy(&value, p, 2);
+                dest[i] = value * (1.0f / 32768.0f);
+            }
+        } else if (bytes == 3) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                int32_t value = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+                dest[i] = value * (1.0f / 8388608.0f);
+            }
+        } else {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                int32_t value;
+                memcpy(&value, p, 4);
+                dest[i] = (float)(value * (1.0 / 2147483648.0));
+            }
+        }
+    }
+}
+
+/// Round and clip to a signed integer of inBits bits.
+static inline int32_t Quantise(float inValue, unsigned inBits) {
+    
+    const double scale  = (double)(1u << (inBits - 1));
+    double value        = nearbyint(inValue * scale);
+    
+    if (value > scale - 1.0) { value = scale - 1.0; }
+    if (value < -scale) { value = -scale; }
+    
+    return (int32_t)value;
+}
+
+void LoPassWaveEncode(const LoPassWaveFormat  &inFormat,
+                      const float *const      *inChannels,
+                      uint8_t                 *outDestP,
+                      unsigned                inFrames) {
+    
+    const unsigned channels = inFormat.mChannels;
+    const unsigned bytes    = inFormat.mBitsPerSample / 8;
+    
+    for (unsigned c = 0; c < channels; c++) {
+        
+        uint8_t *p = outDestP + c * bytes;
+        const float *source = inChannels[c];
+        const unsigned stride = channels * bytes;
+        
+        if (inFormat.mFloat && bytes == 4) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) { memcpy(p, &source[i], 4); }
+        } else if (inFormat.mFloat) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                double value = source[i];
+                memcpy(p, &value, 8);
+            }
+        } else if (bytes == 1) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) { p[0] = (uint8_t)(Quantise(source[i], 8) + 128); }
+        } else if (bytes == 2) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                int16_t value = (int16_t)Quantise(source[i], 16);
+                memcpy(p, &value, 2);
+            }
+        } else if (bytes == 3) {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                int32_t value = Quantise(source[i], 24);
+                p[0] = value & 0xFF;
+                p[1] = (value >> 8) & 0xFF;
+                p[2] = (value >> 16) & 0xFF;
+            }
+        } else {
+            for (unsigned i = 0; i < inFrames; i++, p += stride) {
+                int32_t value = Quantise(source[i], 32);
+                memcpy(p, &value, 4);
+            }
+        }
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveFormat::LoPassWaveFormat()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassWaveFormat::LoPassWaveFormat() :
+    mSampleRate(0.0),
+    mChannels(0),
+    mBitsPerSample(0),
+    mFloat(false),
+    mExtensible(false),
+    mChannelMask(0) {
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveFormat::IsSupported()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWaveFormat::IsSupported() const {
+    
+    if (mChannels == 0 || mSampleRate <= 0.0) { return false; }
+    
+    if (mFloat) { return mBitsPerSample == 32 || mBitsPerSample == 64; }
+    
+    return mBitsPerSample == 8 || mBitsPerSample == 16 || mBitsPerSample == 24 || mBitsPerSample == 32;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveReader::LoPassWaveReader()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassWaveReader::LoPassWaveReader() :
+    mFile(-1),
+    mMap(NULL),
+    mMapSize(0),
+    mReleased(0),
+    mData(NULL),
+    mFrameCount(0),
+    mPosition(0) {
+}
+
+LoPassWaveReader::~LoPassWaveReader() { Close(); }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveReader::Open()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWaveReader::Open(const char *inPath) {
+    
+    Close();
+    
+    mFile = open(inPath, O_RDONLY);
+    if (mFile < 0) { return Fail(std::string(inPath) + ": " + strerror(errno)); }
+    
+    uint64_t dataOffset, frameCount;
+    std::string error;
+    
+    if (!ReadHeader(mFile, mFormat, dataOffset, frameCount, error)) { return Fail(std::string(inPath) + ": " + error); }
+    
+    struct stat info;
+    if (fstat(mFile, &info) != 0) { return Fail(std::string(inPath) + ": " + strerror(errno)); }
+    
+    mMapSize = (size_t)info.st_size;
+    
+    void *map = mmap(NULL, mMapSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+    if (map == MAP_FAILED) { return Fail(std::string(inPath) + ": mmap: " + strerror(errno)); }
+    
+    mMap = (const uint8_t *)map;
+    madvise(map, mMapSize, MADV_SEQUENTIAL);
+    
+    mData       = mMap + dataOffset;
+    mFrameCount = frameCount;
+    
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveReader::ReadHeader()
+//
+// RIFF / WAVE, or RF64 / BW64 where the 32 bit sizes are 0xFFFFFFFF and the real ones
+// are in the ds64 chunk. Only the chunk headers and the small chunks are read.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWaveReader::ReadHeader(int                 inFile,
+                                  LoPassWaveFormat    &outFormat,
+                                  uint64_t            &outDataOffset,
+                                  uint64_t            &outFrameCount,
+                                  std::string         &outError) {
+    
+    struct stat info;
+    if (fstat(inFile, &info) != 0) {
+        outError = strerror(errno);
+        return false;
+    }
+    
+    const uint64_t fileSize = (uint64_t)info.st_size;
+    uint8_t riff[12];
+    
+    if (pread(inFile, riff, sizeof(riff), 0) != (ssize_t)sizeof(riff)) {
+        outError = "too short for a WAV file";
+        return false;
+    }
+    
+    bool rf64 = memcmp(riff, "RF64", 4) == 0 || memcmp(riff, "BW64", 4) == 0;
+    
+    if ((!rf64 && memcmp(riff, "RIFF", 4) != 0) || memcmp(riff + 8, "WAVE", 4) != 0) {
+        outError = "not a WAV or RF64 file";
+        return false;
+    }
+    
+    outFormat           = LoPassWaveFormat();
+    uint64_t dataSize64 = 0;
+    bool haveFormat     = false;
+    uint64_t offset     = 12;
+    
+    while (offset + 8 <= fileSize) {
+        
+        uint8_t chunk[8 + kExtensibleSize];
+        if (pread(inFile, chunk, 8, (off_t)offset) != 8) { break; }
+        
+        uint64_t size           = ReadU32(chunk + 4);
+        const uint8_t *body     = chunk + 8;
+        uint64_t available      = fileSize - offset - 8;
+        
+        // the chunks we look inside are small enough to read whole
+        bool wanted = memcmp(chunk, "ds64", 4) == 0 || memcmp(chunk, "fmt ", 4) == 0;
+        size_t bodySize = (size_t)(size < kExtensibleSize ? size : kExtensibleSize);
+        
+        if (wanted && size <= available && pread(inFile, chunk + 8, bodySize, (off_t)offset + 8) != (ssize_t)bodySize) {
+            break;
+        }
+        
+        if (memcmp(chunk, "ds64", 4) == 0 && size >= 24 && size <= available) {
+            dataSize64 = ReadU64(body + 8);
+        }
+        
+        else if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && size <= available) {
+            
+            uint16_t tag                = ReadU16(body);
+            outFormat.mChannels         = ReadU16(body + 2);
+            outFormat.mSampleRate       = ReadU32(body + 4);
+            outFormat.mBitsPerSample    = ReadU16(body + 14);
+            
+            if (tag == kFormatExtensible && size >= 40) {
+                outFormat.mExtensible   = true;
+                outFormat.mChannelMask  = ReadU32(body + 20);
+                tag                     = ReadU16(body + 24);   // first two bytes of the sub-format GUID
+            }
+            
+            if (tag != kFormatPCM && tag != kFormatFloat) {
+                outError = "only PCM and IEEE float data are supported";
+                return false;
+            }
+            
+            outFormat.mFloat    = tag == kFormatFloat;
+            haveFormat          = true;
+        }
+        
+        else if (memcmp(chunk, "data", 4) == 0) {
+            
+            if (!haveFormat || !outFormat.IsSupported()) {
+                outError = haveFormat ? "unsupported sample format" : "data before fmt chunk";
+                return false;
+            }
+            
+            if (rf64 && size == kMaxRIFFSize) { size = dataSize64; }
+            
+            // a file still being written, or truncated, has less data than it says
+            if (size > available) { size = available; }
+            
+            outDataOffset   = offset + 8;
+            outFrameCount   = size / outFormat.GetBytesPerFrame();
+            return true;
+        }
+        
+        if (rf64 && size == kMaxRIFFSize) { break; }
+        offset += 8 + size + (size & 1);
+    }
+    
+    outError = "no data chunk";
+    return false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveReader::Read()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+unsigned LoPassWaveReader::Read(float *const *outChannels, unsigned inFrames) {
+    
+    uint64_t remaining  = mFrameCount - mPosition;
+    unsigned frames     = remaining < inFrames ? (unsigned)remaining : inFrames;
+    
+    const uint8_t *source = mData + mPosition * mFormat.GetBytesPerFrame();
+    LoPassWaveDecode(mFormat, source, outChannels, frames);
+    
+    mPosition += frames;
+    
+    // give back whole pages that are behind us
+    size_t consumed = (mData - mMap) + mPosition * mFormat.GetBytesPerFrame();
+    
+    if (consumed - mReleased >= kReleaseStep) {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t end  = consumed / page * page;
+        madvise((void *)(mMap + mReleased), end - mReleased, MADV_DONTNEED);
+        mReleased = end;
+    }
+    
+    return frames;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveReader::Close()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassWaveReader::Close() {
+    
+    if (mMap != NULL) { munmap((void *)mMap, mMapSize); }
+    if (mFile >= 0) { close(mFile); }
+    
+    mFile       = -1;
+    mMap        = NULL;
+    mMapSize    = 0;
+    mReleased   = 0;
+    mData       = NULL;
+    mFrameCount = 0;
+    mPosition   = 0;
+    mFormat     = LoPassWaveFormat();
+}
+
+bool LoPassWaveReader::Fail(const std::string &inMessage) {
+    
+    Close();
+    mError = inMessage;
+    return false;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveWriter::LoPassWaveWriter()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+LoPassWaveWriter::LoPassWaveWriter() :
+    mFile(NULL),
+    mFrameCount(0),
+    mWritten(0) {
+}
+
+LoPassWaveWriter::~LoPassWaveWriter() { Close(); }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveWriter::MakeHeader()
+//
+// The length is known up front, so the header is written once and never patched.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void LoPassWaveWriter::MakeHeader(const LoPassWaveFormat &inFormat, uint64_t inFrameCount, std::vector<uint8_t> &outHeader) {
+    
+    uint64_t dataSize   = inFrameCount * inFormat.GetBytesPerFrame();
+    unsigned fmtSize    = inFormat.mExtensible ? kExtensibleSize : kFmtChunkSize;
+    uint64_t riffSize   = 4 + (8 + fmtSize) + 8 + dataSize + (dataSize & 1);
+    bool rf64           = riffSize + 8 + kDS64ChunkSize > kMaxRIFFSize;
+    
+    if (rf64) { riffSize += 8 + kDS64ChunkSize; }
+    
+    outHeader.clear();
+    
+    PutTag(outHeader, rf64 ? "RF64" : "RIFF");
+    PutU32(outHeader, rf64 ? kMaxRIFFSize : (uint32_t)riffSize);
+    PutTag(outHeader, "WAVE");
+    
+    if (rf64) {
+        PutTag(outHeader, "ds64");
+        PutU32(outHeader, kDS64ChunkSize);
+        PutU64(outHeader, riffSize);
+        PutU64(outHeader, dataSize);
+        PutU64(outHeader, inFrameCount);
+        PutU32(outHeader, 0);           // no table
+    }
+    
+    uint16_t tag = inFormat.mFloat ? kFormatFloat : kFormatPCM;
+    
+    PutTag(outHeader, "fmt ");
+    PutU32(outHeader, fmtSize);
+    PutU16(outHeader, inFormat.mExtensible ? kFormatExtensible : tag);
+    PutU16(outHeader, inFormat.mChannels);
+    PutU32(outHeader, (uint32_t)inFormat.mSampleRate);
+    PutU32(outHeader, (uint32_t)inFormat.mSampleRate * inFormat.GetBytesPerFrame());
+    PutU16(outHeader, inFormat.GetBytesPerFrame());
+    PutU16(outHeader, inFormat.mBitsPerSample);
+    
+    if (inFormat.mExtensible) {
+        static const uint8_t kGUIDTail[14] = {
+            0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+        };
+        PutU16(outHeader, 22);
+        PutU16(outHeader, inFormat.mBitsPerSample);
+        PutU32(outHeader, inFormat.mChannelMask);
+        PutU16(outHeader, tag);
+        outHeader.insert(outHeader.end(), kGUIDTail, kGUIDTail + sizeof(kGUIDTail));
+    }
+    
+    PutTag(outHeader, "data");
+    PutU32(outHeader, rf64 ? kMaxRIFFSize : (uint32_t)dataSize);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveWriter::Open()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWaveWriter::Open(const char *inPath, const LoPassWaveFormat &inFormat, uint64_t inFrameCount) {
+    
+    Close();
+    
+    if (!inFormat.IsSupported()) { return Fail("unsupported output format"); }
+    
+    mFormat     = inFormat;
+    mFrameCount = inFrameCount;
+    mWritten    = 0;
+    
+    std::vector<uint8_t> header;
+    MakeHeader(inFormat, inFrameCount, header);
+    
+    mFile = fopen(inPath, "wb");
+    if (mFile == NULL) { return Fail(std::string(inPath) + ": " + strerror(errno)); }
+    
+    if (fwrite(&header[0], 1, header.size(), mFile) != header.size()) {
+        return Fail(std::string(inPath) + ": " + strerror(errno));
+    }
+    
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveWriter::Write()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWaveWriter::Write(const float *const *inChannels, unsigned inFrames) {
+    
+    if (mFile == NULL) { return false; }
+    
+    if (mWritten + inFrames > mFrameCount) { return Fail("more frames written than declared"); }
+    
+    size_t bytes = (size_t)inFrames * mFormat.GetBytesPerFrame();
+    if (mBuffer.size() < bytes) { mBuffer.resize(bytes); }
+    
+    LoPassWaveEncode(mFormat, inChannels, &mBuffer[0], inFrames);
+    
+    if (fwrite(&mBuffer[0], 1, bytes, mFile) != bytes) { return Fail(strerror(errno)); }
+    
+    mWritten += inFrames;
+    return true;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPassWaveWriter::Close()
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool LoPassWaveWriter::Close() {
+    
+    if (mFile == NULL) { return true; }
+    
+    bool ok = mWritten == mFrameCount;
+    if (!ok) { mError = "fewer frames written than declared"; }
+    
+    // pad byte for an odd sized data chunk
+    uint64_t dataSize = mWritten * mFormat.GetBytesPerFrame();
+    if ((dataSize & 1) && fputc(0, mFile) == EOF) { ok = false; }
+    
+    if (fclose(mFile) != 0 && ok) {
+        mError = strerror(errno);
+        ok = false;
+    }
+    
+    mFile = NULL;
+    return ok;
+}
+
+bool LoPassWaveWriter::Fail(const std::string &inMessage) {
+    
+    if (mFile != NULL) { fclose(mFile); }
+    
+    mFile   = NULL;
+    mError  = inMessage;
+    return false;
+}
@@ -0,0 +1,129 @@
+//
+//  LoPassWave.hpp
+//  LoPass
+//
+//  Created by David Miller on 18/10/26.
+//
+//  WAV / RF64 file access for the offline tools (POSIX only).
+//
+
+#ifndef LoPassWave_hpp
+#define LoPassWave_hpp
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Wave Format
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Interleaved PCM: 8 (unsigned), 16, 24 or 32 bit integer, or 32 / 64 bit float.
+struct LoPassWaveFormat {
+    double      mSampleRate;
+    unsigned    mChannels;
+    unsigned    mBitsPerSample;
+    bool        mFloat;
+    bool        mExtensible;    // WAVE_FORMAT_EXTENSIBLE, written back with the same mask
+    uint32_t    mChannelMask;
+    
+    LoPassWaveFormat();
+    
+    unsigned GetBytesPerFrame() const { return mChannels * (mBitsPerSample / 8); }
+    
+    /// True if the samples can be converted to and from float.
+    bool IsSupported() const;
+};
+
+/// Interleaved samples in inFormat to one float buffer per channel.
+void LoPassWaveDecode(const LoPassWaveFormat &inFormat, const uint8_t *inSourceP, float *const *outChannels, unsigned inFrames);
+
+/// One float buffer per channel to interleaved samples in inFormat, rounded and clipped.
+void LoPassWaveEncode(const LoPassWaveFormat &inFormat, const float *const *inChannels, uint8_t *outDestP, unsigned inFrames);
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Wave Reader
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Memory maps the whole file and walks through it once. Pages behind the read position
+/// are dropped as it goes, so the resident size stays bounded for any file length.
+class LoPassWaveReader {
+    
+public:
+    LoPassWaveReader();
+    ~LoPassWaveReader();
+    
+    /// Returns false, with GetError() set, if the file can't be mapped or isn't a WAV / RF64.
+    bool Open(const char *inPath);
+    void Close();
+    
+    /// Finds the format and the sample data of an open file without mapping it, for
+    /// callers doing their own reads. Returns false with outError set if it isn't usable.
+    static bool ReadHeader(int                 inFile,
+                           LoPassWaveFormat    &outFormat,
+                           uint64_t            &outDataOffset,
+                           uint64_t            &outFrameCount,
+                           std::string         &outError);
+    
+    const LoPassWaveFormat &GetFormat() const { return mFormat; }
+    uint64_t GetFrameCount() const { return mFrameCount; }
+    uint64_t GetPosition() const { return mPosition; }
+    const std::string &GetError() const { return mError; }
+    
+    /// Deinterleave and convert up to inFrames frames into one buffer per channel.
+    /// Returns the number of frames read, 0 at the end of the data.
+    unsigned Read(float *const *outChannels, unsigned inFrames);
+    
+private:
+    bool Fail(const std::string &inMessage);
+    
+    int                 mFile;
+    const uint8_t       *mMap;
+    size_t              mMapSize;
+    size_t              mReleased;      // bytes from the start already given back
+    
+    LoPassWaveFormat    mFormat;
+    const uint8_t       *mData;
+    uint64_t            mFrameCount;
+    uint64_t            mPosition;
+    std::string         mError;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LoPass Wave Writer
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Streams a file of known length. RF64 is written when the data won't fit a RIFF size.
+class LoPassWaveWriter {
+    
+public:
+    LoPassWaveWriter();
+    ~LoPassWaveWriter();
+    
+    bool Open(const char *inPath, const LoPassWaveFormat &inFormat, uint64_t inFrameCount);
+    
+    /// The header Open() writes, for callers doing their own writes. The sample data
+    /// follows it, with a pad byte after it if its size is odd.
+    static void MakeHeader(const LoPassWaveFormat &inFormat, uint64_t inFrameCount, std::vector<uint8_t> &outHeader);
+    
+    /// Flushes and closes; false if anything failed to reach the file.
+    bool Close();
+    
+    const std::string &GetError() const { return mError; }
+    
+    /// Interleave and convert inFrames frames, one buffer per channel.
+    bool Write(const float *const *inChannels, unsigned inFrames);
+    
+private:
+    bool Fail(const std::string &inMessage);
+    
+    FILE                    *mFile;
+    LoPassWaveFormat        mFormat;
+    uint64_t                mFrameCount;
+    uint64_t                mWritten;
+    std::vector<uint8_t>    mBuffer;
+    std::string             mError;
+};
+
+#endif /* LoPassWave_hpp */